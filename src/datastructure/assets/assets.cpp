@@ -90,16 +90,4 @@ WeightedBasket::WeightedBasket(
     if (weights_.size()!=asset_ptrs.size())
     {throw MismatchWeightedBasket();}
 }; 
-WeightedBasket::~WeightedBasket(){};
-
-template <typename T>
-std::vector<std::unique_ptr<Asset>> convert_specific_assets_to_base_assets(
-    std::vector<std::unique_ptr<T>> specific_assets)
-{
-    std::vector<std::unique_ptr<Asset>> assets;
-    for (auto& asset : specific_assets) 
-    {
-        assets.push_back(std::move(asset));
-    }
-    return assets;
-};
\ No newline at end of file
+WeightedBasket::~WeightedBasket(){};
\ No newline at end of file
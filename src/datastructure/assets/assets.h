@@ -1,5 +1,7 @@
 #pragma once
 #include <iostream>
+#include <vector>
+#include <memory>
 #include "../datastructure/instruments/instruments.h"
 #include "../datastructure/riskfactors/riskfactors.h"
 
@@ -31,4 +33,12 @@ struct WeightedBasket: Basket
 
 template <typename T>
 std::vector<std::unique_ptr<Asset>> convert_specific_assets_to_base_assets(
-    std::vector<std::unique_ptr<T>> specific_assets);
\ No newline at end of file
+    std::vector<std::unique_ptr<T>> specific_assets)
+{
+    std::vector<std::unique_ptr<Asset>> assets;
+    for (auto& asset : specific_assets) 
+    {
+        assets.push_back(std::move(asset));
+    }
+    return assets;
+};
\ No newline at end of file
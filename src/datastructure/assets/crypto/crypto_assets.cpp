@@ -59,7 +59,7 @@ std::vector<std::unique_ptr<CryptoAsset>> convert_specific_crypto_assets_to_cryp
 WeightedCryptoBasket::WeightedCryptoBasket(
     std::vector<double> weights,
     std::vector<std::unique_ptr<CryptoAsset>> crypto_assets): 
-    WeightedBasket(weights,convert_specific_assets_to_base_assets(crypto_assets)){};
+    WeightedBasket(weights,convert_specific_assets_to_base_assets(std::move(crypto_assets))){};
 WeightedCryptoBasket::~WeightedCryptoBasket(){}; 
 
 /** 
@@ -174,8 +174,7 @@ CryptoVolatilityFuture::~CryptoVolatilityFuture(){};
 CryptoOption::CryptoOption(
     std::unique_ptr<Crypto> crypto_risk_factor, 
     std::unique_ptr<Option> option): 
-    underlying_asset_ptr(std::make_unique<CryptoSpot>(
-        CryptoSpot(std::move(crypto_risk_factor)))), 
+    underlying_asset_ptr(std::make_unique<CryptoSpot>(std::move(crypto_risk_factor))), 
     option_ptr(std::move(option)){};
 CryptoOption::~CryptoOption(){}; 
 
@@ -193,11 +192,9 @@ CryptoOption::CryptoOption(
     std::unique_ptr<Option> option, 
     std::unique_ptr<Future> future): 
     underlying_asset_ptr(std::make_unique<CryptoFuture>(
-        CryptoFuture(
-            std::move(crypto_risk_factor), 
-            std::move(future)))), 
+        std::move(crypto_risk_factor), 
+        std::move(future))), 
     option_ptr(std::move(option)){};
-CryptoOption::~CryptoOption(){}; 
 
 /** 
  * @struct CryptoStructuredOption
@@ -217,7 +214,7 @@ CryptoStructuredOption::CryptoStructuredOption(
     std::vector<std::unique_ptr<CryptoOption>> crypto_options): 
     WeightedCryptoBasket(
         weights, 
-        convert_specific_crypto_assets_to_crypto_assets(crypto_options)){};
+        convert_specific_crypto_assets_to_crypto_assets(std::move(crypto_options))){};
 CryptoStructuredOption::~CryptoStructuredOption(){}; 
 
 /** 
@@ -238,6 +235,6 @@ CryptoStructuredFuture::CryptoStructuredFuture(
     std::vector<std::unique_ptr<CryptoFuture>> crypto_futures): 
     WeightedCryptoBasket(
         weights, 
-        convert_specific_crypto_assets_to_crypto_assets(crypto_futures)){};
-CryptoStructuredOption::~CryptoStructuredOption(){}; 
+        convert_specific_crypto_assets_to_crypto_assets(std::move(crypto_futures))){};
+CryptoStructuredFuture::~CryptoStructuredFuture(){}; 
     
\ No newline at end of file
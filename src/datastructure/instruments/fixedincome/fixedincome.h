@@ -1,6 +1,7 @@
 #pragma once
 #include <iostream>
 #include <vector>
+#include <memory>
 #include "../datastructure/timestamp/timestamp.h"
 #include "../datastructure/instruments/instruments.h"
 
@@ -53,7 +53,6 @@ Future::Future():
         EpochTimestamp(32531558207,EpochTimestampType::SECONDS)
         )), 
     is_perpetual(true){};
-Future::~Future(){}; 
 
 /** 
  * @struct VolatilityFuture
@@ -150,10 +149,9 @@ std::unique_ptr<StructuredFuture> FutureSpread::set_structured_future(
     std::unique_ptr<Future> long_future, 
     std::unique_ptr<Future> short_future)
 {
-    std::vector<std::unique_ptr<Future>> futures = {
-        std::move(long_future), 
-        std::move(short_future)};
-    return std::make_unique<StructuredFuture>(
-        StructuredFuture(futures,get_weights()));
+    std::vector<std::unique_ptr<Future>> futures; 
+    futures.push_back(std::move(long_future)); 
+    futures.push_back(std::move(short_future)); 
+    return std::make_unique<StructuredFuture>(std::move(futures), get_weights());
 };
 FutureSpread::~FutureSpread(){}; 
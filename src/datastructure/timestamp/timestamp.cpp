@@ -1,4 +1,5 @@
 #include "timestamp.h"
+#include <cmath>
 
 /** 
 * @file timestamp.h
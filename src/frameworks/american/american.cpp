@@ -0,0 +1,225 @@
+#include "american.h"
+
+/** 
+* @file american.h
+* @brief This file defines the pricers of the american vanilla options.
+* 
+* The Barone-Adesi-Whaley approximation adds to the european price an early exercise 
+* premium A*(S/S*)^q, the critical price S* being the root of the value matching 
+* condition at the exercise boundary. S* is proportional to the strike: the boundary 
+* is solved once for a strike of 1 and shared by every strike of an expiry with the 
+* same volatility, and it does not depend on the underlying price. The reference mode 
+* is a Leisen-Reimer binomial tree.
+* 
+* References :  
+* - "Efficient Analytic Approximation of American Option Values", Barone-Adesi, 
+*   Whaley, 1987. 
+* - "The Complete Guide to Option Pricing Formulas", Haug, 2007, for the seed and the 
+*   iterations of the critical price.
+* - "Binomial models for option valuation - examining and improving convergence", 
+*   Leisen, Reimer, 1996.
+*/
+
+/**
+ * @struct AmericanBoundary
+ * @brief The early exercise boundary of the Barone-Adesi-Whaley approximation for a 
+ * strike of 1, the options that are never exercised early have a zero coefficient.
+ */
+/**
+ * @var double AmericanBoundary::exponent
+ * @brief The exponent q of the early exercise premium.
+ */
+/**
+ * @var double AmericanBoundary::boundary
+ * @brief The critical price over the strike, infinite (calls) or zero (puts) if the option is never 
+ * exercised early.
+ */
+/**
+ * @var double AmericanBoundary::coefficient
+ * @brief The coefficient A/K of the early exercise premium.
+ */
+
+/**
+ * @brief Solves the critical price of a strike of 1 with the Newton iterations of Haug.
+ * @param r The interest rate.
+ * @param q The carry cost rate.
+ * @param sigma The implied volatility.
+ * @param T The year fraction.
+ * @param is_call indicator if the option is a call (True) or a put (False).
+ * @param is_future indicator if the underyling is a future (True) or not (False).
+ */
+AmericanBoundary::AmericanBoundary(double r, double q, double sigma, double T, bool is_call, bool is_future)
+{
+    const double cp = is_call ? 1.0 : -1.0;
+    const double b = is_future ? 0.0 : r - q;
+    // A call without dividend yield and a put without interest are worth their european price.
+    if ((is_call and b>=r) or (not is_call and r<=0))
+    {
+        exponent = 0.0;
+        boundary = is_call ? std::numeric_limits<double>::infinity() : 0.0;
+        coefficient = 0.0;
+        return;
+    }
+    const double vol = sigma*std::sqrt(T);
+    const double df = std::exp(-r*T);
+    const double carry = std::exp((b - r)*T);
+    const double M = 2*r/(sigma*sigma);
+    const double N = 2*b/(sigma*sigma);
+    exponent = .5*(-(N - 1) + cp*std::sqrt((N - 1)*(N - 1) + 4*M/(1 - df)));
+
+    // The seed interpolates between the strike and the perpetual boundary.
+    const double q_infinity = .5*(-(N - 1) + cp*std::sqrt((N - 1)*(N - 1) + 4*M));
+    const double s_infinity = 1/(1 - 1/q_infinity);
+    double s = is_call 
+        ? 1 + (s_infinity - 1)*(1 - std::exp(-(b*T + 2*vol)/(s_infinity - 1)))
+        : s_infinity + (1 - s_infinity)*std::exp((b*T - 2*vol)/(1 - s_infinity));
+
+    double d1 = 0.0;
+    for (int i = 0; i<AMERICAN_BOUNDARY_MAX_ITERATIONS; i++)
+    {
+        d1 = (std::log(s) + (b + .5*sigma*sigma)*T)/vol;
+        const double Nd1 = simd::normal_cdf(cp*d1);
+        const double european = cp*(s*carry*Nd1 - df*simd::normal_cdf(cp*(d1 - vol)));
+        const double rhs = european + cp*(1 - carry*Nd1)*s/exponent;
+        const double slope = cp*carry*Nd1*(1 - 1/exponent) 
+            + (cp - carry*simd::normal_pdf(d1)/vol)/exponent;
+        if (std::abs(cp*(s - 1) - rhs)<1e-12){break;}
+        s = (cp + rhs - slope*s)/(cp - slope);
+    }
+    d1 = (std::log(s) + (b + .5*sigma*sigma)*T)/vol;
+    boundary = s;
+    coefficient = cp*(s/exponent)*(1 - carry*simd::normal_cdf(cp*d1));
+};
+
+/**
+ * @struct BaroneAdesiWhaley
+ * @brief The Barone-Adesi-Whaley approximation of an american vanilla option, the 
+ * exercise boundary is solved at construction and reused for every underlying price.
+ */
+/**
+ * @var double BaroneAdesiWhaley::b
+ * @brief The cost of carry, r - q for spot underlyings and 0 for futures.
+ */
+/**
+ * @var AmericanBoundary BaroneAdesiWhaley::normalised
+ * @brief The exercise boundary for a strike of 1.
+ */
+
+/**
+ * @brief The main constructor
+ * @param K The strike price of the option. 
+ * @param r The interest rate.
+ * @param q The carry cost rate. 
+ * @param sigma The implied volatility.
+ * @param T The year fraction. 
+ * @param is_call indicator if the option is a call (True) or a put (False).
+ * @param is_future indicator if the underyling is a future (True) or not (False).
+ * @throw BlackScholesNonPositiveImpliedVolatility
+ * @throw BlackScholesNonPositiveYearFraction
+ */
+BaroneAdesiWhaley::BaroneAdesiWhaley(
+    double K, double r, double q, double sigma, double T, bool is_call, bool is_future): 
+    K_(K), r_(r), q_(q), sigma_(sigma), T_(T), 
+    call_put_flag(is_call ? 1 : -1), future_flag(is_future ? 0 : 1), 
+    b(future_flag*(r - q)), 
+    normalised([&]()
+    {
+        if (not (sigma>0)){throw BlackScholesNonPositiveImpliedVolatility();}
+        if (not (T>0)){throw BlackScholesNonPositiveYearFraction();}
+        return AmericanBoundary(r, q, sigma, T, is_call, is_future);
+    }()){};
+
+/**
+ * @return The critical price above (calls) or below (puts) which the option is exercised.
+ */
+double BaroneAdesiWhaley::critical_price()
+{
+    return K_*normalised.boundary;
+};
+
+/**
+ * @param S The spot/future price of the underlying.
+ * @return The price of the european option.
+ */
+double BaroneAdesiWhaley::european_price(double S)
+{
+    const double vol = sigma_*std::sqrt(T_);
+    const double d1 = (std::log(S/K_) + (b + .5*sigma_*sigma_)*T_)/vol;
+    return call_put_flag*(S*std::exp((b - r_)*T_)*simd::normal_cdf(call_put_flag*d1) 
+        - K_*std::exp(-r_*T_)*simd::normal_cdf(call_put_flag*(d1 - vol)));
+};
+
+/**
+ * @param S The spot/future price of the underlying.
+ * @return The approximated price of the american option.
+ */
+double BaroneAdesiWhaley::price(double S)
+{
+    const double S_star = critical_price();
+    if (call_put_flag*(S - S_star)>=0){return call_put_flag*(S - K_);}
+    if (normalised.coefficient==0){return european_price(S);}
+    return european_price(S) + K_*normalised.coefficient*std::pow(S/S_star, normalised.exponent);
+};
+
+/**
+ * @brief The Peizer-Pratt inversion of the normal distribution used by Leisen-Reimer.
+ * @param z The normal quantile.
+ * @param n The number of steps of the tree.
+ * @return The binomial probability matching N(z).
+ */
+static double peizer_pratt(double z, int n)
+{
+    const double x = z/(n + 1./3 + .1/(n + 1));
+    return .5 + std::copysign(.5*std::sqrt(1 - std::exp(-x*x*(n + 1./6))), z);
+};
+
+/**
+ * @brief The reference price of an american vanilla option, from a Leisen-Reimer 
+ * binomial tree.
+ * @param S The spot/future price of the underlying.
+ * @param K The strike price of the option. 
+ * @param r The interest rate.
+ * @param q The carry cost rate. 
+ * @param sigma The implied volatility.
+ * @param T The year fraction. 
+ * @param is_call indicator if the option is a call (True) or a put (False).
+ * @param is_future indicator if the underyling is a future (True) or not (False).
+ * @param steps The number of steps of the tree, rounded up to an odd number. The error
+ * decreases about as 1/steps for the american options, AMERICAN_REFERENCE_STEPS gives 
+ * prices within a few 1e-3 of the converged values for the usual strikes and expiries.
+ * @return The price of the american option.
+ * @throw BlackScholesNonPositiveImpliedVolatility
+ * @throw BlackScholesNonPositiveYearFraction
+ */
+double american_reference_price(
+    double S, double K, double r, double q, double sigma, double T, 
+    bool is_call, bool is_future, int steps)
+{
+    if (not (sigma>0)){throw BlackScholesNonPositiveImpliedVolatility();}
+    if (not (T>0)){throw BlackScholesNonPositiveYearFraction();}
+    const int n = steps | 1;
+    const double cp = is_call ? 1.0 : -1.0;
+    const double b = is_future ? 0.0 : r - q;
+    const double dt = T/n;
+    const double vol = sigma*std::sqrt(T);
+    const double d1 = (std::log(S/K) + (b + .5*sigma*sigma)*T)/vol;
+    const double p = peizer_pratt(d1 - vol, n);
+    const double growth = std::exp(b*dt);
+    const double u = growth*peizer_pratt(d1, n)/p;
+    const double d = (growth - p*u)/(1 - p);
+    const double discount = std::exp(-r*dt);
+
+    std::vector<double> value(n + 1);
+    for (int i = 0; i<=n; i++)
+    {value[i] = std::max(cp*(S*std::pow(u, i)*std::pow(d, n - i) - K), 0.0);}
+    for (int j = n - 1; j>=0; j--)
+    {
+        double node = S*std::pow(d, j);
+        for (int i = 0; i<=j; i++)
+        {
+            value[i] = std::max(discount*(p*value[i+1] + (1 - p)*value[i]), cp*(node - K));
+            node *= u/d;
+        }
+    }
+    return value[0];
+};
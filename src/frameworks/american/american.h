@@ -0,0 +1,56 @@
+#pragma once 
+#include <iostream>
+#include <cmath>
+#include <vector>
+#include "../../frameworks/blackscholes/blackscholes.h"
+#include "../../math/simd/simd.h"
+
+constexpr int AMERICAN_BOUNDARY_MAX_ITERATIONS = 100;
+constexpr int AMERICAN_REFERENCE_STEPS = 1001;
+
+struct AmericanBoundary
+{
+    double exponent; 
+    double boundary; 
+    double coefficient; 
+    AmericanBoundary(double r, double q, double sigma, double T, bool is_call, bool is_future); 
+    ~AmericanBoundary(){};
+};
+
+struct BaroneAdesiWhaley
+{
+    double K_; 
+    double r_; 
+    double q_; 
+    double sigma_; 
+    double T_; 
+    int call_put_flag; 
+    int future_flag; 
+    double b; 
+    AmericanBoundary normalised; 
+    BaroneAdesiWhaley(
+        double K, 
+        double r, 
+        double q, 
+        double sigma, 
+        double T, 
+        bool is_call, 
+        bool is_future
+    );
+    ~BaroneAdesiWhaley(){};
+    double critical_price(); 
+    double european_price(double S); 
+    double price(double S); 
+};
+
+double american_reference_price(
+    double S, 
+    double K, 
+    double r, 
+    double q, 
+    double sigma, 
+    double T, 
+    bool is_call, 
+    bool is_future, 
+    int steps
+);
@@ -0,0 +1,173 @@
+#include "american_chain.h"
+
+/**
+* @file american_chain.h
+* @brief This file defines the batch Barone-Adesi-Whaley pricer of a chain of american 
+* vanilla options written on the same underlying.
+*
+* The normalised exercise boundaries are cached by (T, r, q, sigma, call/put, future): 
+* the strikes of an expiry sharing a volatility share one Newton solve, and since the 
+* boundaries do not depend on the underlying price a tick only reprices the chain, 
+* simd::WIDTH options at a time. The boundary is a function of the volatility, which is
+* therefore part of the key and compared exactly: a volatility update only reuses the
+* boundaries of the (expiry, volatility) pairs left unchanged, every moved volatility
+* costs a new solve.
+*/
+
+/**
+ * @struct AmericanChain
+ * @brief The cached exercise boundaries and the prices of a chain of american vanilla 
+ * options written on the same underlying price.
+ *
+ * The arrays are padded to a multiple of simd::WIDTH with a call that is never 
+ * exercised early, only the first size() prices are meaningful.
+ * @see BaroneAdesiWhaley
+ */
+/**
+ * @var std::size_t AmericanChain::solves
+ * @brief The number of exercise boundaries solved since the construction.
+ */
+/**
+ * @var std::vector<double> AmericanChain::d1_shift
+ * @brief The terms (b + sigma^2/2)*T - log(K), so that d1 = (log(S) + d1_shift)/vol.
+ */
+/**
+ * @var std::vector<double> AmericanChain::carry
+ * @brief The factors exp((b - r)*T).
+ */
+/**
+ * @var std::vector<double> AmericanChain::boundary
+ * @brief The critical prices S* of the options.
+ */
+/**
+ * @var std::vector<double> AmericanChain::log_boundary
+ * @brief The logs of the critical prices, 0 for the options never exercised early.
+ */
+/**
+ * @var std::vector<double> AmericanChain::coefficient
+ * @brief The coefficients A of the early exercise premiums A*(S/S*)^q.
+ */
+/**
+ * @var std::map AmericanChain::boundaries
+ * @brief The normalised boundaries, by (T, r, q, sigma, is_call, is_future).
+ */
+
+/**
+ * @brief The main constructor, the exercise boundaries are solved once per expiry and 
+ * volatility.
+ * @param K The strike prices of the options.
+ * @param r The interest rates.
+ * @param q The carry cost rates.
+ * @param sigma The implied volatilities.
+ * @param T The year fractions.
+ * @param is_call indicators if the options are calls (True) or puts (False).
+ * @param is_future indicators if the underlyings are futures (True) or not (False).
+ * @throw BlackScholesBatchSizeMismatch
+ * @throw BlackScholesNonPositiveImpliedVolatility
+ * @throw BlackScholesNonPositiveYearFraction
+ */
+AmericanChain::AmericanChain(
+    std::span<const double> K,
+    std::span<const double> r,
+    std::span<const double> q,
+    std::span<const double> sigma,
+    std::span<const double> T,
+    std::span<const bool> is_call,
+    std::span<const bool> is_future):
+    n(K.size()), solves(0), r_(r.begin(), r.end()), q_(q.begin(), q.end()), 
+    T_(T.begin(), T.end()), is_call_(is_call.begin(), is_call.end()), 
+    is_future_(is_future.begin(), is_future.end())
+{
+    if (r.size()!=n or q.size()!=n or sigma.size()!=n or T.size()!=n
+        or is_call.size()!=n or is_future.size()!=n)
+    {throw BlackScholesBatchSizeMismatch();}
+    for (std::size_t i = 0; i<n; i++)
+    {if (not (T[i]>0)){throw BlackScholesNonPositiveYearFraction();}}
+    const std::size_t padded = simd::WIDTH*((n + simd::WIDTH - 1)/simd::WIDTH);
+    for (std::vector<double>* cache: {&K_, &cp, &vol, &d1_shift, &df, &carry, &boundary, 
+        &log_boundary, &coefficient, &exponent, &price})
+    {cache->assign(padded, 0.0);}
+    for (std::size_t i = 0; i<padded; i++)
+    {
+        K_[i] = i<n ? K[i] : 1.0;
+        cp[i] = (i>=n or is_call[i]) ? 1.0 : -1.0;
+        df[i] = i<n ? std::exp(-r[i]*T[i]) : 1.0;
+        carry[i] = 1.0;
+        vol[i] = 1.0;
+        boundary[i] = std::numeric_limits<double>::infinity();
+    }
+    update_volatility(sigma);
+};
+
+/**
+ * @return The number of options in the chain.
+ */
+std::size_t AmericanChain::size()
+{
+    return n;
+};
+
+/**
+ * @brief Replaces the implied volatilities, only the boundaries of the new (expiry, 
+ * volatility) pairs are solved, the others are taken from the cache. The volatilities
+ * are all checked before the chain is modified.
+ * @param sigma The new implied volatilities.
+ * @throw BlackScholesBatchSizeMismatch
+ * @throw BlackScholesNonPositiveImpliedVolatility
+ */
+void AmericanChain::update_volatility(std::span<const double> sigma)
+{
+    if (sigma.size()!=n){throw BlackScholesBatchSizeMismatch();}
+    for (std::size_t i = 0; i<n; i++)
+    {if (not (sigma[i]>0)){throw BlackScholesNonPositiveImpliedVolatility();}}
+    std::map<std::tuple<double, double, double, double, bool, bool>, AmericanBoundary> cache;
+    for (std::size_t i = 0; i<n; i++)
+    {
+        const auto key = std::make_tuple(T_[i], r_[i], q_[i], sigma[i], bool(is_call_[i]), bool(is_future_[i]));
+        auto found = cache.find(key);
+        if (found==cache.end())
+        {
+            auto previous = boundaries.find(key);
+            if (previous!=boundaries.end()){found = cache.emplace(key, previous->second).first;}
+            else 
+            {
+                found = cache.emplace(key, AmericanBoundary(r_[i], q_[i], sigma[i], T_[i], 
+                    is_call_[i], is_future_[i])).first;
+                solves++;
+            }
+        }
+        const AmericanBoundary& normalised = found->second;
+        const double b = is_future_[i] ? 0.0 : r_[i] - q_[i];
+        vol[i] = sigma[i]*std::sqrt(T_[i]);
+        d1_shift[i] = (b + .5*sigma[i]*sigma[i])*T_[i] - std::log(K_[i]);
+        carry[i] = std::exp((b - r_[i])*T_[i]);
+        boundary[i] = K_[i]*normalised.boundary;
+        log_boundary[i] = normalised.coefficient==0 ? 0.0 : std::log(boundary[i]);
+        coefficient[i] = K_[i]*normalised.coefficient;
+        exponent[i] = normalised.exponent;
+    }
+    boundaries = std::move(cache);
+};
+
+/**
+ * @brief Reprices the chain at a new underlying price, the boundaries are reused.
+ * @param S The spot/future price of the underlying.
+ */
+void AmericanChain::update_spot(double S)
+{
+    using namespace simd;
+    const Pack S_ = broadcast(S);
+    const Pack log_S = broadcast(std::log(S));
+    for (std::size_t i = 0; i<price.size(); i += WIDTH)
+    {
+        const Pack K = load(&K_[i]);
+        const Pack cp_ = load(&cp[i]);
+        const Pack vol_ = load(&vol[i]);
+        const Pack d1 = (log_S + load(&d1_shift[i]))/vol_;
+        const Pack european = cp_*(S_*load(&carry[i])*normal_cdf(cp_*d1) 
+            - K*load(&df[i])*normal_cdf(cp_*(d1 - vol_)));
+        const Pack premium = load(&coefficient[i])*exp(load(&exponent[i])*(log_S - load(&log_boundary[i])));
+        const Mask exercise = cp_*(S_ - load(&boundary[i])) >= broadcast(0.0);
+        store(&price[i], select(exercise, cp_*(S_ - K), european + premium));
+    }
+};
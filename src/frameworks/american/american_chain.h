@@ -0,0 +1,45 @@
+#pragma once
+#include <iostream>
+#include <map>
+#include <span>
+#include <tuple>
+#include <vector>
+#include "american.h"
+#include "../../frameworks/blackscholes/blackscholes_batch.h"
+#include "../../math/simd/simd.h"
+
+struct AmericanChain
+{
+    std::size_t n; 
+    std::size_t solves; 
+    std::vector<double> r_; 
+    std::vector<double> q_; 
+    std::vector<double> T_; 
+    std::vector<bool> is_call_; 
+    std::vector<bool> is_future_; 
+    std::vector<double> K_; 
+    std::vector<double> cp; 
+    std::vector<double> vol; 
+    std::vector<double> d1_shift; 
+    std::vector<double> df; 
+    std::vector<double> carry; 
+    std::vector<double> boundary; 
+    std::vector<double> log_boundary; 
+    std::vector<double> coefficient; 
+    std::vector<double> exponent; 
+    std::vector<double> price; 
+    std::map<std::tuple<double, double, double, double, bool, bool>, AmericanBoundary> boundaries; 
+    AmericanChain(
+        std::span<const double> K,
+        std::span<const double> r,
+        std::span<const double> q,
+        std::span<const double> sigma,
+        std::span<const double> T,
+        std::span<const bool> is_call,
+        std::span<const bool> is_future
+    );
+    ~AmericanChain(){};
+    std::size_t size(); 
+    void update_volatility(std::span<const double> sigma); 
+    void update_spot(double S); 
+};
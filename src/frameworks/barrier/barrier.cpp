@@ -0,0 +1,498 @@
+#include "barrier.h"
+
+/** 
+* @file barrier.h
+* @brief This file defines the closed form prices and sensitivities of the continuously 
+* monitored barrier options of every BarrierType, without rebate.
+* 
+* The single barrier prices are the Reiner-Rubinstein combinations of four terms A, B, C, 
+* D, the double barrier knock out prices are the Ikeda-Kunitomo series of reflected 
+* terms, summed over at least BARRIER_SERIES_TERMS reflections on each side and until the
+* price, delta, gamma and vega of the next reflections are below BARRIER_SERIES_TOLERANCE 
+* of the underlying price, at most BARRIER_SERIES_MAX_TERMS, and the knock in 
+* prices follow from the in/out parity with the vanilla term A. Every term has the form 
+* w*S^p*N(z) with z affine in log(S), so the delta and gamma are analytic, and the vega 
+* adds up the derivatives of the terms in sigma: z = x/v + v/2 or z = x/v - v/2 with x 
+* independent of sigma, and w depends on it through the exponent of the reflections. 
+* Every price solves the Black Scholes equation inside its barriers, which gives the 
+* theta from the price, delta and gamma.
+* 
+* The batch shares the market data of one expiry: the term A is evaluated once per 
+* distinct strike, the terms B and D once per distinct barrier level, and only the term 
+* C depends on both.
+* 
+* References :  
+* - "Breaking down the barriers", Reiner, Rubinstein, 1991.
+* - "Pricing options with curved boundaries", Ikeda, Kunitomo, 1992.
+* - "The complete guide to option pricing formulas", Haug, 2007, 4.17.
+*/
+
+/** 
+ * @class BarrierInvalidLevels
+ * @brief Definition of the invalid barrier levels error.
+ */
+/** 
+ * @brief Definition of what() virtual std::exception function.
+ * @return The explication of the error.
+ */
+const char * BarrierInvalidLevels::what() const throw(){
+    return "A down barrier needs a positive lower level, an up barrier a positive \
+    upper level and a double barrier a positive lower level below the upper level";
+};
+
+/**
+ * @struct BarrierOptionBatch
+ * @brief A batch of european barrier options written on the same underlying and expiry.
+ */
+/**
+ * @var double BarrierOptionBatch::b
+ * @brief The cost of carry, 0 for the options on futures.
+ */
+/**
+ * @var std::vector<double> BarrierOptionBatch::strikes
+ * @brief The distinct strikes of the batch, strike_index maps the options to them.
+ */
+/**
+ * @var std::vector<double> BarrierOptionBatch::log_strikes
+ * @brief The logs of the distinct strikes.
+ */
+/**
+ * @var std::vector<double> BarrierOptionBatch::levels
+ * @brief The distinct single barrier levels of the batch, level_index maps the single 
+ * barrier options to them.
+ */
+/**
+ * @var std::vector<double> BarrierOptionBatch::log_levels
+ * @brief The logs of the distinct single barrier levels.
+ */
+/**
+ * @var std::vector<double> BarrierOptionBatch::coefficients
+ * @brief Four weights per option: the weights of the terms A, B, C, D for the single 
+ * barriers, the weights of the vanilla term A and of the knock out series for the 
+ * double barriers.
+ */
+/**
+ * @var std::vector<std::size_t> BarrierOptionBatch::double_options
+ * @brief The indices of the double barrier options, whose strikes, call/put flags and 
+ * levels are gathered in the padded arrays double_K, double_cp, double_lower and 
+ * double_upper.
+ */
+/**
+ * @var std::vector<double> BarrierOptionBatch::arguments
+ * @brief The arguments of the normal distribution of the terms: x1 and x1 - v by strike, 
+ * x2, x2 - v, y2 and y2 - v by level, y1 and y1 - v by option (v = sigma*sqrt(T)).
+ */
+/**
+ * @var std::vector<double> BarrierOptionBatch::slopes
+ * @brief The derivatives in sigma of the arguments.
+ */
+/**
+ * @var std::vector<double> BarrierOptionBatch::reflection
+ * @brief The terms (H/S)^(2*mu) by level.
+ */
+
+/**
+ * @brief The main constructor, the arrays are copied. The single down barriers read their 
+ * level in lower, the single up barriers in upper, and the double barriers in both.
+ * @param S The spot/future price of the underlying.
+ * @param r The interest rate.
+ * @param q The carry cost rate.
+ * @param sigma The volatility.
+ * @param T The year fraction of the expiry.
+ * @param is_future indicator if the underlying is a future (True) or not (False).
+ * @param K The strike prices of the options.
+ * @param is_call indicators if the options are calls (True) or puts (False).
+ * @param barrier The barrier types of the options.
+ * @param lower The down barrier levels.
+ * @param upper The up barrier levels.
+ * @throw BlackScholesBatchSizeMismatch
+ * @throw BlackScholesNonPositiveImpliedVolatility
+ * @throw BlackScholesNonPositiveYearFraction
+ * @throw BarrierInvalidLevels
+ */
+BarrierOptionBatch::BarrierOptionBatch(
+    double S, 
+    double r, 
+    double q, 
+    double sigma, 
+    double T, 
+    bool is_future, 
+    std::span<const double> K, 
+    std::span<const bool> is_call, 
+    std::span<const BarrierType> barrier, 
+    std::span<const double> lower, 
+    std::span<const double> upper): 
+    n(K.size()), S_(S), r_(r), q_(q), sigma_(sigma), T_(T), is_future_(is_future), 
+    b(is_future ? 0.0 : r - q), K_(K.begin(), K.end()), cp(K.size()), 
+    barrier_(barrier.begin(), barrier.end()), lower_(lower.begin(), lower.end()), 
+    upper_(upper.begin(), upper.end()), strike_index(K.size()), level_index(K.size()), 
+    coefficients(4*K.size(), 0.0)
+{
+    if (is_call.size()!=n or barrier.size()!=n or lower.size()!=n or upper.size()!=n)
+    {throw BlackScholesBatchSizeMismatch();}
+    if (not (sigma>0)){throw BlackScholesNonPositiveImpliedVolatility();}
+    if (not (T>0)){throw BlackScholesNonPositiveYearFraction();}
+    // Reiner-Rubinstein knock in weights of A, B, C, D by direction, type and strike 
+    // above or below the barrier, the knock out weights follow from the parity.
+    static const double knock_in[2][2][2][4] = {
+        {{{0, 0, 1, 0}, {1, -1, 0, 1}}, {{0, 1, -1, 1}, {1, 0, 0, 0}}}, 
+        {{{1, 0, 0, 0}, {0, 1, -1, 1}}, {{1, -1, 0, 1}, {0, 0, 1, 0}}}};
+    std::map<double, std::size_t> strike_map;
+    std::map<double, std::size_t> level_map;
+    for (std::size_t i = 0; i<n; i++)
+    {
+        cp[i] = is_call[i] ? 1.0 : -1.0;
+        strike_index[i] = strike_map.emplace(K[i], strike_map.size()).first->second;
+        double* weights = &coefficients[4*i];
+        if (barrier[i]==DOUBLE_KNOCK_IN or barrier[i]==DOUBLE_KNOCK_OUT)
+        {
+            if (not (lower[i]>0) or not (lower[i]<upper[i])){throw BarrierInvalidLevels();}
+            const bool breached = S<=lower[i] or S>=upper[i];
+            const bool is_in = barrier[i]==DOUBLE_KNOCK_IN;
+            weights[0] = is_in ? 1.0 : 0.0;
+            weights[1] = breached ? 0.0 : (is_in ? -1.0 : 1.0);
+            double_options.push_back(i);
+            // Breached options keep a valid barrier corridor so that the series stays finite.
+            double_K.push_back(breached ? S : K[i]);
+            double_cp.push_back(cp[i]);
+            double_lower.push_back(breached ? .5*S : lower[i]);
+            double_upper.push_back(breached ? 2*S : upper[i]);
+            continue;
+        }
+        const bool is_down = barrier[i]==DOWN_AND_IN or barrier[i]==DOWN_AND_OUT;
+        const bool is_in = barrier[i]==DOWN_AND_IN or barrier[i]==UP_AND_IN;
+        const double H = is_down ? lower[i] : upper[i];
+        if (not (H>0) or not std::isfinite(H)){throw BarrierInvalidLevels();}
+        level_index[i] = level_map.emplace(H, level_map.size()).first->second;
+        const bool breached = is_down ? S<=H : S>=H;
+        const double* in = knock_in[is_down ? 0 : 1][is_call[i] ? 0 : 1][K[i]>=H ? 0 : 1];
+        for (int term = 0; term<4; term++)
+        {
+            const double in_weight = breached ? (term==0 ? 1.0 : 0.0) : in[term];
+            weights[term] = is_in ? in_weight : (term==0 ? 1.0 : 0.0) - in_weight;
+        }
+    }
+    strikes.resize(strike_map.size());
+    log_strikes.resize(strike_map.size());
+    for (const auto& [strike, index]: strike_map){strikes[index] = strike; log_strikes[index] = std::log(strike);}
+    levels.resize(level_map.size());
+    log_levels.resize(level_map.size());
+    for (const auto& [level, index]: level_map){levels[index] = level; log_levels[index] = std::log(level);}
+    while (double_K.size()%simd::WIDTH!=0)
+    {
+        double_K.push_back(S);
+        double_cp.push_back(1.0);
+        double_lower.push_back(.5*S);
+        double_upper.push_back(2*S);
+    }
+    const std::size_t count = 2*strikes.size() + 4*levels.size() + 2*n;
+    const std::size_t padded = simd::WIDTH*((count + simd::WIDTH - 1)/simd::WIDTH);
+    arguments.assign(padded, 0.0);
+    slopes.assign(padded, 0.0);
+    cdf.assign(padded, 0.0);
+    pdf.assign(padded, 0.0);
+    reflection.assign(levels.size(), 0.0);
+    double_values.assign(4*double_K.size(), 0.0);
+};
+
+/**
+ * @return The number of options in the batch.
+ */
+std::size_t BarrierOptionBatch::size()
+{
+    return n;
+};
+
+/**
+ * @brief Adds a term value*N(z) and its first and second derivatives in S and first 
+ * derivative in sigma, where value is proportional to S^p and z is affine in log(S).
+ * @param value The weight of the term, including its S^p factor.
+ * @param p The power of S in the weight.
+ * @param z The argument of the normal distribution.
+ * @param beta The derivative of z in log(S).
+ * @param cdf The normal cumulative distribution at z.
+ * @param pdf The normal density at z.
+ * @param S The underlying price.
+ * @param value_slope The derivative of log(value) in sigma.
+ * @param z_slope The derivative of z in sigma.
+ * @param out The price, delta, gamma and vega accumulators.
+ */
+template <typename V>
+static void accumulate_term(V value, double p, V z, double beta, V cdf, V pdf, double S, 
+    V value_slope, V z_slope, V* out)
+{
+    out[0] = out[0] + value*cdf;
+    out[1] = out[1] + value*(p*cdf + beta*pdf)/S;
+    out[2] = out[2] + value*(p*(p - 1)*cdf + (2*p - 1)*beta*pdf - beta*beta*z*pdf)/(S*S);
+    out[3] = out[3] + value*(value_slope*cdf + z_slope*pdf);
+};
+
+/**
+ * @brief Adds the term value*N(sign*z) from the cached distribution at z.
+ * @param value The weight of the term, including its S^p factor.
+ * @param p The power of S in the weight.
+ * @param sign The sign applied to the argument.
+ * @param batch The batch holding the cached arguments and distributions.
+ * @param index The index of the argument in the cache.
+ * @param beta The derivative of the unsigned argument in log(S).
+ * @param value_slope The derivative of log(value) in sigma.
+ * @param out The price, delta, gamma and vega accumulators.
+ */
+static void add_term(double value, double p, double sign, BarrierOptionBatch& batch, 
+    std::size_t index, double beta, double value_slope, double* out)
+{
+    if (value==0){return;}
+    const double cdf = sign>0 ? batch.cdf[index] : 1 - batch.cdf[index];
+    accumulate_term(value, p, sign*batch.arguments[index], sign*beta, cdf, batch.pdf[index], 
+        batch.S_, value_slope, sign*batch.slopes[index], out);
+};
+
+/**
+ * @brief Adds the term value*N(z), evaluating the distribution at z, or value*(N(z) - 1) 
+ * = -value*N(-z) for the complement. The terms come in pairs of opposite values, where 
+ * the complement keeps the precision of the large z without changing the sum.
+ * @param value The weights of the term, including their S^p factor.
+ * @param p The power of S in the weights.
+ * @param z The arguments of the normal distribution.
+ * @param beta The derivative of z in log(S).
+ * @param S The underlying price.
+ * @param value_slope The derivatives of log(value) in sigma.
+ * @param z_slope The derivatives of z in sigma.
+ * @param complement Indicator if the distribution is replaced by N(z) - 1.
+ * @param out The price, delta, gamma and vega accumulators.
+ */
+static void add_term(simd::Pack value, double p, simd::Pack z, double beta, double S, 
+    simd::Pack value_slope, simd::Pack z_slope, bool complement, simd::Pack* out)
+{
+    simd::Pack pdf;
+    simd::Pack cdf;
+    simd::normal_pdf_cdf(complement ? -z : z, pdf, cdf);
+    if (complement){cdf = -cdf;}
+    accumulate_term(value, p, z, beta, cdf, pdf, S, value_slope, z_slope, out);
+};
+
+/**
+ * @brief The Ikeda-Kunitomo double knock out values of simd::WIDTH options with flat 
+ * barriers. The payoff is integrated over the strike range inside the corridor, 
+ * [max(K, L), U] for the calls and [L, min(K, U)] for the puts. The number of reflections
+ * grows as sigma*sqrt(T)/log(U/L), it is shared by the lanes of the block.
+ * @param batch The batch.
+ * @param sigma The volatility.
+ * @param T The year fraction.
+ * @param k The index of the first option of the block in the double barrier arrays.
+ * @param out The price, delta, gamma and vega lanes.
+ */
+static void double_knock_out_block(BarrierOptionBatch& batch, double sigma, double T, 
+    std::size_t k, simd::Pack* out)
+{
+    using namespace simd;
+    const double S = batch.S_;
+    const double log_S = std::log(S);
+    const double sqrt_T = std::sqrt(T);
+    const double v = sigma*sqrt_T;
+    const double m = 2*batch.b/(sigma*sigma) + 1;
+    const double m_slope = -4*batch.b/(sigma*sigma*sigma);
+    const double drift = (batch.b + .5*sigma*sigma)*T;
+    const double g = std::exp((batch.b - batch.r_)*T);
+    const double df = std::exp(-batch.r_*T);
+    const Pack K = load(&batch.double_K[k]);
+    const Pack cp = load(&batch.double_cp[k]);
+    const Pack L = load(&batch.double_lower[k]);
+    const Pack U = load(&batch.double_upper[k]);
+    const Mask is_call = cp>broadcast(0.0);
+    const Pack a = select(is_call, max(K, L), L);
+    const Pack c = max(a, select(is_call, U, min(K, U)));
+    const Pack log_a = log(a);
+    const Pack log_c = log(c);
+    const Pack log_L = log(L);
+    const Pack log_U = log(U);
+    const Pack log_ratio = log_U - log_L;
+    const Pack forward = cp*g*S;
+    const Pack strike = cp*df*K;
+    // The reflections j and -j of a corridor of width log(U/L) shift the arguments by about
+    // 2*j*log(U/L)/v, the narrow corridors need many of them before the terms vanish. The 
+    // weights of the direct terms grow with j>0 and those of the images with j<0, where 
+    // both sides of the corridor have N(z) close to 1, the complements keep their 
+    // difference exact.
+    const auto add_reflection = [&](int j, Pack* terms)
+    {
+        const Pack direct = log_S + 2.0*j*log_ratio + drift;
+        const Pack image_log = (j + 1.0)*log_L - 1.0*j*log_U - log_S;
+        const Pack image = 2.0*image_log + log_S + drift;
+        const Pack direct_S = forward*exp(j*m*log_ratio);
+        const Pack direct_K = strike*exp(j*(m - 2)*log_ratio);
+        const Pack image_S = forward*exp(m*image_log);
+        const Pack image_K = strike*exp((m - 2)*image_log);
+        const Pack direct_slope = broadcast(j*m_slope)*log_ratio;
+        const Pack image_slope = m_slope*image_log;
+        for (int side = 0; side<2; side++)
+        {
+            const Pack log_z = side==0 ? log_a : log_c;
+            const double sign = side==0 ? 1.0 : -1.0;
+            const Pack d = (direct - log_z)/v;
+            const Pack e = (image - log_z)/v;
+            const Pack d_slope = -d/sigma;
+            const Pack e_slope = -e/sigma;
+            add_term(sign*direct_S, 1, d, 1/v, S, direct_slope, d_slope + sqrt_T, j>0, terms);
+            add_term(-sign*image_S, 1 - m, e, -1/v, S, image_slope, e_slope + sqrt_T, j<0, terms);
+            add_term(-sign*direct_K, 0, d - v, 1/v, S, direct_slope, d_slope, j>0, terms);
+            add_term(sign*image_K, 2 - m, e - v, -1/v, S, image_slope, e_slope, j<0, terms);
+        }
+    };
+    out[0] = out[1] = out[2] = out[3] = broadcast(0.0);
+    add_reflection(0, out);
+    for (int j = 1; j<=BARRIER_SERIES_MAX_TERMS; j++)
+    {
+        Pack size = broadcast(0.0);
+        for (int reflection: {j, -j})
+        {
+            Pack terms[4] = {broadcast(0.0), broadcast(0.0), broadcast(0.0), broadcast(0.0)};
+            add_reflection(reflection, terms);
+            for (int i = 0; i<4; i++){out[i] = out[i] + terms[i];}
+            size = size + abs(terms[0]) + S*abs(terms[1]) + S*S*abs(terms[2]) + abs(terms[3]);
+        }
+        if (j>=BARRIER_SERIES_TERMS and not any(size>broadcast(BARRIER_SERIES_TOLERANCE*S))){break;}
+    }
+};
+
+/**
+ * @brief The prices, deltas, gammas and vegas of the batch at a given volatility and year 
+ * fraction.
+ * @param batch The batch.
+ * @param sigma The volatility.
+ * @param T The year fraction.
+ * @param values The output price, delta, gamma and vega of each option, interleaved.
+ */
+static void barrier_values(BarrierOptionBatch& batch, double sigma, double T, std::vector<double>& values)
+{
+    using namespace simd;
+    const std::size_t n = batch.n;
+    const std::size_t n_strikes = batch.strikes.size();
+    const std::size_t n_levels = batch.levels.size();
+    const double S = batch.S_;
+    const double log_S = std::log(S);
+    const double sqrt_T = std::sqrt(T);
+    const double v = sigma*sqrt_T;
+    const double mu = (batch.b - .5*sigma*sigma)/(sigma*sigma);
+    const double mu_slope = -2*batch.b/(sigma*sigma*sigma);
+    const double shift = (1 + mu)*v;
+    const double g = std::exp((batch.b - batch.r_)*T);
+    const double df = std::exp(-batch.r_*T);
+
+    // Arguments by strike, by level then by option. They come in pairs z = x/v + v/2 and 
+    // z - v, whose derivatives in sigma are sqrt(T) - z/sigma and -z/sigma.
+    std::vector<double>& z = batch.arguments;
+    std::vector<double>& z_slope = batch.slopes;
+    const std::size_t by_level = 2*n_strikes;
+    const std::size_t by_option = by_level + 4*n_levels;
+    for (std::size_t s = 0; s<n_strikes; s++)
+    {
+        z[s] = (log_S - batch.log_strikes[s])/v + shift;
+        z[n_strikes + s] = z[s] - v;
+        z_slope[s] = sqrt_T - z[s]/sigma;
+        z_slope[n_strikes + s] = -z[s]/sigma;
+    }
+    for (std::size_t l = 0; l<n_levels; l++)
+    {
+        const double log_H = batch.log_levels[l];
+        z[by_level + l] = (log_S - log_H)/v + shift;
+        z[by_level + n_levels + l] = z[by_level + l] - v;
+        z[by_level + 2*n_levels + l] = (log_H - log_S)/v + shift;
+        z[by_level + 3*n_levels + l] = z[by_level + 2*n_levels + l] - v;
+        z_slope[by_level + l] = sqrt_T - z[by_level + l]/sigma;
+        z_slope[by_level + n_levels + l] = -z[by_level + l]/sigma;
+        z_slope[by_level + 2*n_levels + l] = sqrt_T - z[by_level + 2*n_levels + l]/sigma;
+        z_slope[by_level + 3*n_levels + l] = -z[by_level + 2*n_levels + l]/sigma;
+        batch.reflection[l] = std::pow(batch.levels[l]/S, 2*mu);
+    }
+    for (std::size_t i = 0; i<n; i++)
+    {
+        const bool is_double = batch.barrier_[i]==DOUBLE_KNOCK_IN or batch.barrier_[i]==DOUBLE_KNOCK_OUT;
+        const double log_H = is_double ? log_S : batch.log_levels[batch.level_index[i]];
+        z[by_option + i] = (2*log_H - log_S - batch.log_strikes[batch.strike_index[i]])/v + shift;
+        z[by_option + n + i] = z[by_option + i] - v;
+        z_slope[by_option + i] = sqrt_T - z[by_option + i]/sigma;
+        z_slope[by_option + n + i] = -z[by_option + i]/sigma;
+    }
+    for (std::size_t k = 0; k<z.size(); k += WIDTH)
+    {
+        Pack density;
+        Pack distribution;
+        normal_pdf_cdf(load(&z[k]), density, distribution);
+        store(&batch.pdf[k], density);
+        store(&batch.cdf[k], distribution);
+    }
+
+    const std::size_t n_double = batch.double_K.size();
+    for (std::size_t k = 0; k<n_double; k += WIDTH)
+    {
+        Pack out[4];
+        double_knock_out_block(batch, sigma, T, k, out);
+        for (int m = 0; m<4; m++){store(&batch.double_values[m*n_double + k], out[m]);}
+    }
+
+    values.assign(4*n, 0.0);
+    std::size_t double_count = 0;
+    for (std::size_t i = 0; i<n; i++)
+    {
+        double* out = &values[4*i];
+        const double* weights = &batch.coefficients[4*i];
+        const double phi = batch.cp[i];
+        const double K = batch.K_[i];
+        const std::size_t s = batch.strike_index[i];
+        add_term(weights[0]*phi*g*S, 1, phi, batch, s, 1/v, 0.0, out);
+        add_term(-weights[0]*phi*K*df, 0, phi, batch, n_strikes + s, 1/v, 0.0, out);
+        const BarrierType type = batch.barrier_[i];
+        if (type==DOUBLE_KNOCK_IN or type==DOUBLE_KNOCK_OUT)
+        {
+            for (int m = 0; m<4; m++){out[m] += weights[1]*batch.double_values[m*n_double + double_count];}
+            double_count++;
+            continue;
+        }
+        const std::size_t l = batch.level_index[i];
+        const double eta = (type==DOWN_AND_IN or type==DOWN_AND_OUT) ? 1.0 : -1.0;
+        const double ratio = batch.levels[l]/S;
+        const double C_S = phi*g*S*batch.reflection[l]*ratio*ratio;
+        const double C_K = -phi*K*df*batch.reflection[l];
+        // The reflection (H/S)^(2*mu) carries the volatility of the weights of C and D.
+        const double C_slope = 2*(batch.log_levels[l] - log_S)*mu_slope;
+        add_term(weights[1]*phi*g*S, 1, phi, batch, by_level + l, 1/v, 0.0, out);
+        add_term(-weights[1]*phi*K*df, 0, phi, batch, by_level + n_levels + l, 1/v, 0.0, out);
+        add_term(weights[2]*C_S, -1 - 2*mu, eta, batch, by_option + i, -1/v, C_slope, out);
+        add_term(weights[2]*C_K, -2*mu, eta, batch, by_option + n + i, -1/v, C_slope, out);
+        add_term(weights[3]*C_S, -1 - 2*mu, eta, batch, by_level + 2*n_levels + l, -1/v, C_slope, out);
+        add_term(weights[3]*C_K, -2*mu, eta, batch, by_level + 3*n_levels + l, -1/v, C_slope, out);
+    }
+};
+
+/**
+ * @brief Evaluates the selected price and sensitivities of every option of the batch. 
+ * The PRICE, DELTA, GAMMA and VEGA are analytic, the THETA follows from the Black 
+ * Scholes equation, theta = r*V - b*S*delta - sigma^2*S^2*gamma/2, the other flags are 
+ * not supported and their arrays are left untouched.
+ * @param result The output arrays, each selected array must have the batch size.
+ * @param greeks The BlackScholesGreek flags to evaluate.
+ * @throw BlackScholesBatchSizeMismatch
+ */
+void BarrierOptionBatch::evaluate(BlackScholesBatchResult& result, unsigned int greeks)
+{
+    greeks &= PRICE | DELTA | GAMMA | THETA | VEGA;
+    for (int g = 0; g<BLACK_SCHOLES_GREEK_COUNT; g++)
+    {
+        if ((greeks & (1u << g)) and result.output(g).size()!=n)
+        {throw BlackScholesBatchSizeMismatch();}
+    }
+    if (greeks==0){return;}
+    std::vector<double> values;
+    barrier_values(*this, sigma_, T_, values);
+    for (std::size_t i = 0; i<n; i++)
+    {
+        const double* value = &values[4*i];
+        if (greeks & PRICE){result.price[i] = value[0];}
+        if (greeks & DELTA){result.delta[i] = value[1];}
+        if (greeks & GAMMA){result.gamma[i] = value[2];}
+        if (greeks & VEGA){result.vega[i] = value[3];}
+        if (greeks & THETA)
+        {result.theta[i] = r_*value[0] - b*S_*value[1] - .5*sigma_*sigma_*S_*S_*value[2];}
+    }
+};
@@ -0,0 +1,68 @@
+#pragma once 
+#include <iostream>
+#include <cmath>
+#include <map>
+#include <span>
+#include <vector>
+#include "../../datastructure/instruments/option/option.h"
+#include "../../frameworks/blackscholes/blackscholes.h"
+#include "../../frameworks/blackscholes/blackscholes_batch.h"
+#include "../../math/simd/simd.h"
+
+class BarrierInvalidLevels: public std::exception 
+{public: const char * what() const throw();};
+
+constexpr int BARRIER_SERIES_TERMS = 5;
+constexpr int BARRIER_SERIES_MAX_TERMS = 1000;
+constexpr double BARRIER_SERIES_TOLERANCE = 1e-16;
+
+struct BarrierOptionBatch
+{
+    std::size_t n; 
+    double S_; 
+    double r_; 
+    double q_; 
+    double sigma_; 
+    double T_; 
+    bool is_future_; 
+    double b; 
+    std::vector<double> K_; 
+    std::vector<double> cp; 
+    std::vector<BarrierType> barrier_; 
+    std::vector<double> lower_; 
+    std::vector<double> upper_; 
+    std::vector<double> strikes; 
+    std::vector<double> log_strikes; 
+    std::vector<std::size_t> strike_index; 
+    std::vector<double> levels; 
+    std::vector<double> log_levels; 
+    std::vector<std::size_t> level_index; 
+    std::vector<double> coefficients; 
+    std::vector<std::size_t> double_options; 
+    std::vector<double> double_K; 
+    std::vector<double> double_cp; 
+    std::vector<double> double_lower; 
+    std::vector<double> double_upper; 
+    std::vector<double> arguments; 
+    std::vector<double> slopes; 
+    std::vector<double> cdf; 
+    std::vector<double> pdf; 
+    std::vector<double> reflection; 
+    std::vector<double> double_values; 
+    BarrierOptionBatch(
+        double S, 
+        double r, 
+        double q, 
+        double sigma, 
+        double T, 
+        bool is_future, 
+        std::span<const double> K, 
+        std::span<const bool> is_call, 
+        std::span<const BarrierType> barrier, 
+        std::span<const double> lower, 
+        std::span<const double> upper
+    );
+    ~BarrierOptionBatch(){};
+    std::size_t size(); 
+    void evaluate(BlackScholesBatchResult& result, unsigned int greeks); 
+};
@@ -1,407 +1,566 @@
-#include "blackscholes.h"
-
-/** 
-* @file blackscholes.h
-* @brief This file defines the framework for the Black Scholes model. 
-* 
-* References :  
-* - "The Pricing of Options and Corporate Liabilities", Black, Scholes, 1972. 
-* - "The pricing of commodity contracts", Black, 1876
-*/
-
-/** 
- * @class BlackScholesNonPositiveYearFraction
- * @brief Definition of the mismatch error when the year fraction is not positive. 
- * 
- */
-
-/** 
- * @brief Definition of what() virtual std::exception function.
- * @return The explication of the error.
- */
-const char * BlackScholesNonPositiveYearFraction::what() const throw(){
-    return "The year fraction cannot be negative or equal to zero.";
-};
-
-/** 
- * @class BlackScholesNonPositiveImpliedVolatility
- * @brief Definition of the mismatch error when the implied volatility is not positive. 
- * 
- */
-/** 
- * @brief Definition of what() virtual std::exception function.
- * @return The explication of the error.
- */
-const char * BlackScholesNonPositiveImpliedVolatility::what() const throw(){
-    return "The implied volatility cannot be negative or equal to zero.";
-};
-
-/** 
- * @struct BlackScholesClosedForm
- * @brief Used to calculate the Black Scholes analytical formula for euopean vanilla options.
- * 
- */
-
- /**
- * @var double BlackScholesClosedForm::S_
- * @brief The spot/future price of the underlying.
- */
-
- /**
- * @var double BlackScholesClosedForm::K_
- * @brief The strike price of the option. 
- */
-
- /**
- * @var double BlackScholesClosedForm::r_
- * @brief The interest rate.
- */
-
-/**
- * @var double BlackScholesClosedForm::q_
- * @brief The carry cost rate. 
- */
-
-/**
- * @var double BlackScholesClosedForm::sigma_
- * @brief The implied volatility 
- */
-
-/**
- * @var double BlackScholesClosedForm::T_
- * @brief The year fraction. 
- */
-
-/**
- * @var double BlackScholesClosedForm::call_put_flag
- * @brief 1 if the option is a call, -1 if it is a put. 
- */
-
-/**
- * @var double BlackScholesClosedForm::future_flag
- * @brief 0 if the underyling is a future, 1 if not. 
- */
-
-/**
- * @var double BlackScholesClosedForm::mu
- * @brief The underlying drift. 
- */
-
-/**
- * @var double BlackScholesClosedForm::df
- * @brief The discount factor value.
- */
-
-/**
- * @var double BlackScholesClosedForm::d1
- * @brief The d1 values, with respect of the Black scholes formula. 
- */
-/**
- * @var double BlackScholesClosedForm::d2
- * @brief The d2 values, with respect of the Black scholes formula. 
- */
-
-/**
- * @var double BlackScholesClosedForm::nd2
- * @brief The standard normal pdf value of d2.
- */
-
-/**
- * @var double BlackScholesClosedForm::nd1
- * @brief The standard normal pdf value of d1.
- */
-
-/**
- * @var double BlackScholesClosedForm::Nd2
- * @brief The standard normal cdf value of d2.
- */
-
-/**
- * @var double BlackScholesClosedForm::Nd1
- * @brief The standard normal cdf value of d1.
- */
-
- /** 
- * @brief The main constructor
- * @param S The spot/future price of the underlying.
- * @param K The strike price of the option. 
- * @param r The interest rate.
- * @param q The carry cost rate. 
- * @param sigma The implied volatility.
- * @param T The year fraction. 
- * @param is_call indicator if the option is a call (True) or a put (False).
- * @param is_future indicator if the underyling is a future (True) or not (False).
- * @throw BlackScholesNonPositiveImpliedVolatility
- * @throw BlackScholesNonPositiveYearFraction
- */
- BlackScholesClosedForm::BlackScholesClosedForm(
-    double S, double K, double r, double q, 
-    double sigma, double T, bool is_call, bool is_future): 
-    S_(S), K_(K), r_(r), q_(q), sigma_(sigma), T_(T),
-    future_flag(set_future_flag(is_future)),
-    call_put_flag(set_call_put_flag(is_call)), 
-    mu(compute_mu()), df(compute_df()),F(compute_F()), 
-    d1(compute_d1()), d2(compute_d2()), nd1(compute_nd1()),
-    nd2(compute_nd2()), Nd1(compute_Nd1()), Nd2(compute_Nd2())
-{
-    if (sigma_<=0){throw BlackScholesNonPositiveImpliedVolatility();}
-    if (T_<=0){throw BlackScholesNonPositiveYearFraction();}
-};
-
-/**
- * @param is_future the future indicator. 
- * @return return the future flag. 
- */
-int BlackScholesClosedForm::set_future_flag(bool is_future)
-{
-    if (is_future){return 0;}
-    else{return 1;}
-};
-
-/**
- * @param is_call the call/put indicator. 
- * @return return the call/put flag. 
- */
-int BlackScholesClosedForm::set_call_put_flag(bool is_call)
-{
-    if (is_call){return 1;}
-    else{return -1;}
-};
-
-/**
- * @return return the discount factor
- */
-double BlackScholesClosedForm::compute_df()
-{
-    return exp(-r_*T_);
-};
-
-/**
- * @return return the underlying's drift.
- */
-double BlackScholesClosedForm::compute_mu()
-{
-    return future_flag*(r_-q_);
-};
-
-/**
- * @return return the corresponding future price.
- */
-double BlackScholesClosedForm::compute_F()
-{
-    return S_*exp(mu*T_);
-};
-
-/**
- * @return return the d1 value.
- */
-double BlackScholesClosedForm::compute_d1()
-{
-    return (log(F/K_) + T_*.5*sigma_*sigma_)/(sigma_*sqrt(T_));
-};
-
-/**
- * @return return the d2 value.
- */
-double BlackScholesClosedForm::compute_d2()
-{
-    return d1 - sigma_*sqrt(T_);
-};
-
-/**
- * @return return the standard normal pdf of d1.
- */
-double BlackScholesClosedForm::compute_nd1()
-{
-    NormalDistribution stdnorm = NormalDistribution();
-    return stdnorm.pdf(d1);
-};
-
-/**
- * @return return the standard normal pdf of d2.
- */
-double BlackScholesClosedForm::compute_nd2()
-{
-    NormalDistribution stdnorm = NormalDistribution();
-    return stdnorm.pdf(d2);
-};
-
-/**
- * @return return the standard normal cdf of d1.
- */
-double BlackScholesClosedForm::compute_Nd1()
-{
-    NormalDistribution stdnorm = NormalDistribution();
-    return stdnorm.cdf(call_put_flag*d1);
-};
-
-/**
- * @return return the standard normal cdf of d2.
- */
-double BlackScholesClosedForm::compute_Nd2()
-{
-    NormalDistribution stdnorm = NormalDistribution();
-    return stdnorm.cdf(call_put_flag*d2);
-};
-
-/**
- * @return compute the european vanilla option's price.
- */
-double BlackScholesClosedForm::price()
-{
-    return df*call_put_flag*(F*Nd1 - K_*Nd2);
-};
-
-/**
- * @return compute the european vanilla option's delta.
- */
-double BlackScholesClosedForm::delta()
-{
-    return df*call_put_flag*exp(mu*T_)*Nd1;
-};
-
-/**
- * @return compute the european vanilla option's gamma.
- */
-double BlackScholesClosedForm::gamma()
-{
-    double drift = exp(mu*T_);
-    return df*drift*drift*nd1/(F*sigma_*sqrt(T_));
-};
-
-/**
- * @return compute the european vanilla option's theta.
- */
-double BlackScholesClosedForm::theta()
-{
-    double term1 = -F*df*nd1*sigma_/(2*sqrt(T_));
-    double term2 = -call_put_flag*r_*K_*df*Nd2; 
-    double term3 = call_put_flag*(r_-mu)*F*df*Nd1;
-    return term1+term2+term3;
-};
-
-/**
- * @return compute the european vanilla option's vega.
- */
-double BlackScholesClosedForm::vega()
-{
-    return F*df*nd1*sqrt(T_);
-};
-
-/**
- * @return compute the european vanilla option's rho.
- */
-double BlackScholesClosedForm::rho()
-{
-    if (future_flag == 0){
-        return -T_*df*price();
-    }
-    else{
-        return call_put_flag*K_*T_*Nd2*df;
-    };
-};
-
-/**
- * @return compute the european vanilla option's epsilon.
- */
-double BlackScholesClosedForm::epsilon()
-{
-    if (future_flag == 0){
-        return 0.0;
-    }
-    else{
-        return -call_put_flag*F*T_*Nd1*df;
-    };
-};
-
-/**
- * @return compute the european vanilla option's vanna.
- */
-double BlackScholesClosedForm::vanna()
-{
-    return -df*exp(mu*T_)*nd1*d2/sigma_;
-};
-
-/**
- * @return compute the european vanilla option's volga.
- */
-double BlackScholesClosedForm::volga()
-{
-    return vega()*d1*d2/sigma_;
-};
-
-/**
- * @return compute the european vanilla option's charm.
- */
-double BlackScholesClosedForm::charm()
-{
-    double drift = exp(mu*T_);
-    double term1 = (mu-r_)*df*drift*Nd1; 
-    double term2 = (2*mu*T_ - sigma_*d2*sqrt(T_))/(2*T_*sigma_*sqrt(T_));
-    double term3 = df*drift*nd1; 
-    return call_put_flag*term1 - term2*term3;
-};
-
-/**
- * @return compute the european vanilla option's veta.
- */
-double BlackScholesClosedForm::veta()
-{
-    double term1 = -F*df*nd1*sqrt(T_);
-    double term2 = (r_-mu)+mu*d1/(sigma_*sqrt(T_));
-    double term3 = (1+d1*d2)/(2*T_); 
-    return term1*(term2-term3);
-};
-
-/**
- * @return compute the european vanilla option's speed.
- */
-double BlackScholesClosedForm::speed()
-{
-    double term1 = -exp(mu*T_)*gamma()*(1+d1/(sigma_*sqrt(T_)));
-    return term1/F;
-};
-
-/**
- * @return compute the european vanilla option's zomma.
- */
-double BlackScholesClosedForm::zomma()
-{
-    return gamma()*(d1*d2-1)/sigma_;
-};
-
-/**
- * @return compute the european vanilla option's ultima.
- */
-double BlackScholesClosedForm::ultima()
-{
-    return -vega()*(d1*d2*(1-d1*d2) + d1*d1 + d2*d2)/(sigma_*sigma_);
-};
-
-/**
- * @return compute the european vanilla option's color.
- */
-double BlackScholesClosedForm::color()
-{
-    double term1 = d1*(2*mu*T_ - d2*sigma_*sqrt(T_))/(sigma_*sqrt(T_));
-    return gamma()*(2*(r_-mu) + 1 + term1)/(2*T_);
-};
-
-/**
- * @return compute the european vanilla option's dual delta.
- */
-double BlackScholesClosedForm::dual_delta()
-{
-    return -call_put_flag*df*Nd2;
-};
-
-/**
- * @return compute the european vanilla option's dual gamma.
- */
-double BlackScholesClosedForm::dual_gamma()
-{
-    return df*nd2/(K_*sigma_*sqrt(T_));
-};
-
-
-
+#include "blackscholes.h"
+#include "blackscholes_greeks.h"
+
+/** 
+* @file blackscholes.h
+* @brief This file defines the framework for the Black Scholes model. 
+* 
+* References :  
+* - "The Pricing of Options and Corporate Liabilities", Black, Scholes, 1972. 
+* - "The pricing of commodity contracts", Black, 1876
+*/
+
+/** 
+ * @class BlackScholesNonPositiveYearFraction
+ * @brief Definition of the mismatch error when the year fraction is not positive. 
+ * 
+ */
+
+/** 
+ * @brief Definition of what() virtual std::exception function.
+ * @return The explication of the error.
+ */
+const char * BlackScholesNonPositiveYearFraction::what() const throw(){
+    return "The year fraction cannot be negative or equal to zero.";
+};
+
+/** 
+ * @class BlackScholesNonPositiveImpliedVolatility
+ * @brief Definition of the mismatch error when the implied volatility is not positive. 
+ * 
+ */
+/** 
+ * @brief Definition of what() virtual std::exception function.
+ * @return The explication of the error.
+ */
+const char * BlackScholesNonPositiveImpliedVolatility::what() const throw(){
+    return "The implied volatility cannot be negative or equal to zero.";
+};
+
+/** 
+ * @class BlackScholesNonPositivePrice
+ * @brief Definition of the error when the underlying or the strike price is not positive. 
+ * 
+ */
+/** 
+ * @brief Definition of what() virtual std::exception function.
+ * @return The explication of the error.
+ */
+const char * BlackScholesNonPositivePrice::what() const throw(){
+    return "The underlying and strike prices cannot be negative or equal to zero.";
+};
+
+/** 
+ * @enum BlackScholesGreek
+ * @brief Bit flags selecting the price and sensitivities to evaluate. Flags are 
+ * combined with | and the bit index of each flag is its position in the output layout.
+ */
+/**
+ * @var BlackScholesGreek BlackScholesGreek::ALL_GREEKS
+ * @brief Selects the price and every sensitivity. 
+ */
+
+/** 
+ * @enum BlackScholesStatus
+ * @brief Bit flags describing the invalid inputs of a Black Scholes evaluation. 
+ */
+/**
+ * @var BlackScholesStatus BlackScholesStatus::BLACK_SCHOLES_NON_POSITIVE_PRICE
+ * @brief The underlying or the strike price is not positive. 
+ */
+/**
+ * @var BlackScholesStatus BlackScholesStatus::BLACK_SCHOLES_NON_FINITE_RATE
+ * @brief The interest or the carry cost rate is not finite. 
+ */
+
+/**
+ * @brief Validates the inputs of a Black Scholes evaluation without throwing. 
+ * NaN inputs are reported as invalid.
+ * @param S The spot/future price of the underlying.
+ * @param K The strike price of the option. 
+ * @param r The interest rate.
+ * @param q The carry cost rate. 
+ * @param sigma The implied volatility.
+ * @param T The year fraction. 
+ * @return The BlackScholesStatus flags, BLACK_SCHOLES_VALID if the inputs are valid.
+ */
+int black_scholes_status(double S, double K, double r, double q, double sigma, double T)
+{
+    int status = BLACK_SCHOLES_VALID;
+    if (!(sigma>0)){status |= BLACK_SCHOLES_NON_POSITIVE_VOLATILITY;}
+    if (!(T>0)){status |= BLACK_SCHOLES_NON_POSITIVE_YEAR_FRACTION;}
+    if (!(S>0) or !(K>0)){status |= BLACK_SCHOLES_NON_POSITIVE_PRICE;}
+    if (!std::isfinite(r) or !std::isfinite(q)){status |= BLACK_SCHOLES_NON_FINITE_RATE;}
+    return status;
+};
+
+/** 
+ * @struct GreeksBundle
+ * @brief The price and sensitivities of an option evaluated in one pass. 
+ * 
+ * The fields not selected by the greeks flags are set to NaN.
+ * @see BlackScholesGreek
+ */
+/**
+ * @var unsigned int GreeksBundle::greeks
+ * @brief The BlackScholesGreek flags that were evaluated. 
+ */
+
+/**
+ * @param index The bit index of the BlackScholesGreek flag.
+ * @return The field corresponding to the flag.
+ */
+double& GreeksBundle::output(int index)
+{
+    switch (index)
+    {
+        case 0: return price;
+        case 1: return delta;
+        case 2: return gamma;
+        case 3: return theta;
+        case 4: return vega;
+        case 5: return rho;
+        case 6: return epsilon;
+        case 7: return vanna;
+        case 8: return volga;
+        case 9: return charm;
+        case 10: return veta;
+        case 11: return zomma;
+        case 12: return speed;
+        case 13: return color;
+        case 14: return ultima;
+        case 15: return dual_delta;
+        default: return dual_gamma;
+    }
+};
+
+/** 
+ * @struct BlackScholesClosedForm
+ * @brief Used to calculate the Black Scholes analytical formula for euopean vanilla options.
+ * 
+ */
+
+ /**
+ * @var double BlackScholesClosedForm::S_
+ * @brief The spot/future price of the underlying.
+ */
+
+ /**
+ * @var double BlackScholesClosedForm::K_
+ * @brief The strike price of the option. 
+ */
+
+ /**
+ * @var double BlackScholesClosedForm::r_
+ * @brief The interest rate.
+ */
+
+/**
+ * @var double BlackScholesClosedForm::q_
+ * @brief The carry cost rate. 
+ */
+
+/**
+ * @var double BlackScholesClosedForm::sigma_
+ * @brief The implied volatility 
+ */
+
+/**
+ * @var double BlackScholesClosedForm::T_
+ * @brief The year fraction. 
+ */
+
+/**
+ * @var double BlackScholesClosedForm::call_put_flag
+ * @brief 1 if the option is a call, -1 if it is a put. 
+ */
+
+/**
+ * @var double BlackScholesClosedForm::future_flag
+ * @brief 0 if the underyling is a future, 1 if not. 
+ */
+
+/**
+ * @var double BlackScholesClosedForm::mu
+ * @brief The underlying drift. 
+ */
+
+/**
+ * @var double BlackScholesClosedForm::drift
+ * @brief The underlying growth factor exp(mu*T). 
+ */
+
+/**
+ * @var double BlackScholesClosedForm::sqrt_T
+ * @brief The square root of the year fraction. 
+ */
+
+/**
+ * @var double BlackScholesClosedForm::df
+ * @brief The discount factor value.
+ */
+
+/**
+ * @var double BlackScholesClosedForm::d1
+ * @brief The d1 values, with respect of the Black scholes formula. 
+ */
+/**
+ * @var double BlackScholesClosedForm::d2
+ * @brief The d2 values, with respect of the Black scholes formula. 
+ */
+
+/**
+ * @var double BlackScholesClosedForm::nd2
+ * @brief The standard normal pdf value of d2.
+ */
+
+/**
+ * @var double BlackScholesClosedForm::nd1
+ * @brief The standard normal pdf value of d1.
+ */
+
+/**
+ * @var double BlackScholesClosedForm::Nd2
+ * @brief The standard normal cdf value of d2.
+ */
+
+/**
+ * @var double BlackScholesClosedForm::Nd1
+ * @brief The standard normal cdf value of d1.
+ */
+
+/**
+ * @var int BlackScholesClosedForm::status
+ * @brief The BlackScholesStatus flags of the inputs.
+ */
+
+ /** 
+ * @brief The main constructor, a thin wrapper of the non throwing constructor.
+ * @param S The spot/future price of the underlying.
+ * @param K The strike price of the option. 
+ * @param r The interest rate.
+ * @param q The carry cost rate. 
+ * @param sigma The implied volatility.
+ * @param T The year fraction. 
+ * @param is_call indicator if the option is a call (True) or a put (False).
+ * @param is_future indicator if the underyling is a future (True) or not (False).
+ * @throw BlackScholesNonPositivePrice
+ * @throw BlackScholesNonPositiveImpliedVolatility
+ * @throw BlackScholesNonPositiveYearFraction
+ */
+ BlackScholesClosedForm::BlackScholesClosedForm(
+    double S, double K, double r, double q, 
+    double sigma, double T, bool is_call, bool is_future): 
+    BlackScholesClosedForm(S, K, r, q, sigma, T, is_call, is_future, std::nothrow)
+{
+    if (status & BLACK_SCHOLES_NON_POSITIVE_PRICE){throw BlackScholesNonPositivePrice();}
+    if (status & BLACK_SCHOLES_NON_POSITIVE_VOLATILITY){throw BlackScholesNonPositiveImpliedVolatility();}
+    if (status & BLACK_SCHOLES_NON_POSITIVE_YEAR_FRACTION){throw BlackScholesNonPositiveYearFraction();}
+};
+
+ /** 
+ * @brief The non throwing constructor, invalid inputs are reported in the status flags 
+ * and evaluate() then returns NaN values.
+ * @param S The spot/future price of the underlying.
+ * @param K The strike price of the option. 
+ * @param r The interest rate.
+ * @param q The carry cost rate. 
+ * @param sigma The implied volatility.
+ * @param T The year fraction. 
+ * @param is_call indicator if the option is a call (True) or a put (False).
+ * @param is_future indicator if the underyling is a future (True) or not (False).
+ * @see BlackScholesStatus
+ */
+ BlackScholesClosedForm::BlackScholesClosedForm(
+    double S, double K, double r, double q, 
+    double sigma, double T, bool is_call, bool is_future, const std::nothrow_t&): 
+    S_(S), K_(K), r_(r), q_(q), sigma_(sigma), T_(T),
+    future_flag(set_future_flag(is_future)),
+    call_put_flag(set_call_put_flag(is_call)), 
+    mu(compute_mu()), drift(compute_drift()), sqrt_T(compute_sqrt_T()), 
+    df(compute_df()),F(compute_F()), 
+    d1(compute_d1()), d2(compute_d2()), nd1(compute_nd1()),
+    nd2(compute_nd2()), Nd1(compute_Nd1()), Nd2(compute_Nd2()), 
+    status(black_scholes_status(S, K, r, q, sigma, T)){};
+
+/**
+ * @param is_future the future indicator. 
+ * @return return the future flag. 
+ */
+int BlackScholesClosedForm::set_future_flag(bool is_future)
+{
+    if (is_future){return 0;}
+    else{return 1;}
+};
+
+/**
+ * @param is_call the call/put indicator. 
+ * @return return the call/put flag. 
+ */
+int BlackScholesClosedForm::set_call_put_flag(bool is_call)
+{
+    if (is_call){return 1;}
+    else{return -1;}
+};
+
+/**
+ * @return return the discount factor
+ */
+double BlackScholesClosedForm::compute_df()
+{
+    return exp(-r_*T_);
+};
+
+/**
+ * @return return the underlying's drift.
+ */
+double BlackScholesClosedForm::compute_mu()
+{
+    return future_flag*(r_-q_);
+};
+
+/**
+ * @return return the growth factor exp(mu*T) of the underlying.
+ */
+double BlackScholesClosedForm::compute_drift()
+{
+    return exp(mu*T_);
+};
+
+/**
+ * @return return the square root of the year fraction.
+ */
+double BlackScholesClosedForm::compute_sqrt_T()
+{
+    return sqrt(T_);
+};
+
+/**
+ * @return return the corresponding future price.
+ */
+double BlackScholesClosedForm::compute_F()
+{
+    return S_*drift;
+};
+
+/**
+ * @return return the d1 value.
+ */
+double BlackScholesClosedForm::compute_d1()
+{
+    return (log(F/K_) + T_*.5*sigma_*sigma_)/(sigma_*sqrt_T);
+};
+
+/**
+ * @return return the d2 value.
+ */
+double BlackScholesClosedForm::compute_d2()
+{
+    return d1 - sigma_*sqrt_T;
+};
+
+/**
+ * @return return the standard normal pdf of d1.
+ */
+double BlackScholesClosedForm::compute_nd1()
+{
+    NormalDistribution stdnorm = NormalDistribution();
+    return stdnorm.pdf(d1);
+};
+
+/**
+ * @return return the standard normal pdf of d2.
+ */
+double BlackScholesClosedForm::compute_nd2()
+{
+    NormalDistribution stdnorm = NormalDistribution();
+    return stdnorm.pdf(d2);
+};
+
+/**
+ * @return return the standard normal cdf of d1.
+ */
+double BlackScholesClosedForm::compute_Nd1()
+{
+    NormalDistribution stdnorm = NormalDistribution();
+    return stdnorm.cdf(call_put_flag*d1);
+};
+
+/**
+ * @return return the standard normal cdf of d2.
+ */
+double BlackScholesClosedForm::compute_Nd2()
+{
+    NormalDistribution stdnorm = NormalDistribution();
+    return stdnorm.cdf(call_put_flag*d2);
+};
+
+/**
+ * @param option The european vanilla option.
+ * @return The terms of the option, as used by black_scholes_greeks().
+ */
+static BlackScholesTerms<double> terms(const BlackScholesClosedForm& option)
+{
+    return {option.K_, option.r_, option.sigma_, option.T_, 
+        (double) option.call_put_flag, (double) option.future_flag, option.mu, 
+        option.drift, option.sqrt_T, option.F, option.df, option.d1, option.d2, 
+        option.Nd1, option.Nd2, option.nd1, option.nd2};
+};
+
+/**
+ * @return compute the european vanilla option's price.
+ */
+double BlackScholesClosedForm::price()
+{
+    return black_scholes_greek(terms(*this), PRICE);
+};
+
+/**
+ * @return compute the european vanilla option's delta.
+ */
+double BlackScholesClosedForm::delta()
+{
+    return black_scholes_greek(terms(*this), DELTA);
+};
+
+/**
+ * @return compute the european vanilla option's gamma.
+ */
+double BlackScholesClosedForm::gamma()
+{
+    return black_scholes_greek(terms(*this), GAMMA);
+};
+
+/**
+ * @return compute the european vanilla option's theta.
+ */
+double BlackScholesClosedForm::theta()
+{
+    return black_scholes_greek(terms(*this), THETA);
+};
+
+/**
+ * @return compute the european vanilla option's vega.
+ */
+double BlackScholesClosedForm::vega()
+{
+    return black_scholes_greek(terms(*this), VEGA);
+};
+
+/**
+ * @return compute the european vanilla option's rho.
+ */
+double BlackScholesClosedForm::rho()
+{
+    return black_scholes_greek(terms(*this), RHO);
+};
+
+/**
+ * @return compute the european vanilla option's epsilon.
+ */
+double BlackScholesClosedForm::epsilon()
+{
+    return black_scholes_greek(terms(*this), EPSILON);
+};
+
+/**
+ * @return compute the european vanilla option's vanna.
+ */
+double BlackScholesClosedForm::vanna()
+{
+    return black_scholes_greek(terms(*this), VANNA);
+};
+
+/**
+ * @return compute the european vanilla option's volga.
+ */
+double BlackScholesClosedForm::volga()
+{
+    return black_scholes_greek(terms(*this), VOLGA);
+};
+
+/**
+ * @return compute the european vanilla option's charm.
+ */
+double BlackScholesClosedForm::charm()
+{
+    return black_scholes_greek(terms(*this), CHARM);
+};
+
+/**
+ * @return compute the european vanilla option's veta.
+ */
+double BlackScholesClosedForm::veta()
+{
+    return black_scholes_greek(terms(*this), VETA);
+};
+
+/**
+ * @return compute the european vanilla option's speed.
+ */
+double BlackScholesClosedForm::speed()
+{
+    return black_scholes_greek(terms(*this), SPEED);
+};
+
+/**
+ * @return compute the european vanilla option's zomma.
+ */
+double BlackScholesClosedForm::zomma()
+{
+    return black_scholes_greek(terms(*this), ZOMMA);
+};
+
+/**
+ * @return compute the european vanilla option's ultima.
+ */
+double BlackScholesClosedForm::ultima()
+{
+    return black_scholes_greek(terms(*this), ULTIMA);
+};
+
+/**
+ * @return compute the european vanilla option's color.
+ */
+double BlackScholesClosedForm::color()
+{
+    return black_scholes_greek(terms(*this), COLOR);
+};
+
+/**
+ * @return compute the european vanilla option's dual delta.
+ */
+double BlackScholesClosedForm::dual_delta()
+{
+    return black_scholes_greek(terms(*this), DUAL_DELTA);
+};
+
+/**
+ * @return compute the european vanilla option's dual gamma.
+ */
+double BlackScholesClosedForm::dual_gamma()
+{
+    return black_scholes_greek(terms(*this), DUAL_GAMMA);
+};
+
+/**
+ * @brief Evaluates the selected price and sensitivities in one pass.
+ * 
+ * Unlike the individual member functions, the shared terms (discounted drift, 
+ * sigma*sqrt(T), gamma, vega, d1*d2) are computed once for the whole selection.
+ * The formulas are the ones of black_scholes_greeks(). 
+ * 
+ * @param greeks The BlackScholesGreek flags to evaluate.
+ * @return The bundle of selected values, the others are NaN. Every value is NaN 
+ * if the inputs are invalid.
+ * @see GreeksBundle
+ */
+GreeksBundle BlackScholesClosedForm::evaluate(unsigned int greeks)
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    GreeksBundle bundle = {greeks, nan, nan, nan, nan, nan, nan, nan, nan, 
+        nan, nan, nan, nan, nan, nan, nan, nan, nan};
+    if (status!=BLACK_SCHOLES_VALID){return bundle;}
+    black_scholes_greeks(terms(*this), greeks, [&](int g, double value){bundle.output(g) = value;});
+    return bundle;
+};
@@ -1,69 +1,149 @@
-#pragma once 
-#include <iostream>
-#include "../../math/probability/normal/normal.h"
-
-class BlackScholesNonPositiveImpliedVolatility:  public std::exception 
-{public: const char * what() const throw();};
-
-class BlackScholesNonPositiveYearFraction:  public std::exception 
-{public: const char * what() const throw();};
-
-struct BlackScholesClosedForm
-{
-    double S_; 
-    double K_; 
-    double r_; 
-    double q_; 
-    double sigma_; 
-    double T_; 
-    int call_put_flag; 
-    int future_flag; 
-    double mu; 
-    double F; 
-    double df; 
-    double d1; 
-    double d2; 
-    double Nd1; 
-    double Nd2; 
-    double nd1; 
-    double nd2; 
-    BlackScholesClosedForm(
-        double S, 
-        double K, 
-        double r, 
-        double q, 
-        double sigma, 
-        double T, 
-        bool is_call, 
-        bool is_future
-    );
-    ~BlackScholesClosedForm(){}; 
-    int set_future_flag(bool is_future); 
-    int set_call_put_flag(bool is_call); 
-    double compute_df(); 
-    double compute_mu();
-    double compute_F(); 
-    double compute_d1(); 
-    double compute_d2(); 
-    double compute_nd1(); 
-    double compute_nd2(); 
-    double compute_Nd1(); 
-    double compute_Nd2(); 
-    double price();
-    double delta();
-    double gamma();
-    double theta();
-    double vega();
-    double rho();
-    double epsilon();
-    double vanna();
-    double volga();
-    double charm();
-    double veta();
-    double zomma();
-    double speed();
-    double color();
-    double ultima();
-    double dual_delta();
-    double dual_gamma();
+#pragma once 
+#include <iostream>
+#include <limits>
+#include <new>
+#include "../../math/probability/normal/normal.h"
+
+class BlackScholesNonPositiveImpliedVolatility:  public std::exception 
+{public: const char * what() const throw();};
+
+class BlackScholesNonPositiveYearFraction:  public std::exception 
+{public: const char * what() const throw();};
+
+class BlackScholesNonPositivePrice:  public std::exception 
+{public: const char * what() const throw();};
+
+enum BlackScholesGreek
+{
+    PRICE = 1 << 0, 
+    DELTA = 1 << 1, 
+    GAMMA = 1 << 2, 
+    THETA = 1 << 3, 
+    VEGA = 1 << 4, 
+    RHO = 1 << 5, 
+    EPSILON = 1 << 6, 
+    VANNA = 1 << 7, 
+    VOLGA = 1 << 8, 
+    CHARM = 1 << 9, 
+    VETA = 1 << 10, 
+    ZOMMA = 1 << 11, 
+    SPEED = 1 << 12, 
+    COLOR = 1 << 13, 
+    ULTIMA = 1 << 14, 
+    DUAL_DELTA = 1 << 15, 
+    DUAL_GAMMA = 1 << 16, 
+    ALL_GREEKS = (1 << 17) - 1
+};
+
+constexpr int BLACK_SCHOLES_GREEK_COUNT = 17;
+
+enum BlackScholesStatus
+{
+    BLACK_SCHOLES_VALID = 0, 
+    BLACK_SCHOLES_NON_POSITIVE_VOLATILITY = 1 << 0, 
+    BLACK_SCHOLES_NON_POSITIVE_YEAR_FRACTION = 1 << 1, 
+    BLACK_SCHOLES_NON_POSITIVE_PRICE = 1 << 2, 
+    BLACK_SCHOLES_NON_FINITE_RATE = 1 << 3
+};
+
+int black_scholes_status(double S, double K, double r, double q, double sigma, double T);
+
+struct GreeksBundle
+{
+    unsigned int greeks; 
+    double price; 
+    double delta; 
+    double gamma; 
+    double theta; 
+    double vega; 
+    double rho; 
+    double epsilon; 
+    double vanna; 
+    double volga; 
+    double charm; 
+    double veta; 
+    double zomma; 
+    double speed; 
+    double color; 
+    double ultima; 
+    double dual_delta; 
+    double dual_gamma; 
+    double& output(int index); 
+};
+
+struct BlackScholesClosedForm
+{
+    double S_; 
+    double K_; 
+    double r_; 
+    double q_; 
+    double sigma_; 
+    double T_; 
+    int call_put_flag; 
+    int future_flag; 
+    double mu; 
+    double drift; 
+    double sqrt_T; 
+    double F; 
+    double df; 
+    double d1; 
+    double d2; 
+    double Nd1; 
+    double Nd2; 
+    double nd1; 
+    double nd2; 
+    int status; 
+    BlackScholesClosedForm(
+        double S, 
+        double K, 
+        double r, 
+        double q, 
+        double sigma, 
+        double T, 
+        bool is_call, 
+        bool is_future
+    );
+    BlackScholesClosedForm(
+        double S, 
+        double K, 
+        double r, 
+        double q, 
+        double sigma, 
+        double T, 
+        bool is_call, 
+        bool is_future, 
+        const std::nothrow_t&
+    );
+    ~BlackScholesClosedForm(){}; 
+    int set_future_flag(bool is_future); 
+    int set_call_put_flag(bool is_call); 
+    double compute_df(); 
+    double compute_mu();
+    double compute_drift(); 
+    double compute_sqrt_T(); 
+    double compute_F(); 
+    double compute_d1(); 
+    double compute_d2(); 
+    double compute_nd1(); 
+    double compute_nd2(); 
+    double compute_Nd1(); 
+    double compute_Nd2(); 
+    double price();
+    double delta();
+    double gamma();
+    double theta();
+    double vega();
+    double rho();
+    double epsilon();
+    double vanna();
+    double volga();
+    double charm();
+    double veta();
+    double zomma();
+    double speed();
+    double color();
+    double ultima();
+    double dual_delta();
+    double dual_gamma();
+    GreeksBundle evaluate(unsigned int greeks);
 }; 
\ No newline at end of file
@@ -0,0 +1,232 @@
+#include "blackscholes_batch.h"
+#include "blackscholes_greeks.h"
+
+/**
+* @file blackscholes_batch.h
+* @brief This file defines the structure-of-arrays batch evaluation of the Black Scholes
+* closed form, used to reprice whole option chains at once.
+*
+* The kernel evaluates simd::WIDTH options per iteration with the formulas of
+* black_scholes_greeks(), shared with BlackScholesClosedForm, so that results match the
+* scalar struct up to the accuracy of the vectorized exp/log (a few ulps).
+*/
+
+/**
+ * @class BlackScholesBatchSizeMismatch
+ * @brief Definition of the error when the input or output arrays of a batch do not have the same size.
+ */
+/**
+ * @brief Definition of what() virtual std::exception function.
+ * @return The explication of the error.
+ */
+const char * BlackScholesBatchSizeMismatch::what() const throw(){
+    return "All the input arrays and the selected output arrays of a batch must have the same size.";
+};
+
+/**
+ * @struct BlackScholesBatchResult
+ * @brief The output arrays of a batch evaluation, one array per sensitivity. Only the arrays
+ * selected by the BlackScholesGreek flags are written, the others can be left empty.
+ */
+
+/**
+ * @param index The bit index of the BlackScholesGreek flag.
+ * @return The output array corresponding to the flag.
+ */
+std::span<double>& BlackScholesBatchResult::output(int index)
+{
+    switch (index)
+    {
+        case 0: return price;
+        case 1: return delta;
+        case 2: return gamma;
+        case 3: return theta;
+        case 4: return vega;
+        case 5: return rho;
+        case 6: return epsilon;
+        case 7: return vanna;
+        case 8: return volga;
+        case 9: return charm;
+        case 10: return veta;
+        case 11: return zomma;
+        case 12: return speed;
+        case 13: return color;
+        case 14: return ultima;
+        case 15: return dual_delta;
+        default: return dual_gamma;
+    }
+};
+
+/**
+ * @struct BlackScholesBatch
+ * @brief Structure-of-arrays view over a chain of european vanilla options.
+ * @see BlackScholesClosedForm
+ */
+
+/**
+ * @brief The main constructor, the arrays are not copied.
+ * @param S The spot/future prices of the underlying.
+ * @param K The strike prices of the options.
+ * @param r The interest rates.
+ * @param q The carry cost rates.
+ * @param sigma The implied volatilities.
+ * @param T The year fractions.
+ * @param is_call indicators if the options are calls (True) or puts (False).
+ * @param is_future indicators if the underlyings are futures (True) or not (False).
+ * @throw BlackScholesBatchSizeMismatch
+ */
+BlackScholesBatch::BlackScholesBatch(
+    std::span<const double> S,
+    std::span<const double> K,
+    std::span<const double> r,
+    std::span<const double> q,
+    std::span<const double> sigma,
+    std::span<const double> T,
+    std::span<const bool> is_call,
+    std::span<const bool> is_future):
+    S_(S), K_(K), r_(r), q_(q), sigma_(sigma), T_(T),
+    is_call_(is_call), is_future_(is_future)
+{
+    std::size_t n = S_.size();
+    if (K_.size()!=n or r_.size()!=n or q_.size()!=n or sigma_.size()!=n
+        or T_.size()!=n or is_call_.size()!=n or is_future_.size()!=n)
+    {throw BlackScholesBatchSizeMismatch();}
+};
+
+/**
+ * @return The number of options in the batch.
+ */
+std::size_t BlackScholesBatch::size()
+{
+    return S_.size();
+};
+
+/**
+ * @brief Evaluates simd::WIDTH options with black_scholes_greeks().
+ * @param in The S, K, r, q, sigma, T input lanes.
+ * @param cp The call/put flags (1 or -1).
+ * @param ff The future flags (0 if future, 1 if not).
+ * @param out The output lanes, indexed by the bit index of the BlackScholesGreek flags.
+ * @param greeks The selected BlackScholesGreek flags.
+ * @param status The output BlackScholesStatus lanes.
+ */
+static void evaluate_block(
+    const double* const* in, const double* cp_, const double* ff_,
+    double* const* out, unsigned int greeks, double* status)
+{
+    using namespace simd;
+    const Pack S = load(in[0]);
+    const Pack K = load(in[1]);
+    const Pack r = load(in[2]);
+    const Pack q = load(in[3]);
+    const Pack sigma = load(in[4]);
+    const Pack T = load(in[5]);
+    const Pack cp = load(cp_);
+    const Pack ff = load(ff_);
+
+    // Same checks as black_scholes_status, the invalid lanes are overwritten with NaN.
+    const Pack zero = broadcast(0.0);
+    const Pack inf = broadcast(HUGE_VAL);
+    const Pack flags = select(sigma > zero, zero, broadcast(BLACK_SCHOLES_NON_POSITIVE_VOLATILITY))
+        + select(T > zero, zero, broadcast(BLACK_SCHOLES_NON_POSITIVE_YEAR_FRACTION))
+        + select((S > zero) & (K > zero), zero, broadcast(BLACK_SCHOLES_NON_POSITIVE_PRICE))
+        + select((abs(r) < inf) & (abs(q) < inf), zero, broadcast(BLACK_SCHOLES_NON_FINITE_RATE));
+    const Mask valid = flags == zero;
+    const Pack nan = broadcast(std::numeric_limits<double>::quiet_NaN());
+    store(status, flags);
+    black_scholes_greeks(black_scholes_terms(S, K, r, q, sigma, T, cp, ff), greeks,
+        [&](int g, const Pack& value){store(out[g], select(valid, value, nan));});
+};
+
+/**
+ * @brief Evaluates the selected price and sensitivities of every option of the batch.
+ *
+ * The outputs of the options with invalid inputs are NaN.
+ * @param result The output arrays, each selected array must have the batch size.
+ * @param greeks The BlackScholesGreek flags to evaluate.
+ * @throw BlackScholesBatchSizeMismatch
+ */
+void BlackScholesBatch::evaluate(BlackScholesBatchResult& result, unsigned int greeks)
+{
+    evaluate(result, greeks, std::span<int>());
+};
+
+/**
+ * @brief Evaluates the selected price and sensitivities of every option of the batch,
+ * and reports the invalid inputs per option instead of throwing.
+ *
+ * Full blocks of simd::WIDTH options are read and written in place, the remaining
+ * options are copied into a padded block so that the tail runs through the same kernel.
+ * The outputs of the options with invalid inputs are NaN.
+ *
+ * @param result The output arrays, each selected array must have the batch size.
+ * @param greeks The BlackScholesGreek flags to evaluate.
+ * @param status The output BlackScholesStatus flags, empty if they are not needed.
+ * @throw BlackScholesBatchSizeMismatch
+ */
+void BlackScholesBatch::evaluate(BlackScholesBatchResult& result, unsigned int greeks, std::span<int> status)
+{
+    const std::size_t n = size();
+    if (!status.empty() and status.size()!=n){throw BlackScholesBatchSizeMismatch();}
+    const std::size_t W = simd::WIDTH;
+    for (int g = 0; g<BLACK_SCHOLES_GREEK_COUNT; g++)
+    {
+        if ((greeks & (1u << g)) and result.output(g).size()!=n)
+        {throw BlackScholesBatchSizeMismatch();}
+    }
+
+    double* out[BLACK_SCHOLES_GREEK_COUNT];
+    double tail_out[BLACK_SCHOLES_GREEK_COUNT][simd::WIDTH];
+    double* tail_ptrs[BLACK_SCHOLES_GREEK_COUNT];
+    for (int g = 0; g<BLACK_SCHOLES_GREEK_COUNT; g++)
+    {
+        out[g] = result.output(g).data();
+        tail_ptrs[g] = tail_out[g];
+    }
+    const double* inputs[6] = {S_.data(), K_.data(), r_.data(), q_.data(), sigma_.data(), T_.data()};
+    double cp[simd::WIDTH];
+    double ff[simd::WIDTH];
+    double block_status[simd::WIDTH];
+
+    std::size_t i = 0;
+    for (; i + W<=n; i += W)
+    {
+        for (std::size_t j = 0; j<W; j++)
+        {
+            cp[j] = is_call_[i+j] ? 1.0 : -1.0;
+            ff[j] = is_future_[i+j] ? 0.0 : 1.0;
+        }
+        const double* in[6];
+        double* block_out[BLACK_SCHOLES_GREEK_COUNT];
+        for (int k = 0; k<6; k++){in[k] = inputs[k] + i;}
+        for (int g = 0; g<BLACK_SCHOLES_GREEK_COUNT; g++){block_out[g] = out[g] + i;}
+        evaluate_block(in, cp, ff, block_out, greeks, block_status);
+        if (!status.empty())
+        {for (std::size_t j = 0; j<W; j++){status[i+j] = (int) block_status[j];}}
+    }
+    if (i<n)
+    {
+        // Padding lanes hold a valid at-the-money option so that they stay finite.
+        double tail_in[6][simd::WIDTH];
+        const double* in[6];
+        for (int k = 0; k<6; k++)
+        {
+            for (std::size_t j = 0; j<W; j++)
+            {tail_in[k][j] = i+j<n ? inputs[k][i+j] : (k==2 or k==3 ? 0.0 : 1.0);}
+            in[k] = tail_in[k];
+        }
+        for (std::size_t j = 0; j<W; j++)
+        {
+            cp[j] = (i+j<n and !is_call_[i+j]) ? -1.0 : 1.0;
+            ff[j] = (i+j<n and is_future_[i+j]) ? 0.0 : 1.0;
+        }
+        evaluate_block(in, cp, ff, tail_ptrs, greeks, block_status);
+        if (!status.empty())
+        {for (std::size_t j = 0; i+j<n; j++){status[i+j] = (int) block_status[j];}}
+        for (int g = 0; g<BLACK_SCHOLES_GREEK_COUNT; g++)
+        {
+            if (!(greeks & (1u << g))){continue;}
+            for (std::size_t j = 0; i+j<n; j++){out[g][i+j] = tail_out[g][j];}
+        }
+    }
+};
@@ -0,0 +1,56 @@
+#pragma once
+#include <iostream>
+#include <span>
+#include "blackscholes.h"
+#include "../../math/simd/simd.h"
+
+class BlackScholesBatchSizeMismatch:  public std::exception
+{public: const char * what() const throw();};
+
+struct BlackScholesBatchResult
+{
+    std::span<double> price;
+    std::span<double> delta;
+    std::span<double> gamma;
+    std::span<double> theta;
+    std::span<double> vega;
+    std::span<double> rho;
+    std::span<double> epsilon;
+    std::span<double> vanna;
+    std::span<double> volga;
+    std::span<double> charm;
+    std::span<double> veta;
+    std::span<double> zomma;
+    std::span<double> speed;
+    std::span<double> color;
+    std::span<double> ultima;
+    std::span<double> dual_delta;
+    std::span<double> dual_gamma;
+    std::span<double>& output(int index);
+};
+
+struct BlackScholesBatch
+{
+    std::span<const double> S_;
+    std::span<const double> K_;
+    std::span<const double> r_;
+    std::span<const double> q_;
+    std::span<const double> sigma_;
+    std::span<const double> T_;
+    std::span<const bool> is_call_;
+    std::span<const bool> is_future_;
+    BlackScholesBatch(
+        std::span<const double> S,
+        std::span<const double> K,
+        std::span<const double> r,
+        std::span<const double> q,
+        std::span<const double> sigma,
+        std::span<const double> T,
+        std::span<const bool> is_call,
+        std::span<const bool> is_future
+    );
+    ~BlackScholesBatch(){};
+    std::size_t size();
+    void evaluate(BlackScholesBatchResult& result, unsigned int greeks);
+    void evaluate(BlackScholesBatchResult& result, unsigned int greeks, std::span<int> status);
+};
@@ -0,0 +1,432 @@
+#include "blackscholes_chain.h"
+#include "blackscholes_greeks.h"
+
+/**
+* @file blackscholes_chain.h
+* @brief This file defines the Black Scholes closed form specialised at compile time
+* on the option type and on the kind of underlying, and the chain pricer built on it.
+*
+* BlackScholesClosedForm multiplies the runtime call/put and future flags into every
+* formula and branches on them in rho() and epsilon(). In BlackScholes<type, underlying>
+* both flags are constants, so the sign flips fold into the arithmetic and the future
+* drift and branches disappear. The runtime choice is made once per chain by
+* BlackScholesChain, which dispatches to one of four kernels pricing simd::WIDTH options
+* at a time. Every path evaluates the formulas of black_scholes_greeks(), instantiated with
+* both flags as template parameters.
+*/
+
+/**
+ * @enum UnderlyingType
+ * @brief The kind of underlying of an option, its value is the future flag of
+ * BlackScholesClosedForm.
+ */
+/**
+ * @var UnderlyingType UnderlyingType::FUTURE_UNDERLYING
+ * @brief The underlying is a future, it has no drift.
+ */
+/**
+ * @var UnderlyingType UnderlyingType::SPOT_UNDERLYING
+ * @brief The underlying is a spot asset, it drifts at the rate r-q.
+ */
+
+/**
+ * @struct BlackScholes
+ * @brief The Black Scholes analytical formula for european vanilla options, with the
+ * option type and the kind of underlying known at compile time.
+ * @see BlackScholesClosedForm
+ */
+
+/**
+ * @brief The main constructor
+ * @param S The spot/future price of the underlying.
+ * @param K The strike price of the option.
+ * @param r The interest rate.
+ * @param q The carry cost rate.
+ * @param sigma The implied volatility.
+ * @param T The year fraction.
+ * @throw BlackScholesNonPositiveImpliedVolatility
+ * @throw BlackScholesNonPositiveYearFraction
+ */
+template <OptionType type, UnderlyingType underlying>
+BlackScholes<type, underlying>::BlackScholes(
+    double S, double K, double r, double q, double sigma, double T):
+    S_(S), K_(K), r_(r), q_(q), sigma_(sigma), T_(T)
+{
+    if (sigma_<=0){throw BlackScholesNonPositiveImpliedVolatility();}
+    if (T_<=0){throw BlackScholesNonPositiveYearFraction();}
+    if constexpr (underlying==FUTURE_UNDERLYING){mu = 0.0; drift = 1.0; F = S_;}
+    else{mu = r_ - q_; drift = exp(mu*T_); F = S_*drift;}
+    sqrt_T = sqrt(T_);
+    df = exp(-r_*T_);
+    d1 = (log(F/K_) + T_*.5*sigma_*sigma_)/(sigma_*sqrt_T);
+    d2 = d1 - sigma_*sqrt_T;
+    nd1 = simd::normal_pdf(d1);
+    nd2 = nd1*F/K_;
+    Nd1 = simd::normal_cdf(call_put_flag*d1);
+    Nd2 = simd::normal_cdf(call_put_flag*d2);
+};
+
+/**
+ * @param option The european vanilla option.
+ * @return The terms of the option, as used by black_scholes_greeks().
+ */
+template <OptionType type, UnderlyingType underlying>
+static BlackScholesTerms<double> terms(const BlackScholes<type, underlying>& option)
+{
+    return {option.K_, option.r_, option.sigma_, option.T_, (double) type, (double) underlying,
+        option.mu, option.drift, option.sqrt_T, option.F, option.df, option.d1, option.d2,
+        option.Nd1, option.Nd2, option.nd1, option.nd2};
+};
+
+/**
+ * @return compute the european vanilla option's price.
+ */
+template <OptionType type, UnderlyingType underlying>
+double BlackScholes<type, underlying>::price()
+{
+    return black_scholes_greek<type, underlying>(terms(*this), PRICE);
+};
+
+/**
+ * @return compute the european vanilla option's delta.
+ */
+template <OptionType type, UnderlyingType underlying>
+double BlackScholes<type, underlying>::delta()
+{
+    return black_scholes_greek<type, underlying>(terms(*this), DELTA);
+};
+
+/**
+ * @return compute the european vanilla option's gamma.
+ */
+template <OptionType type, UnderlyingType underlying>
+double BlackScholes<type, underlying>::gamma()
+{
+    return black_scholes_greek<type, underlying>(terms(*this), GAMMA);
+};
+
+/**
+ * @return compute the european vanilla option's theta.
+ */
+template <OptionType type, UnderlyingType underlying>
+double BlackScholes<type, underlying>::theta()
+{
+    return black_scholes_greek<type, underlying>(terms(*this), THETA);
+};
+
+/**
+ * @return compute the european vanilla option's vega.
+ */
+template <OptionType type, UnderlyingType underlying>
+double BlackScholes<type, underlying>::vega()
+{
+    return black_scholes_greek<type, underlying>(terms(*this), VEGA);
+};
+
+/**
+ * @return compute the european vanilla option's rho.
+ */
+template <OptionType type, UnderlyingType underlying>
+double BlackScholes<type, underlying>::rho()
+{
+    return black_scholes_greek<type, underlying>(terms(*this), RHO);
+};
+
+/**
+ * @return compute the european vanilla option's epsilon.
+ */
+template <OptionType type, UnderlyingType underlying>
+double BlackScholes<type, underlying>::epsilon()
+{
+    return black_scholes_greek<type, underlying>(terms(*this), EPSILON);
+};
+
+/**
+ * @return compute the european vanilla option's vanna.
+ */
+template <OptionType type, UnderlyingType underlying>
+double BlackScholes<type, underlying>::vanna()
+{
+    return black_scholes_greek<type, underlying>(terms(*this), VANNA);
+};
+
+/**
+ * @return compute the european vanilla option's volga.
+ */
+template <OptionType type, UnderlyingType underlying>
+double BlackScholes<type, underlying>::volga()
+{
+    return black_scholes_greek<type, underlying>(terms(*this), VOLGA);
+};
+
+/**
+ * @return compute the european vanilla option's charm.
+ */
+template <OptionType type, UnderlyingType underlying>
+double BlackScholes<type, underlying>::charm()
+{
+    return black_scholes_greek<type, underlying>(terms(*this), CHARM);
+};
+
+/**
+ * @return compute the european vanilla option's veta.
+ */
+template <OptionType type, UnderlyingType underlying>
+double BlackScholes<type, underlying>::veta()
+{
+    return black_scholes_greek<type, underlying>(terms(*this), VETA);
+};
+
+/**
+ * @return compute the european vanilla option's zomma.
+ */
+template <OptionType type, UnderlyingType underlying>
+double BlackScholes<type, underlying>::zomma()
+{
+    return black_scholes_greek<type, underlying>(terms(*this), ZOMMA);
+};
+
+/**
+ * @return compute the european vanilla option's speed.
+ */
+template <OptionType type, UnderlyingType underlying>
+double BlackScholes<type, underlying>::speed()
+{
+    return black_scholes_greek<type, underlying>(terms(*this), SPEED);
+};
+
+/**
+ * @return compute the european vanilla option's color.
+ */
+template <OptionType type, UnderlyingType underlying>
+double BlackScholes<type, underlying>::color()
+{
+    return black_scholes_greek<type, underlying>(terms(*this), COLOR);
+};
+
+/**
+ * @return compute the european vanilla option's ultima.
+ */
+template <OptionType type, UnderlyingType underlying>
+double BlackScholes<type, underlying>::ultima()
+{
+    return black_scholes_greek<type, underlying>(terms(*this), ULTIMA);
+};
+
+/**
+ * @return compute the european vanilla option's dual delta.
+ */
+template <OptionType type, UnderlyingType underlying>
+double BlackScholes<type, underlying>::dual_delta()
+{
+    return black_scholes_greek<type, underlying>(terms(*this), DUAL_DELTA);
+};
+
+/**
+ * @return compute the european vanilla option's dual gamma.
+ */
+template <OptionType type, UnderlyingType underlying>
+double BlackScholes<type, underlying>::dual_gamma()
+{
+    return black_scholes_greek<type, underlying>(terms(*this), DUAL_GAMMA);
+};
+
+/**
+ * @brief Evaluates the selected price and sensitivities in one pass.
+ * @param greeks The BlackScholesGreek flags to evaluate.
+ * @return The bundle of selected values, the others are NaN.
+ * @see BlackScholesClosedForm::evaluate
+ */
+template <OptionType type, UnderlyingType underlying>
+GreeksBundle BlackScholes<type, underlying>::evaluate(unsigned int greeks)
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    GreeksBundle bundle = {greeks, nan, nan, nan, nan, nan, nan, nan, nan,
+        nan, nan, nan, nan, nan, nan, nan, nan, nan};
+    black_scholes_greeks<type, underlying>(terms(*this), greeks, [&](int g, double value){bundle.output(g) = value;});
+    return bundle;
+};
+
+template struct BlackScholes<CALL, SPOT_UNDERLYING>;
+template struct BlackScholes<PUT, SPOT_UNDERLYING>;
+template struct BlackScholes<CALL, FUTURE_UNDERLYING>;
+template struct BlackScholes<PUT, FUTURE_UNDERLYING>;
+
+/**
+ * @param option The crypto option.
+ * @return The type of the option.
+ */
+OptionType option_type(const CryptoOption& option)
+{
+    return option.option_ptr->type_;
+};
+
+/**
+ * @param option The crypto option.
+ * @return FUTURE_UNDERLYING if the option was built on a future, SPOT_UNDERLYING if not.
+ * @see CryptoFuture
+ */
+UnderlyingType underlying_type(const CryptoOption& option)
+{
+    if (dynamic_cast<const CryptoFuture*>(option.underlying_asset_ptr.get())){return FUTURE_UNDERLYING;}
+    else{return SPOT_UNDERLYING;}
+};
+
+/**
+ * @struct BlackScholesChain
+ * @brief Structure-of-arrays view over a chain of european vanilla options sharing
+ * one option type and one kind of underlying, e.g. the calls of a future settled expiry.
+ * @see BlackScholes
+ */
+
+/**
+ * @brief The main constructor, the arrays are not copied.
+ * @param S The spot/future prices of the underlying.
+ * @param K The strike prices of the options.
+ * @param r The interest rates.
+ * @param q The carry cost rates.
+ * @param sigma The implied volatilities.
+ * @param T The year fractions.
+ * @param type The type of every option of the chain.
+ * @param underlying The kind of underlying of every option of the chain.
+ * @throw BlackScholesBatchSizeMismatch
+ */
+BlackScholesChain::BlackScholesChain(
+    std::span<const double> S,
+    std::span<const double> K,
+    std::span<const double> r,
+    std::span<const double> q,
+    std::span<const double> sigma,
+    std::span<const double> T,
+    OptionType type,
+    UnderlyingType underlying):
+    S_(S), K_(K), r_(r), q_(q), sigma_(sigma), T_(T),
+    type_(type), underlying_(underlying)
+{
+    std::size_t n = S_.size();
+    if (K_.size()!=n or r_.size()!=n or q_.size()!=n or sigma_.size()!=n or T_.size()!=n)
+    {throw BlackScholesBatchSizeMismatch();}
+};
+
+/**
+ * @brief The crypto option constructor, the option type and the kind of underlying
+ * are read from a crypto option of the chain.
+ * @param S The spot/future prices of the underlying.
+ * @param K The strike prices of the options.
+ * @param r The interest rates.
+ * @param q The carry cost rates.
+ * @param sigma The implied volatilities.
+ * @param T The year fractions.
+ * @param option A crypto option of the chain.
+ * @throw BlackScholesBatchSizeMismatch
+ * @see CryptoOption
+ */
+BlackScholesChain::BlackScholesChain(
+    std::span<const double> S,
+    std::span<const double> K,
+    std::span<const double> r,
+    std::span<const double> q,
+    std::span<const double> sigma,
+    std::span<const double> T,
+    const CryptoOption& option):
+    BlackScholesChain(S, K, r, q, sigma, T, option_type(option), underlying_type(option)){};
+
+/**
+ * @return The number of options in the chain.
+ */
+std::size_t BlackScholesChain::size()
+{
+    return S_.size();
+};
+
+/**
+ * @brief Prices every option of the chain, simd::WIDTH options at a time.
+ *
+ * The call/put and future flags are template parameters of the kernel, which folds the drift 
+ * of a future, the signs and the branches of rho and epsilon at compile time.
+ * Full blocks are read and written in place, the remaining options are copied into a
+ * padded block so that the tail runs through the same kernel.
+ *
+ * @param chain The option chain.
+ * @param out The output arrays, indexed by the bit index of the BlackScholesGreek flags.
+ * @param greeks The selected BlackScholesGreek flags.
+ */
+template <OptionType type, UnderlyingType underlying>
+static void evaluate_chain(BlackScholesChain& chain, double* const* out, unsigned int greeks)
+{
+    using namespace simd;
+    const std::size_t n = chain.size();
+    const Pack cp = broadcast(type);
+    const Pack ff = broadcast(underlying);
+    const double* inputs[6] = {chain.S_.data(), chain.K_.data(), chain.r_.data(),
+        chain.q_.data(), chain.sigma_.data(), chain.T_.data()};
+    auto evaluate_block = [&](const double* const* in, std::size_t i, double* const* block_out)
+    {
+        const BlackScholesTerms<Pack> t = black_scholes_terms<type, underlying>(load(in[0] + i), 
+            load(in[1] + i), load(in[2] + i), load(in[3] + i), load(in[4] + i), load(in[5] + i), 
+            cp, ff);
+        black_scholes_greeks<type, underlying>(t, greeks, [&](int g, const Pack& value){store(block_out[g] + i, value);});
+    };
+
+    std::size_t i = 0;
+    for (; i + WIDTH<=n; i += WIDTH){evaluate_block(inputs, i, out);}
+    if (i<n)
+    {
+        // Padding lanes hold a valid at-the-money option so that they stay finite.
+        double tail_in[6][WIDTH];
+        double tail_out[BLACK_SCHOLES_GREEK_COUNT][WIDTH];
+        const double* in[6];
+        double* tail_ptrs[BLACK_SCHOLES_GREEK_COUNT];
+        for (int k = 0; k<6; k++)
+        {
+            for (std::size_t j = 0; j<WIDTH; j++)
+            {tail_in[k][j] = i + j<n ? inputs[k][i + j] : (k==2 or k==3 ? 0.0 : 1.0);}
+            in[k] = tail_in[k];
+        }
+        for (int g = 0; g<BLACK_SCHOLES_GREEK_COUNT; g++){tail_ptrs[g] = tail_out[g];}
+        evaluate_block(in, 0, tail_ptrs);
+        for (int g = 0; g<BLACK_SCHOLES_GREEK_COUNT; g++)
+        {
+            if (!(greeks & (1u << g))){continue;}
+            for (std::size_t j = 0; i + j<n; j++){out[g][i + j] = tail_out[g][j];}
+        }
+    }
+};
+
+/**
+ * @brief Evaluates the selected price and sensitivities of every option of the chain.
+ *
+ * The option type and the kind of underlying are dispatched once for the whole chain.
+ * Every input is validated before any output is written, so that a chain rejected with
+ * an exception leaves the output arrays untouched.
+ *
+ * @param result The output arrays, each selected array must have the chain size.
+ * @param greeks The BlackScholesGreek flags to evaluate.
+ * @throw BlackScholesBatchSizeMismatch
+ * @throw BlackScholesNonPositiveImpliedVolatility
+ * @throw BlackScholesNonPositiveYearFraction
+ */
+void BlackScholesChain::evaluate(BlackScholesBatchResult& result, unsigned int greeks)
+{
+    const std::size_t n = size();
+    double* out[BLACK_SCHOLES_GREEK_COUNT];
+    for (int g = 0; g<BLACK_SCHOLES_GREEK_COUNT; g++)
+    {
+        if ((greeks & (1u << g)) and result.output(g).size()!=n)
+        {throw BlackScholesBatchSizeMismatch();}
+        out[g] = result.output(g).data();
+    }
+    for (std::size_t i = 0; i<n; i++)
+    {
+        if (sigma_[i]<=0){throw BlackScholesNonPositiveImpliedVolatility();}
+        if (T_[i]<=0){throw BlackScholesNonPositiveYearFraction();}
+    }
+    if (type_==CALL and underlying_==SPOT_UNDERLYING)
+    {evaluate_chain<CALL, SPOT_UNDERLYING>(*this, out, greeks);}
+    else if (type_==PUT and underlying_==SPOT_UNDERLYING)
+    {evaluate_chain<PUT, SPOT_UNDERLYING>(*this, out, greeks);}
+    else if (type_==CALL)
+    {evaluate_chain<CALL, FUTURE_UNDERLYING>(*this, out, greeks);}
+    else
+    {evaluate_chain<PUT, FUTURE_UNDERLYING>(*this, out, greeks);}
+};
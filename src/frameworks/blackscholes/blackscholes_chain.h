@@ -0,0 +1,100 @@
+#pragma once
+#include <iostream>
+#include <memory>
+#include <span>
+#include <vector>
+#include "blackscholes.h"
+#include "blackscholes_batch.h"
+#include "../../math/simd/simd.h"
+#include "../../datastructure/assets/crypto/crypto_assets.h"
+
+enum UnderlyingType {FUTURE_UNDERLYING = 0, SPOT_UNDERLYING = 1};
+
+template <OptionType type, UnderlyingType underlying>
+struct BlackScholes
+{
+    static constexpr int call_put_flag = type;
+    static constexpr int future_flag = underlying;
+    double S_;
+    double K_;
+    double r_;
+    double q_;
+    double sigma_;
+    double T_;
+    double mu;
+    double drift;
+    double sqrt_T;
+    double F;
+    double df;
+    double d1;
+    double d2;
+    double Nd1;
+    double Nd2;
+    double nd1;
+    double nd2;
+    BlackScholes(
+        double S,
+        double K,
+        double r,
+        double q,
+        double sigma,
+        double T
+    );
+    ~BlackScholes(){};
+    double price();
+    double delta();
+    double gamma();
+    double theta();
+    double vega();
+    double rho();
+    double epsilon();
+    double vanna();
+    double volga();
+    double charm();
+    double veta();
+    double zomma();
+    double speed();
+    double color();
+    double ultima();
+    double dual_delta();
+    double dual_gamma();
+    GreeksBundle evaluate(unsigned int greeks);
+};
+
+OptionType option_type(const CryptoOption& option);
+
+UnderlyingType underlying_type(const CryptoOption& option);
+
+struct BlackScholesChain
+{
+    std::span<const double> S_;
+    std::span<const double> K_;
+    std::span<const double> r_;
+    std::span<const double> q_;
+    std::span<const double> sigma_;
+    std::span<const double> T_;
+    OptionType type_;
+    UnderlyingType underlying_;
+    BlackScholesChain(
+        std::span<const double> S,
+        std::span<const double> K,
+        std::span<const double> r,
+        std::span<const double> q,
+        std::span<const double> sigma,
+        std::span<const double> T,
+        OptionType type,
+        UnderlyingType underlying
+    );
+    BlackScholesChain(
+        std::span<const double> S,
+        std::span<const double> K,
+        std::span<const double> r,
+        std::span<const double> q,
+        std::span<const double> sigma,
+        std::span<const double> T,
+        const CryptoOption& option
+    );
+    ~BlackScholesChain(){};
+    std::size_t size();
+    void evaluate(BlackScholesBatchResult& result, unsigned int greeks);
+};
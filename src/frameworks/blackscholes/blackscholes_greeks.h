@@ -0,0 +1,210 @@
+#pragma once
+#include <iostream>
+#include "blackscholes.h"
+#include "../../math/simd/simd.h"
+
+/**
+* @file blackscholes_greeks.h
+* @brief This file defines the formulas of the Black Scholes price and sensitivities, shared
+* by every pricer of the framework.
+*
+* The formulas are written once on the terms of an option (forward, discount factor, d1, d2
+* and their normal pdf/cdf) and templated on the lane type, so that the same kernel runs on
+* double for BlackScholesClosedForm and BlackScholes, and on simd::Pack for the batch, chain
+* and pricing state kernels.
+*
+* The option type (1 or -1) and the kind of underlying (0 if future, 1 if not) are template
+* parameters as well. They default to BLACK_SCHOLES_LANE_FLAGS, for which the flags are read
+* from the cp and ff lanes, while BlackScholes and the chain fix them at compile time, so that
+* the drift of a future, the signs and the branches of rho and epsilon are folded away.
+*/
+
+constexpr int BLACK_SCHOLES_LANE_FLAGS = 2;
+
+/**
+ * @brief Multiplies by the call/put flag, a compile time type being folded into the sign.
+ * @param cp The call/put flag lanes, only read for BLACK_SCHOLES_LANE_FLAGS.
+ * @param x The value.
+ * @return cp*x.
+ */
+template <int type, typename V>
+inline V call_put(const V& cp, const V& x)
+{
+    if constexpr (type==1){return x;}
+    else if constexpr (type==-1){return -x;}
+    else {return cp*x;}
+};
+
+/**
+ * @struct BlackScholesTerms
+ * @brief The terms shared by the price and the sensitivities of one option, or of one pack
+ * of options.
+ * @see BlackScholesClosedForm
+ */
+template <typename V>
+struct BlackScholesTerms
+{
+    V K;
+    V r;
+    V sigma;
+    V T;
+    V cp;
+    V ff;
+    V mu;
+    V drift;
+    V sqrt_T;
+    V F;
+    V df;
+    V d1;
+    V d2;
+    V Nd1;
+    V Nd2;
+    V nd1;
+    V nd2;
+};
+
+/**
+ * @brief Computes the terms of the options from their inputs, the template parameters type 
+ * and underlying overriding cp and ff unless BLACK_SCHOLES_LANE_FLAGS.
+ * @param S The spot/future price of the underlying.
+ * @param K The strike price of the option.
+ * @param r The interest rate.
+ * @param q The carry cost rate.
+ * @param sigma The implied volatility.
+ * @param T The year fraction.
+ * @param cp The call/put flag (1 or -1).
+ * @param ff The future flag (0 if future, 1 if not).
+ * @return The terms of the options.
+ */
+template <int type = BLACK_SCHOLES_LANE_FLAGS, int underlying = BLACK_SCHOLES_LANE_FLAGS, 
+    typename V>
+inline BlackScholesTerms<V> black_scholes_terms(
+    const V& S, const V& K, const V& r, const V& q,
+    const V& sigma, const V& T, const V& cp, const V& ff)
+{
+    BlackScholesTerms<V> t;
+    t.K = K;
+    t.r = r;
+    t.sigma = sigma;
+    t.T = T;
+    t.cp = type==BLACK_SCHOLES_LANE_FLAGS ? cp : simd::constant<V>(type);
+    t.ff = underlying==BLACK_SCHOLES_LANE_FLAGS ? ff : simd::constant<V>(underlying);
+    t.df = simd::exp(-r*T);
+    if constexpr (underlying==0)
+    {
+        t.mu = simd::constant<V>(0.0);
+        t.drift = simd::constant<V>(1.0);
+        t.F = S;
+    }
+    else
+    {
+        t.mu = underlying==1 ? r - q : ff*(r - q);
+        t.drift = simd::exp(t.mu*T);
+        t.F = S*t.drift;
+    }
+    t.sqrt_T = simd::sqrt(T);
+    const V vol = sigma*t.sqrt_T;
+    t.d1 = (simd::log(t.F/K) + .5*vol*vol)/vol;
+    t.d2 = t.d1 - vol;
+    t.nd1 = simd::normal_pdf(t.d1);
+    t.nd2 = t.nd1*t.F/K;
+    t.Nd1 = simd::normal_cdf(call_put<type>(cp, t.d1));
+    t.Nd2 = simd::normal_cdf(call_put<type>(cp, t.d2));
+    return t;
+};
+
+/**
+ * @brief Evaluates the selected price and sensitivities of the options.
+ *
+ * The values are handed to put(g, value), g being the bit index of the BlackScholesGreek
+ * flag, in the order of the flags. The template parameters type and underlying must be the 
+ * ones the terms were computed with.
+ *
+ * @param t The terms of the options.
+ * @param greeks The BlackScholesGreek flags to evaluate.
+ * @param put The output callback.
+ */
+template <int type = BLACK_SCHOLES_LANE_FLAGS, int underlying = BLACK_SCHOLES_LANE_FLAGS, 
+    typename V, typename Put>
+inline void black_scholes_greeks(const BlackScholesTerms<V>& t, unsigned int greeks, Put put)
+{
+    const V vol = t.sigma*t.sqrt_T;
+    const V df_drift = t.df*t.drift;
+    const V df_F = t.df*t.F;
+    const V d1d2 = t.d1*t.d2;
+    const V gamma = df_drift*t.drift*t.nd1/(t.F*vol);
+    const V vega = df_F*t.nd1*t.sqrt_T;
+    const V price = call_put<type>(t.cp, df_F*t.Nd1 - t.df*t.K*t.Nd2);
+
+    if (greeks & PRICE){put(0, price);}
+    if (greeks & DELTA){put(1, call_put<type>(t.cp, df_drift*t.Nd1));}
+    if (greeks & GAMMA){put(2, gamma);}
+    if (greeks & THETA)
+    {
+        const V term1 = -df_F*t.nd1*t.sigma/(2.0*t.sqrt_T);
+        const V term2 = t.r*t.K*t.df*t.Nd2;
+        const V term3 = (t.r - t.mu)*df_F*t.Nd1;
+        put(3, term1 + call_put<type>(t.cp, term3 - term2));
+    }
+    if (greeks & VEGA){put(4, vega);}
+    if (greeks & RHO)
+    {
+        if constexpr (underlying==0){put(5, -t.T*price);}
+        else if constexpr (underlying==1){put(5, call_put<type>(t.cp, t.K*t.T*t.Nd2*t.df));}
+        else
+        {
+            put(5, simd::select(t.ff==simd::constant<V>(0.0), -t.T*price, 
+                call_put<type>(t.cp, t.K*t.T*t.Nd2*t.df)));
+        }
+    }
+    if (greeks & EPSILON)
+    {
+        if constexpr (underlying==0){put(6, simd::constant<V>(0.0));}
+        else if constexpr (underlying==1){put(6, -call_put<type>(t.cp, t.T*df_F*t.Nd1));}
+        else
+        {
+            put(6, simd::select(t.ff==simd::constant<V>(0.0), simd::constant<V>(0.0), 
+                -call_put<type>(t.cp, t.T*df_F*t.Nd1)));
+        }
+    }
+    if (greeks & VANNA){put(7, -df_drift*t.nd1*t.d2/t.sigma);}
+    if (greeks & VOLGA){put(8, vega*d1d2/t.sigma);}
+    if (greeks & CHARM)
+    {
+        const V term1 = (t.r - t.mu)*df_drift*t.Nd1;
+        const V term2 = (2.0*t.mu*t.T - t.d2*vol)/(2.0*t.T*vol);
+        put(9, call_put<type>(t.cp, term1) - term2*df_drift*t.nd1);
+    }
+    if (greeks & VETA)
+    {
+        const V term2 = (t.r - t.mu) + t.mu*t.d1/vol;
+        const V term3 = (1.0 + d1d2)/(2.0*t.T);
+        put(10, -vega*(term2 - term3));
+    }
+    if (greeks & ZOMMA){put(11, gamma*(d1d2 - 1.0)/t.sigma);}
+    if (greeks & SPEED){put(12, -t.drift*gamma*(1.0 + t.d1/vol)/t.F);}
+    if (greeks & COLOR)
+    {
+        const V term1 = t.d1*(2.0*t.mu*t.T - t.d2*vol)/vol;
+        put(13, gamma*(2.0*(t.r - t.mu)*t.T + 1.0 + term1)/(2.0*t.T));
+    }
+    if (greeks & ULTIMA)
+    {put(14, -vega*(d1d2*(1.0 - d1d2) + t.d1*t.d1 + t.d2*t.d2)/(t.sigma*t.sigma));}
+    if (greeks & DUAL_DELTA){put(15, -call_put<type>(t.cp, t.df*t.Nd2));}
+    if (greeks & DUAL_GAMMA){put(16, t.df*t.nd2/(t.K*vol));}
+};
+
+/**
+ * @brief Evaluates one sensitivity of the options.
+ * @param t The terms of the options.
+ * @param greek The BlackScholesGreek flag to evaluate.
+ * @return The sensitivity.
+ */
+template <int type = BLACK_SCHOLES_LANE_FLAGS, int underlying = BLACK_SCHOLES_LANE_FLAGS, 
+    typename V>
+inline V black_scholes_greek(const BlackScholesTerms<V>& t, unsigned int greek)
+{
+    V value = simd::constant<V>(0.0);
+    black_scholes_greeks<type, underlying>(t, greek, [&](int, const V& x){value = x;});
+    return value;
+};
@@ -0,0 +1,229 @@
+#include "blackscholes_state.h"
+#include "blackscholes_greeks.h"
+
+/**
+* @file blackscholes_state.h
+* @brief This file defines the persistent pricing state of an option chain, repriced
+* incrementally on every tick of the underlying.
+*
+* Between two ticks only the underlying price moves. The strike, rate and time dependent
+* terms (discount factor, growth factor, sigma*sqrt(T), mu*T - log(K)) are cached once,
+* so that log(F/K) = log(S) + mu*T - log(K) costs a single log per tick for the whole
+* chain and the per option work reduces to one pdf and two cdf evaluations.
+*/
+
+/** 
+ * @class BlackScholesIndexOutOfRange
+ * @brief Definition of the error when an option index is not in the chain. 
+ * 
+ */
+/** 
+ * @brief Definition of what() virtual std::exception function.
+ * @return The explication of the error.
+ */
+const char * BlackScholesIndexOutOfRange::what() const throw(){
+    return "The option index is out of the range of the chain.";
+};
+
+/**
+ * @struct BlackScholesPricingState
+ * @brief The cached inputs and the price and first/second order sensitivities of a
+ * chain of european vanilla options written on the same underlying price.
+ *
+ * The arrays are padded to a multiple of simd::WIDTH with a valid at-the-money option,
+ * only the first size() values of the output arrays are meaningful.
+ * @see BlackScholesClosedForm
+ */
+/**
+ * @var double BlackScholesPricingState::S_
+ * @brief The current spot/future price of the underlying.
+ */
+/**
+ * @var double BlackScholesPricingState::log_S
+ * @brief The log of the current underlying price.
+ */
+/**
+ * @var std::vector<double> BlackScholesPricingState::cp
+ * @brief The call/put flags (1 or -1).
+ */
+/**
+ * @var std::vector<double> BlackScholesPricingState::mu
+ * @brief The underlying drifts, 0 for the options on futures.
+ */
+/**
+ * @var std::vector<double> BlackScholesPricingState::vol
+ * @brief The total volatilities sigma*sqrt(T).
+ */
+/**
+ * @var std::vector<double> BlackScholesPricingState::drift
+ * @brief The underlying growth factors exp(mu*T).
+ */
+/**
+ * @var std::vector<double> BlackScholesPricingState::log_moneyness_shift
+ * @brief The terms mu*T - log(K), so that log(F/K) = log(S) + log_moneyness_shift.
+ */
+
+/**
+ * @brief The main constructor, the inputs are copied and the chain is priced at S.
+ * @param S The spot/future price of the underlying.
+ * @param K The strike prices of the options.
+ * @param r The interest rates.
+ * @param q The carry cost rates.
+ * @param sigma The implied volatilities.
+ * @param T The year fractions.
+ * @param is_call indicators if the options are calls (True) or puts (False).
+ * @param is_future indicators if the underlyings are futures (True) or not (False).
+ * @throw BlackScholesBatchSizeMismatch
+ * @throw BlackScholesNonPositivePrice
+ * @throw BlackScholesNonPositiveImpliedVolatility
+ * @throw BlackScholesNonPositiveYearFraction
+ */
+BlackScholesPricingState::BlackScholesPricingState(
+    double S,
+    std::span<const double> K,
+    std::span<const double> r,
+    std::span<const double> q,
+    std::span<const double> sigma,
+    std::span<const double> T,
+    std::span<const bool> is_call,
+    std::span<const bool> is_future):
+    n(K.size()), S_(S), log_S(log(S))
+{
+    if (r.size()!=n or q.size()!=n or sigma.size()!=n or T.size()!=n
+        or is_call.size()!=n or is_future.size()!=n)
+    {throw BlackScholesBatchSizeMismatch();}
+    if (!(S>0)){throw BlackScholesNonPositivePrice();}
+    for (std::size_t i = 0; i<n; i++)
+    {
+        if (!(K[i]>0)){throw BlackScholesNonPositivePrice();}
+        if (!(sigma[i]>0)){throw BlackScholesNonPositiveImpliedVolatility();}
+        if (!(T[i]>0)){throw BlackScholesNonPositiveYearFraction();}
+    }
+    const std::size_t padded = simd::WIDTH*((n + simd::WIDTH - 1)/simd::WIDTH);
+    for (std::vector<double>* cache: {&K_, &r_, &sigma_, &cp, &mu, &sqrt_T, &vol, &df,
+        &drift, &log_moneyness_shift, &price, &delta, &gamma, &vega, &theta, &vanna, &volga})
+    {cache->assign(padded, 0.0);}
+    for (std::size_t i = 0; i<padded; i++)
+    {
+        // Padding lanes hold a valid at-the-money option so that they stay finite.
+        bool pad = i>=n;
+        double T_ = pad ? 1.0 : T[i];
+        K_[i] = pad ? S : K[i];
+        r_[i] = pad ? 0.0 : r[i];
+        sigma_[i] = pad ? 1.0 : sigma[i];
+        cp[i] = (pad or is_call[i]) ? 1.0 : -1.0;
+        mu[i] = (pad or is_future[i]) ? 0.0 : r[i] - q[i];
+        sqrt_T[i] = sqrt(T_);
+        vol[i] = sigma_[i]*sqrt_T[i];
+        df[i] = exp(-r_[i]*T_);
+        drift[i] = exp(mu[i]*T_);
+        log_moneyness_shift[i] = mu[i]*T_ - log(K_[i]);
+    }
+    refresh();
+};
+
+/**
+ * @return The number of options in the chain.
+ */
+std::size_t BlackScholesPricingState::size()
+{
+    return n;
+};
+
+/**
+ * @brief Reprices simd::WIDTH options from the cached terms.
+ * @param state The pricing state.
+ * @param i The index of the first option of the block.
+ */
+static void refresh_block(BlackScholesPricingState& state, std::size_t i)
+{
+    using namespace simd;
+    const Pack S = broadcast(state.S_);
+    const Pack vol = load(&state.vol[i]);
+    BlackScholesTerms<Pack> t;
+    t.K = load(&state.K_[i]);
+    t.r = load(&state.r_[i]);
+    t.sigma = load(&state.sigma_[i]);
+    t.cp = load(&state.cp[i]);
+    t.mu = load(&state.mu[i]);
+    t.sqrt_T = load(&state.sqrt_T[i]);
+    // The year fraction and the future flag only enter sensitivities the state does not keep.
+    t.T = t.sqrt_T*t.sqrt_T;
+    t.ff = broadcast(1.0);
+    t.df = load(&state.df[i]);
+    t.drift = load(&state.drift[i]);
+    t.F = S*t.drift;
+    t.d1 = (broadcast(state.log_S) + load(&state.log_moneyness_shift[i]))/vol + .5*vol;
+    t.d2 = t.d1 - vol;
+    t.nd1 = normal_pdf(t.d1);
+    t.nd2 = t.nd1*t.F/t.K;
+    t.Nd1 = normal_cdf(t.cp*t.d1);
+    t.Nd2 = normal_cdf(t.cp*t.d2);
+
+    double* out[BLACK_SCHOLES_GREEK_COUNT] = {};
+    out[0] = &state.price[i];
+    out[1] = &state.delta[i];
+    out[2] = &state.gamma[i];
+    out[3] = &state.theta[i];
+    out[4] = &state.vega[i];
+    out[7] = &state.vanna[i];
+    out[8] = &state.volga[i];
+    black_scholes_greeks(t, PRICE | DELTA | GAMMA | THETA | VEGA | VANNA | VOLGA,
+        [&](int g, const Pack& value){store(out[g], value);});
+};
+
+/**
+ * @brief Reprices the whole chain from the cached terms.
+ */
+void BlackScholesPricingState::refresh()
+{
+    for (std::size_t i = 0; i<price.size(); i += simd::WIDTH){refresh_block(*this, i);}
+};
+
+/**
+ * @brief Moves the underlying price and reprices the chain.
+ * @param S The new spot/future price of the underlying.
+ * @throw BlackScholesNonPositivePrice
+ */
+void BlackScholesPricingState::update_spot(double S)
+{
+    if (!(S>0)){throw BlackScholesNonPositivePrice();}
+    S_ = S;
+    log_S = log(S);
+    refresh();
+};
+
+/**
+ * @brief Replaces the implied volatilities and reprices the chain.
+ * @param sigma The new implied volatilities.
+ * @throw BlackScholesBatchSizeMismatch
+ * @throw BlackScholesNonPositiveImpliedVolatility
+ */
+void BlackScholesPricingState::update_volatility(std::span<const double> sigma)
+{
+    if (sigma.size()!=n){throw BlackScholesBatchSizeMismatch();}
+    for (std::size_t i = 0; i<n; i++)
+    {if (!(sigma[i]>0)){throw BlackScholesNonPositiveImpliedVolatility();}}
+    for (std::size_t i = 0; i<n; i++)
+    {
+        sigma_[i] = sigma[i];
+        vol[i] = sigma[i]*sqrt_T[i];
+    }
+    refresh();
+};
+
+/**
+ * @brief Replaces the implied volatility of one option and reprices its block only.
+ * @param index The index of the option in the chain.
+ * @param sigma The new implied volatility.
+ * @throw BlackScholesIndexOutOfRange
+ * @throw BlackScholesNonPositiveImpliedVolatility
+ */
+void BlackScholesPricingState::update_volatility(std::size_t index, double sigma)
+{
+    if (index>=n){throw BlackScholesIndexOutOfRange();}
+    if (!(sigma>0)){throw BlackScholesNonPositiveImpliedVolatility();}
+    sigma_[index] = sigma;
+    vol[index] = sigma*sqrt_T[index];
+    refresh_block(*this, index - index%simd::WIDTH);
+};
@@ -0,0 +1,50 @@
+#pragma once
+#include <iostream>
+#include <span>
+#include <vector>
+#include "blackscholes.h"
+#include "blackscholes_batch.h"
+#include "../../math/simd/simd.h"
+
+class BlackScholesIndexOutOfRange:  public std::exception 
+{public: const char * what() const throw();};
+
+struct BlackScholesPricingState
+{
+    std::size_t n;
+    double S_;
+    double log_S;
+    std::vector<double> K_;
+    std::vector<double> r_;
+    std::vector<double> sigma_;
+    std::vector<double> cp;
+    std::vector<double> mu;
+    std::vector<double> sqrt_T;
+    std::vector<double> vol;
+    std::vector<double> df;
+    std::vector<double> drift;
+    std::vector<double> log_moneyness_shift;
+    std::vector<double> price;
+    std::vector<double> delta;
+    std::vector<double> gamma;
+    std::vector<double> vega;
+    std::vector<double> theta;
+    std::vector<double> vanna;
+    std::vector<double> volga;
+    BlackScholesPricingState(
+        double S,
+        std::span<const double> K,
+        std::span<const double> r,
+        std::span<const double> q,
+        std::span<const double> sigma,
+        std::span<const double> T,
+        std::span<const bool> is_call,
+        std::span<const bool> is_future
+    );
+    ~BlackScholesPricingState(){};
+    std::size_t size();
+    void update_spot(double S);
+    void update_volatility(std::span<const double> sigma);
+    void update_volatility(std::size_t index, double sigma);
+    void refresh();
+};
@@ -0,0 +1,427 @@
+#include "implied_volatility.h"
+
+/**
+* @file implied_volatility.h
+* @brief This file defines the implied volatility solver of the Black Scholes model.
+*
+* The option price is normalised to an out-of-the-money call on a unit forward
+* b(x,s) = exp(x/2)N(x/s+s/2) - exp(-x/2)N(x/s-s/2), with x = log(F/K) <= 0 and
+* s = sigma*sqrt(T). The root of b(x,s) = beta is found with third order Householder
+* steps on the transformed objectives of Jaeckel, which make the iteration well
+* conditioned from the tiny prices of the lower branch to the upper price bound.
+*
+* References :
+* - "Let's be rational", Jaeckel, 2015.
+* - "Algorithm AS241: The percentage points of the normal distribution", Wichura, 1988.
+*/
+
+/**
+ * @enum ImpliedVolatilityStatus
+ * @brief Bit flags describing the outcome of an implied volatility inversion.
+ */
+/**
+ * @var ImpliedVolatilityStatus ImpliedVolatilityStatus::IV_CONVERGED
+ * @brief The volatility was found to machine precision.
+ */
+/**
+ * @var ImpliedVolatilityStatus ImpliedVolatilityStatus::IV_BELOW_INTRINSIC
+ * @brief The price is below the intrinsic value, no volatility exists.
+ */
+/**
+ * @var ImpliedVolatilityStatus ImpliedVolatilityStatus::IV_ABOVE_MAXIMUM
+ * @brief The price is above the price at infinite volatility, no volatility exists.
+ */
+/**
+ * @var ImpliedVolatilityStatus ImpliedVolatilityStatus::IV_NOT_CONVERGED
+ * @brief The iteration stopped at IMPLIED_VOLATILITY_MAX_ITERATIONS, the volatility is NaN.
+ */
+/**
+ * @var ImpliedVolatilityStatus ImpliedVolatilityStatus::IV_INVALID_INPUT
+ * @brief A non finite price or a non positive spot, strike or year fraction.
+ */
+
+
+/**
+ * @param x The normalised log moneyness, non positive.
+ * @param s The total volatility sigma*sqrt(T).
+ * @return The normalised out-of-the-money call price b(x,s).
+ */
+template <typename V>
+static V normalised_black(const V& x, const V& s)
+{
+    const V h = x/s;
+    const V t = .5*s;
+    return simd::exp(.5*x)*simd::normal_cdf(h+t) - simd::exp(-.5*x)*simd::normal_cdf(h-t);
+};
+
+
+/**
+ * @brief Runs the safeguarded Householder iteration on one lane or one pack of lanes.
+ *
+ * The region selects the objective: 0 for 1/log(b) on the lower branch, 1 for b itself
+ * and 2 for log(b_max-b) on the upper branch. Each step is kept inside the bracket
+ * given by the monotonicity of the objective in s, falling back to bisection (or doubling while the
+ * bracket is open) when a step leaves it. b_max-b is evaluated from the complementary
+ * cdf values so that the upper objective does not suffer from cancellation.
+ *
+ * @param x,beta,b_max,target,region The normalised problem, see NormalisedBlackProblem.
+ * @param s The initial guess, overwritten by the solution.
+ * @param active The lanes to solve, overwritten by the lanes that did not converge.
+ * @return The number of iterations performed.
+ */
+template <typename V, typename M>
+static int householder_iterations(
+    const V& x, const V& beta, const V& b_max, const V& target, const V& region,
+    V& s, M& active)
+{
+    using simd::select;
+    const V zero = simd::constant<V>(0.0);
+    const V inf = simd::constant<V>(HUGE_VAL);
+    const V inv_b_max = 1.0/b_max;
+    V lo = zero;
+    V hi = inf;
+    V previous = inf;
+    int iteration = 0;
+    while (simd::any(active) and iteration<IMPLIED_VOLATILITY_MAX_ITERATIONS)
+    {
+        iteration++;
+        const V h = x/s;
+        const V t = .5*s;
+        const V b = b_max*simd::normal_cdf(h+t) - inv_b_max*simd::normal_cdf(h-t);
+        const V D = b_max*simd::normal_cdf(-h-t) + inv_b_max*simd::normal_cdf(h-t);
+        const V vega = simd::exp(-.5*(h*h + t*t))*(1/std::sqrt(2*numbers::PI));
+        const V x2 = x*x;
+        const V s2 = s*s;
+        const V a2 = x2/(s2*s) - .25*s;
+        const V a3 = a2*a2 - 3.0*x2/(s2*s2) - .25;
+
+        // Lower branch, objective 1/log(b) - 1/log(beta).
+        const V L = simd::log(b);
+        const V rho = vega/b;
+        const V nu_l = L*(1.0 - L*target)/rho;
+        const V h2_l = a2 - (2.0 + L)*rho/L;
+        const V h3_l = 2.0*(L*L + 3.0*L + 3.0)*rho*rho/(L*L) - 3.0*(2.0 + L)*rho*a2/L + a3;
+
+        // Upper branch, objective log(b_max-beta) - log(b_max-b).
+        const V qD = vega/D;
+        const V nu_u = (simd::log(D) - target)/qD;
+        const V h2_u = qD + a2;
+        const V h3_u = 2.0*qD*qD + 3.0*qD*a2 + a3;
+
+        const V nu_m = (beta - b)/vega;
+        const auto lower = region < simd::constant<V>(.5);
+        const auto upper = region > simd::constant<V>(1.5);
+        const V nu = select(lower, nu_l, select(upper, nu_u, nu_m));
+        const V h2 = select(lower, h2_l, select(upper, h2_u, a2));
+        const V h3 = select(lower, h3_l, select(upper, h3_u, a3));
+        const V step = nu*(1.0 + .5*h2*nu)/(1.0 + nu*(h2 + h3*nu*(1.0/6.0)));
+
+        // The objectives are increasing in s, so the Newton step gives the side of the root.
+        const auto above = nu < simd::constant<V>(0.0);
+        hi = select(active & above, s, hi);
+        lo = select(active & !above, s, lo);
+        // Converged at machine precision, or stalled on the rounding noise of b.
+        const V size = simd::abs(step);
+        const auto converged = (size <= (4*std::numeric_limits<double>::epsilon())*s)
+            | ((size >= .5*previous) & (size <= 1e-10*s));
+        previous = size;
+        V next = s + step;
+        const auto inside = (next >= lo) & (next <= hi);
+        next = select(inside | converged, next, select(hi < inf, .5*(lo + hi), 2.0*s));
+        s = select(active, next, s);
+        active = active & !converged;
+    }
+    return iteration;
+};
+
+
+/**
+ * @struct NormalisedBlackProblem
+ * @brief An option price mapped to the normalised out-of-the-money call problem,
+ * together with its objective region and initial guess, for one lane or one pack of lanes.
+ */
+/**
+ * @var V NormalisedBlackProblem::x
+ * @brief The normalised log moneyness -|log(F/K)|.
+ */
+/**
+ * @var V NormalisedBlackProblem::beta
+ * @brief The normalised time value of the option.
+ */
+/**
+ * @var V NormalisedBlackProblem::b_max
+ * @brief The normalised price at infinite volatility exp(x/2).
+ */
+/**
+ * @var V NormalisedBlackProblem::target
+ * @brief The objective value of beta in its region.
+ */
+/**
+ * @var V NormalisedBlackProblem::region
+ * @brief 0 for the lower branch, 1 for the central branch, 2 for the upper branch.
+ */
+/**
+ * @var V NormalisedBlackProblem::s
+ * @brief The initial guess of the total volatility sigma*sqrt(T).
+ */
+/**
+ * @var V NormalisedBlackProblem::status
+ * @brief The ImpliedVolatilityStatus flags found before the iteration.
+ */
+template <typename V>
+struct NormalisedBlackProblem
+{
+    V x;
+    V beta;
+    V b_max;
+    V target;
+    V region;
+    V s;
+    V status;
+    NormalisedBlackProblem(
+        const V& price,
+        const V& S,
+        const V& K,
+        const V& r,
+        const V& q,
+        const V& T,
+        const V& cp,
+        const V& ff
+    );
+};
+
+/**
+ * @brief The main constructor.
+ *
+ * Every branch is evaluated and the lanes pick theirs with selects, the values of
+ * the lanes that are not solved (invalid inputs, prices out of bounds) are meaningless.
+ * The boundaries of the regions are the points s_l and s_u where the tangent of b at
+ * its inflection point s_c = sqrt(2|x|) crosses 0 and b_max, where b(x,s_c) and the
+ * vega have the closed forms b_max/2 - N(-s_c)/b_max and exp(x/2)/sqrt(2pi).
+ *
+ * @param price The option price.
+ * @param S The spot/future price of the underlying.
+ * @param K The strike price of the option.
+ * @param r The interest rate.
+ * @param q The carry cost rate.
+ * @param T The year fraction.
+ * @param cp The call/put flag (1 or -1).
+ * @param ff The future flag (0 if future, 1 if not).
+ */
+template <typename V>
+NormalisedBlackProblem<V>::NormalisedBlackProblem(
+    const V& price, const V& S, const V& K, const V& r, const V& q,
+    const V& T, const V& cp, const V& ff)
+{
+    using simd::select;
+    const V zero = simd::constant<V>(0.0);
+    const V inf = simd::constant<V>(HUGE_VAL);
+    const auto valid = (simd::abs(price) < inf) & (S > zero) & (K > zero) & (T > zero)
+        & (simd::abs(r) < inf) & (simd::abs(q) < inf);
+
+    const V F = S*simd::exp(ff*(r - q)*T);
+    const V log_moneyness = simd::log(F/K);
+    const V intrinsic = cp*(simd::exp(.5*log_moneyness) - simd::exp(-.5*log_moneyness));
+    beta = price*simd::exp(r*T)/simd::sqrt(F*K);
+    beta = select(cp*log_moneyness > zero, beta - intrinsic, beta);
+    x = -simd::abs(log_moneyness);
+    b_max = simd::exp(.5*x);
+    const V inv_b_max = 1.0/b_max;
+
+    const V s_c = simd::sqrt(-2.0*x);
+    const V b_c = .5*b_max - inv_b_max*simd::normal_cdf(-s_c);
+    const V vega_c = b_max*(1/std::sqrt(2*numbers::PI));
+    const V s_l = s_c - b_c/vega_c;
+    const V b_l = select(s_l > zero, normalised_black(x, s_l), zero);
+    const V s_u = s_c + (b_max - b_c)/vega_c;
+    const V b_u = normalised_black(x, s_u);
+    const auto lower = beta < b_l;
+    const auto upper = (beta >= b_l) & (beta > b_u);
+
+    const V f = (2*numbers::PI/(3*std::sqrt(3.0)))*(-x);
+    const V s_lower = x/(std::sqrt(3.0)*simd::normal_quantile(simd::exp(simd::log(beta/f)*(1.0/3.0))));
+    const V s_upper = -2.0*simd::normal_quantile((b_max - beta)/(b_max + inv_b_max));
+    const V s_middle = s_c + (beta - b_c)/vega_c;
+    region = select(lower, zero, select(upper, simd::constant<V>(2.0), simd::constant<V>(1.0)));
+    target = select(lower, 1.0/simd::log(beta), select(upper, simd::log(b_max - beta), beta));
+    s = select(lower, s_lower, select(upper, s_upper, s_middle));
+
+    status = select(!valid, simd::constant<V>(IV_INVALID_INPUT),
+        select(beta < zero, simd::constant<V>(IV_BELOW_INTRINSIC),
+        select(beta >= b_max, simd::constant<V>(IV_ABOVE_MAXIMUM), zero)));
+    // A price equal to its intrinsic value has a zero volatility, and invalid lanes are not solved.
+    s = select((status == zero) & (beta > zero), s, zero);
+};
+
+/**
+ * @struct BlackScholesImpliedVolatility
+ * @brief The implied volatility of a single european vanilla option price.
+ * @see BlackScholesClosedForm
+ */
+/**
+ * @var int BlackScholesImpliedVolatility::status
+ * @brief The ImpliedVolatilityStatus flags of the inversion.
+ */
+/**
+ * @var int BlackScholesImpliedVolatility::iterations
+ * @brief The number of Householder iterations performed.
+ */
+/**
+ * @var double BlackScholesImpliedVolatility::sigma
+ * @brief The implied volatility, NaN if the status is not IV_CONVERGED.
+ */
+
+/**
+ * @brief The main constructor, solves for the implied volatility.
+ * @param price The option price.
+ * @param S The spot/future price of the underlying.
+ * @param K The strike price of the option.
+ * @param r The interest rate.
+ * @param q The carry cost rate.
+ * @param T The year fraction.
+ * @param is_call indicator if the option is a call (True) or a put (False).
+ * @param is_future indicator if the underyling is a future (True) or not (False).
+ */
+BlackScholesImpliedVolatility::BlackScholesImpliedVolatility(
+    double price, double S, double K, double r, double q,
+    double T, bool is_call, bool is_future):
+    price_(price), S_(S), K_(K), r_(r), q_(q), T_(T),
+    is_call_(is_call), is_future_(is_future),
+    status(IV_CONVERGED), iterations(0),
+    sigma(std::numeric_limits<double>::quiet_NaN())
+{
+    NormalisedBlackProblem<double> problem(price, S, K, r, q, T,
+        is_call ? 1.0 : -1.0, is_future ? 0.0 : 1.0);
+    status = (int) problem.status;
+    if (status!=IV_CONVERGED){return;}
+    double s = problem.s;
+    bool active = s>0;
+    iterations = householder_iterations(problem.x, problem.beta, problem.b_max,
+        problem.target, problem.region, s, active);
+    if (active){status = IV_NOT_CONVERGED; return;}
+    sigma = s/sqrt(T);
+};
+
+/**
+ * @struct BlackScholesImpliedVolatilityBatch
+ * @brief Structure-of-arrays implied volatility solver over an option chain.
+ *
+ * The normalisation, the initial guesses and the Householder iterations all run
+ * simd::WIDTH options at a time, a pack iterates until every lane has converged.
+ * @see BlackScholesImpliedVolatility
+ */
+
+/**
+ * @brief The main constructor, the arrays are not copied.
+ * @param price The option prices.
+ * @param S The spot/future prices of the underlying.
+ * @param K The strike prices of the options.
+ * @param r The interest rates.
+ * @param q The carry cost rates.
+ * @param T The year fractions.
+ * @param is_call indicators if the options are calls (True) or puts (False).
+ * @param is_future indicators if the underlyings are futures (True) or not (False).
+ * @throw BlackScholesBatchSizeMismatch
+ */
+BlackScholesImpliedVolatilityBatch::BlackScholesImpliedVolatilityBatch(
+    std::span<const double> price,
+    std::span<const double> S,
+    std::span<const double> K,
+    std::span<const double> r,
+    std::span<const double> q,
+    std::span<const double> T,
+    std::span<const bool> is_call,
+    std::span<const bool> is_future):
+    price_(price), S_(S), K_(K), r_(r), q_(q), T_(T),
+    is_call_(is_call), is_future_(is_future)
+{
+    std::size_t n = price_.size();
+    if (S_.size()!=n or K_.size()!=n or r_.size()!=n or q_.size()!=n
+        or T_.size()!=n or is_call_.size()!=n or is_future_.size()!=n)
+    {throw BlackScholesBatchSizeMismatch();}
+};
+
+/**
+ * @return The number of options in the batch.
+ */
+std::size_t BlackScholesImpliedVolatilityBatch::size()
+{
+    return price_.size();
+};
+
+/**
+ * @brief Solves simd::WIDTH options.
+ * @param in The price, S, K, r, q, T input lanes.
+ * @param cp The call/put flags (1 or -1).
+ * @param ff The future flags (0 if future, 1 if not).
+ * @param sigma The output implied volatility lanes.
+ * @param status The output ImpliedVolatilityStatus lanes.
+ */
+static void evaluate_block(
+    const double* const* in, const double* cp, const double* ff,
+    double* sigma, double* status)
+{
+    using namespace simd;
+    const Pack T = load(in[5]);
+    NormalisedBlackProblem<Pack> problem(load(in[0]), load(in[1]), load(in[2]),
+        load(in[3]), load(in[4]), T, load(cp), load(ff));
+    Pack s = problem.s;
+    Mask active = s > broadcast(0.0);
+    householder_iterations(problem.x, problem.beta, problem.b_max,
+        problem.target, problem.region, s, active);
+    const Pack flags = problem.status + select(active, broadcast(IV_NOT_CONVERGED), broadcast(0.0));
+    const Mask solved = (problem.status == broadcast(0.0)) & !active;
+    store(sigma, select(solved, s/simd::sqrt(T), broadcast(std::numeric_limits<double>::quiet_NaN())));
+    store(status, flags);
+};
+
+/**
+ * @brief Solves the implied volatility of every option of the batch.
+ *
+ * Full blocks of simd::WIDTH options are read in place, the remaining options are
+ * copied into a block padded with invalid lanes, which are not iterated.
+ *
+ * @param sigma The output implied volatilities, NaN where the status is not IV_CONVERGED.
+ * @param status The output ImpliedVolatilityStatus flags.
+ * @throw BlackScholesBatchSizeMismatch
+ */
+void BlackScholesImpliedVolatilityBatch::evaluate(std::span<double> sigma, std::span<int> status)
+{
+    const std::size_t n = size();
+    const std::size_t W = simd::WIDTH;
+    if (sigma.size()!=n or status.size()!=n){throw BlackScholesBatchSizeMismatch();}
+    const double* inputs[6] = {price_.data(), S_.data(), K_.data(), r_.data(), q_.data(), T_.data()};
+    double cp[simd::WIDTH];
+    double ff[simd::WIDTH];
+    double block_sigma[simd::WIDTH];
+    double block_status[simd::WIDTH];
+    double tail_in[6][simd::WIDTH];
+    for (std::size_t i = 0; i<n; i += W)
+    {
+        const double* in[6];
+        for (std::size_t j = 0; j<W; j++)
+        {
+            cp[j] = (i+j<n and !is_call_[i+j]) ? -1.0 : 1.0;
+            ff[j] = (i+j<n and is_future_[i+j]) ? 0.0 : 1.0;
+        }
+        if (i + W<=n)
+        {
+            for (int k = 0; k<6; k++){in[k] = inputs[k] + i;}
+        }
+        else
+        {
+            for (int k = 0; k<6; k++)
+            {
+                for (std::size_t j = 0; j<W; j++)
+                {tail_in[k][j] = i+j<n ? inputs[k][i+j] : std::numeric_limits<double>::quiet_NaN();}
+                in[k] = tail_in[k];
+            }
+        }
+        evaluate_block(in, cp, ff, block_sigma, block_status);
+        for (std::size_t j = 0; j<W and i+j<n; j++)
+        {
+            sigma[i+j] = block_sigma[j];
+            status[i+j] = (int) block_status[j];
+        }
+    }
+};
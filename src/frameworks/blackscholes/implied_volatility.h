@@ -0,0 +1,68 @@
+#pragma once
+#include <iostream>
+#include <span>
+#include "blackscholes.h"
+#include "blackscholes_batch.h"
+#include "../../math/simd/simd.h"
+
+enum ImpliedVolatilityStatus
+{
+    IV_CONVERGED = 0,
+    IV_BELOW_INTRINSIC = 1 << 0,
+    IV_ABOVE_MAXIMUM = 1 << 1,
+    IV_NOT_CONVERGED = 1 << 2,
+    IV_INVALID_INPUT = 1 << 3
+};
+
+constexpr int IMPLIED_VOLATILITY_MAX_ITERATIONS = 8;
+
+struct BlackScholesImpliedVolatility
+{
+    double price_;
+    double S_;
+    double K_;
+    double r_;
+    double q_;
+    double T_;
+    bool is_call_;
+    bool is_future_;
+    int status;
+    int iterations;
+    double sigma;
+    BlackScholesImpliedVolatility(
+        double price,
+        double S,
+        double K,
+        double r,
+        double q,
+        double T,
+        bool is_call,
+        bool is_future
+    );
+    ~BlackScholesImpliedVolatility(){};
+};
+
+struct BlackScholesImpliedVolatilityBatch
+{
+    std::span<const double> price_;
+    std::span<const double> S_;
+    std::span<const double> K_;
+    std::span<const double> r_;
+    std::span<const double> q_;
+    std::span<const double> T_;
+    std::span<const bool> is_call_;
+    std::span<const bool> is_future_;
+    BlackScholesImpliedVolatilityBatch(
+        std::span<const double> price,
+        std::span<const double> S,
+        std::span<const double> K,
+        std::span<const double> r,
+        std::span<const double> q,
+        std::span<const double> T,
+        std::span<const bool> is_call,
+        std::span<const bool> is_future
+    );
+    ~BlackScholesImpliedVolatilityBatch(){};
+    std::size_t size();
+    void evaluate(std::span<double> sigma, std::span<int> status);
+};
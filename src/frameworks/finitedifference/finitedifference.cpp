@@ -0,0 +1,453 @@
+#include "finitedifference.h"
+
+/** 
+* @file finitedifference.h
+* @brief This file defines the finite difference pricer of the vanilla and knock out 
+* options on a geometric brownian motion.
+* 
+* The pricing equation is solved backward in time to expiry tau on a uniform grid of 
+* the log price x, where its coefficients are constant:
+* V_tau = 0.5 sigma^2 V_xx + (b - 0.5 sigma^2) V_x - r V.
+* The Crank-Nicolson scheme is started with implicit Euler half steps (Rannacher) to 
+* damp the payoff kink, and the early exercise constraint V >= payoff is enforced with a 
+* penalty term. With constant coefficients the LU factorisations of the tridiagonal 
+* systems are computed once per grid, and every strike of a strip is one simd lane of 
+* the same backward sweep.
+* 
+* References :  
+* - "Convergence analysis of Crank-Nicolson and Rannacher time-marching", Giles, 
+*   Carter, 2006.
+* - "Quadratic convergence for valuing American options using a penalty method", 
+*   Forsyth, Vetzal, 2002.
+*/
+
+/** 
+ * @class FiniteDifferenceInvalidGrid
+ * @brief Definition of the invalid grid parameters error.
+ */
+/** 
+ * @brief Definition of what() virtual std::exception function.
+ * @return The explication of the error.
+ */
+const char * FiniteDifferenceInvalidGrid::what() const throw(){
+    return "The grid needs a positive volatility and year fraction, at least 4 space \
+    steps and 1 time step, and barriers surrounding the underlying price";
+};
+
+/** 
+ * @class FiniteDifferenceExpiryMismatch
+ * @brief Definition of the option priced on the grid of another expiry error.
+ */
+/** 
+ * @brief Definition of what() virtual std::exception function.
+ * @return The explication of the error.
+ */
+const char * FiniteDifferenceExpiryMismatch::what() const throw(){
+    return "The expiry of the option must be the expiry of the grid";
+};
+
+/** 
+ * @class FiniteDifferenceNotConverged
+ * @brief Definition of the early exercise region not found error.
+ */
+/** 
+ * @brief Definition of what() virtual std::exception function.
+ * @return The explication of the error.
+ */
+const char * FiniteDifferenceNotConverged::what() const throw(){
+    return "The penalty iteration did not find the exercise region in \
+    FINITE_DIFFERENCE_PENALTY_ITERATIONS iterations";
+};
+
+/**
+ * @enum FiniteDifferenceStatus
+ * @brief Bit flags describing the outcome of the backward sweep of a strike.
+ */
+/**
+ * @var FiniteDifferenceStatus FiniteDifferenceStatus::FINITE_DIFFERENCE_CONVERGED
+ * @brief The exercise region of every time step was found.
+ */
+/**
+ * @var FiniteDifferenceStatus FiniteDifferenceStatus::FINITE_DIFFERENCE_NOT_CONVERGED
+ * @brief The penalty iteration of a time step stopped at FINITE_DIFFERENCE_PENALTY_ITERATIONS
+ * while the exercise region was still moving, the values are not reliable.
+ */
+
+/**
+ * @struct FiniteDifferenceGrid
+ * @brief The space/time grid of an expiry and its cached tridiagonal factorisations, 
+ * shared by all the options of the expiry.
+ */
+/**
+ * @var double FiniteDifferenceGrid::lower_barrier
+ * @brief The knock out barrier at the bottom of the grid, 0 if there is none.
+ */
+/**
+ * @var double FiniteDifferenceGrid::upper_barrier
+ * @brief The knock out barrier at the top of the grid, infinite if there is none.
+ */
+/**
+ * @var double FiniteDifferenceGrid::h
+ * @brief The log price step.
+ */
+/**
+ * @var double FiniteDifferenceGrid::lower
+ * @brief The coefficient of V_{i-1} in the discretised operator.
+ */
+/**
+ * @var double FiniteDifferenceGrid::diagonal
+ * @brief The coefficient of V_i in the discretised operator.
+ */
+/**
+ * @var double FiniteDifferenceGrid::upper
+ * @brief The coefficient of V_{i+1} in the discretised operator.
+ */
+/**
+ * @var std::vector<double> FiniteDifferenceGrid::cn_pivot
+ * @brief The inverse pivots of the Crank-Nicolson system.
+ */
+/**
+ * @var std::vector<double> FiniteDifferenceGrid::implicit_pivot
+ * @brief The inverse pivots of the implicit Euler half step system.
+ */
+
+/**
+ * @brief The vanilla grid constructor, the grid spans FINITE_DIFFERENCE_STANDARD_DEVIATIONS
+ * standard deviations around the underlying price, which is a node.
+ * @param S The spot/future price of the underlying.
+ * @param r The interest rate.
+ * @param q The carry cost rate.
+ * @param sigma The volatility.
+ * @param T The year fraction of the expiry.
+ * @param is_future indicator if the underlying is a future (True) or not (False).
+ * @param space_steps The number of log price steps, rounded up to an even number.
+ * @param time_steps The number of time steps.
+ * @throw FiniteDifferenceInvalidGrid
+ */
+FiniteDifferenceGrid::FiniteDifferenceGrid(
+    double S, double r, double q, double sigma, double T, bool is_future, 
+    std::size_t space_steps, std::size_t time_steps): 
+    FiniteDifferenceGrid(S, r, q, sigma, T, is_future, space_steps + space_steps%2, time_steps, 
+        0.0, std::numeric_limits<double>::infinity()){};
+
+/**
+ * @brief The knock out grid constructor, the grid ends at the barriers.
+ * @param S The spot/future price of the underlying.
+ * @param r The interest rate.
+ * @param q The carry cost rate.
+ * @param sigma The volatility.
+ * @param T The year fraction of the expiry.
+ * @param is_future indicator if the underlying is a future (True) or not (False).
+ * @param space_steps The number of log price steps.
+ * @param time_steps The number of time steps.
+ * @param lower_barrier The down barrier, 0 if there is none.
+ * @param upper_barrier The up barrier, infinite if there is none.
+ * @throw FiniteDifferenceInvalidGrid
+ */
+FiniteDifferenceGrid::FiniteDifferenceGrid(
+    double S, double r, double q, double sigma, double T, bool is_future, 
+    std::size_t space_steps, std::size_t time_steps, 
+    double lower_barrier, double upper_barrier): 
+    S_(S), r_(r), q_(q), sigma_(sigma), T_(T), is_future_(is_future), 
+    space_steps(space_steps), time_steps(time_steps), 
+    lower_barrier(lower_barrier), upper_barrier(upper_barrier), 
+    b(is_future ? 0.0 : r - q)
+{
+    if (not (sigma>0) or not (T>0) or space_steps<4 or time_steps<1 
+        or not (lower_barrier<S) or not (S<upper_barrier))
+    {throw FiniteDifferenceInvalidGrid();}
+    const double x0 = std::log(S);
+    const double width = FINITE_DIFFERENCE_STANDARD_DEVIATIONS*sigma*std::sqrt(T);
+    x_min = lower_barrier>0 ? std::log(lower_barrier) : x0 - width;
+    const double x_max = std::isfinite(upper_barrier) ? std::log(upper_barrier) : x0 + width;
+    h = (x_max - x_min)/space_steps;
+    dt = T/time_steps;
+    x.resize(space_steps + 1);
+    for (std::size_t i = 0; i<=space_steps; i++){x[i] = x_min + i*h;}
+
+    const double diffusion = .5*sigma*sigma/(h*h);
+    const double convection = (b - .5*sigma*sigma)/(2*h);
+    lower = diffusion - convection;
+    diagonal = -2*diffusion - r;
+    upper = diffusion + convection;
+    factorise(.5, dt, cn_pivot, cn_upper);
+    factorise(1.0, dt/FINITE_DIFFERENCE_RANNACHER_STEPS, implicit_pivot, implicit_upper);
+};
+
+/**
+ * @brief LU factorisation of the system (I - theta*tau*L) V = rhs on the interior nodes.
+ * @param theta The implicit weight of the scheme.
+ * @param tau The time step.
+ * @param pivot The inverse pivots, by node.
+ * @param factor The upper factors, by node.
+ */
+void FiniteDifferenceGrid::factorise(double theta, double tau, std::vector<double>& pivot, std::vector<double>& factor)
+{
+    const double l = -theta*tau*lower;
+    const double d = 1 - theta*tau*diagonal;
+    const double u = -theta*tau*upper;
+    pivot.assign(space_steps + 1, 0.0);
+    factor.assign(space_steps + 1, 0.0);
+    for (std::size_t i = 1; i<space_steps; i++)
+    {
+        pivot[i] = 1/(d - (i>1 ? l*factor[i-1] : 0.0));
+        factor[i] = u*pivot[i];
+    }
+};
+
+/**
+ * @struct FiniteDifferenceSolver
+ * @brief The finite difference solver of a grid, with its workspaces. The values are 
+ * stored by node then strike: value[i*lanes + k] is the value of the strike k at the 
+ * node i.
+ */
+/**
+ * @var std::size_t FiniteDifferenceSolver::lanes
+ * @brief The number of strikes of the last strip, padded to a multiple of simd::WIDTH.
+ */
+/**
+ * @var std::vector<double> FiniteDifferenceSolver::penalty
+ * @brief The penalty of the nodes violating the early exercise constraint, kept from 
+ * one time step to the next as the first guess of the exercise region.
+ */
+/**
+ * @var std::vector<double> FiniteDifferenceSolver::forward
+ * @brief The forward eliminated right hand sides.
+ */
+/**
+ * @var std::vector<int> FiniteDifferenceSolver::status
+ * @brief The FiniteDifferenceStatus flags of the strikes of the last strip.
+ */
+
+/**
+ * @brief The main constructor.
+ * @param grid The grid of the expiry.
+ */
+FiniteDifferenceSolver::FiniteDifferenceSolver(FiniteDifferenceGrid grid): 
+    grid(grid), lanes(0){};
+
+/**
+ * @brief The Dirichlet values at the edges of the grid.
+ * @param grid The grid.
+ * @param K The strike.
+ * @param cp The call/put flag.
+ * @param is_american indicator if the option can be exercised early.
+ * @param tau The time to expiry.
+ * @param bottom The value at the lowest node.
+ * @param top The value at the highest node.
+ */
+static void edge_values(FiniteDifferenceGrid& grid, double K, double cp, bool is_american, 
+    double tau, double& bottom, double& top)
+{
+    const double df = std::exp(-grid.r_*tau);
+    const double carry = std::exp((grid.b - grid.r_)*tau);
+    for (int side = 0; side<2; side++)
+    {
+        const bool knocked = side==0 ? grid.lower_barrier>0 : std::isfinite(grid.upper_barrier);
+        const double S = std::exp(side==0 ? grid.x.front() : grid.x.back());
+        double edge = 0.0;
+        if (not knocked)
+        {
+            edge = std::max(cp*(S*carry - K*df), 0.0);
+            if (is_american){edge = std::max(edge, cp*(S - K));}
+        }
+        (side==0 ? bottom : top) = edge;
+    }
+};
+
+/**
+ * @brief Prices a strip of options sharing the grid, the type and the exercise in one 
+ * backward sweep. The prices and the grid sensitivities at the underlying price are 
+ * written to price, delta, gamma and theta, and the outcome of the sweep to status.
+ * @param K The strike prices of the options.
+ * @param is_call indicator if the options are calls (True) or puts (False).
+ * @param is_american indicator if the options can be exercised early (True) or not (False).
+ */
+void FiniteDifferenceSolver::solve(std::span<const double> K, bool is_call, bool is_american)
+{
+    using namespace simd;
+    const std::size_t n = K.size();
+    const std::size_t N = grid.space_steps;
+    const double cp = is_call ? 1.0 : -1.0;
+    lanes = WIDTH*((n + WIDTH - 1)/WIDTH);
+    const std::size_t L = lanes;
+    // Padding lanes repeat the first strike.
+    K_.assign(L, n>0 ? K[0] : 1.0);
+    for (std::size_t k = 0; k<n; k++){K_[k] = K[k];}
+    for (std::vector<double>* workspace: {&value, &rhs, &payoff, &forward, &factor})
+    {workspace->resize((N + 1)*L);}
+    penalty.assign((N + 1)*L, 0.0);
+    status.assign(n, FINITE_DIFFERENCE_CONVERGED);
+    std::vector<char> moved(L);
+    std::vector<double> change(L);
+    for (std::size_t i = 0; i<=N; i++)
+    {
+        const double S = std::exp(grid.x[i]);
+        for (std::size_t k = 0; k<L; k++)
+        {
+            payoff[i*L + k] = std::max(cp*(S - K_[k]), 0.0);
+            value[i*L + k] = payoff[i*L + k];
+        }
+    }
+    std::vector<double> bottom(L);
+    std::vector<double> top(L);
+    for (std::size_t k = 0; k<L; k++){edge_values(grid, K_[k], cp, false, 0.0, bottom[k], top[k]);}
+    for (std::size_t k = 0; k<L; k++){value[k] = bottom[k]; value[N*L + k] = top[k];}
+
+    double tau = 0.0;
+    const int total = FINITE_DIFFERENCE_RANNACHER_STEPS + grid.time_steps - 1;
+    for (int step = 0; step<total; step++)
+    {
+        const bool rannacher = step<FINITE_DIFFERENCE_RANNACHER_STEPS;
+        const double theta = rannacher ? 1.0 : .5;
+        const double tau_step = rannacher ? grid.dt/FINITE_DIFFERENCE_RANNACHER_STEPS : grid.dt;
+        const std::vector<double>& grid_pivot = rannacher ? grid.implicit_pivot : grid.cn_pivot;
+        const std::vector<double>& grid_factor = rannacher ? grid.implicit_upper : grid.cn_upper;
+        tau += tau_step;
+        for (std::size_t k = 0; k<L; k++){edge_values(grid, K_[k], cp, is_american, tau, bottom[k], top[k]);}
+
+        // Explicit part of the scheme, the new edge values enter the first and last rows.
+        const Pack a = broadcast((1 - theta)*tau_step*grid.lower);
+        const Pack c = broadcast(1 + (1 - theta)*tau_step*grid.diagonal);
+        const Pack e = broadcast((1 - theta)*tau_step*grid.upper);
+        for (std::size_t i = 1; i<N; i++)
+        {
+            for (std::size_t k = 0; k<L; k += WIDTH)
+            {
+                const Pack explicit_part = a*load(&value[(i-1)*L + k]) + c*load(&value[i*L + k]) 
+                    + e*load(&value[(i+1)*L + k]);
+                store(&rhs[i*L + k], explicit_part);
+            }
+        }
+        for (std::size_t k = 0; k<L; k++)
+        {
+            rhs[L + k] += theta*tau_step*grid.lower*bottom[k];
+            rhs[(N-1)*L + k] += theta*tau_step*grid.upper*top[k];
+        }
+
+        const Pack l = broadcast(-theta*tau_step*grid.lower);
+        const Pack d = broadcast(1 - theta*tau_step*grid.diagonal);
+        const Pack u = broadcast(-theta*tau_step*grid.upper);
+        bool penalised = false;
+        for (int iteration = 0; iteration<FINITE_DIFFERENCE_PENALTY_ITERATIONS; iteration++)
+        {
+            // Forward elimination, the cached factorisation is exact without exercise.
+            for (std::size_t i = 1; i<N; i++)
+            {
+                for (std::size_t k = 0; k<L; k += WIDTH)
+                {
+                    const Pack p = load(&penalty[i*L + k]);
+                    const Pack y_previous = i>1 ? load(&forward[(i-1)*L + k]) : broadcast(0.0);
+                    const Pack source = load(&rhs[i*L + k]) + p*load(&payoff[i*L + k]);
+                    Pack inverse_pivot;
+                    if (is_american)
+                    {
+                        const Pack f_previous = i>1 ? load(&factor[(i-1)*L + k]) : broadcast(0.0);
+                        inverse_pivot = 1.0/(d + p - l*f_previous);
+                        store(&factor[i*L + k], u*inverse_pivot);
+                    }
+                    else 
+                    {
+                        inverse_pivot = broadcast(grid_pivot[i]);
+                        store(&factor[i*L + k], broadcast(grid_factor[i]));
+                    }
+                    store(&forward[i*L + k], (source - l*y_previous)*inverse_pivot);
+                }
+            }
+            // Back substitution into the new values, with the largest relative change of 
+            // each strike.
+            for (std::size_t k = 0; k<L; k++){value[N*L + k] = top[k]; value[k] = bottom[k];}
+            change.assign(L, 0.0);
+            for (std::size_t i = N - 1; i>=1; i--)
+            {
+                for (std::size_t k = 0; k<L; k += WIDTH)
+                {
+                    const Pack next = i<N-1 ? load(&value[(i+1)*L + k]) : broadcast(0.0);
+                    const Pack updated = load(&forward[i*L + k]) - load(&factor[i*L + k])*next;
+                    if (is_american)
+                    {
+                        const Pack relative = abs(updated - load(&value[i*L + k]))
+                            /max(abs(updated), broadcast(1.0));
+                        store(&change[k], max(load(&change[k]), relative));
+                    }
+                    store(&value[i*L + k], updated);
+                }
+            }
+            if (not is_american){break;}
+            // The penalty is active where the values fall below the payoff. A node on the 
+            // exercise boundary can flip at every iteration while its value moves by about
+            // 1/FINITE_DIFFERENCE_PENALTY, the strikes whose values no longer move have 
+            // converged (Forsyth, Vetzal).
+            penalised = false;
+            moved.assign(L, false);
+            for (std::size_t i = 1; i<N; i++)
+            {
+                for (std::size_t k = 0; k<L; k++)
+                {
+                    const double p = value[i*L + k]<payoff[i*L + k] ? FINITE_DIFFERENCE_PENALTY : 0.0;
+                    if (p!=penalty[i*L + k] and change[k]>FINITE_DIFFERENCE_PENALTY_TOLERANCE)
+                    {penalised = true; moved[k] = true;}
+                    penalty[i*L + k] = p;
+                }
+            }
+            if (not penalised){break;}
+        }
+        // The exercise regions still moving after the last iteration were not found.
+        if (penalised)
+        {for (std::size_t k = 0; k<n; k++){if (moved[k]){status[k] |= FINITE_DIFFERENCE_NOT_CONVERGED;}}}
+    }
+
+    // Three points interpolation at the underlying price, the theta is read from the 
+    // pricing equation rather than differenced over a time step, and vanishes where 
+    // the option is exercised.
+    const double x0 = std::log(grid.S_);
+    const std::size_t j = std::min(std::max<std::size_t>(std::lround((x0 - grid.x_min)/grid.h), 1), N - 1);
+    const double v = (x0 - grid.x[j])/grid.h;
+    const double S = grid.S_;
+    price.resize(n);
+    delta.resize(n);
+    gamma.resize(n);
+    theta.resize(n);
+    for (std::size_t k = 0; k<n; k++)
+    {
+        const double* V = &value[k];
+        const double first = .5*(V[(j+1)*L] - V[(j-1)*L]);
+        const double second = V[(j+1)*L] - 2*V[j*L] + V[(j-1)*L];
+        const double V_x = (first + v*second)/grid.h;
+        const double V_xx = second/(grid.h*grid.h);
+        price[k] = V[j*L] + v*first + .5*v*v*second;
+        delta[k] = V_x/S;
+        gamma[k] = (V_xx - V_x)/(S*S);
+        const bool exercised = is_american and price[k]<=std::max(cp*(S - K_[k]), 0.0);
+        const double sigma2 = grid.sigma_*grid.sigma_;
+        theta[k] = exercised ? 0.0 : 
+            -(.5*sigma2*V_xx + (grid.b - .5*sigma2)*V_x - grid.r_*price[k]);
+    }
+};
+
+/**
+ * @brief Prices an option of the grid expiry, AmericanVanillaOption instruments are 
+ * exercised early, the other options are european.
+ * @param option The option instrument.
+ * @param valuation The valuation date.
+ * @param convention The day count convention of the year fraction to expiry.
+ * @return The price, delta, gamma and theta, the other sensitivities are NaN.
+ * @throw FiniteDifferenceExpiryMismatch
+ * @throw FiniteDifferenceNotConverged
+ */
+GreeksBundle FiniteDifferenceSolver::evaluate(const Option& option, EpochTimestamp valuation, DayCountConvention convention)
+{
+    // The grid is built for one year fraction, the option must expire at its end.
+    if (not option.expiry_ptr){throw FiniteDifferenceExpiryMismatch();}
+    const double T = get_year_fraction(valuation, *option.expiry_ptr, convention);
+    if (not (std::fabs(T - grid.T_)<=FINITE_DIFFERENCE_EXPIRY_TOLERANCE))
+    {throw FiniteDifferenceExpiryMismatch();}
+    const bool is_american = dynamic_cast<const AmericanVanillaOption*>(&option)!=nullptr;
+    const double K = option.K;
+    solve(std::span<const double>(&K, 1), option.type_==CALL, is_american);
+    if (status[0]!=FINITE_DIFFERENCE_CONVERGED){throw FiniteDifferenceNotConverged();}
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    GreeksBundle bundle = {PRICE | DELTA | GAMMA | THETA, price[0], delta[0], gamma[0], 
+        theta[0], nan, nan, nan, nan, nan, nan, nan, nan, nan, nan, nan, nan, nan};
+    return bundle;
+};
@@ -0,0 +1,103 @@
+#pragma once 
+#include <iostream>
+#include <cmath>
+#include <limits>
+#include <span>
+#include <vector>
+#include "../../datastructure/instruments/option/option.h"
+#include "../../frameworks/blackscholes/blackscholes.h"
+#include "../../math/simd/simd.h"
+
+class FiniteDifferenceInvalidGrid: public std::exception 
+{public: const char * what() const throw();};
+
+class FiniteDifferenceExpiryMismatch: public std::exception 
+{public: const char * what() const throw();};
+
+class FiniteDifferenceNotConverged: public std::exception 
+{public: const char * what() const throw();};
+
+enum FiniteDifferenceStatus
+{
+    FINITE_DIFFERENCE_CONVERGED = 0,
+    FINITE_DIFFERENCE_NOT_CONVERGED = 1 << 0
+};
+
+constexpr double FINITE_DIFFERENCE_STANDARD_DEVIATIONS = 6.0;
+constexpr int FINITE_DIFFERENCE_RANNACHER_STEPS = 2;
+constexpr int FINITE_DIFFERENCE_PENALTY_ITERATIONS = 20;
+constexpr double FINITE_DIFFERENCE_PENALTY = 1e8;
+constexpr double FINITE_DIFFERENCE_PENALTY_TOLERANCE = 1/FINITE_DIFFERENCE_PENALTY;
+constexpr double FINITE_DIFFERENCE_EXPIRY_TOLERANCE = 1.0/(365.0*24*60*60);
+
+struct FiniteDifferenceGrid
+{
+    double S_; 
+    double r_; 
+    double q_; 
+    double sigma_; 
+    double T_; 
+    bool is_future_; 
+    std::size_t space_steps; 
+    std::size_t time_steps; 
+    double lower_barrier; 
+    double upper_barrier; 
+    double b; 
+    double x_min; 
+    double h; 
+    double dt; 
+    double lower; 
+    double diagonal; 
+    double upper; 
+    std::vector<double> x; 
+    std::vector<double> cn_pivot; 
+    std::vector<double> cn_upper; 
+    std::vector<double> implicit_pivot; 
+    std::vector<double> implicit_upper; 
+    FiniteDifferenceGrid(
+        double S, 
+        double r, 
+        double q, 
+        double sigma, 
+        double T, 
+        bool is_future, 
+        std::size_t space_steps, 
+        std::size_t time_steps
+    );
+    FiniteDifferenceGrid(
+        double S, 
+        double r, 
+        double q, 
+        double sigma, 
+        double T, 
+        bool is_future, 
+        std::size_t space_steps, 
+        std::size_t time_steps, 
+        double lower_barrier, 
+        double upper_barrier
+    );
+    ~FiniteDifferenceGrid(){};
+    void factorise(double theta, double tau, std::vector<double>& pivot, std::vector<double>& factor); 
+};
+
+struct FiniteDifferenceSolver
+{
+    FiniteDifferenceGrid grid; 
+    std::size_t lanes; 
+    std::vector<double> K_; 
+    std::vector<double> value; 
+    std::vector<double> rhs; 
+    std::vector<double> payoff; 
+    std::vector<double> penalty; 
+    std::vector<double> forward; 
+    std::vector<double> factor; 
+    std::vector<double> price; 
+    std::vector<double> delta; 
+    std::vector<double> gamma; 
+    std::vector<double> theta; 
+    std::vector<int> status; 
+    FiniteDifferenceSolver(FiniteDifferenceGrid grid); 
+    ~FiniteDifferenceSolver(){};
+    void solve(std::span<const double> K, bool is_call, bool is_american); 
+    GreeksBundle evaluate(const Option& option, EpochTimestamp valuation, DayCountConvention convention); 
+};
@@ -0,0 +1,499 @@
+#include "longstaff_schwartz.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+/**
+* @file longstaff_schwartz.h
+* @brief This file defines the least squares Monte Carlo pricer of the bermudan options 
+* written on a geometric brownian motion.
+*
+* The backward pass regresses, date by date, the discounted cash flows of the training 
+* paths on a polynomial of S/S0 over the in the money paths. The training paths are not 
+* stored date by date: every path keeps only its brownian motion, its underlying price 
+* and its cash flow at the current date, and steps back to the previous exercise date 
+* with the Brownian bridge, drawing the normals of date k from the counter k of its 
+* block stream. The memory is 3 doubles per training path whatever the number of dates.
+* The forward pass prices the option on independent paths, streamed block by block, 
+* exercising where the exercise value exceeds the regressed continuation value, which 
+* gives a low biased estimate. Both passes share the blocks of paths between the 
+* workers, and the per block sums are reduced in block order so that the results do 
+* not depend on the number of workers.
+*
+* References :
+* - "Valuing American options by simulation: a simple least-squares approach", 
+*   Longstaff, Schwartz, 2001.
+* - "Monte Carlo Methods in Financial Engineering", Glasserman, 2003, 8.6.
+*/
+
+/** 
+ * @class LongstaffSchwartzInvalidDates
+ * @brief Definition of the invalid exercise dates error.
+ */
+/** 
+ * @brief Definition of what() virtual std::exception function.
+ * @return The explication of the error.
+ */
+const char * LongstaffSchwartzInvalidDates::what() const throw(){
+    return "The exercise dates must be positive and strictly increasing, the last one \
+    is the expiry";
+};
+
+/** 
+ * @class LongstaffSchwartzBarrierPayoff
+ * @brief Definition of the unsupported barrier payoff error.
+ */
+/** 
+ * @brief Definition of what() virtual std::exception function.
+ * @return The explication of the error.
+ */
+const char * LongstaffSchwartzBarrierPayoff::what() const throw(){
+    return "The exercise value of a bermudan option cannot have a barrier";
+};
+
+/**
+ * @brief The sums of the normal equations of one block at one exercise date.
+ */
+struct LongstaffSchwartzSums
+{
+    double matrix[LONGSTAFF_SCHWARTZ_BASIS*LONGSTAFF_SCHWARTZ_BASIS]; 
+    double rhs[LONGSTAFF_SCHWARTZ_BASIS]; 
+    std::size_t n; 
+};
+
+/**
+ * @brief The sums of the discounted payoffs of one block.
+ */
+struct LongstaffSchwartzMoments
+{
+    double y = 0.0; 
+    double yy = 0.0; 
+    std::size_t n = 0; 
+};
+
+/**
+ * @struct LongstaffSchwartzEngine
+ * @brief The least squares Monte Carlo engine of the bermudan options, exercisable on a 
+ * set of dates up to their expiry.
+ */
+/**
+ * @var std::vector<double> LongstaffSchwartzEngine::dates
+ * @brief The year fractions of the exercise dates, the last one is the expiry.
+ */
+/**
+ * @var std::size_t LongstaffSchwartzEngine::training_paths
+ * @brief The number of paths of the regressions, rounded up to a multiple of 
+ * MONTE_CARLO_BLOCK. They use the streams 0 to training_paths/MONTE_CARLO_BLOCK - 1.
+ */
+/**
+ * @var std::size_t LongstaffSchwartzEngine::paths
+ * @brief The number of pricing paths, rounded up to a multiple of MONTE_CARLO_BLOCK. 
+ * They use the streams following the training streams.
+ */
+/**
+ * @var bool LongstaffSchwartzEngine::antithetic
+ * @brief Indicator if every pricing path is paired with its antithetic path (True by default).
+ */
+/**
+ * @var std::size_t LongstaffSchwartzEngine::workers
+ * @brief The number of worker threads, the hardware concurrency by default.
+ */
+/**
+ * @var std::vector<double> LongstaffSchwartzEngine::coefficients
+ * @brief The LONGSTAFF_SCHWARTZ_BASIS coefficients of the continuation value in powers of 
+ * S/S0, by exercise date.
+ */
+/**
+ * @var std::vector<bool> LongstaffSchwartzEngine::regressed
+ * @brief Indicators if the regression of the date succeeded, the option is not exercised 
+ * before its expiry on the other dates.
+ */
+/**
+ * @var std::vector<double> LongstaffSchwartzEngine::brownian
+ * @brief The brownian motion of every training path at the current date.
+ */
+/**
+ * @var std::vector<double> LongstaffSchwartzEngine::cashflow
+ * @brief The cash flow of every training path, discounted to the current date.
+ */
+/**
+ * @var std::vector<double> LongstaffSchwartzEngine::normal_matrix
+ * @brief The workspace of the normal equations of the regressions.
+ */
+
+/**
+ * @brief LongstaffSchwartzEngine constructor
+ * @param S The spot/future price of the underlying.
+ * @param r The interest rate.
+ * @param q The carry cost rate.
+ * @param sigma The volatility.
+ * @param is_future indicator if the underlying is a future (True) or not (False).
+ * @param dates The year fractions of the exercise dates, the last one is the expiry.
+ * @param training_paths The number of paths of the regressions.
+ * @param paths The number of pricing paths.
+ * @param seed The seed of the run.
+ * @throw LongstaffSchwartzInvalidDates
+ * @throw MonteCarloNonPositivePaths
+ */
+LongstaffSchwartzEngine::LongstaffSchwartzEngine(
+    double S, 
+    double r, 
+    double q, 
+    double sigma, 
+    bool is_future, 
+    std::span<const double> dates, 
+    std::size_t training_paths, 
+    std::size_t paths, 
+    uint64_t seed): 
+    S_(S), r_(r), q_(q), sigma_(sigma), is_future_(is_future), dates(dates.begin(), dates.end()), 
+    training_paths(MONTE_CARLO_BLOCK*((training_paths + MONTE_CARLO_BLOCK - 1)/MONTE_CARLO_BLOCK)), 
+    paths(MONTE_CARLO_BLOCK*((paths + MONTE_CARLO_BLOCK - 1)/MONTE_CARLO_BLOCK)), 
+    seed(seed), antithetic(true), workers(std::max(1u, std::thread::hardware_concurrency())), 
+    coefficients(LONGSTAFF_SCHWARTZ_BASIS*dates.size(), 0.0), regressed(dates.size(), false), 
+    normal_matrix(LONGSTAFF_SCHWARTZ_BASIS*LONGSTAFF_SCHWARTZ_BASIS), 
+    normal_rhs(LONGSTAFF_SCHWARTZ_BASIS)
+{
+    if (dates.empty() or not (dates[0]>0)){throw LongstaffSchwartzInvalidDates();}
+    for (std::size_t k = 1; k<dates.size(); k++)
+    {if (not (dates[k]>dates[k-1])){throw LongstaffSchwartzInvalidDates();}}
+    if (training_paths==0 or paths==0){throw MonteCarloNonPositivePaths();}
+};
+
+/**
+ * @brief Runs work(block, worker) on every block, the blocks are shared between the workers.
+ * @param workers The number of workers.
+ * @param blocks The number of blocks.
+ * @param work The work on one block.
+ */
+template <typename Work>
+static void parallel_blocks(std::size_t workers, std::size_t blocks, Work work)
+{
+    std::atomic<std::size_t> next{0};
+    auto run = [&](std::size_t worker)
+    {for (std::size_t b = next++; b<blocks; b = next++){work(b, worker);}};
+    std::vector<std::thread> pool;
+    for (std::size_t w = 1; w<std::min(workers, blocks); w++){pool.emplace_back(run, w);}
+    run(0);
+    for (std::thread& thread: pool){thread.join();}
+};
+
+/**
+ * @param path_steps The number of path steps of a parallel pass.
+ * @return The number of threads of the pass: every thread gets at least 
+ * MONTE_CARLO_WORKER_PATH_STEPS path steps, so that the small runs, and the one step 
+ * passes of the regressions of every exercise date, stay on the calling thread.
+ */
+std::size_t LongstaffSchwartzEngine::active_workers(std::size_t path_steps)
+{
+    const std::size_t by_size = std::max<std::size_t>(1, path_steps/MONTE_CARLO_WORKER_PATH_STEPS);
+    return std::min(workers, by_size);
+};
+
+/**
+ * @param payoff The payoff.
+ * @param S The underlying prices.
+ * @return The exercise values.
+ */
+static simd::Pack exercise_value(const MonteCarloPayoff& payoff, simd::Pack S)
+{
+    using namespace simd;
+    Pack value = broadcast(0.0);
+    for (std::size_t i = 0; i<payoff.K.size(); i++)
+    {value = value + payoff.weights[i]*max(payoff.cp[i]*(S - payoff.K[i]), broadcast(0.0));}
+    return value;
+};
+
+/**
+ * @param beta The coefficients of the regression.
+ * @param x The ratios S/S0.
+ * @return The regressed continuation values.
+ */
+static simd::Pack continuation_value(const double* beta, simd::Pack x)
+{
+    using namespace simd;
+    Pack value = broadcast(beta[LONGSTAFF_SCHWARTZ_BASIS - 1]);
+    for (std::size_t a = LONGSTAFF_SCHWARTZ_BASIS - 1; a>0; a--){value = fmadd(value, x, broadcast(beta[a-1]));}
+    return value;
+};
+
+/**
+ * @brief Solves the normal equations in place with a Cholesky factorisation.
+ * @param matrix The symmetric normal matrix, overwritten by its factor.
+ * @param rhs The right hand side, overwritten by the coefficients.
+ * @return False if the matrix is numerically singular.
+ */
+static bool solve_normal_equations(double* matrix, double* rhs)
+{
+    const std::size_t m = LONGSTAFF_SCHWARTZ_BASIS;
+    const double scale = matrix[0];
+    for (std::size_t j = 0; j<m; j++)
+    {
+        double pivot = matrix[j*m + j];
+        for (std::size_t k = 0; k<j; k++){pivot -= matrix[j*m + k]*matrix[j*m + k];}
+        if (not (pivot>1e-13*scale)){return false;}
+        matrix[j*m + j] = std::sqrt(pivot);
+        for (std::size_t i = j + 1; i<m; i++)
+        {
+            double value = matrix[i*m + j];
+            for (std::size_t k = 0; k<j; k++){value -= matrix[i*m + k]*matrix[j*m + k];}
+            matrix[i*m + j] = value/matrix[j*m + j];
+        }
+    }
+    for (std::size_t i = 0; i<m; i++)
+    {
+        for (std::size_t k = 0; k<i; k++){rhs[i] -= matrix[i*m + k]*rhs[k];}
+        rhs[i] /= matrix[i*m + i];
+    }
+    for (std::size_t i = m; i-->0;)
+    {
+        for (std::size_t k = i + 1; k<m; k++){rhs[i] -= matrix[k*m + i]*rhs[k];}
+        rhs[i] /= matrix[i*m + i];
+    }
+    return true;
+};
+
+/**
+ * @brief Moves one block of training paths to the exercise date k, after exercising them 
+ * on the date k + 1, and sums its normal equations at the date k.
+ * @param engine The engine.
+ * @param payoff The payoff.
+ * @param k The index of the exercise date.
+ * @param block The index of the block, which is also the index of its random stream.
+ * @param z The normal draws buffer, MONTE_CARLO_BLOCK values.
+ * @param sums The output sums of the block.
+ */
+static void backward_block(
+    LongstaffSchwartzEngine& engine, 
+    const MonteCarloPayoff& payoff, 
+    std::size_t k, 
+    std::size_t block, 
+    std::vector<double>& z, 
+    LongstaffSchwartzSums& sums)
+{
+    using namespace simd;
+    const std::size_t B = MONTE_CARLO_BLOCK;
+    const std::size_t m = LONGSTAFF_SCHWARTZ_BASIS;
+    const std::size_t last = engine.dates.size() - 1;
+    double* W = &engine.brownian[block*B];
+    double* S = &engine.spot[block*B];
+    double* Y = &engine.cashflow[block*B];
+    PhiloxStream stream(engine.seed, block);
+    stream.fill_normal(k*B, std::span<double>(z.data(), B));
+
+    const double t = engine.dates[k];
+    const double mu = engine.is_future_ ? 0.0 : engine.r_ - engine.q_;
+    const double drift = (mu - .5*engine.sigma_*engine.sigma_)*t;
+    const double S0 = engine.S_;
+    const Pack zero = broadcast(0.0);
+    // The last date starts the paths, the other dates bridge back from the next one.
+    const double t_next = k<last ? engine.dates[k+1] : t;
+    const double weight = k<last ? t/t_next : 0.0;
+    const double spread = k<last ? std::sqrt(t*(t_next - t)/t_next) : std::sqrt(t);
+    const double df = std::exp(-engine.r_*(t_next - t));
+    const bool exercise_next = k<last and engine.regressed[k+1];
+    const double* beta_next = k<last ? &engine.coefficients[(k+1)*m] : nullptr;
+
+    Pack matrix[m*m];
+    Pack rhs[m];
+    Pack count = zero;
+    for (std::size_t a = 0; a<m*m; a++){matrix[a] = zero;}
+    for (std::size_t a = 0; a<m; a++){rhs[a] = zero;}
+    for (std::size_t j = 0; j<B; j += WIDTH)
+    {
+        Pack cash = load(&Y[j]);
+        if (exercise_next)
+        {
+            const Pack S_next = load(&S[j]);
+            const Pack value = exercise_value(payoff, S_next);
+            const Mask exercise = (value>zero) & (value>=continuation_value(beta_next, S_next/S0));
+            cash = select(exercise, value, cash);
+        }
+        const Pack w = weight*load(&W[j]) + spread*load(&z[j]);
+        const Pack spot = S0*exp(drift + engine.sigma_*w);
+        const Pack value = exercise_value(payoff, spot);
+        cash = k<last ? df*cash : value;
+        store(&W[j], w);
+        store(&S[j], spot);
+        store(&Y[j], cash);
+        if (k==last){continue;}
+
+        // Regression on the in the money paths only, the basis is zero on the others.
+        const Pack in_the_money = select(value>zero, broadcast(1.0), zero);
+        const Pack x = spot/S0;
+        Pack basis[m];
+        basis[0] = in_the_money;
+        for (std::size_t a = 1; a<m; a++){basis[a] = basis[a-1]*x;}
+        count = count + in_the_money;
+        for (std::size_t a = 0; a<m; a++)
+        {
+            rhs[a] = fmadd(basis[a], cash, rhs[a]);
+            for (std::size_t b = a; b<m; b++){matrix[a*m + b] = fmadd(basis[a], basis[b], matrix[a*m + b]);}
+        }
+    }
+    auto total = [](Pack p){double lanes[WIDTH]; store(lanes, p); double s = 0.0; for (double l: lanes){s += l;} return s;};
+    for (std::size_t a = 0; a<m; a++)
+    {
+        sums.rhs[a] = total(rhs[a]);
+        for (std::size_t b = a; b<m; b++){sums.matrix[a*m + b] = sums.matrix[b*m + a] = total(matrix[a*m + b]);}
+    }
+    sums.n = std::size_t(total(count));
+};
+
+/**
+ * @brief The backward pass: regresses the continuation values of the payoff on every 
+ * exercise date but the expiry.
+ * @param payoff The payoff.
+ * @return The in sample price of the training paths, which is biased high.
+ * @throw LongstaffSchwartzBarrierPayoff
+ */
+double LongstaffSchwartzEngine::regress(const MonteCarloPayoff& payoff)
+{
+    using namespace simd;
+    if (payoff.has_barrier){throw LongstaffSchwartzBarrierPayoff();}
+    const std::size_t m = LONGSTAFF_SCHWARTZ_BASIS;
+    const std::size_t N = training_paths/MONTE_CARLO_BLOCK;
+    brownian.assign(training_paths, 0.0);
+    spot.assign(training_paths, 0.0);
+    cashflow.assign(training_paths, 0.0);
+    std::vector<LongstaffSchwartzSums> sums(N);
+    const std::size_t threads = active_workers(training_paths);
+    std::vector<std::vector<double>> normals(std::min(threads, N), std::vector<double>(MONTE_CARLO_BLOCK));
+    std::fill(regressed.begin(), regressed.end(), false);
+    for (std::size_t k = dates.size(); k-->0;)
+    {
+        parallel_blocks(threads, N, [&](std::size_t b, std::size_t w)
+        {backward_block(*this, payoff, k, b, normals[w], sums[b]);});
+        if (k==dates.size() - 1){continue;}
+        // The blocks are reduced in order so that the regression does not depend on the workers.
+        std::fill(normal_matrix.begin(), normal_matrix.end(), 0.0);
+        std::fill(normal_rhs.begin(), normal_rhs.end(), 0.0);
+        std::size_t n = 0;
+        for (std::size_t b = 0; b<N; b++)
+        {
+            for (std::size_t a = 0; a<m*m; a++){normal_matrix[a] += sums[b].matrix[a];}
+            for (std::size_t a = 0; a<m; a++){normal_rhs[a] += sums[b].rhs[a];}
+            n += sums[b].n;
+        }
+        regressed[k] = n>=m and solve_normal_equations(normal_matrix.data(), normal_rhs.data());
+        std::copy_n(normal_rhs.begin(), m, &coefficients[k*m]);
+    }
+
+    // Exercise on the first date and discount to the valuation date.
+    const double df = std::exp(-r_*dates[0]);
+    double total = 0.0;
+    for (std::size_t j = 0; j<training_paths; j += WIDTH)
+    {
+        Pack cash = load(&cashflow[j]);
+        if (regressed[0])
+        {
+            const Pack S = load(&spot[j]);
+            const Pack value = exercise_value(payoff, S);
+            const Mask exercise = (value>broadcast(0.0)) & (value>=continuation_value(&coefficients[0], S/S_));
+            cash = select(exercise, value, cash);
+        }
+        double lanes[WIDTH];
+        store(lanes, df*cash);
+        for (double l: lanes){total += l;}
+    }
+    return total/training_paths;
+};
+
+/**
+ * @brief Simulates one block of pricing paths forward and sums their discounted payoffs, 
+ * the paths are exercised on the first date where the exercise value is positive and 
+ * not below the regressed continuation value.
+ * @param engine The engine.
+ * @param payoff The payoff.
+ * @param block The index of the block, its random stream follows the training streams.
+ * @param path The path buffers: the log price, the discounted payoff, the alive 
+ * indicator and the normal draws, MONTE_CARLO_BLOCK values each.
+ * @param moments The output sums.
+ */
+static void forward_block(
+    LongstaffSchwartzEngine& engine, 
+    const MonteCarloPayoff& payoff, 
+    std::size_t block, 
+    std::vector<double>& path, 
+    LongstaffSchwartzMoments& moments)
+{
+    using namespace simd;
+    const std::size_t B = MONTE_CARLO_BLOCK;
+    const std::size_t m = LONGSTAFF_SCHWARTZ_BASIS;
+    const std::size_t draws = engine.antithetic ? B/2 : B;
+    const std::size_t last = engine.dates.size() - 1;
+    double* log_S = &path[0];
+    double* y = &path[B];
+    double* alive = &path[2*B];
+    double* z = &path[3*B];
+    PhiloxStream stream(engine.seed, engine.training_paths/B + block);
+    std::fill_n(log_S, B, std::log(engine.S_));
+    std::fill_n(y, B, 0.0);
+    std::fill_n(alive, B, 1.0);
+
+    const double mu = engine.is_future_ ? 0.0 : engine.r_ - engine.q_;
+    const double S0 = engine.S_;
+    const Pack zero = broadcast(0.0);
+    const Pack never = broadcast(HUGE_VAL);
+    double t = 0.0;
+    for (std::size_t k = 0; k<=last; k++)
+    {
+        const double dt = engine.dates[k] - t;
+        t = engine.dates[k];
+        const Pack drift = broadcast((mu - .5*engine.sigma_*engine.sigma_)*dt);
+        const Pack vol = broadcast(engine.sigma_*std::sqrt(dt));
+        const double df = std::exp(-engine.r_*t);
+        const double* beta = &engine.coefficients[k*m];
+        stream.fill_normal(k*draws, std::span<double>(z, draws));
+        if (engine.antithetic){for (std::size_t j = 0; j<draws; j++){z[draws + j] = -z[j];}}
+        for (std::size_t j = 0; j<B; j += WIDTH)
+        {
+            const Pack x = fmadd(vol, load(&z[j]), load(&log_S[j]) + drift);
+            store(&log_S[j], x);
+            const Pack S = exp(x);
+            const Pack value = exercise_value(payoff, S);
+            const Pack continuation = k==last ? zero 
+                : (engine.regressed[k] ? continuation_value(beta, S/S0) : never);
+            const Mask exercise = (load(&alive[j])>zero) & (value>zero) & (value>=continuation);
+            store(&y[j], load(&y[j]) + select(exercise, df*value, zero));
+            store(&alive[j], select(exercise, zero, load(&alive[j])));
+        }
+    }
+    for (std::size_t j = 0; j<draws; j++)
+    {
+        const double y_j = engine.antithetic ? .5*(y[j] + y[draws + j]) : y[j];
+        moments.y += y_j;
+        moments.yy += y_j*y_j;
+        moments.n++;
+    }
+};
+
+/**
+ * @brief Prices the bermudan option: regresses the continuation values on the training 
+ * paths, then prices on the independent pricing paths.
+ * @param payoff The payoff, the weighted vanilla legs paid on exercise.
+ * @return The estimate, biased low by the sub-optimality of the regressed exercise.
+ * @throw LongstaffSchwartzBarrierPayoff
+ */
+MonteCarloEstimate LongstaffSchwartzEngine::price(const MonteCarloPayoff& payoff)
+{
+    regress(payoff);
+    const std::size_t N = paths/MONTE_CARLO_BLOCK;
+    std::vector<LongstaffSchwartzMoments> moments(N);
+    const std::size_t threads = active_workers(paths*dates.size());
+    std::vector<std::vector<double>> buffers(std::min(threads, N), std::vector<double>(4*MONTE_CARLO_BLOCK));
+    parallel_blocks(threads, N, [&](std::size_t b, std::size_t w)
+    {forward_block(*this, payoff, b, buffers[w], moments[b]);});
+
+    LongstaffSchwartzMoments total;
+    for (std::size_t b = 0; b<N; b++)
+    {
+        total.y += moments[b].y;
+        total.yy += moments[b].yy;
+        total.n += moments[b].n;
+    }
+    const double n = total.n;
+    const double mean = total.y/n;
+    const double variance = std::max((total.yy - n*mean*mean)/(n - 1), 0.0);
+    return {mean, std::sqrt(variance/n), total.n};
+};
@@ -0,0 +1,53 @@
+#pragma once 
+#include <iostream>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "montecarlo.h"
+#include "../../math/probability/random/random.h"
+#include "../../math/simd/simd.h"
+
+class LongstaffSchwartzInvalidDates: public std::exception 
+{public: const char * what() const throw();};
+
+class LongstaffSchwartzBarrierPayoff: public std::exception 
+{public: const char * what() const throw();};
+
+constexpr std::size_t LONGSTAFF_SCHWARTZ_BASIS = 4;
+
+struct LongstaffSchwartzEngine
+{
+    double S_; 
+    double r_; 
+    double q_; 
+    double sigma_; 
+    bool is_future_; 
+    std::vector<double> dates; 
+    std::size_t training_paths; 
+    std::size_t paths; 
+    uint64_t seed; 
+    bool antithetic; 
+    std::size_t workers; 
+    std::vector<double> coefficients; 
+    std::vector<bool> regressed; 
+    std::vector<double> brownian; 
+    std::vector<double> spot; 
+    std::vector<double> cashflow; 
+    std::vector<double> normal_matrix; 
+    std::vector<double> normal_rhs; 
+    LongstaffSchwartzEngine(
+        double S, 
+        double r, 
+        double q, 
+        double sigma, 
+        bool is_future, 
+        std::span<const double> dates, 
+        std::size_t training_paths, 
+        std::size_t paths, 
+        uint64_t seed
+    );
+    ~LongstaffSchwartzEngine(){};
+    std::size_t active_workers(std::size_t path_steps); 
+    double regress(const MonteCarloPayoff& payoff); 
+    MonteCarloEstimate price(const MonteCarloPayoff& payoff); 
+};
@@ -0,0 +1,504 @@
+#include "montecarlo.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+/**
+* @file montecarlo.h
+* @brief This file defines the Monte Carlo pricing engine of the options written on a
+* geometric brownian motion (Black-Scholes for spot underlyings, Black-76 for futures).
+*
+* The paths are simulated by blocks of MONTE_CARLO_BLOCK paths stored in structure of
+* arrays layout, one simd::WIDTH lane per path, and every payoff of the run is evaluated
+* on the same paths. Block b draws its normals from the counter based stream b of the
+* seed and the per block moments are merged in block order, so that the estimates do not
+* depend on the number of workers nor on their scheduling.
+*
+* References :
+* - "Monte Carlo Methods in Financial Engineering", Glasserman, 2003.
+*/
+
+/** 
+ * @class MonteCarloInvalidBarrier
+ * @brief Definition of the invalid barrier levels error.
+ */
+/** 
+ * @brief Definition of what() virtual std::exception function.
+ * @return The explication of the error.
+ */
+const char * MonteCarloInvalidBarrier::what() const throw(){
+    return "A single barrier needs one level and a double barrier needs a lower \
+    level below the upper level";
+};
+
+/** 
+ * @class MonteCarloNonPositivePaths
+ * @brief Definition of the non positive number of paths or time steps error.
+ */
+/** 
+ * @brief Definition of what() virtual std::exception function.
+ * @return The explication of the error.
+ */
+const char * MonteCarloNonPositivePaths::what() const throw(){
+    return "The number of paths and the number of time steps must be positive";
+};
+
+/**
+ * @struct MonteCarloPayoff
+ * @brief A weighted sum of vanilla payoffs paid at the horizon of the simulation, alive 
+ * only if its barrier condition holds on the monitoring dates (the simulation steps).
+ */
+/**
+ * @var std::vector<double> MonteCarloPayoff::cp
+ * @brief The call/put flags (1 or -1) of the legs.
+ */
+/**
+ * @var std::vector<double> MonteCarloPayoff::weights
+ * @brief The quantities of the legs.
+ */
+/**
+ * @var double MonteCarloPayoff::lower_barrier
+ * @brief The down barrier level, 0 if there is none.
+ */
+/**
+ * @var double MonteCarloPayoff::upper_barrier
+ * @brief The up barrier level, infinite if there is none.
+ */
+
+/**
+ * @brief Vanilla payoff constructor.
+ * @param type The option's type.
+ * @param strike The option's strike value.
+ */
+MonteCarloPayoff::MonteCarloPayoff(OptionType type, double strike): 
+    K{strike}, cp{double(type)}, weights{1.0}, has_barrier(false), 
+    barrier_type(DOWN_AND_OUT), lower_barrier(0.0), 
+    upper_barrier(std::numeric_limits<double>::infinity()){};
+
+/**
+ * @brief Single barrier payoff constructor.
+ * @param type The option's type.
+ * @param strike The option's strike value.
+ * @param barrier The barrier type, up or down.
+ * @param level The barrier level.
+ * @throw MonteCarloInvalidBarrier
+ */
+MonteCarloPayoff::MonteCarloPayoff(OptionType type, double strike, BarrierType barrier, double level): 
+    MonteCarloPayoff(type, strike)
+{
+    if (barrier==DOUBLE_KNOCK_IN or barrier==DOUBLE_KNOCK_OUT){throw MonteCarloInvalidBarrier();}
+    has_barrier = true;
+    barrier_type = barrier;
+    if (barrier==UP_AND_IN or barrier==UP_AND_OUT){upper_barrier = level;}
+    else {lower_barrier = level;}
+};
+
+/**
+ * @brief Double barrier payoff constructor.
+ * @param type The option's type.
+ * @param strike The option's strike value.
+ * @param barrier The barrier type, double knock in or double knock out.
+ * @param lower The down barrier level.
+ * @param upper The up barrier level.
+ * @throw MonteCarloInvalidBarrier
+ */
+MonteCarloPayoff::MonteCarloPayoff(OptionType type, double strike, BarrierType barrier, double lower, double upper): 
+    MonteCarloPayoff(type, strike)
+{
+    if ((barrier!=DOUBLE_KNOCK_IN and barrier!=DOUBLE_KNOCK_OUT) or not (lower<upper))
+    {throw MonteCarloInvalidBarrier();}
+    has_barrier = true;
+    barrier_type = barrier;
+    lower_barrier = lower;
+    upper_barrier = upper;
+};
+
+/**
+ * @brief Option constructor, the option is paid at the horizon of the simulation.
+ * @param option The option instrument.
+ * @see Option
+ */
+MonteCarloPayoff::MonteCarloPayoff(const Option& option): 
+    MonteCarloPayoff(option.type_, option.K){};
+
+/**
+ * @brief Structured option constructor, every leg is paid at the horizon of the simulation.
+ * @param option The structured option instrument.
+ * @see StructuredOption
+ */
+MonteCarloPayoff::MonteCarloPayoff(const StructuredOption& option): 
+    has_barrier(false), barrier_type(DOWN_AND_OUT), lower_barrier(0.0), 
+    upper_barrier(std::numeric_limits<double>::infinity())
+{
+    for (std::size_t i = 0; i<option.option_ptrs.size(); i++)
+    {
+        K.push_back(option.option_ptrs[i]->K);
+        cp.push_back(double(option.option_ptrs[i]->type_));
+        weights.push_back(option.weights_[i]);
+    }
+};
+
+/**
+ * @param path_min The minimum of the path on the monitoring dates.
+ * @param path_max The maximum of the path on the monitoring dates.
+ * @return True if the payoff is paid on this path.
+ */
+bool MonteCarloPayoff::alive(double path_min, double path_max)
+{
+    if (not has_barrier){return true;}
+    bool touched = path_min<=lower_barrier or path_max>=upper_barrier;
+    switch (barrier_type)
+    {
+        case UP_AND_IN: case DOWN_AND_IN: case DOUBLE_KNOCK_IN: return touched;
+        default: return not touched;
+    }
+};
+
+/**
+ * @struct MonteCarloEstimate
+ * @brief The Monte Carlo estimate of a price.
+ */
+/**
+ * @var double MonteCarloEstimate::standard_error
+ * @brief The standard error of the estimate.
+ */
+/**
+ * @var std::size_t MonteCarloEstimate::samples
+ * @brief The number of independent samples, antithetic pairs count as one.
+ */
+
+/**
+ * @brief The moments of one payoff Y and of its control X over a set of samples: their means 
+ * and the sums of the products of their deviations from the means, which do not cancel 
+ * when the standard error is small against the price.
+ */
+struct MonteCarloMoments
+{
+    double y = 0.0; 
+    double yy = 0.0; 
+    double x = 0.0; 
+    double xx = 0.0; 
+    double xy = 0.0; 
+    std::size_t n = 0; 
+};
+
+/**
+ * @brief Merges the moments of a set of samples into the moments of another one.
+ * 
+ * References : 
+ * - "Updating formulae and a pairwise algorithm for computing sample variances", Chan, 
+ * Golub, LeVeque, 1979.
+ * @param total The moments of the first set, updated in place.
+ * @param m The moments of the second set.
+ */
+static void merge_moments(MonteCarloMoments& total, const MonteCarloMoments& m)
+{
+    if (m.n==0){return;}
+    const double n = total.n + m.n;
+    const double dy = m.y - total.y;
+    const double dx = m.x - total.x;
+    const double weight = double(total.n)*m.n/n;
+    total.y += dy*m.n/n;
+    total.x += dx*m.n/n;
+    total.yy += m.yy + dy*dy*weight;
+    total.xx += m.xx + dx*dx*weight;
+    total.xy += m.xy + dx*dy*weight;
+    total.n += m.n;
+};
+
+/**
+ * @struct MonteCarloEngine
+ * @brief The Monte Carlo engine of the options written on an underlying following a 
+ * geometric brownian motion with constant rate, carry and volatility.
+ */
+/**
+ * @var std::size_t MonteCarloEngine::steps
+ * @brief The number of time steps, which are also the barrier monitoring dates.
+ */
+/**
+ * @var std::size_t MonteCarloEngine::paths
+ * @brief The number of paths, rounded up to a multiple of MONTE_CARLO_BLOCK.
+ */
+/**
+ * @var bool MonteCarloEngine::antithetic
+ * @brief Indicator if every path is paired with its antithetic path (True by default).
+ */
+/**
+ * @var bool MonteCarloEngine::control_variate
+ * @brief Indicator if the discounted vanilla payoff of the legs, whose price is known in 
+ * closed form, is used as control variate (True by default).
+ */
+/**
+ * @var bool MonteCarloEngine::quasi_random
+ * @brief Indicator if the paths are built from an Owen scrambled Sobol sequence with the
+ * Brownian bridge (False by default), the sequence is seeded by the seed of the run and 
+ * the block b uses its points b*draws onwards, draws being MONTE_CARLO_BLOCK/2 with the
+ * antithetic paths and MONTE_CARLO_BLOCK otherwise. The standard errors keep the
+ * independent samples formula, which overstates the quasi random error.
+ */
+/**
+ * @var std::size_t MonteCarloEngine::workers
+ * @brief The maximum number of worker threads, the hardware concurrency by default.
+ */
+
+/**
+ * @brief MonteCarloEngine constructor
+ * @param S The spot/future price of the underlying.
+ * @param r The interest rate.
+ * @param q The carry cost rate.
+ * @param sigma The volatility.
+ * @param T The year fraction of the horizon.
+ * @param is_future indicator if the underlying is a future (True) or not (False).
+ * @param steps The number of time steps.
+ * @param paths The number of paths.
+ * @param seed The seed of the run.
+ * @throw MonteCarloNonPositivePaths
+ * @throw BlackScholesNonPositivePrice
+ * @throw BlackScholesNonPositiveImpliedVolatility
+ * @throw BlackScholesNonPositiveYearFraction
+ */
+MonteCarloEngine::MonteCarloEngine(
+    double S, 
+    double r, 
+    double q, 
+    double sigma, 
+    double T, 
+    bool is_future, 
+    std::size_t steps, 
+    std::size_t paths, 
+    uint64_t seed): 
+    S_(S), r_(r), q_(q), sigma_(sigma), T_(T), is_future_(is_future), 
+    steps(steps), paths(MONTE_CARLO_BLOCK*((paths + MONTE_CARLO_BLOCK - 1)/MONTE_CARLO_BLOCK)), 
+    seed(seed), antithetic(true), control_variate(true), quasi_random(false), 
+    workers(std::max(1u, std::thread::hardware_concurrency()))
+{
+    if (steps==0 or paths==0){throw MonteCarloNonPositivePaths();}
+    if (not (S>0)){throw BlackScholesNonPositivePrice();}
+    if (not (sigma>0)){throw BlackScholesNonPositiveImpliedVolatility();}
+    if (not (T>0)){throw BlackScholesNonPositiveYearFraction();}
+};
+
+/**
+ * @return The number of blocks of paths.
+ */
+std::size_t MonteCarloEngine::blocks()
+{
+    return paths/MONTE_CARLO_BLOCK;
+};
+
+/**
+ * @return The number of threads a run uses: every thread gets at least
+ * MONTE_CARLO_WORKER_PATH_STEPS path steps, so that the small runs stay on the calling
+ * thread instead of paying for the start of threads that would have nothing to do.
+ */
+std::size_t MonteCarloEngine::active_workers()
+{
+    const std::size_t by_size = std::max<std::size_t>(1, paths*steps/MONTE_CARLO_WORKER_PATH_STEPS);
+    return std::min({workers, blocks(), by_size});
+};
+
+/**
+ * @param payoff The payoff.
+ * @return The closed form price of the control variate: the legs without their barrier.
+ */
+double MonteCarloEngine::control_price(const MonteCarloPayoff& payoff)
+{
+    double price = 0.0;
+    for (std::size_t i = 0; i<payoff.K.size(); i++)
+    {
+        BlackScholesClosedForm model(S_, payoff.K[i], r_, q_, sigma_, T_, payoff.cp[i]>0, is_future_);
+        price += payoff.weights[i]*model.price();
+    }
+    return price;
+};
+
+/**
+ * @brief Simulates one block of paths and accumulates the payoffs evaluated on them.
+ * @param engine The engine.
+ * @param payoffs The payoffs.
+ * @param block The index of the block, which is also the index of its random stream.
+ * @param path The path buffers: the log price, its running minimum and maximum and the 
+ * normal draws, MONTE_CARLO_BLOCK values each.
+ * @param sobol The Sobol sequence of the quasi random runs, nullptr otherwise.
+ * @param bridge The Brownian bridge of the quasi random runs, nullptr otherwise.
+ * @param normals The buffers of the quasi random runs, the Sobol normals and the 
+ * standardised brownian increments of the block, step by step.
+ * @param moments The output moments of the block, one per payoff.
+ */
+static void simulate_block(
+    MonteCarloEngine& engine, 
+    std::vector<MonteCarloPayoff>& payoffs, 
+    std::size_t block, 
+    std::vector<double>& path, 
+    SobolSequence* sobol, 
+    BrownianBridge* bridge, 
+    std::vector<double>& normals, 
+    MonteCarloMoments* moments)
+{
+    using namespace simd;
+    const std::size_t B = MONTE_CARLO_BLOCK;
+    const std::size_t draws = engine.antithetic ? B/2 : B;
+    double* log_S = &path[0];
+    double* log_min = &path[B];
+    double* log_max = &path[2*B];
+    double* z = &path[3*B];
+    PhiloxStream stream(engine.seed, block);
+
+    const double dt = engine.T_/engine.steps;
+    const double mu = engine.is_future_ ? 0.0 : engine.r_ - engine.q_;
+    const Pack drift = broadcast((mu - .5*engine.sigma_*engine.sigma_)*dt);
+    const Pack vol = broadcast(engine.sigma_*std::sqrt(dt));
+    for (std::size_t j = 0; j<B; j++){log_S[j] = log_min[j] = log_max[j] = std::log(engine.S_);}
+    if (sobol)
+    {
+        // The bridge runs on the unit time grid, its increments are standard normals.
+        const std::size_t size = engine.steps*draws;
+        std::span<double> sobol_normals(&normals[0], size);
+        std::span<double> brownian(&normals[size], size);
+        sobol->skip_to(block*draws);
+        sobol->next_normal(draws, sobol_normals);
+        bridge->build(sobol_normals, brownian, draws);
+        for (std::size_t k = engine.steps - 1; k>0; k--)
+        {for (std::size_t j = 0; j<draws; j++){brownian[k*draws + j] -= brownian[(k-1)*draws + j];}}
+    }
+    for (std::size_t k = 0; k<engine.steps; k++)
+    {
+        if (sobol){std::copy_n(&normals[(engine.steps + k)*draws], draws, z);}
+        else {stream.fill_normal(k*draws, std::span<double>(z, draws));}
+        if (engine.antithetic){for (std::size_t j = 0; j<draws; j++){z[draws + j] = -z[j];}}
+        for (std::size_t j = 0; j<B; j += WIDTH)
+        {
+            const Pack x = fmadd(vol, load(&z[j]), load(&log_S[j]) + drift);
+            store(&log_S[j], x);
+            store(&log_min[j], min(load(&log_min[j]), x));
+            store(&log_max[j], max(load(&log_max[j]), x));
+        }
+    }
+    // The log prices are exponentiated in place.
+    double* S_T = log_S;
+    double* S_min = log_min;
+    double* S_max = log_max;
+    for (std::size_t j = 0; j<B; j += WIDTH)
+    {
+        store(&S_T[j], exp(load(&log_S[j])));
+        store(&S_min[j], exp(load(&log_min[j])));
+        store(&S_max[j], exp(load(&log_max[j])));
+    }
+
+    // The discounted payoff Y and control X of every path, reusing the normal buffer.
+    const double df = std::exp(-engine.r_*engine.T_);
+    double* y = z;
+    double* x = &path[4*B];
+    for (std::size_t p = 0; p<payoffs.size(); p++)
+    {
+        MonteCarloPayoff& payoff = payoffs[p];
+        for (std::size_t j = 0; j<B; j++)
+        {
+            double vanilla = 0.0;
+            for (std::size_t i = 0; i<payoff.K.size(); i++)
+            {vanilla += payoff.weights[i]*std::max(payoff.cp[i]*(S_T[j] - payoff.K[i]), 0.0);}
+            x[j] = df*vanilla;
+            y[j] = payoff.alive(S_min[j], S_max[j]) ? x[j] : 0.0;
+        }
+        // The samples of the block, antithetic pairs averaged, then their means and deviations.
+        if (engine.antithetic)
+        {
+            for (std::size_t j = 0; j<draws; j++)
+            {
+                y[j] = .5*(y[j] + y[draws + j]);
+                x[j] = .5*(x[j] + x[draws + j]);
+            }
+        }
+        MonteCarloMoments& m = moments[p];
+        m = MonteCarloMoments();
+        for (std::size_t j = 0; j<draws; j++){m.y += y[j]; m.x += x[j];}
+        m.y /= draws;
+        m.x /= draws;
+        for (std::size_t j = 0; j<draws; j++)
+        {
+            const double dy = y[j] - m.y;
+            const double dx = x[j] - m.x;
+            m.yy += dy*dy;
+            m.xx += dx*dx;
+            m.xy += dx*dy;
+        }
+        m.n = draws;
+    }
+};
+
+/**
+ * @brief Prices several payoffs on the same paths, the blocks of paths are shared 
+ * between the workers.
+ * @param payoffs The payoffs.
+ * @return The estimates, one per payoff.
+ * @throw SobolDimensionOutOfRange
+ */
+std::vector<MonteCarloEstimate> MonteCarloEngine::price(std::vector<MonteCarloPayoff>& payoffs)
+{
+    const std::size_t P = payoffs.size();
+    const std::size_t N = blocks();
+    std::vector<MonteCarloMoments> moments(N*P);
+    // The sequence and the bridge are built, and their inputs checked, before any worker
+    // starts: an exception thrown inside a worker would terminate the program.
+    std::unique_ptr<SobolSequence> sobol_prototype;
+    std::unique_ptr<BrownianBridge> bridge;
+    if (quasi_random)
+    {
+        sobol_prototype = std::make_unique<SobolSequence>(steps, seed);
+        bridge = std::make_unique<BrownianBridge>(steps, double(steps));
+    }
+    std::atomic<std::size_t> next{0};
+    auto work = [&]()
+    {
+        std::vector<double> path(5*MONTE_CARLO_BLOCK);
+        std::vector<double> normals;
+        std::unique_ptr<SobolSequence> sobol;
+        if (quasi_random)
+        {
+            sobol = std::make_unique<SobolSequence>(*sobol_prototype);
+            normals.resize(2*steps*MONTE_CARLO_BLOCK);
+        }
+        for (std::size_t b = next++; b<N; b = next++)
+        {simulate_block(*this, payoffs, b, path, sobol.get(), bridge.get(), normals, &moments[b*P]);}
+    };
+    std::vector<std::thread> pool;
+    for (std::size_t w = 1; w<active_workers(); w++){pool.emplace_back(work);}
+    work();
+    for (std::thread& thread: pool){thread.join();}
+
+    std::vector<MonteCarloEstimate> estimates(P);
+    for (std::size_t p = 0; p<P; p++)
+    {
+        // The blocks are merged in order so that the moments do not depend on the workers.
+        MonteCarloMoments total;
+        for (std::size_t b = 0; b<N; b++){merge_moments(total, moments[b*P + p]);}
+        const double n = total.n;
+        const double mean_y = total.y;
+        const double mean_x = total.x;
+        const double var_y = total.yy/(n - 1);
+        const double var_x = total.xx/(n - 1);
+        const double cov_xy = total.xy/(n - 1);
+        double price = mean_y;
+        double variance = var_y;
+        if (control_variate and var_x>0)
+        {
+            const double beta = cov_xy/var_x;
+            price = mean_y - beta*(mean_x - control_price(payoffs[p]));
+            variance = std::max(var_y - beta*cov_xy, 0.0);
+        }
+        estimates[p] = {price, sqrt(variance/n), total.n};
+    }
+    return estimates;
+};
+
+/**
+ * @brief Prices one payoff.
+ * @param payoff The payoff.
+ * @return The estimate.
+ */
+MonteCarloEstimate MonteCarloEngine::price(MonteCarloPayoff& payoff)
+{
+    std::vector<MonteCarloPayoff> payoffs = {payoff};
+    return price(payoffs)[0];
+};
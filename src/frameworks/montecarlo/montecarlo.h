@@ -0,0 +1,78 @@
+#pragma once 
+#include <iostream>
+#include <cstdint>
+#include <vector>
+#include "../../datastructure/instruments/option/option.h"
+#include "../../frameworks/blackscholes/blackscholes.h"
+#include "../../math/probability/random/random.h"
+#include "../../math/probability/sobol/sobol.h"
+#include "../../math/probability/brownianbridge/brownianbridge.h"
+#include "../../math/simd/simd.h"
+
+class MonteCarloInvalidBarrier: public std::exception 
+{public: const char * what() const throw();};
+
+class MonteCarloNonPositivePaths: public std::exception 
+{public: const char * what() const throw();};
+
+constexpr std::size_t MONTE_CARLO_BLOCK = 512;
+constexpr std::size_t MONTE_CARLO_WORKER_PATH_STEPS = 1 << 16;
+
+struct MonteCarloPayoff
+{
+    std::vector<double> K; 
+    std::vector<double> cp; 
+    std::vector<double> weights; 
+    bool has_barrier; 
+    BarrierType barrier_type; 
+    double lower_barrier; 
+    double upper_barrier; 
+    MonteCarloPayoff(OptionType type, double strike); 
+    MonteCarloPayoff(OptionType type, double strike, BarrierType barrier, double level); 
+    MonteCarloPayoff(OptionType type, double strike, BarrierType barrier, double lower, double upper); 
+    MonteCarloPayoff(const Option& option); 
+    MonteCarloPayoff(const StructuredOption& option); 
+    ~MonteCarloPayoff(){};
+    bool alive(double path_min, double path_max);
+};
+
+struct MonteCarloEstimate
+{
+    double price; 
+    double standard_error; 
+    std::size_t samples; 
+};
+
+struct MonteCarloEngine
+{
+    double S_; 
+    double r_; 
+    double q_; 
+    double sigma_; 
+    double T_; 
+    bool is_future_; 
+    std::size_t steps; 
+    std::size_t paths; 
+    uint64_t seed; 
+    bool antithetic; 
+    bool control_variate; 
+    bool quasi_random; 
+    std::size_t workers; 
+    MonteCarloEngine(
+        double S, 
+        double r, 
+        double q, 
+        double sigma, 
+        double T, 
+        bool is_future, 
+        std::size_t steps, 
+        std::size_t paths, 
+        uint64_t seed
+    );
+    ~MonteCarloEngine(){};
+    std::size_t blocks(); 
+    std::size_t active_workers(); 
+    double control_price(const MonteCarloPayoff& payoff); 
+    std::vector<MonteCarloEstimate> price(std::vector<MonteCarloPayoff>& payoffs); 
+    MonteCarloEstimate price(MonteCarloPayoff& payoff); 
+};
@@ -1,4 +1,5 @@
 #include "nelsonsiegel.h"
+#include <cmath>
 
 /** 
 * @file nelsonsiegel.h
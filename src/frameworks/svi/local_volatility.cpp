@@ -0,0 +1,264 @@
+#include "local_volatility.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include "vol_surface.h"
+#include "../../math/simd/simd.h"
+
+/** 
+* @file local_volatility.h
+* @brief This file defines the Dupire local variance grid of a sequence of SVI slices.
+* 
+* In total variance w(k, T) at fixed log moneyness, the local variance is 
+* dw/dT / g(k), with Durrleman's density 
+* g(k) = (1 - k*w'/(2w))^2 - w'^2/4*(1/w + 1/4) + w''/2. The grid is built at the expiries of 
+* the slices: w, w' and w'' are analytic in k, and dw/dT = w/T*dlog(w)/dlog(T) is the 
+* derivative of the quadratic in log(T) of log(w) through the slice and its neighbours. A 
+* total variance close to a power of T, as the short expiries of most surfaces, is then 
+* differentiated accurately even where the expiries are far apart relative to T. The 
+* density is floored by density_floor, dw/dT by 0 and the local variance by variance_floor, 
+* NaN included, so that a slice with a little arbitrage does not break the engines 
+* sampling the grid. The rows are built in parallel over the expiries.
+* 
+* The grid is interpolated bilinearly in (k, T), and extrapolated flat outside of it. A grid 
+* without expiry, such as one never built, throws on its queries.
+*/
+
+/** 
+ * @struct LocalVolatilityGrid
+ * @brief The Dupire local variances of raw SVI slices on a (log moneyness, expiry) grid. 
+ */
+/**
+ * @var std::vector<double> LocalVolatilityGrid::k_
+ * @brief The uniform log moneyness grid k_min + i*dk, i < nk.
+ */
+/**
+ * @var std::vector<double> LocalVolatilityGrid::w
+ * @brief The total variances, the row of the slice j starting at j*nk.
+ */
+/**
+ * @var std::vector<double> LocalVolatilityGrid::density
+ * @brief The unfloored densities g(k), in the layout of w.
+ */
+/**
+ * @var std::vector<double> LocalVolatilityGrid::variance
+ * @brief The floored local variances, in the layout of w.
+ */
+/**
+ * @var double LocalVolatilityGrid::density_floor
+ * @brief The floor of the density, LOCAL_VOLATILITY_DENSITY_FLOOR by default.
+ */
+/**
+ * @var double LocalVolatilityGrid::variance_floor
+ * @brief The floor of the local variance, LOCAL_VOLATILITY_VARIANCE_FLOOR by default.
+ */
+/**
+ * @var std::size_t LocalVolatilityGrid::workers
+ * @brief The maximum number of worker threads of build(), the hardware concurrency by 
+ * default. A worker is only started for every LOCAL_VOLATILITY_POINTS_PER_WORKER points.
+ */
+
+/**
+ * @brief The main constructor, without slice.
+ * @param k_min The lowest log moneyness of the grid.
+ * @param k_max The highest log moneyness of the grid.
+ * @param nk The number of points of the grid.
+ * @throw VolSurfaceInvalidGrid
+ */
+LocalVolatilityGrid::LocalVolatilityGrid(double k_min, double k_max, std::size_t nk): 
+    k_min(k_min), dk((k_max - k_min)/((double)nk - 1)), nk(nk), 
+    density_floor(LOCAL_VOLATILITY_DENSITY_FLOOR), variance_floor(LOCAL_VOLATILITY_VARIANCE_FLOOR), 
+    workers(std::max(1u, std::thread::hardware_concurrency()))
+{
+    if (nk<2 or not (k_max>k_min)){throw VolSurfaceInvalidGrid();}
+    k_.resize(nk);
+    for (std::size_t i = 0; i<nk; i++){k_[i] = k_min + (double)i*dk;}
+};
+
+/**
+ * @return The number of expiries of the grid.
+ */
+std::size_t LocalVolatilityGrid::size()
+{
+    return T_.size();
+};
+
+/**
+ * @brief Runs work(j) for every expiry, the expiries being shared between the workers.
+ * @param grid The local volatility grid.
+ * @param work The work of one expiry.
+ */
+template <typename Work>
+static void for_each_expiry(LocalVolatilityGrid& grid, Work work)
+{
+    const std::size_t n = grid.size();
+    std::atomic<std::size_t> next{0};
+    auto run = [&]()
+    {for (std::size_t j = next++; j<n; j = next++){work(j);}};
+    const std::size_t count = std::min({grid.workers, n, 
+        1 + n*grid.nk/LOCAL_VOLATILITY_POINTS_PER_WORKER});
+    std::vector<std::thread> pool;
+    for (std::size_t worker = 1; worker<count; worker++){pool.emplace_back(run);}
+    run();
+    for (std::thread& thread: pool){thread.join();}
+};
+
+/**
+ * @brief Builds the grid at the expiries of the slices, replacing the previous one.
+ * @param slices The raw SVI slices.
+ * @param t The year fractions of the slices, increasing.
+ * @throw SVIBatchSizeMismatch
+ * @throw VolSurfaceUnsortedSlices
+ */
+void LocalVolatilityGrid::build(std::span<const RawSVI> slices, std::span<const double> t)
+{
+    const std::size_t n = t.size();
+    if (slices.size()!=n){throw SVIBatchSizeMismatch();}
+    for (std::size_t j = 0; j<n; j++)
+    {if (not (t[j]>(j==0 ? 0.0 : t[j-1]))){throw VolSurfaceUnsortedSlices();}}
+    T_.assign(t.begin(), t.end());
+    w.resize(n*nk);
+    density.resize(n*nk);
+    variance.resize(n*nk);
+
+    std::vector<double> log_w(n*nk);
+    for_each_expiry(*this, [&](std::size_t j)
+    {
+        RawSVI slice = slices[j];
+        slice.evaluate(k_, T_[j], std::span<double>(&w[j*nk], nk), std::span<double>(),
+            std::span<double>(), std::span<double>(&density[j*nk], nk));
+        using namespace simd;
+        std::size_t i = 0;
+        for (; i + simd::WIDTH<=nk; i += simd::WIDTH){store(&log_w[j*nk + i], log(load(&w[j*nk + i])));}
+        for (; i<nk; i++){log_w[j*nk + i] = std::log(w[j*nk + i]);}
+    });
+
+    for_each_expiry(*this, [&](std::size_t j)
+    {
+        // The quadratic in log(T) of log(w) through the slice and its neighbours, a single 
+        // slice being taken proportional to T.
+        const std::size_t count = std::min(n, (std::size_t)3);
+        const std::size_t first = std::min(j - std::min(j, (std::size_t)1), n - count);
+        double nodes[3];
+        for (std::size_t l = 0; l<count; l++){nodes[l] = std::log(T_[first + l]);}
+        double weights[3] = {0.0, 0.0, 0.0};
+        if (count==1){weights[0] = 1.0;}
+        for (std::size_t l = 0; l<count and count>1; l++)
+        {
+            // The derivative at log(T_j) of the Lagrange basis polynomial of the node l.
+            for (std::size_t m = 0; m<count; m++)
+            {
+                if (m==l){continue;}
+                double term = 1/(nodes[l] - nodes[m]);
+                for (std::size_t o = 0; o<count; o++)
+                {if (o!=l and o!=m){term *= (nodes[j - first] - nodes[o])/(nodes[l] - nodes[o]);}}
+                weights[l] += term;
+            }
+        }
+        for (std::size_t i = 0; i<nk; i++)
+        {
+            double elasticity = 0.0;
+            if (count==1){elasticity = 1.0;}
+            else {for (std::size_t l = 0; l<count; l++){elasticity += weights[l]*log_w[(first + l)*nk + i];}}
+            double dwdt = elasticity*w[j*nk + i]/T_[j];
+            if (not (dwdt>0)){dwdt = 0.0;}
+            // The comparisons send a NaN density or variance to its floor.
+            const double g = density[j*nk + i];
+            const double local = dwdt/(not (g>density_floor) ? density_floor : g);
+            variance[j*nk + i] = not (local>variance_floor) ? variance_floor : local;
+        }
+    });
+};
+
+/**
+ * @brief The rows and weights of a year fraction, flat outside of the expiries.
+ * @param grid The local volatility grid.
+ * @param t The year fraction.
+ * @param row0 The output first row.
+ * @param row1 The output second row.
+ * @param c1 The output weight of the second row.
+ * @throw VolSurfaceEmpty
+ */
+static void expiry_rows(LocalVolatilityGrid& grid, double t, const double*& row0, 
+    const double*& row1, double& c1)
+{
+    const std::vector<double>& T = grid.T_;
+    if (T.empty()){throw VolSurfaceEmpty();}
+    const std::size_t j = std::upper_bound(T.begin(), T.end(), t) - T.begin();
+    if (j==0 or j==T.size())
+    {
+        row0 = row1 = &grid.variance[(j==0 ? 0 : j - 1)*grid.nk];
+        c1 = 0.0;
+        return;
+    }
+    row0 = &grid.variance[(j - 1)*grid.nk];
+    row1 = row0 + grid.nk;
+    c1 = (t - T[j - 1])/(T[j] - T[j - 1]);
+};
+
+/**
+ * @brief The linear interpolation of two rows at a log moneyness, flat outside of the grid.
+ * @param grid The local volatility grid.
+ * @param row0 The first row.
+ * @param row1 The second row.
+ * @param c1 The weight of the second row.
+ * @param k The log moneyness.
+ * @return The interpolated local variance.
+ */
+static double interpolate(LocalVolatilityGrid& grid, const double* row0, const double* row1, 
+    double c1, double k)
+{
+    const double x = std::min(std::max((k - grid.k_min)/grid.dk, 0.0), (double)(grid.nk - 1));
+    const std::size_t i = std::min((std::size_t)x, grid.nk - 2);
+    const double f = x - (double)i;
+    const double v0 = row0[i] + f*(row0[i + 1] - row0[i]);
+    const double v1 = row1[i] + f*(row1[i + 1] - row1[i]);
+    return v0 + c1*(v1 - v0);
+};
+
+/**
+ * @param k The log moneyness.
+ * @param t The year fraction.
+ * @return The interpolated local variance.
+ * @throw VolSurfaceEmpty
+ */
+double LocalVolatilityGrid::local_variance(double k, double t)
+{
+    const double* row0;
+    const double* row1;
+    double c1;
+    expiry_rows(*this, t, row0, row1, c1);
+    return interpolate(*this, row0, row1, c1, k);
+};
+
+/**
+ * @param k The log moneyness.
+ * @param t The year fraction.
+ * @return The interpolated local volatility.
+ * @throw VolSurfaceEmpty
+ */
+double LocalVolatilityGrid::local_volatility(double k, double t)
+{
+    return std::sqrt(local_variance(k, t));
+};
+
+/**
+ * @brief Interpolates the local volatilities of a set of log moneyness at one year 
+ * fraction, such as the paths of a Monte Carlo time step, the expiries being found once.
+ * @param k The log moneyness.
+ * @param t The year fraction.
+ * @param local_volatility The output local volatilities.
+ * @throw SVIBatchSizeMismatch
+ * @throw VolSurfaceEmpty
+ */
+void LocalVolatilityGrid::evaluate(std::span<const double> k, double t, 
+    std::span<double> local_volatility)
+{
+    if (local_volatility.size()!=k.size()){throw SVIBatchSizeMismatch();}
+    const double* row0;
+    const double* row1;
+    double c1;
+    expiry_rows(*this, t, row0, row1, c1);
+    for (std::size_t i = 0; i<k.size(); i++)
+    {local_volatility[i] = std::sqrt(interpolate(*this, row0, row1, c1, k[i]));}
+};
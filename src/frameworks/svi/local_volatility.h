@@ -0,0 +1,32 @@
+#pragma once 
+#include <iostream>
+#include <cmath>
+#include <span>
+#include <vector>
+#include "svi.h"
+
+constexpr double LOCAL_VOLATILITY_DENSITY_FLOOR = 1e-4;
+constexpr double LOCAL_VOLATILITY_VARIANCE_FLOOR = 1e-6;
+constexpr std::size_t LOCAL_VOLATILITY_POINTS_PER_WORKER = 1 << 16;
+
+struct LocalVolatilityGrid
+{
+    double k_min; 
+    double dk; 
+    std::size_t nk; 
+    std::vector<double> k_; 
+    std::vector<double> T_; 
+    std::vector<double> w; 
+    std::vector<double> density; 
+    std::vector<double> variance; 
+    double density_floor; 
+    double variance_floor; 
+    std::size_t workers; 
+    LocalVolatilityGrid(double k_min, double k_max, std::size_t nk); 
+    ~LocalVolatilityGrid(){}; 
+    std::size_t size(); 
+    void build(std::span<const RawSVI> slices, std::span<const double> t); 
+    double local_variance(double k, double t); 
+    double local_volatility(double k, double t); 
+    void evaluate(std::span<const double> k, double t, std::span<double> local_volatility); 
+};
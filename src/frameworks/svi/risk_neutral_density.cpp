@@ -0,0 +1,525 @@
+#include "risk_neutral_density.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include "vol_surface.h"
+#include "../../math/numbers.h"
+#include "../../math/simd/simd.h"
+
+/**
+* @file risk_neutral_density.h
+* @brief This file defines the risk neutral densities of a sequence of SVI slices, tabulated
+* once per expiry and used to price european payoffs by quadrature.
+*
+* The density of the log moneyness k = log(S/F) at expiry is
+* g(k)/sqrt(2*pi*w)*exp(-d2^2/2), with d2 = -k/sqrt(w) - sqrt(w)/2 and g the density
+* of SVI::risk_neutral_density(). Each expiry has its own grid
+* k = center + scale*sinh(u), u uniform, centered on the ATM log moneyness mean -w(0)/2 and
+* scaled by the ATM standard deviation sqrt(w(0)): the nodes gather where the density is
+* large and spread in the wings, which end where the density, weighted by the underlying price
+* on the right, falls under tail_tolerance. The trapezoidal rule in u of a smooth decaying
+* integrand converges geometrically, so a few hundred nodes price a smooth payoff to machine
+* precision, while the kink of a tabulated vanilla payoff limits it to second order.
+* Negative densities, from a slice with butterfly arbitrage, are set to 0 and the density is
+* normalised to a unit mass: the prices stay those of a valid measure, but the forward of
+* such a slice is no longer repriced exactly and mass keeps track of the correction.
+*
+* A tabulated payoff costs one SIMD dot product with the quadrature weights. Calls, puts and
+* digitals use the cumulative probabilities and partial expectations of the underlying price,
+* summed cell by cell with the 4 point cubic rule: the strike is located in O(1) by inverting
+* the grid map and its cell is integrated up to the strike only, so that these prices
+* converge to fourth order whatever the strike. A whole strip of
+* strikes is then priced for the cost of a single pass over the grid.
+*/
+
+/**
+ * @class RiskNeutralDensityUnknownExpiry
+ * @brief Definition of the error when an expiry index is not one of the grid.
+ */
+/**
+ * @brief Definition of what() virtual std::exception function.
+ * @return The explication of the error.
+ */
+const char * RiskNeutralDensityUnknownExpiry::what() const throw(){
+    return "The expiry index must be lower than the number of expiries of the grid.";
+};
+
+/**
+ * @class RiskNeutralDensityExpiryMismatch
+ * @brief Definition of the error when an option is priced on the density of another expiry.
+ */
+/**
+ * @brief Definition of what() virtual std::exception function.
+ * @return The explication of the error.
+ */
+const char * RiskNeutralDensityExpiryMismatch::what() const throw(){
+    return "The expiry of every leg of the option must be the expiry of the density.";
+};
+
+/**
+ * @struct RiskNeutralDensityGrid
+ * @brief The normalised risk neutral densities of raw SVI slices, with the cumulative tables
+ * of the quadrature pricing. The tables of the expiry j start at j*nk.
+ */
+/**
+ * @var std::size_t RiskNeutralDensityGrid::nk
+ * @brief The number of nodes of every expiry.
+ */
+/**
+ * @var std::vector<double> RiskNeutralDensityGrid::T_
+ * @brief The year fractions of the expiries.
+ */
+/**
+ * @var std::vector<double> RiskNeutralDensityGrid::F_
+ * @brief The forward prices of the expiries.
+ */
+/**
+ * @var std::vector<double> RiskNeutralDensityGrid::D_
+ * @brief The discount factors of the expiries.
+ */
+/**
+ * @var std::vector<double> RiskNeutralDensityGrid::center
+ * @brief The log moneyness k at u = 0 of the expiries.
+ */
+/**
+ * @var std::vector<double> RiskNeutralDensityGrid::scale
+ * @brief The log moneyness scales of the grid maps of the expiries.
+ */
+/**
+ * @var std::vector<double> RiskNeutralDensityGrid::u_min
+ * @brief The first u nodes of the expiries.
+ */
+/**
+ * @var std::vector<double> RiskNeutralDensityGrid::du
+ * @brief The u steps of the expiries.
+ */
+/**
+ * @var std::vector<double> RiskNeutralDensityGrid::mass
+ * @brief The masses of the floored densities before normalisation, 1 up to the truncation of
+ * the tails for an arbitrage free slice.
+ */
+/**
+ * @var std::vector<double> RiskNeutralDensityGrid::k_
+ * @brief The log moneyness nodes.
+ */
+/**
+ * @var std::vector<double> RiskNeutralDensityGrid::density
+ * @brief The normalised densities of k at the nodes.
+ */
+/**
+ * @var std::vector<double> RiskNeutralDensityGrid::weights
+ * @brief The quadrature weights of the nodes, of unit sum on every expiry.
+ */
+/**
+ * @var std::vector<double> RiskNeutralDensityGrid::share_weights
+ * @brief The quadrature weights times S/F = exp(k_i).
+ */
+/**
+ * @var std::vector<double> RiskNeutralDensityGrid::lower
+ * @brief The probabilities P(k < k_i).
+ */
+/**
+ * @var std::vector<double> RiskNeutralDensityGrid::lower_share
+ * @brief The partial expectations E[S/F; k < k_i].
+ */
+/**
+ * @var double RiskNeutralDensityGrid::tail_tolerance
+ * @brief The density level at which the grids end, RISK_NEUTRAL_DENSITY_TAIL_TOLERANCE by
+ * default. The grids are never wider than RISK_NEUTRAL_DENSITY_MAX_WIDTH ATM standard
+ * deviations on each side.
+ */
+/**
+ * @var std::size_t RiskNeutralDensityGrid::workers
+ * @brief The maximum number of worker threads of build(), the hardware concurrency by
+ * default. A worker is only started for every RISK_NEUTRAL_DENSITY_POINTS_PER_WORKER nodes.
+ */
+
+/**
+ * @brief The main constructor, without expiry.
+ * @param nk The number of nodes of every expiry.
+ * @throw VolSurfaceInvalidGrid
+ */
+RiskNeutralDensityGrid::RiskNeutralDensityGrid(std::size_t nk):
+    nk(nk), tail_tolerance(RISK_NEUTRAL_DENSITY_TAIL_TOLERANCE),
+    workers(std::max(1u, std::thread::hardware_concurrency()))
+{
+    if (nk<3){throw VolSurfaceInvalidGrid();}
+};
+
+/**
+ * @return The number of expiries of the grid.
+ */
+std::size_t RiskNeutralDensityGrid::size()
+{
+    return F_.size();
+};
+
+/**
+ * @brief Runs work(j) for every expiry, the expiries being shared between the workers.
+ * @param grid The risk neutral density grid.
+ * @param work The work of one expiry.
+ */
+template <typename Work>
+static void for_each_expiry(RiskNeutralDensityGrid& grid, Work work)
+{
+    const std::size_t n = grid.size();
+    std::atomic<std::size_t> next{0};
+    auto run = [&]()
+    {for (std::size_t j = next++; j<n; j = next++){work(j);}};
+    const std::size_t count = std::min({grid.workers, n,
+        1 + n*grid.nk/RISK_NEUTRAL_DENSITY_POINTS_PER_WORKER});
+    std::vector<std::thread> pool;
+    for (std::size_t worker = 1; worker<count; worker++){pool.emplace_back(run);}
+    run();
+    for (std::thread& thread: pool){thread.join();}
+};
+
+/**
+ * @param slice The raw SVI slice.
+ * @param k The log moneyness.
+ * @return The density of the log moneyness at expiry.
+ */
+static double log_moneyness_density(RawSVI& slice, double k)
+{
+    const double w = slice.total_variance(k);
+    const double d2 = -k/std::sqrt(w) - .5*std::sqrt(w);
+    return slice.risk_neutral_density(k)*std::exp(-.5*d2*d2)/std::sqrt(2*numbers::PI*w);
+};
+
+/**
+ * @brief Widens one side of the grid of a slice until the tail is negligible.
+ * @param grid The risk neutral density grid.
+ * @param slice The raw SVI slice.
+ * @param j The expiry index.
+ * @param side -1 for the left tail, 1 for the right one.
+ * @return The end of the side in units of scale, the argument of the asinh map.
+ */
+static double tail_width(RiskNeutralDensityGrid& grid, RawSVI& slice, std::size_t j, double side)
+{
+    double width = 4.0;
+    for (; width<RISK_NEUTRAL_DENSITY_MAX_WIDTH; width *= 1.25)
+    {
+        const double k = grid.center[j] + side*width*grid.scale[j];
+        const double tail = std::fabs(log_moneyness_density(slice, k))*std::max(1.0, std::exp(k));
+        if (tail*grid.scale[j]<grid.tail_tolerance){break;}
+    }
+    return side*std::min(width, RISK_NEUTRAL_DENSITY_MAX_WIDTH);
+};
+
+/**
+ * @brief Gathers the values at the 4 nearest nodes of a cell, those beyond the grid being 0.
+ * @param f The values at the nodes.
+ * @param nk The number of nodes.
+ * @param i The cell [u_i, u_i+1].
+ * @param values The output values at the nodes i-1 to i+2.
+ */
+static void cell_values(const double* f, std::size_t nk, std::size_t i, double* values)
+{
+    values[0] = i>0 ? f[i-1] : 0.0;
+    values[1] = f[i];
+    values[2] = f[i+1];
+    values[3] = i + 2<nk ? f[i+2] : 0.0;
+};
+
+/**
+ * @brief Integrates over a part of a cell the cubic through the values of its 4 nearest
+ * nodes.
+ * @param values The values at the nodes i-1 to i+2, the integrand in u times du.
+ * @param fraction The integrated part [u_i, u_i + fraction*du] of the cell [u_i, u_i+1].
+ * @return The integral, (-f_i-1 + 13f_i + 13f_i+1 - f_i+2)/24 on the whole cell.
+ */
+static double cell_integral(const double* values, double fraction)
+{
+    const double x2 = fraction*fraction;
+    const double x3 = x2*fraction;
+    const double x4 = x3*fraction;
+    return -values[0]*(.25*x4 - x3 + x2)/6 + values[1]*(.25*x4 - 2*x3/3 - .5*x2 + 2*fraction)/2
+        - values[2]*(.25*x4 - x3/3 - x2)/2 + values[3]*(.25*x4 - .5*x2)/6;
+};
+
+/**
+ * @brief Tabulates the densities and the cumulative tables of the slices, replacing the
+ * previous ones.
+ * @param slices The raw SVI slices, one per expiry.
+ * @param T The year fractions of the expiries.
+ * @param forward The forward prices of the expiries, positive.
+ * @param discount_factor The discount factors of the expiries, positive.
+ * @throw SVIBatchSizeMismatch
+ * @throw SVIWrongParameterValue
+ */
+void RiskNeutralDensityGrid::build(
+    std::span<const RawSVI> slices,
+    std::span<const double> T,
+    std::span<const double> forward,
+    std::span<const double> discount_factor)
+{
+    const std::size_t n = slices.size();
+    if (T.size()!=n or forward.size()!=n or discount_factor.size()!=n){throw SVIBatchSizeMismatch();}
+    for (std::size_t j = 0; j<n; j++)
+    {
+        RawSVI slice = slices[j];
+        if (not (slice.atm_total_variance()>0 and T[j]>0 and forward[j]>0 and discount_factor[j]>0))
+        {throw SVIWrongParameterValue();}
+    }
+    T_.assign(T.begin(), T.end());
+    F_.assign(forward.begin(), forward.end());
+    D_.assign(discount_factor.begin(), discount_factor.end());
+    for (std::vector<double>* row: {&center, &scale, &u_min, &du, &mass}){row->resize(n);}
+    for (std::vector<double>* table: {&k_, &density, &weights, &share_weights, &lower, &lower_share})
+    {table->resize(n*nk);}
+
+    for_each_expiry(*this, [&](std::size_t j)
+    {
+        RawSVI slice = slices[j];
+        const double theta = slice.atm_total_variance();
+        center[j] = -.5*theta;
+        scale[j] = std::sqrt(theta);
+        u_min[j] = std::asinh(tail_width(*this, slice, j, -1.0));
+        du[j] = (std::asinh(tail_width(*this, slice, j, 1.0)) - u_min[j])/((double)nk - 1);
+
+        double* k = &k_[j*nk];
+        double* p = &density[j*nk];
+        double* w = &lower[j*nk];
+        for (std::size_t i = 0; i<nk; i++){k[i] = center[j] + scale[j]*std::sinh(u_min[j] + (double)i*du[j]);}
+        slice.evaluate(std::span<const double>(k, nk), 1.0, std::span<double>(w, nk),
+            std::span<double>(), std::span<double>(), std::span<double>(p, nk));
+
+        // The densities of k and the quadrature weights p(k)*dk/du*du, dk/du being
+        // sqrt(scale^2 + (k - center)^2).
+        using namespace simd;
+        const Pack c = broadcast(center[j]);
+        const Pack scale2 = broadcast(scale[j]*scale[j]);
+        const Pack normal = broadcast(1/std::sqrt(2*numbers::PI));
+        const Pack step = broadcast(du[j]);
+        auto block = [&](const double* k_, const double* w_, double* p_, double* weight_)
+        {
+            const Pack x = load(k_);
+            const Pack root = sqrt(load(w_));
+            const Pack d2 = -x/root - .5*root;
+            const Pack q = load(p_)*normal/root*exp(-.5*d2*d2);
+            const Pack positive = select(q>broadcast(0.0), q, broadcast(0.0));
+            const Pack shift = x - c;
+            store(p_, positive);
+            store(weight_, positive*step*sqrt(fmadd(shift, shift, scale2)));
+        };
+        double* weight = &weights[j*nk];
+        const std::size_t full = nk - nk%simd::WIDTH;
+        for (std::size_t i = 0; i<full; i += simd::WIDTH){block(k + i, w + i, p + i, weight + i);}
+        if (full<nk)
+        {
+            double tail[4][simd::WIDTH] = {};
+            std::copy(k + full, k + nk, tail[0]);
+            std::copy(w + full, w + nk, tail[1]);
+            std::copy(p + full, p + nk, tail[2]);
+            block(tail[0], tail[1], tail[2], tail[3]);
+            std::copy_n(tail[2], nk - full, p + full);
+            std::copy_n(tail[3], nk - full, weight + full);
+        }
+
+        // The cumulative tables by cell, then the normalisation to a unit mass.
+        double* cdf = &lower[j*nk];
+        double* share = &lower_share[j*nk];
+        mass[j] = 0.0;
+        for (std::size_t i = 0; i<nk; i++){mass[j] += weight[i];}
+        const double inverse = mass[j]>0 ? 1/mass[j] : 0.0;
+        double* weight_share = &share_weights[j*nk];
+        for (std::size_t i = 0; i<nk; i++)
+        {
+            p[i] *= inverse;
+            weight[i] *= inverse;
+            weight_share[i] = weight[i]*std::exp(k[i]);
+        }
+        cdf[0] = 0.0;
+        share[0] = 0.0;
+        double values[4];
+        for (std::size_t i = 0; i + 1<nk; i++)
+        {
+            cell_values(weight, nk, i, values);
+            cdf[i+1] = cdf[i] + (13*(values[1] + values[2]) - values[0] - values[3])/24;
+            cell_values(weight_share, nk, i, values);
+            share[i+1] = share[i] + (13*(values[1] + values[2]) - values[0] - values[3])/24;
+        }
+    });
+};
+
+/**
+ * @brief The underlying prices at the nodes of an expiry, at which a payoff is tabulated
+ * for price().
+ * @param expiry The expiry index.
+ * @param S The output underlying prices F*exp(k_i), of size nk.
+ * @throw RiskNeutralDensityUnknownExpiry
+ * @throw SVIBatchSizeMismatch
+ */
+void RiskNeutralDensityGrid::underlying_prices(std::size_t expiry, std::span<double> S)
+{
+    if (expiry>=size()){throw RiskNeutralDensityUnknownExpiry();}
+    if (S.size()!=nk){throw SVIBatchSizeMismatch();}
+    for (std::size_t i = 0; i<nk; i++){S[i] = F_[expiry]*std::exp(k_[expiry*nk + i]);}
+};
+
+/**
+ * @brief Prices a european payoff tabulated at the nodes of an expiry.
+ * @param expiry The expiry index.
+ * @param payoff The payoff at the underlying prices of underlying_prices(), of size nk.
+ * @return The discounted expectation of the payoff.
+ * @throw RiskNeutralDensityUnknownExpiry
+ * @throw SVIBatchSizeMismatch
+ */
+double RiskNeutralDensityGrid::price(std::size_t expiry, std::span<const double> payoff)
+{
+    if (expiry>=size()){throw RiskNeutralDensityUnknownExpiry();}
+    if (payoff.size()!=nk){throw SVIBatchSizeMismatch();}
+    using namespace simd;
+    const double* weight = &weights[expiry*nk];
+    const std::size_t full = nk - nk%simd::WIDTH;
+    Pack sum = broadcast(0.0);
+    for (std::size_t i = 0; i<full; i += simd::WIDTH)
+    {sum = fmadd(load(weight + i), load(&payoff[i]), sum);}
+    double lanes[simd::WIDTH];
+    store(lanes, sum);
+    double total = 0.0;
+    for (double lane: lanes){total += lane;}
+    for (std::size_t i = full; i<nk; i++){total += weight[i]*payoff[i];}
+    return D_[expiry]*total;
+};
+
+/**
+ * @brief The probability and the partial expectation of S/F under a strike.
+ * @param grid The risk neutral density grid.
+ * @param expiry The expiry index.
+ * @param K The strike price.
+ * @param probability The output probability P(S < K).
+ * @param share The output partial expectation E[S/F; S < K].
+ */
+static void lower_tail(RiskNeutralDensityGrid& grid, std::size_t expiry, double K,
+    double& probability, double& share)
+{
+    const std::size_t nk = grid.nk;
+    const std::size_t row = expiry*nk;
+    const double x = std::log(K/grid.F_[expiry]);
+    const double u = std::asinh((x - grid.center[expiry])/grid.scale[expiry]);
+    const double position = (u - grid.u_min[expiry])/grid.du[expiry];
+    if (not (position>0)){probability = 0.0; share = 0.0; return;}
+    if (position>=(double)(nk - 1))
+    {probability = grid.lower[row + nk - 1]; share = grid.lower_share[row + nk - 1]; return;}
+
+    // The cell of the strike is integrated up to the strike only.
+    const std::size_t i = (std::size_t)position;
+    const double fraction = position - (double)i;
+    double values[4];
+    cell_values(&grid.weights[row], nk, i, values);
+    probability = grid.lower[row + i] + cell_integral(values, fraction);
+    cell_values(&grid.share_weights[row], nk, i, values);
+    share = grid.lower_share[row + i] + cell_integral(values, fraction);
+};
+
+/**
+ * @brief Prices a european vanilla option.
+ * @param expiry The expiry index.
+ * @param type The option's type.
+ * @param K The strike price.
+ * @return The price of the option.
+ * @throw RiskNeutralDensityUnknownExpiry
+ */
+double RiskNeutralDensityGrid::price(std::size_t expiry, OptionType type, double K)
+{
+    if (expiry>=size()){throw RiskNeutralDensityUnknownExpiry();}
+    double probability, share;
+    lower_tail(*this, expiry, K, probability, share);
+    const double F = F_[expiry];
+    if (type==PUT){return D_[expiry]*(K*probability - F*share);}
+    const double total = lower[expiry*nk + nk - 1];
+    const double total_share = lower_share[expiry*nk + nk - 1];
+    return D_[expiry]*(F*(total_share - share) - K*(total - probability));
+};
+
+/**
+ * @brief Prices the legs of a structured option, all of them paid at the expiry.
+ * @param expiry The expiry index.
+ * @param option The structured option instrument.
+ * @param valuation The valuation date.
+ * @param convention The day count convention of the year fractions to the expiries of the legs.
+ * @return The weighted sum of the prices of the legs.
+ * @throw RiskNeutralDensityUnknownExpiry
+ * @throw RiskNeutralDensityExpiryMismatch
+ * @see StructuredOption
+ */
+double RiskNeutralDensityGrid::price(
+    std::size_t expiry,
+    const StructuredOption& option,
+    EpochTimestamp valuation,
+    DayCountConvention convention)
+{
+    if (expiry>=size()){throw RiskNeutralDensityUnknownExpiry();}
+    // The density is the one of a single expiry, every leg must expire at it.
+    for (const std::unique_ptr<Option>& leg: option.option_ptrs)
+    {
+        if (not leg->expiry_ptr){throw RiskNeutralDensityExpiryMismatch();}
+        const double T = get_year_fraction(valuation, *leg->expiry_ptr, convention);
+        if (not (std::fabs(T - T_[expiry])<=RISK_NEUTRAL_DENSITY_EXPIRY_TOLERANCE))
+        {throw RiskNeutralDensityExpiryMismatch();}
+    }
+    double total = 0.0;
+    for (std::size_t i = 0; i<option.option_ptrs.size(); i++)
+    {
+        const Option& leg = *option.option_ptrs[i];
+        total += option.weights_[i]*price(expiry, leg.type_, leg.K);
+    }
+    return total;
+};
+
+/**
+ * @brief Prices a strip of european vanilla options of one expiry.
+ * @param expiry The expiry index.
+ * @param K The strike prices.
+ * @param is_call indicators if the options are calls (True) or puts (False).
+ * @param price The output prices.
+ * @throw RiskNeutralDensityUnknownExpiry
+ * @throw SVIBatchSizeMismatch
+ */
+void RiskNeutralDensityGrid::price(
+    std::size_t expiry,
+    std::span<const double> K,
+    std::span<const bool> is_call,
+    std::span<double> price)
+{
+    if (is_call.size()!=K.size() or price.size()!=K.size()){throw SVIBatchSizeMismatch();}
+    for (std::size_t i = 0; i<K.size(); i++)
+    {price[i] = this->price(expiry, is_call[i] ? CALL : PUT, K[i]);}
+};
+
+/**
+ * @brief Prices a european cash-or-nothing digital option paying 1.
+ * @param expiry The expiry index.
+ * @param type The option's type, a call pays above the strike and a put under it.
+ * @param K The strike price.
+ * @return The price of the digital option.
+ * @throw RiskNeutralDensityUnknownExpiry
+ */
+double RiskNeutralDensityGrid::digital(std::size_t expiry, OptionType type, double K)
+{
+    if (expiry>=size()){throw RiskNeutralDensityUnknownExpiry();}
+    double probability, share;
+    lower_tail(*this, expiry, K, probability, share);
+    return D_[expiry]*(type==PUT ? probability : lower[expiry*nk + nk - 1] - probability);
+};
+
+/**
+ * @brief Prices a strip of european cash-or-nothing digital options of one expiry.
+ * @param expiry The expiry index.
+ * @param K The strike prices.
+ * @param is_call indicators if the options are calls (True) or puts (False).
+ * @param price The output prices.
+ * @throw RiskNeutralDensityUnknownExpiry
+ * @throw SVIBatchSizeMismatch
+ */
+void RiskNeutralDensityGrid::digital(
+    std::size_t expiry,
+    std::span<const double> K,
+    std::span<const bool> is_call,
+    std::span<double> price)
+{
+    if (is_call.size()!=K.size() or price.size()!=K.size()){throw SVIBatchSizeMismatch();}
+    for (std::size_t i = 0; i<K.size(); i++)
+    {price[i] = digital(expiry, is_call[i] ? CALL : PUT, K[i]);}
+};
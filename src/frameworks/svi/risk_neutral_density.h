@@ -0,0 +1,70 @@
+#pragma once 
+#include <iostream>
+#include <cmath>
+#include <span>
+#include <vector>
+#include "svi.h"
+#include "../../datastructure/instruments/option/option.h"
+
+class RiskNeutralDensityUnknownExpiry:  public std::exception 
+{public: const char * what() const throw();};
+
+class RiskNeutralDensityExpiryMismatch:  public std::exception 
+{public: const char * what() const throw();};
+
+constexpr double RISK_NEUTRAL_DENSITY_TAIL_TOLERANCE = 1e-12;
+constexpr double RISK_NEUTRAL_DENSITY_MAX_WIDTH = 64.0;
+constexpr std::size_t RISK_NEUTRAL_DENSITY_POINTS_PER_WORKER = 1 << 14;
+constexpr double RISK_NEUTRAL_DENSITY_EXPIRY_TOLERANCE = 1.0/(365.0*24*60*60);
+
+struct RiskNeutralDensityGrid
+{
+    std::size_t nk; 
+    std::vector<double> T_; 
+    std::vector<double> F_; 
+    std::vector<double> D_; 
+    std::vector<double> center; 
+    std::vector<double> scale; 
+    std::vector<double> u_min; 
+    std::vector<double> du; 
+    std::vector<double> mass; 
+    std::vector<double> k_; 
+    std::vector<double> density; 
+    std::vector<double> weights; 
+    std::vector<double> share_weights; 
+    std::vector<double> lower; 
+    std::vector<double> lower_share; 
+    double tail_tolerance; 
+    std::size_t workers; 
+    RiskNeutralDensityGrid(std::size_t nk); 
+    ~RiskNeutralDensityGrid(){}; 
+    std::size_t size(); 
+    void build( 
+        std::span<const RawSVI> slices, 
+        std::span<const double> T, 
+        std::span<const double> forward, 
+        std::span<const double> discount_factor
+    ); 
+    void underlying_prices(std::size_t expiry, std::span<double> S); 
+    double price(std::size_t expiry, std::span<const double> payoff); 
+    double price(std::size_t expiry, OptionType type, double K); 
+    double price( 
+        std::size_t expiry, 
+        const StructuredOption& option, 
+        EpochTimestamp valuation, 
+        DayCountConvention convention
+    ); 
+    void price( 
+        std::size_t expiry, 
+        std::span<const double> K, 
+        std::span<const bool> is_call, 
+        std::span<double> price
+    ); 
+    double digital(std::size_t expiry, OptionType type, double K); 
+    void digital( 
+        std::size_t expiry, 
+        std::span<const double> K, 
+        std::span<const bool> is_call, 
+        std::span<double> price
+    ); 
+};
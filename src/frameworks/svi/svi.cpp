@@ -1,4 +1,6 @@
 #include "svi.h"
+#include <algorithm>
+#include "../../math/simd/simd.h"
 
 /** 
 * @file svi.h
@@ -36,6 +38,42 @@ const char * SSVIWrongParameterValue::what() const throw(){
     return "There is an error in the SSVI input parameters.";
 };
 
+/** 
+ * @class SVIBatchSizeMismatch
+ * @brief Definition of the error when the input or output arrays of a SVI batch do not have the same size. 
+ * 
+ */
+
+/** 
+ * @brief Definition of what() virtual std::exception function.
+ * @return The explication of the error.
+ */
+const char * SVIBatchSizeMismatch::what() const throw(){
+    return "All the input and output arrays of a SVI batch must have the same size.";
+};
+
+/** 
+ * @enum SVIStatus
+ * @brief Bit flags describing the invalid parameters of a SVI slice. 
+ */
+/**
+ * @var SVIStatus SVIStatus::SVI_NON_POSITIVE_VARIANCE
+ * @brief The ATM variance vt or the minimum variance vmt is not positive. 
+ */
+/**
+ * @var SVIStatus SVIStatus::SVI_CORRELATION_OUT_OF_RANGE
+ * @brief The raw parameter p or the translation parameter beta is outside [-1,1]. 
+ */
+/**
+ * @var SVIStatus SVIStatus::SVI_NEGATIVE_MINIMUM_VARIANCE
+ * @brief The minimum total variance a+b*s*sqrt(1-p*p) is negative. 
+ */
+
+/** 
+ * @enum SSVIStatus
+ * @brief Bit flags describing the invalid parameters or inputs of a SSVI evaluation. 
+ */
+
 /** 
  * @struct SSVI
  * @brief The Surface stochastic volatility inspired model (Power-Law parametrization).
@@ -57,33 +95,51 @@ const char * SSVIWrongParameterValue::what() const throw(){
  * @brief The SSVI model's parameter gamma_. 
  */
 
+ /**
+ * @var int SSVI::status
+ * @brief The SSVIStatus flags of the parameters. 
+ */
+
 /** 
- * @brief The main constructor
+ * @brief The main constructor, a thin wrapper of the non throwing constructor.
  * @param rho The SSVI model's parameter rho. 
  * @param nu The SSVI model's parameter nu. 
  * @param gamma The SSVI model's parameter gamma_. 
  * @throw SSVIWrongParameterValue
  */
  SSVI::SSVI(double rho, double nu, double gamma): 
-    rho_(rho), nu_(nu_), gamma_(gamma) 
+    SSVI(rho, nu, gamma, std::nothrow) 
 {
-    if(abs(rho) > 1){throw SSVIWrongParameterValue();}
-    if(gamma > 1 or gamma<0){throw SSVIWrongParameterValue();}
-    if(nu < 0){throw SSVIWrongParameterValue();}
+    if(status!=SSVI_VALID){throw SSVIWrongParameterValue();}
+};
+
+/** 
+ * @brief The non throwing constructor, invalid parameters are reported in the status flags.
+ * @param rho The SSVI model's parameter rho. 
+ * @param nu The SSVI model's parameter nu. 
+ * @param gamma The SSVI model's parameter gamma_. 
+ * @see SSVIStatus
+ */
+ SSVI::SSVI(double rho, double nu, double gamma, const std::nothrow_t&): 
+    rho_(rho), nu_(nu), gamma_(gamma), status(SSVI_VALID) 
+{
+    if(!(fabs(rho)<=1)){status |= SSVI_CORRELATION_OUT_OF_RANGE;}
+    if(!(gamma>=0 and gamma<=1)){status |= SSVI_GAMMA_OUT_OF_RANGE;}
+    if(!(nu>=0)){status |= SSVI_NEGATIVE_NU;}
 };
 
 /**
  * @param atm_total_variance the ATM total variance. 
- * @return The power law parametrization function value. 
+ * @return The power law parametrization function value nu*theta^(-gamma). 
  */
 double SSVI::prmtrzt(double atm_total_variance)
 {
-    return nu_*pow(atm_total_variance, gamma_);
+    return nu_*pow(atm_total_variance, -gamma_);
 };
 
 /**
  * @param atm_total_variance the ATM total variance. 
- * @return The first derivative of the power law parametrization function value. 
+ * @return The derivative of theta*prmtrzt(theta) with respect to the ATM total variance theta. 
  */
 double SSVI::dprmtrzt(double atm_total_variance)
 {
@@ -97,7 +153,7 @@ double SSVI::dprmtrzt(double atm_total_variance)
 bool SSVI::butterfly_arbitrage_check(double atm_total_variance)
 {
     double prmtrzt_ = prmtrzt(atm_total_variance);
-    double cond1 = atm_total_variance*prmtrzt_*(1+abs(rho_));
+    double cond1 = atm_total_variance*prmtrzt_*(1+std::fabs(rho_));
     double cond2 = cond1*prmtrzt_;
     if (cond1<=4 and cond2<=4){return true;}
     else{return false;}
@@ -151,6 +207,105 @@ double SSVI::implied_volatility(double k, double atm_total_variance, double t)
     return sqrt(implied_variance(k,atm_total_variance,t));
 };
 
+/**
+ * @brief Evaluates the surface on the grid of the log moneyness k and the ATM total 
+ * variances theta in one SIMD pass per slice, the output of (k[i], theta[j]) being at 
+ * j*k.size() + i. Every slice shares prmtrzt(theta), and every point the square root 
+ * R = sqrt((phi*k + rho)^2 + 1 - rho*rho) and its inverse. An empty output span is neither 
+ * computed nor written. 
+ * 
+ * The derivative with respect to theta is the one at fixed k, a local variance follows 
+ * from dwdtheta*dtheta/dt/risk_neutral_density for a given ATM term structure.
+ * @param k The log moneyness grid.
+ * @param atm_total_variance The ATM total variances of the slices.
+ * @param t The year fractions of the slices.
+ * @param total_variance The output total variances.
+ * @param implied_volatility The output implied volatilities.
+ * @param dwdk The output first derivatives of the total variance with respect to k.
+ * @param dwdtheta The output first derivatives of the total variance with respect to theta.
+ * @param risk_neutral_density The output densities, with the formula of 
+ * SVI::risk_neutral_density().
+ * @throw SVIBatchSizeMismatch
+ */
+void SSVI::evaluate(
+    std::span<const double> k, 
+    std::span<const double> atm_total_variance, 
+    std::span<const double> t, 
+    std::span<double> total_variance, 
+    std::span<double> implied_volatility, 
+    std::span<double> dwdk, 
+    std::span<double> dwdtheta, 
+    std::span<double> risk_neutral_density)
+{
+    const std::size_t n = k.size();
+    const std::size_t slices = atm_total_variance.size();
+    if (t.size()!=slices){throw SVIBatchSizeMismatch();}
+    std::span<double> outputs[5] = {total_variance, implied_volatility, dwdk, dwdtheta, 
+        risk_neutral_density};
+    for (std::span<double> output: outputs)
+    {if (not output.empty() and output.size()!=n*slices){throw SVIBatchSizeMismatch();}}
+    const bool slope = not (dwdk.empty() and dwdtheta.empty() and risk_neutral_density.empty());
+
+    using namespace simd;
+    const Pack rho = broadcast(rho_);
+    const Pack cross = broadcast(1 - rho_*rho_);
+    const std::size_t full = n - n%simd::WIDTH;
+    double tail_k[simd::WIDTH] = {};
+    std::copy(k.begin() + full, k.end(), tail_k);
+    for (std::size_t j = 0; j<slices; j++)
+    {
+        const double theta_ = atm_total_variance[j];
+        const double phi_ = prmtrzt(theta_);
+        const Pack phi = broadcast(phi_);
+        const Pack half = broadcast(.5*theta_);
+        const Pack half_phi = broadcast(.5*theta_*phi_);
+        const Pack curvature = broadcast(.5*theta_*phi_*phi_*(1 - rho_*rho_));
+        const Pack inverse_T = broadcast(1/t[j]);
+        const Pack inverse_theta = broadcast(1/theta_);
+        const Pack gamma = broadcast(gamma_);
+        auto block = [&](const double* k_, double* const* out)
+        {
+            const Pack x = load(k_);
+            const Pack phi_k = phi*x;
+            const Pack y = phi_k + rho;
+            const Pack root = sqrt(fmadd(y, y, cross));
+            const Pack w = half*(fmadd(rho, phi_k, root) + 1.0);
+            if (out[0]){store(out[0], w);}
+            if (out[1]){store(out[1], sqrt(w*inverse_T));}
+            if (not slope){return;}
+            const Pack inverse_root = 1.0/root;
+            const Pack w1 = half_phi*fmadd(y, inverse_root, rho);
+            if (out[2]){store(out[2], w1);}
+            // d(phi)/d(theta) = -gamma*phi/theta and k*dw/dphi = k*dw/dk/phi.
+            if (out[3]){store(out[3], (w - gamma*x*w1)*inverse_theta);}
+            if (not out[4]){return;}
+            const Pack w2 = curvature*inverse_root*inverse_root*inverse_root;
+            const Pack inverse_w = 1.0/w;
+            const Pack term1 = 1.0 - .5*x*w1*inverse_w;
+            store(out[4], term1*term1 - .25*w1*w1*(.25 + inverse_w) + .5*w2);
+        };
+
+        double* out[5];
+        const std::size_t offset = j*n;
+        for (std::size_t i = 0; i<full; i += simd::WIDTH)
+        {
+            for (int l = 0; l<5; l++){out[l] = outputs[l].empty() ? nullptr : &outputs[l][offset + i];}
+            block(&k[i], out);
+        }
+        if (full<n)
+        {
+            double tail_out[5][simd::WIDTH];
+            for (int l = 0; l<5; l++){out[l] = outputs[l].empty() ? nullptr : tail_out[l];}
+            block(tail_k, out);
+            for (int l = 0; l<5; l++)
+            {
+                if (outputs[l].empty()){continue;}
+                std::copy_n(tail_out[l], n - full, &outputs[l][offset + full]);
+            }
+        }
+    }
+};
+
 /** 
  * @struct SVI
  * @brief The stochastic volatility inspired model (Jump-wings parametrization).
@@ -219,6 +374,11 @@ double SSVI::implied_volatility(double k, double atm_total_variance, double t)
  /**
  * @var double SVI::alpha
  * @brief The parameter alpha used for translation from JW-SVI to raw SVI.
+ */
+
+  /**
+ * @var int SVI::status
+ * @brief The SVIStatus flags of the parameters. 
  */
 
   /**
@@ -242,7 +402,7 @@ double SSVI::implied_volatility(double k, double atm_total_variance, double t)
  */
 
 /** 
- * @brief The main constructor
+ * @brief The main constructor, a thin wrapper of the non throwing constructor.
  * @param vt The Jump-Wing SVI model's parameter vt. 
  * @param ut The Jump-Wing SVI model's parameter ut. 
  * @param ct The Jump-Wing SVI model's parameter ct. 
@@ -252,55 +412,73 @@ double SSVI::implied_volatility(double k, double atm_total_variance, double t)
  * @throw SVIWrongParameterValue
  */
  SVI::SVI(double vt, double ut, double ct, double pt, double vmt, double t): 
+    SVI(vt, ut, ct, pt, vmt, t, std::nothrow)
+{
+    if(status!=SVI_VALID){throw SVIWrongParameterValue();}
+};
+
+/** 
+ * @brief The non throwing constructor, invalid parameters are reported in the status flags.
+ * 
+ * The raw parameters are initialised in the order of their dependencies, which is 
+ * also their declaration order. 
+ * 
+ * @param vt The Jump-Wing SVI model's parameter vt. 
+ * @param ut The Jump-Wing SVI model's parameter ut. 
+ * @param ct The Jump-Wing SVI model's parameter ct. 
+ * @param pt The Jump-Wing SVI model's parameter pt. 
+ * @param vmt The Jump-Wing SVI model's parameter vmt. 
+ * @param t The Jump-Wing SVI model's parameter t. 
+ * @see SVIStatus
+ */
+ SVI::SVI(double vt, double ut, double ct, double pt, double vmt, double t, const std::nothrow_t&): 
     vt_(vt), ut_(ut), ct_(ct), pt_(pt), vmt_(vmt), T_(t),
-    b(get_b()), p(get_p()),beta(get_beta()), alpha(get_alpha()), 
+    b(get_b()), p(get_p()), beta(get_beta()), alpha(get_alpha()), 
     m(get_m()), a(get_a()), s(get_s()), dbdt(get_dbdt()), 
-    dmdt(get_dmdt()), dsdt(get_dsdt()), dadt(get_dadt())
+    dmdt(get_dmdt()), dsdt(get_dsdt()), dadt(get_dadt()), 
+    status(parameter_status()){};
+
+/**
+ * @brief Validates the parameters without throwing, NaN values are reported as invalid.
+ * @return The SVIStatus flags, SVI_VALID if the slice is valid.
+ */
+int SVI::parameter_status()
 {
-    if(vt_<=0){throw SVIWrongParameterValue();}
-    if(vmt_<=0){throw SVIWrongParameterValue();}
-    if(T_<=0){throw SVIWrongParameterValue();}
-    if(s<=0){throw SVIWrongParameterValue();}
-    if((a+b*s*sqrt(1-p*p))<0){throw SVIWrongParameterValue();}
+    int status_ = SVI_VALID;
+    if(!(vt_>0) or !(vmt_>0)){status_ |= SVI_NON_POSITIVE_VARIANCE;}
+    if(!(T_>0)){status_ |= SVI_NON_POSITIVE_YEAR_FRACTION;}
+    if(status_!=SVI_VALID){return status_;}
+    if(!(b>=0)){status_ |= SVI_NEGATIVE_B;}
+    if(!(fabs(p)<=1.0) or !(fabs(beta)<=1.0)){return status_ | SVI_CORRELATION_OUT_OF_RANGE;}
+    if(!(s>0)){status_ |= SVI_NON_POSITIVE_S;}
+    if(!(a+b*s*sqrt(1-p*p)>=0)){status_ |= SVI_NEGATIVE_MINIMUM_VARIANCE;}
+    return status_;
 };
 
 /**
  * @return Return the raw SVI parameter b.
- * @throw SVIWrongParameterValue
  */
 double SVI::get_b()
 {
-    double b_ = sqrt(vt_*T_)*(ct_+pt_)/2;
-    if (b_<0){throw SVIWrongParameterValue();}
-    return b_;
+    return sqrt(vt_*T_)*(ct_+pt_)/2;
 };
 
 /**
  * @return Return the raw SVI parameter p.
- * @throw SVIWrongParameterValue
  */
 double SVI::get_p()
 {
-    double p_;
-    if (b==0){p_ = 0.0;}
-    else{p_ = 1 - pt_*sqrt(vt_*T_)/b;}
-    if (abs(p_)>1.0){throw SVIWrongParameterValue();}
-    return p_;
+    if (b==0){return 0.0;}
+    else{return 1 - pt_*sqrt(vt_*T_)/b;}
 };
 
 /**
  * @return Return the parameter beta used for translation from JW-SVI to raw SVI.
- * @throw SVIWrongParameterValue
  */
 double SVI::get_beta()
 {
     if (b==0){return 1.0;}
-    else
-    {
-        double beta_ = p - 2*ut_*sqrt(vt_*T_)/b;
-        if (abs(beta_)>1.0){throw SVIWrongParameterValue();}
-        return beta_;
-    }
+    else{return p - 2*ut_*sqrt(vt_*T_)/b;}
 };
 
 /**
@@ -324,7 +502,7 @@ double SVI::get_m()
         double intterm;
         if (alpha<0){intterm = -sqrt(1+alpha*alpha);}
         else{intterm = sqrt(1+alpha*alpha);}
-        return (T_*(vmt_-vt_)/(b*(-p+intterm-alpha*sqrt(1-p*p))));
+        return (T_*(vt_-vmt_)/(b*(-p+intterm-alpha*sqrt(1-p*p))));
     }
 };
 
@@ -410,7 +588,9 @@ double SVI::dwdk(double k)
  */
 double SVI::dw2dk2(double k)
 {
-    return sqrt(implied_variance(k));
+    double km = k-m;
+    double root = sqrt(km*km + s*s);
+    return b*s*s/(root*root*root);
 };
 
 /**
@@ -430,10 +610,10 @@ double SVI::get_dmdt()
     else{
         double factor;
         if (alpha<0){
-            double factor = (-p - sqrt(1+alpha*alpha) - alpha*sqrt(1-p*p));
+            factor = (-p - sqrt(1+alpha*alpha) - alpha*sqrt(1-p*p));
         }
         else{
-            double factor = (-p + sqrt(1+alpha*alpha) - alpha*sqrt(1-p*p));
+            factor = (-p + sqrt(1+alpha*alpha) - alpha*sqrt(1-p*p));
         }
         return (vt_-vmt_)*(b-T_*dbdt)/(factor*b*b);
     }
@@ -520,6 +700,261 @@ double SVI::local_volatility(double k)
     return sqrt(local_variance(k)); 
 };
 
+/**
+ * @brief Evaluates a raw SVI slice on a grid of log moneyness in one SIMD pass. The square 
+ * root sqrt((k-m)^2 + s^2), its inverse and the total variance are shared by every output, 
+ * and an empty output span is neither computed nor written.
+ * @param raw The raw SVI slice.
+ * @param t The year fraction.
+ * @param dwdt_terms The time derivatives (da/dt, db/dt, dm/dt, ds/dt) of the parameters, 
+ * only read for the local volatilities.
+ * @param k The log moneyness grid.
+ * @param outputs The total variances, implied volatilities, first derivatives with respect 
+ * to k, densities of SVI::risk_neutral_density() and local volatilities, of the size of k 
+ * or empty.
+ */
+static void evaluate_slice(RawSVI raw, double t, const double* dwdt_terms, 
+    std::span<const double> k, std::span<double>* outputs)
+{
+    const std::size_t n = k.size();
+    const bool slope = not (outputs[2].empty() and outputs[3].empty() and outputs[4].empty());
+    const bool density = not (outputs[3].empty() and outputs[4].empty());
+
+    using namespace simd;
+    const Pack a_ = broadcast(raw.a);
+    const Pack b_ = broadcast(raw.b);
+    const Pack p_ = broadcast(raw.p);
+    const Pack m_ = broadcast(raw.m);
+    const Pack s2 = broadcast(raw.s*raw.s);
+    const Pack inverse_T = broadcast(1/t);
+    auto block = [&](const double* k_, double* const* out)
+    {
+        const Pack x = load(k_);
+        const Pack km = x - m_;
+        const Pack root = sqrt(fmadd(km, km, s2));
+        const Pack g_ = fmadd(p_, km, root);
+        const Pack w = fmadd(b_, g_, a_);
+        if (out[0]){store(out[0], w);}
+        if (out[1]){store(out[1], sqrt(w*inverse_T));}
+        if (not slope){return;}
+        const Pack inverse_root = 1.0/root;
+        const Pack w1 = b_*fmadd(km, inverse_root, p_);
+        if (out[2]){store(out[2], w1);}
+        if (not density){return;}
+        const Pack w2 = b_*s2*inverse_root*inverse_root*inverse_root;
+        const Pack inverse_w = 1.0/w;
+        const Pack term1 = 1.0 - .5*x*w1*inverse_w;
+        const Pack g = term1*term1 - .25*w1*w1*(.25 + inverse_w) + .5*w2;
+        if (out[3]){store(out[3], g);}
+        if (not out[4]){return;}
+        const double dadt = dwdt_terms[0];
+        const double dbdt = dwdt_terms[1];
+        const double dmdt = dwdt_terms[2];
+        const double dsdt = dwdt_terms[3];
+        const Pack dgdt_ = (raw.s*dsdt - dmdt*km)*inverse_root - raw.p*dmdt;
+        const Pack dwdt_ = fmadd(b_, dgdt_, fmadd(broadcast(dbdt), g_, broadcast(dadt)));
+        store(out[4], sqrt(dwdt_/g));
+    };
+
+    double* out[5];
+    const std::size_t full = n - n%simd::WIDTH;
+    for (std::size_t i = 0; i<full; i += simd::WIDTH)
+    {
+        for (int j = 0; j<5; j++){out[j] = outputs[j].empty() ? nullptr : &outputs[j][i];}
+        block(&k[i], out);
+    }
+    if (full<n)
+    {
+        double tail_k[simd::WIDTH] = {};
+        double tail_out[5][simd::WIDTH];
+        std::copy(k.begin() + full, k.end(), tail_k);
+        for (int j = 0; j<5; j++){out[j] = outputs[j].empty() ? nullptr : tail_out[j];}
+        block(tail_k, out);
+        for (int j = 0; j<5; j++)
+        {
+            if (outputs[j].empty()){continue;}
+            std::copy_n(tail_out[j], n - full, &outputs[j][full]);
+        }
+    }
+};
+
+/**
+ * @brief Evaluates the slice on a grid of log moneyness in one SIMD pass. The square root 
+ * sqrt((k-m)^2 + s^2), its inverse and the total variance are shared by every output, and 
+ * an empty output span is neither computed nor written.
+ * @param k The log moneyness grid.
+ * @param total_variance The output total variances.
+ * @param implied_volatility The output implied volatilities.
+ * @param dwdk The output first derivatives of the total variance with respect to k.
+ * @param risk_neutral_density The output densities of risk_neutral_density().
+ * @param local_volatility The output local volatilities.
+ * @throw SVIBatchSizeMismatch
+ */
+void SVI::evaluate(
+    std::span<const double> k, 
+    std::span<double> total_variance, 
+    std::span<double> implied_volatility, 
+    std::span<double> dwdk, 
+    std::span<double> risk_neutral_density, 
+    std::span<double> local_volatility)
+{
+    std::span<double> outputs[5] = {total_variance, implied_volatility, dwdk, 
+        risk_neutral_density, local_volatility};
+    for (std::span<double> output: outputs)
+    {if (not output.empty() and output.size()!=k.size()){throw SVIBatchSizeMismatch();}}
+    const double dwdt_terms[4] = {dadt, dbdt, dmdt, dsdt};
+    evaluate_slice(get_raw_svi(), T_, dwdt_terms, k, outputs);
+};
+
+/**
+ * @return The raw parameters of the slice.
+ */
+RawSVI SVI::get_raw_svi()
+{
+    return RawSVI(a, b, p, m, s);
+};
+
+/** 
+ * @struct RawSVI
+ * @brief A raw SVI slice w(k) = a + b*(p*(k-m) + sqrt((k-m)^2 + s^2)) for evaluation. 
+ * 
+ * It is trivially copyable and holds the 5 parameters only, so that slices are stored 
+ * contiguously and built without the Jump-Wings conversion. The conversion and the time 
+ * derivatives of the parameters, needed by the local volatility and the calendar spread 
+ * checks, are only computed by get_svi().
+ */
+
+/**
+ * @brief The default constructor, a flat slice of zero variance.
+ */
+RawSVI::RawSVI(): a(0.0), b(0.0), p(0.0), m(0.0), s(1.0){};
+
+/**
+ * @brief The main constructor, the parameters are not validated.
+ * @param a The raw SVI parameter a.
+ * @param b The raw SVI parameter b.
+ * @param p The raw SVI parameter p.
+ * @param m The raw SVI parameter m.
+ * @param s The raw SVI parameter s.
+ */
+RawSVI::RawSVI(double a, double b, double p, double m, double s): 
+    a(a), b(b), p(p), m(m), s(s){};
+
+/**
+ * @param t The year fraction.
+ * @return The Jump-Wings SVI slice with its time derivatives, built with the non throwing 
+ * constructor.
+ */
+SVI RawSVI::get_svi(double t)
+{
+    const double root = std::sqrt(m*m + s*s);
+    const double w = atm_total_variance();
+    const double sqrt_w = std::sqrt(w);
+    return SVI(
+        w/t, 
+        .5*b*(p - m/root)/sqrt_w, 
+        b*(1 + p)/sqrt_w, 
+        b*(1 - p)/sqrt_w, 
+        (a + b*s*std::sqrt(1 - p*p))/t, 
+        t, 
+        std::nothrow);
+};
+
+/**
+ * @return The total variance at k = 0.
+ */
+double RawSVI::atm_total_variance()
+{
+    return a + b*(std::sqrt(m*m + s*s) - p*m);
+};
+
+/**
+ * @return True if no butterfly arbitrage, the conditions of SVI::butterfly_arbitrage_check() 
+ * b*(1+|p|) < 2 and b*b*(1+|p|) <= w(0) in raw parameters.
+ */
+bool RawSVI::butterfly_arbitrage_check()
+{
+    const double wing = b*(1 + std::fabs(p));
+    return wing<2 and b*wing<=atm_total_variance();
+};
+
+/**
+ * @param k The log moneyness.
+ * @return The total variance.
+ */
+double RawSVI::total_variance(double k)
+{
+    return a + b*(p*(k - m) + std::sqrt((k - m)*(k - m) + s*s));
+};
+
+/**
+ * @param k The log moneyness.
+ * @param t The year fraction.
+ * @return The implied volatility.
+ */
+double RawSVI::implied_volatility(double k, double t)
+{
+    return std::sqrt(total_variance(k)/t);
+};
+
+/**
+ * @param k The log moneyness.
+ * @return The first derivative of the total variance with respect to k.
+ */
+double RawSVI::dwdk(double k)
+{
+    const double km = k - m;
+    return b*(p + km/std::sqrt(km*km + s*s));
+};
+
+/**
+ * @param k The log moneyness.
+ * @return The second derivative of the total variance with respect to k.
+ */
+double RawSVI::dw2dk2(double k)
+{
+    const double km = k - m;
+    const double root = std::sqrt(km*km + s*s);
+    return b*s*s/(root*root*root);
+};
+
+/**
+ * @param k The log moneyness.
+ * @return The density of SVI::risk_neutral_density().
+ */
+double RawSVI::risk_neutral_density(double k)
+{
+    const double dwdk_ = dwdk(k);
+    const double w = total_variance(k);
+    const double term1 = 1 - k*dwdk_/(2*w);
+    return term1*term1 - .25*dwdk_*dwdk_*(.25 + 1/w) + .5*dw2dk2(k);
+};
+
+/**
+ * @brief Evaluates the slice on a grid of log moneyness in one SIMD pass, see SVI::evaluate().
+ * @param k The log moneyness grid.
+ * @param t The year fraction.
+ * @param total_variance The output total variances.
+ * @param implied_volatility The output implied volatilities.
+ * @param dwdk The output first derivatives of the total variance with respect to k.
+ * @param risk_neutral_density The output densities of risk_neutral_density().
+ * @throw SVIBatchSizeMismatch
+ */
+void RawSVI::evaluate(
+    std::span<const double> k, 
+    double t, 
+    std::span<double> total_variance, 
+    std::span<double> implied_volatility, 
+    std::span<double> dwdk, 
+    std::span<double> risk_neutral_density)
+{
+    std::span<double> outputs[5] = {total_variance, implied_volatility, dwdk, 
+        risk_neutral_density, std::span<double>()};
+    for (std::span<double> output: outputs)
+    {if (not output.empty() and output.size()!=k.size()){throw SVIBatchSizeMismatch();}}
+    evaluate_slice(*this, t, nullptr, k, outputs);
+};
+
 /**
  * @return The corresponding powerr law SSVI.
  */
@@ -547,3 +982,166 @@ SVI SSVI::get_svi(double atm_total_variance, double t)
         t);
 };
 
+/**
+ * @param atm_total_variance the ATM total variance. 
+ * @return The raw SVI slice at the ATM total variance, a = theta*(1-rho*rho)/2, 
+ * b = theta*phi/2, p = rho, m = -rho/phi and s = sqrt(1-rho*rho)/phi, without the 
+ * Jump-Wings conversion of get_svi().
+ */
+RawSVI SSVI::get_raw_svi(double atm_total_variance)
+{
+    double phi = prmtrzt(atm_total_variance);
+    if (phi==0){return RawSVI(atm_total_variance, 0.0, rho_, 0.0, 1.0);}
+    return RawSVI(
+        .5*atm_total_variance*(1-rho_*rho_), 
+        .5*atm_total_variance*phi, 
+        rho_, 
+        -rho_/phi, 
+        sqrt(1-rho_*rho_)/phi);
+};
+
+/** 
+ * @struct SVIBatch
+ * @brief Non throwing evaluation of the implied volatilities of a batch of quotes, 
+ * each quote having its own Jump-Wings SVI slice. 
+ * @see SVI
+ */
+
+/** 
+ * @brief The main constructor, the arrays are not copied.
+ * @param vt The Jump-Wing SVI model's parameters vt. 
+ * @param ut The Jump-Wing SVI model's parameters ut. 
+ * @param ct The Jump-Wing SVI model's parameters ct. 
+ * @param pt The Jump-Wing SVI model's parameters pt. 
+ * @param vmt The Jump-Wing SVI model's parameters vmt. 
+ * @param t The year fractions. 
+ * @param k The log moneyness of the quotes. 
+ * @throw SVIBatchSizeMismatch
+ */
+SVIBatch::SVIBatch(
+    std::span<const double> vt, 
+    std::span<const double> ut, 
+    std::span<const double> ct, 
+    std::span<const double> pt, 
+    std::span<const double> vmt, 
+    std::span<const double> t, 
+    std::span<const double> k): 
+    vt_(vt), ut_(ut), ct_(ct), pt_(pt), vmt_(vmt), T_(t), k_(k)
+{
+    std::size_t n = k_.size();
+    if (vt_.size()!=n or ut_.size()!=n or ct_.size()!=n or pt_.size()!=n 
+        or vmt_.size()!=n or T_.size()!=n)
+    {throw SVIBatchSizeMismatch();}
+};
+
+/**
+ * @return The number of quotes in the batch.
+ */
+std::size_t SVIBatch::size()
+{
+    return k_.size();
+};
+
+/**
+ * @brief Evaluates every quote, an invalid slice does not interrupt the batch. The consecutive 
+ * quotes of the same slice, such as the quotes of a chain sorted by expiry, are evaluated 
+ * together by SVI::evaluate.
+ * @param implied_volatility The output implied volatilities, NaN for the invalid slices.
+ * @param status The output SVIStatus flags.
+ * @throw SVIBatchSizeMismatch
+ */
+void SVIBatch::evaluate(std::span<double> implied_volatility, std::span<int> status)
+{
+    const std::size_t n = size();
+    if (implied_volatility.size()!=n or status.size()!=n){throw SVIBatchSizeMismatch();}
+    std::size_t i = 0;
+    while (i<n)
+    {
+        std::size_t j = i + 1;
+        while (j<n and vt_[j]==vt_[i] and ut_[j]==ut_[i] and ct_[j]==ct_[i] and pt_[j]==pt_[i] 
+            and vmt_[j]==vmt_[i] and T_[j]==T_[i]){j++;}
+        SVI svi(vt_[i], ut_[i], ct_[i], pt_[i], vmt_[i], T_[i], std::nothrow);
+        std::fill(status.begin() + i, status.begin() + j, svi.status);
+        if (svi.status==SVI_VALID)
+        {svi.evaluate(k_.subspan(i, j - i), {}, implied_volatility.subspan(i, j - i), {}, {}, {});}
+        else
+        {
+            std::fill(implied_volatility.begin() + i, implied_volatility.begin() + j, 
+                std::numeric_limits<double>::quiet_NaN());
+        }
+        i = j;
+    }
+};
+
+/** 
+ * @struct SSVIBatch
+ * @brief Non throwing evaluation of the implied volatilities of a batch of quotes 
+ * on one SSVI surface. 
+ * @see SSVI
+ */
+
+/** 
+ * @brief The main constructor, the arrays are not copied and the parameters are 
+ * only validated by evaluate().
+ * @param rho The SSVI model's parameter rho. 
+ * @param nu The SSVI model's parameter nu. 
+ * @param gamma The SSVI model's parameter gamma_. 
+ * @param k The log moneyness of the quotes. 
+ * @param atm_total_variance The ATM total variances of the quotes' expiries. 
+ * @param t The year fractions. 
+ * @throw SVIBatchSizeMismatch
+ */
+SSVIBatch::SSVIBatch(
+    double rho, 
+    double nu, 
+    double gamma, 
+    std::span<const double> k, 
+    std::span<const double> atm_total_variance, 
+    std::span<const double> t): 
+    rho_(rho), nu_(nu), gamma_(gamma), k_(k), 
+    atm_total_variance_(atm_total_variance), T_(t)
+{
+    if (atm_total_variance_.size()!=k_.size() or T_.size()!=k_.size())
+    {throw SVIBatchSizeMismatch();}
+};
+
+/**
+ * @return The number of quotes in the batch.
+ */
+std::size_t SSVIBatch::size()
+{
+    return k_.size();
+};
+
+/**
+ * @brief Evaluates every quote, invalid parameters or inputs do not interrupt the batch. The 
+ * consecutive valid quotes of the same expiry are evaluated together by SSVI::evaluate.
+ * @param implied_volatility The output implied volatilities, NaN for the invalid quotes.
+ * @param status The output SSVIStatus flags, the parameter flags are set on every quote.
+ * @throw SVIBatchSizeMismatch
+ */
+void SSVIBatch::evaluate(std::span<double> implied_volatility, std::span<int> status)
+{
+    const std::size_t n = size();
+    if (implied_volatility.size()!=n or status.size()!=n){throw SVIBatchSizeMismatch();}
+    SSVI ssvi(rho_, nu_, gamma_, std::nothrow);
+    std::size_t i = 0;
+    while (i<n)
+    {
+        int status_ = ssvi.status;
+        if (!(atm_total_variance_[i]>0)){status_ |= SSVI_NON_POSITIVE_VARIANCE;}
+        if (!(T_[i]>0)){status_ |= SSVI_NON_POSITIVE_YEAR_FRACTION;}
+        status[i] = status_;
+        if (status_!=SSVI_VALID)
+        {
+            implied_volatility[i++] = std::numeric_limits<double>::quiet_NaN();
+            continue;
+        }
+        std::size_t j = i + 1;
+        while (j<n and atm_total_variance_[j]==atm_total_variance_[i] and T_[j]==T_[i])
+        {status[j++] = SSVI_VALID;}
+        ssvi.evaluate(k_.subspan(i, j - i), atm_total_variance_.subspan(i, 1), T_.subspan(i, 1), 
+            {}, implied_volatility.subspan(i, j - i), {}, {}, {});
+        i = j;
+    }
+};
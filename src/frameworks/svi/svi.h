@@ -1,5 +1,9 @@
 #pragma once 
 #include <iostream>
+#include <cmath>
+#include <limits>
+#include <new>
+#include <span>
 
 class SSVIWrongParameterValue:  public std::exception 
 {public: const char * what() const throw();};
@@ -8,14 +12,44 @@ class SSVIWrongParameterValue:  public std::exception
 class SVIWrongParameterValue:  public std::exception 
 {public: const char * what() const throw();};
 
+class SVIBatchSizeMismatch:  public std::exception 
+{public: const char * what() const throw();};
+
+enum SVIStatus
+{
+    SVI_VALID = 0, 
+    SVI_NON_POSITIVE_VARIANCE = 1 << 0, 
+    SVI_NON_POSITIVE_YEAR_FRACTION = 1 << 1, 
+    SVI_NEGATIVE_B = 1 << 2, 
+    SVI_CORRELATION_OUT_OF_RANGE = 1 << 3, 
+    SVI_NON_POSITIVE_S = 1 << 4, 
+    SVI_NEGATIVE_MINIMUM_VARIANCE = 1 << 5
+};
+
+enum SSVIStatus
+{
+    SSVI_VALID = 0, 
+    SSVI_CORRELATION_OUT_OF_RANGE = 1 << 0, 
+    SSVI_GAMMA_OUT_OF_RANGE = 1 << 1, 
+    SSVI_NEGATIVE_NU = 1 << 2, 
+    SSVI_NON_POSITIVE_VARIANCE = 1 << 3, 
+    SSVI_NON_POSITIVE_YEAR_FRACTION = 1 << 4
+};
+
+struct SVI;
+struct RawSVI;
+
 struct SSVI
 {
     double rho_; 
     double nu_; 
     double gamma_; 
+    int status; 
     SSVI(double rho, double nu, double gamma); 
+    SSVI(double rho, double nu, double gamma, const std::nothrow_t&); 
     ~SSVI(){}; 
     SVI get_svi(double atm_total_variance, double t);
+    RawSVI get_raw_svi(double atm_total_variance);
     double prmtrzt(double atm_total_variance); 
     double dprmtrzt(double atm_total_variance); 
     bool butterfly_arbitrage_check(double atm_total_variance); 
@@ -26,6 +60,16 @@ struct SSVI
     double risk_neutral_density(double k, double atm_total_variance, double t); 
     double local_volatility(double k, double atm_total_variance, double t); 
     double atm_volatility_skew(double k, double atm_total_variance, double t);
+    void evaluate(
+        std::span<const double> k, 
+        std::span<const double> atm_total_variance, 
+        std::span<const double> t, 
+        std::span<double> total_variance, 
+        std::span<double> implied_volatility, 
+        std::span<double> dwdk, 
+        std::span<double> dwdtheta, 
+        std::span<double> risk_neutral_density
+    ); 
 };
 
 struct SVI
@@ -36,18 +80,21 @@ struct SVI
     double pt_;
     double vmt_; 
     double T_; 
-    double a; 
+    double b; 
+    double p; 
     double beta; 
     double alpha;
-    double b; 
     double m; 
+    double a; 
     double s; 
-    double p; 
+    double dbdt; 
     double dmdt; 
-    double dadt; 
     double dsdt; 
-    double dbdt; 
+    double dadt; 
+    int status; 
     SVI(double vt, double ut, double ct, double pt, double vmt, double t); 
+    SVI(double vt, double ut, double ct, double pt, double vmt, double t, const std::nothrow_t&); 
+    int parameter_status(); 
     ~SVI(){}; 
     double get_a(); 
     double get_b(); 
@@ -66,6 +113,7 @@ struct SVI
     double dgdt(double k);
     double dwdt(double k);
     SSVI get_power_law_ssvi();
+    RawSVI get_raw_svi();
     bool butterfly_arbitrage_check(); 
     bool calendar_spread_arbitrage_check(SVI svi); 
     double total_variance(double k); 
@@ -74,6 +122,85 @@ struct SVI
     double risk_neutral_density(double k); 
     double local_variance(double k); 
     double local_volatility(double k); 
+    void evaluate(
+        std::span<const double> k, 
+        std::span<double> total_variance, 
+        std::span<double> implied_volatility, 
+        std::span<double> dwdk, 
+        std::span<double> risk_neutral_density, 
+        std::span<double> local_volatility
+    ); 
+};
+
+struct RawSVI
+{
+    double a; 
+    double b; 
+    double p; 
+    double m; 
+    double s; 
+    RawSVI(); 
+    RawSVI(double a, double b, double p, double m, double s); 
+    SVI get_svi(double t); 
+    double atm_total_variance(); 
+    bool butterfly_arbitrage_check(); 
+    double total_variance(double k); 
+    double implied_volatility(double k, double t); 
+    double dwdk(double k); 
+    double dw2dk2(double k); 
+    double risk_neutral_density(double k); 
+    void evaluate(
+        std::span<const double> k, 
+        double t, 
+        std::span<double> total_variance, 
+        std::span<double> implied_volatility, 
+        std::span<double> dwdk, 
+        std::span<double> risk_neutral_density
+    ); 
+};
+
+struct SVIBatch
+{
+    std::span<const double> vt_; 
+    std::span<const double> ut_; 
+    std::span<const double> ct_; 
+    std::span<const double> pt_; 
+    std::span<const double> vmt_; 
+    std::span<const double> T_; 
+    std::span<const double> k_; 
+    SVIBatch(
+        std::span<const double> vt, 
+        std::span<const double> ut, 
+        std::span<const double> ct, 
+        std::span<const double> pt, 
+        std::span<const double> vmt, 
+        std::span<const double> t, 
+        std::span<const double> k
+    ); 
+    ~SVIBatch(){}; 
+    std::size_t size(); 
+    void evaluate(std::span<double> implied_volatility, std::span<int> status); 
+};
+
+struct SSVIBatch
+{
+    double rho_; 
+    double nu_; 
+    double gamma_; 
+    std::span<const double> k_; 
+    std::span<const double> atm_total_variance_; 
+    std::span<const double> T_; 
+    SSVIBatch(
+        double rho, 
+        double nu, 
+        double gamma, 
+        std::span<const double> k, 
+        std::span<const double> atm_total_variance, 
+        std::span<const double> t
+    ); 
+    ~SSVIBatch(){}; 
+    std::size_t size(); 
+    void evaluate(std::span<double> implied_volatility, std::span<int> status); 
 };
 
 struct ReducedSVI
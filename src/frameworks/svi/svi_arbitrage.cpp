@@ -0,0 +1,196 @@
+#include "svi_arbitrage.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include "vol_surface.h"
+
+/** 
+* @file svi_arbitrage.h
+* @brief This file defines the scan of SVI surfaces for static arbitrage on a grid of 
+* log moneyness.
+* 
+* The parameter conditions of SVI::butterfly_arbitrage_check and 
+* SSVI::calendar_spread_arbitrage_check are only sufficient. The scanner tests the 
+* conditions themselves at every point of the grid: Durrleman's density 
+* g(k) = (1 - k*w'/(2w))^2 - w'^2/4*(1/w + 1/4) + w''/2 >= 0 of every slice, and 
+* w(k, T_j+1) >= w(k, T_j) between consecutive expiries. The grid points failing a condition 
+* are merged into regions of consecutive points.
+* 
+* References :  
+* - "Arbitrage-free SVI volatility surface", Gatheral, Jacquier, 2013. 
+*/
+
+/** 
+ * @enum ArbitrageType
+ * @brief The static arbitrage condition failed by a region. 
+ */
+/**
+ * @var ArbitrageType ArbitrageType::BUTTERFLY_ARBITRAGE
+ * @brief The density g(k) of the slice is negative or undefined. 
+ */
+/**
+ * @var ArbitrageType ArbitrageType::CALENDAR_SPREAD_ARBITRAGE
+ * @brief The total variance of the next slice is lower than the one of the slice. 
+ */
+
+/** 
+ * @struct ArbitrageRegion
+ * @brief Consecutive grid points of a slice failing one static arbitrage condition. 
+ */
+/**
+ * @var std::size_t ArbitrageRegion::surface
+ * @brief The index of the surface in the scanner.
+ */
+/**
+ * @var std::size_t ArbitrageRegion::slice
+ * @brief The index of the slice, the earlier one of the pair for a calendar spread arbitrage.
+ */
+/**
+ * @var double ArbitrageRegion::k_lower
+ * @brief The lowest failing log moneyness of the region.
+ */
+/**
+ * @var double ArbitrageRegion::k_upper
+ * @brief The highest failing log moneyness of the region.
+ */
+/**
+ * @var double ArbitrageRegion::worst
+ * @brief The lowest density, or difference of total variance with the next slice, of the 
+ * region, NaN if undefined.
+ */
+
+/** 
+ * @struct ArbitrageScanner
+ * @brief The static arbitrage scan of a set of surfaces, every surface being a view over 
+ * raw SVI slices sorted by expiry and owned by the caller. 
+ */
+/**
+ * @var std::vector<double> ArbitrageScanner::k_
+ * @brief The uniform log moneyness grid of the scan.
+ */
+/**
+ * @var std::vector<ArbitrageRegion> ArbitrageScanner::regions
+ * @brief The regions found by the last scan, ordered by surface, slice and log moneyness.
+ */
+/**
+ * @var std::size_t ArbitrageScanner::workers
+ * @brief The maximum number of worker threads, the hardware concurrency by default. A worker 
+ * is only started for every ARBITRAGE_POINTS_PER_WORKER points.
+ */
+
+/**
+ * @brief The main constructor, without surface.
+ * @param k_min The lowest log moneyness of the grid.
+ * @param k_max The highest log moneyness of the grid.
+ * @param nk The number of points of the grid.
+ * @throw VolSurfaceInvalidGrid
+ */
+ArbitrageScanner::ArbitrageScanner(double k_min, double k_max, std::size_t nk): 
+    workers(std::max(1u, std::thread::hardware_concurrency()))
+{
+    if (nk<2 or not (k_max>k_min)){throw VolSurfaceInvalidGrid();}
+    k_.resize(nk);
+    for (std::size_t i = 0; i<nk; i++){k_[i] = k_min + (double)i*(k_max - k_min)/((double)nk - 1);}
+};
+
+/**
+ * @brief Adds a surface, the arrays are not copied.
+ * @param slices The raw SVI slices of the surface.
+ * @param t The year fractions of the slices, increasing.
+ * @return The index of the surface.
+ * @throw SVIBatchSizeMismatch
+ * @throw VolSurfaceUnsortedSlices
+ */
+std::size_t ArbitrageScanner::add_surface(std::span<const RawSVI> slices, std::span<const double> t)
+{
+    if (t.size()!=slices.size()){throw SVIBatchSizeMismatch();}
+    for (std::size_t j = 0; j<t.size(); j++)
+    {if (not (t[j]>(j==0 ? 0.0 : t[j-1]))){throw VolSurfaceUnsortedSlices();}}
+    slices_.push_back(slices);
+    T_.push_back(t);
+    return slices_.size() - 1;
+};
+
+/**
+ * @return The number of surfaces.
+ */
+std::size_t ArbitrageScanner::size()
+{
+    return slices_.size();
+};
+
+/**
+ * @brief Appends the regions of consecutive grid points failing a condition.
+ * @param k The log moneyness grid.
+ * @param values The values of the condition, which holds if non negative.
+ * @param surface The index of the surface.
+ * @param slice The index of the slice.
+ * @param type The condition.
+ * @param regions The regions, appended.
+ */
+static void append_regions(std::span<const double> k, std::span<const double> values, 
+    std::size_t surface, std::size_t slice, ArbitrageType type, std::vector<ArbitrageRegion>& regions)
+{
+    for (std::size_t i = 0; i<k.size(); i++)
+    {
+        if (values[i]>=0){continue;}
+        ArbitrageRegion region = {surface, slice, type, k[i], k[i], values[i]};
+        for (; i<k.size() and not (values[i]>=0); i++)
+        {
+            region.k_upper = k[i];
+            if (not std::isnan(region.worst) and not (values[i]>=region.worst)){region.worst = values[i];}
+        }
+        regions.push_back(region);
+    }
+};
+
+/**
+ * @brief Scans every surface, in parallel over the surfaces.
+ * @return True if no region fails a condition.
+ */
+bool ArbitrageScanner::scan()
+{
+    const std::size_t n = size();
+    const std::size_t nk = k_.size();
+    std::vector<std::vector<ArbitrageRegion>> found(n);
+    std::atomic<std::size_t> next{0};
+    auto work = [&]()
+    {
+        std::vector<double> w(nk);
+        std::vector<double> w_next(nk);
+        std::vector<double> g(nk);
+        for (std::size_t s = next++; s<n; s = next++)
+        {
+            std::span<const RawSVI> slices = slices_[s];
+            for (std::size_t j = 0; j<slices.size(); j++)
+            {
+                RawSVI slice = slices[j];
+                slice.evaluate(k_, T_[s][j], j==0 ? std::span<double>(w) : std::span<double>(w_next), 
+                    std::span<double>(), std::span<double>(), g);
+                append_regions(k_, g, s, j, BUTTERFLY_ARBITRAGE, found[s]);
+                if (j==0){continue;}
+                // w holds the previous slice, and becomes the difference with it.
+                for (std::size_t i = 0; i<nk; i++){w[i] = w_next[i] - w[i];}
+                append_regions(k_, w, s, j - 1, CALENDAR_SPREAD_ARBITRAGE, found[s]);
+                std::swap(w, w_next);
+            }
+        }
+    };
+    std::size_t points = 0;
+    for (std::size_t s = 0; s<n; s++){points += slices_[s].size()*nk;}
+    const std::size_t count = std::min({workers, n, 1 + points/ARBITRAGE_POINTS_PER_WORKER});
+    std::vector<std::thread> pool;
+    for (std::size_t worker = 1; worker<count; worker++){pool.emplace_back(work);}
+    work();
+    for (std::thread& thread: pool){thread.join();}
+
+    regions.clear();
+    for (std::size_t s = 0; s<n; s++)
+    {
+        // The regions of a slice are listed by log moneyness, butterfly before calendar spread.
+        std::stable_sort(found[s].begin(), found[s].end(), 
+            [](const ArbitrageRegion& x, const ArbitrageRegion& y){return x.slice<y.slice;});
+        regions.insert(regions.end(), found[s].begin(), found[s].end());
+    }
+    return regions.empty();
+};
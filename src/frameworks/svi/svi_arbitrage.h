@@ -0,0 +1,38 @@
+#pragma once 
+#include <iostream>
+#include <cmath>
+#include <span>
+#include <vector>
+#include "svi.h"
+
+enum ArbitrageType
+{
+    BUTTERFLY_ARBITRAGE = 0, 
+    CALENDAR_SPREAD_ARBITRAGE = 1
+};
+
+constexpr std::size_t ARBITRAGE_POINTS_PER_WORKER = 1 << 16;
+
+struct ArbitrageRegion
+{
+    std::size_t surface; 
+    std::size_t slice; 
+    ArbitrageType type; 
+    double k_lower; 
+    double k_upper; 
+    double worst; 
+};
+
+struct ArbitrageScanner
+{
+    std::vector<double> k_; 
+    std::vector<std::span<const RawSVI>> slices_; 
+    std::vector<std::span<const double>> T_; 
+    std::vector<ArbitrageRegion> regions; 
+    std::size_t workers; 
+    ArbitrageScanner(double k_min, double k_max, std::size_t nk); 
+    ~ArbitrageScanner(){}; 
+    std::size_t add_surface(std::span<const RawSVI> slices, std::span<const double> t); 
+    std::size_t size(); 
+    bool scan(); 
+};
@@ -0,0 +1,1048 @@
+#include "svi_calibration.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include "../../math/simd/simd.h"
+
+/** 
+* @file svi_calibration.h
+* @brief This file defines the calibration of raw SVI slices and of power law SSVI 
+* surfaces to total variance quotes.
+* 
+* For a fixed translation m and curvature s, the raw SVI total variance 
+* w(k) = a + d*y + c*sqrt(y*y + 1), y = (k - m)/s, d = b*p*s, c = b*s, is linear in 
+* (a, d, c), so the weighted least squares fit of (a, d, c) is a 3 by 3 quadratic 
+* program solved explicitly over the active sets of its constraints. The outer problem 
+* is the 2 dimensional minimisation over (m, log(s)), solved by Nelder-Mead and warm 
+* started from the previous fit of the slice.
+* 
+* The constraints are the ones of SVI::butterfly_arbitrage_check, b*(1+|p|) < 2 and 
+* b*b*(1+|p|) <= w(0), together with |p| <= 1 and 0 <= a <= max(w), and they are all 
+* enforced by the inner problem.
+* 
+* The SSVI surface is fitted globally by a bounded Levenberg-Marquardt over (rho, nu, gamma) 
+* and the ATM total variances of the slices, with the analytic derivatives of 
+* SSVI::total_variance. The ATM total variances are parametrised by their non negative 
+* increments and nu by its ratio to the largest value passing SSVI::butterfly_arbitrage_check 
+* at every slice, so that every point within the bounds passes both 
+* SSVI::butterfly_arbitrage_check and SSVI::calendar_spread_arbitrage_check.
+* 
+* References :  
+* - "Quasi-Explicit Calibration of Gatheral's SVI model", Zeliade Systems, 2009. 
+* - "Arbitrage-free SVI volatility surface", Gatheral, Jacquier, 2013. 
+*/
+
+/** 
+ * @class SVINotEnoughQuotes
+ * @brief Definition of the error when a slice has too few quotes with positive weights, 5 for 
+ * a SVI slice and 1 for a SSVI slice. 
+ */
+/** 
+ * @brief Definition of what() virtual std::exception function.
+ * @return The explication of the error.
+ */
+const char * SVINotEnoughQuotes::what() const throw(){
+    return "A slice does not have enough quotes with positive weights to be calibrated.";
+};
+
+/** 
+ * @class SSVIUnsortedSlices
+ * @brief Definition of the error when the SSVI slices are not added by increasing year fractions. 
+ */
+/** 
+ * @brief Definition of what() virtual std::exception function.
+ * @return The explication of the error.
+ */
+const char * SSVIUnsortedSlices::what() const throw(){
+    return "The SSVI slices must be added by strictly increasing positive year fractions.";
+};
+
+/** 
+ * @struct SVIFit
+ * @brief The raw SVI parameters calibrated on a slice. 
+ */
+/**
+ * @var double SVIFit::rmse
+ * @brief The weighted root mean square error of the total variances.
+ */
+/**
+ * @var int SVIFit::evaluations
+ * @brief The number of evaluations of the outer objective, 0 if the slice was never calibrated.
+ */
+/**
+ * @var bool SVIFit::arbitrage_free
+ * @brief Indicator if the Jump-Wings slice is valid and passes SVI::butterfly_arbitrage_check.
+ */
+
+/**
+ * @return The Jump-Wings SVI slice of the raw parameters, built with the non throwing 
+ * constructor.
+ */
+SVI SVIFit::get_svi()
+{
+    return get_raw_svi().get_svi(T_);
+};
+
+/**
+ * @return The raw SVI slice of the fit.
+ */
+RawSVI SVIFit::get_raw_svi()
+{
+    return RawSVI(a, b, p, m, s);
+};
+
+/**
+ * @param k The log moneyness.
+ * @return The total variance of the raw SVI slice.
+ */
+double SVIFit::total_variance(double k)
+{
+    return a + b*(p*(k - m) + std::sqrt((k - m)*(k - m) + s*s));
+};
+
+/** 
+ * @struct SVICalibrator
+ * @brief The calibrator of the SVI slices of a surface, the quotes of every slice are 
+ * views over arrays owned by the caller, which can be updated between calibrations.
+ */
+/**
+ * @var std::vector<SVIFit> SVICalibrator::fits
+ * @brief The last fit of every slice, which is the starting point of the next calibration.
+ */
+/**
+ * @var std::size_t SVICalibrator::workers
+ * @brief The number of worker threads, the hardware concurrency by default.
+ */
+
+/**
+ * @brief The default constructor, without slice.
+ */
+SVICalibrator::SVICalibrator(): 
+    workers(std::max(1u, std::thread::hardware_concurrency())){};
+
+/**
+ * @brief Adds a slice, the arrays are not copied.
+ * @param t The year fraction of the slice.
+ * @param k The log moneyness of the quotes.
+ * @param w The total variances of the quotes.
+ * @param weight The non negative weights of the quotes.
+ * @return The index of the slice.
+ * @throw SVIBatchSizeMismatch
+ * @throw SVINotEnoughQuotes
+ */
+std::size_t SVICalibrator::add_slice(
+    double t, 
+    std::span<const double> k, 
+    std::span<const double> w, 
+    std::span<const double> weight)
+{
+    if (w.size()!=k.size() or weight.size()!=k.size()){throw SVIBatchSizeMismatch();}
+    if (std::count_if(weight.begin(), weight.end(), [](double x){return x>0;})<5)
+    {throw SVINotEnoughQuotes();}
+    T_.push_back(t);
+    k_.push_back(k);
+    w_.push_back(w);
+    weight_.push_back(weight);
+    SVIFit fit = {0.0, 0.0, 0.0, 0.0, 0.0, t, 0.0, 0, false};
+    fits.push_back(fit);
+    return fits.size() - 1;
+};
+
+/**
+ * @return The number of slices.
+ */
+std::size_t SVICalibrator::size()
+{
+    return fits.size();
+};
+
+/**
+ * @brief Solves a small dense linear system in place by Gaussian elimination with 
+ * partial pivoting.
+ * @param A The n by n matrix, row major, overwritten.
+ * @param x The right hand side, overwritten by the solution.
+ * @param n The size of the system.
+ * @return False if the matrix is numerically singular.
+ */
+static bool solve_linear_system(double* A, double* x, int n)
+{
+    double norm = 0.0;
+    for (int i = 0; i<n*n; i++){norm = std::max(norm, std::fabs(A[i]));}
+    for (int j = 0; j<n; j++)
+    {
+        int pivot = j;
+        for (int i = j + 1; i<n; i++){if (std::fabs(A[i*n + j])>std::fabs(A[pivot*n + j])){pivot = i;}}
+        if (not (std::fabs(A[pivot*n + j])>1e-13*norm)){return false;}
+        if (pivot!=j)
+        {
+            for (int l = 0; l<n; l++){std::swap(A[j*n + l], A[pivot*n + l]);}
+            std::swap(x[j], x[pivot]);
+        }
+        for (int i = j + 1; i<n; i++)
+        {
+            const double factor = A[i*n + j]/A[j*n + j];
+            for (int l = j; l<n; l++){A[i*n + l] -= factor*A[j*n + l];}
+            x[i] -= factor*x[j];
+        }
+    }
+    for (int j = n - 1; j>=0; j--)
+    {
+        for (int l = j + 1; l<n; l++){x[j] -= A[j*n + l]*x[l];}
+        x[j] /= A[j*n + j];
+    }
+    return true;
+};
+
+/**
+ * @brief The minimum of the convex quadratic x'Hx - 2g'x + ww over one set of active 
+ * constraints, if it is feasible.
+ * @param H The 3 by 3 matrix of the quadratic.
+ * @param g The linear term.
+ * @param ww The constant term.
+ * @param G The constraint rows.
+ * @param h The constraint bounds.
+ * @param constraints The number of constraints.
+ * @param active The bit set of the active constraints, at most 3.
+ * @param x The output minimum.
+ * @param multipliers The output Lagrange multipliers of the constraints, 0 for the 
+ * inactive ones.
+ * @param optimal The output indicator if the minimum is the one of the whole problem: 
+ * feasible with non negative multipliers of its active constraints (KKT).
+ * @return The minimum value, infinite if the minimum is not feasible.
+ */
+static double active_set_fit(const double* H, const double* g, double ww, 
+    const double (*G)[3], const double* h, int constraints, int active, double* x, 
+    double* multipliers, bool& optimal)
+{
+    optimal = false;
+    double bound = 0.0;
+    for (int j = 0; j<constraints; j++){bound = std::max(bound, std::fabs(h[j]));}
+    // The KKT system [H G'; G 0] [x; lambda] = [g; h] of the active constraints.
+    const int n = 3 + __builtin_popcount(active);
+    double A[36];
+    double z[6];
+    std::fill_n(A, n*n, 0.0);
+    double H_norm = 0.0;
+    for (int r = 0; r<3; r++)
+    {
+        z[r] = g[r]; 
+        for (int c = 0; c<3; c++)
+        {
+            A[r*n + c] = H[3*r + c]; 
+            H_norm = std::max(H_norm, std::fabs(H[3*r + c]));
+        }
+    }
+    // The constraint rows are scaled to the size of H, the pivots of the multipliers are 
+    // otherwise lost in the rounding of H when s is small.
+    double scale[6] = {1, 1, 1, 1, 1, 1};
+    for (int j = 0, row = 3; j<constraints; j++)
+    {
+        if (not (active & (1 << j))){continue;}
+        const double G_norm = std::max({std::fabs(G[j][0]), std::fabs(G[j][1]), std::fabs(G[j][2])});
+        if (G_norm>0 and H_norm>0){scale[row] = H_norm/G_norm;}
+        for (int c = 0; c<3; c++){A[row*n + c] = A[c*n + row] = scale[row]*G[j][c];}
+        z[row] = scale[row]*h[j];
+        row++;
+    }
+    if (not solve_linear_system(A, z, n)){return HUGE_VAL;}
+    for (int j = 0; j<constraints; j++)
+    {
+        const double lhs = G[j][0]*z[0] + G[j][1]*z[1] + G[j][2]*z[2];
+        if (lhs>h[j] + 1e-12*(std::fabs(h[j]) + bound)){return HUGE_VAL;}
+    }
+    optimal = true;
+    for (int row = 3; row<n; row++){if (z[row]<0){optimal = false;}}
+    double value = ww;
+    for (int r = 0; r<3; r++)
+    {
+        value -= 2*g[r]*z[r];
+        for (int c = 0; c<3; c++){value += z[r]*H[3*r + c]*z[c];}
+    }
+    std::copy_n(z, 3, x);
+    for (int j = 0, row = 3; j<constraints; j++)
+    {
+        multipliers[j] = 0.0;
+        if (active & (1 << j)){multipliers[j] = scale[row]*z[row]; row++;}
+    }
+    return value;
+};
+
+/**
+ * @brief The minimum of the convex quadratic x'Hx - 2g'x + ww under the linear 
+ * constraints G*x <= h. The minimum lies in the relative interior of one face of the 
+ * constraint polytope, so it is the minimum over one set of at most 3 active 
+ * constraints. The active sets of the previous solves are tried first, most recent 
+ * first, then the other sets by increasing distance to the most recent one, until one 
+ * passes the KKT conditions, the best feasible point being kept when rounding fails 
+ * them all.
+ * @param H The 3 by 3 matrix of the quadratic.
+ * @param g The linear term.
+ * @param ww The constant term.
+ * @param G The constraint rows.
+ * @param h The constraint bounds.
+ * @param constraints The number of constraints.
+ * @param x The output minimum.
+ * @param multipliers The output Lagrange multipliers of the constraints at the minimum.
+ * @param active The active sets of the previous solves, most recent first, -1 if none, 
+ * updated with the active set of the minimum.
+ * @param sets The number of active sets kept.
+ * @return The minimum value, infinite if no candidate is feasible.
+ */
+static double constrained_fit(const double* H, const double* g, double ww, 
+    const double (*G)[3], const double* h, int constraints, double* x, double* multipliers, 
+    int* active, int sets)
+{
+    auto valid = [&](int candidate)
+    {return candidate>=0 and candidate<(1 << constraints) and __builtin_popcount(candidate)<=3;};
+    auto previous = [&](int candidate)
+    {return std::find(active, active + sets, candidate)!=active + sets;};
+    const int hint = valid(active[0]) ? active[0] : 0;
+    double best = HUGE_VAL;
+    int found = -1;
+    double z[3];
+    double lambda[7];
+    auto attempt = [&](int candidate)
+    {
+        bool optimal;
+        const double value = active_set_fit(H, g, ww, G, h, constraints, candidate, z, lambda, optimal);
+        if (value<best or optimal)
+        {
+            best = value; 
+            found = candidate; 
+            std::copy_n(z, 3, x); 
+            std::copy_n(lambda, constraints, multipliers);
+        }
+        return optimal;
+    };
+    bool optimal = false;
+    for (int i = 0; i<sets and not optimal; i++)
+    {
+        if (valid(active[i]) and std::find(active, active + i, active[i])==active + i)
+        {optimal = attempt(active[i]);}
+    }
+    for (int distance = 0; distance<=constraints and not optimal; distance++)
+    {
+        for (int candidate = 0; candidate<(1 << constraints) and not optimal; candidate++)
+        {
+            if (__builtin_popcount(candidate ^ hint)!=distance or not valid(candidate) 
+                or previous(candidate)){continue;}
+            optimal = attempt(candidate);
+        }
+    }
+    if (found>=0)
+    {
+        // The set found moves to the front.
+        int* last = std::find(active, active + sets - 1, found);
+        std::copy_backward(active, last, last + 1);
+        active[0] = found;
+    }
+    return best;
+};
+
+/**
+ * @brief The state an inner fit passes to the next one, at a close (m, s): the active sets
+ * of its last solves and its optimal B.
+ */
+struct SVIInnerFitHint
+{
+    int active = 0;
+    int probe_active[SVI_CALIBRATION_ACTIVE_SETS] = {-1, -1, -1, -1};
+    double B = 0.0;
+};
+
+/**
+ * @brief The inner problem: the weighted least squares fit of (a, d, c) for a given
+ * (m, s) under the butterfly arbitrage constraints.
+ *
+ * The fit is first solved under the linear constraints 0 <= a <= max(w), |d| <= c and
+ * c + |d| <= 2*s. If it breaks c*(c + |d|) <= s*s*w(0), the constraints c + |d| <= B*s
+ * and c*B <= s*w(0), linear for a fixed B and which imply it, replace the wing one and
+ * the fit is minimised over B in (0, 2). The derivative of the fit in B follows from the
+ * multipliers of the constraints which depend on B (envelope theorem). The search brackets
+ * its zero, stepping away from the optimal B of the previous fit when there is one, then
+ * narrows the bracket with regula falsi steps (Illinois) until it is below
+ * SVI_CALIBRATION_SEARCH_TOLERANCE or the fit is within SVI_CALIBRATION_TOLERANCE of its
+ * minimum. Every constraint keeps a relative margin of 1e-9 so that the rounding of the
+ * Jump-Wings parameters does not break the strict inequalities.
+ * @param k The log moneyness of the quotes.
+ * @param w The total variances of the quotes.
+ * @param weight The weights of the quotes.
+ * @param m The translation.
+ * @param s The curvature.
+ * @param w_max The upper bound of a.
+ * @param x The output (a, d, c).
+ * @param hint The state of the previous fit, overwritten by the state of this one.
+ * @return The weighted sum of the squared errors.
+ */
+static double inner_fit(std::span<const double> k, std::span<const double> w,
+    std::span<const double> weight, double m, double s, double w_max, double* x,
+    SVIInnerFitHint& hint)
+{
+    double H[9] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+    double g[3] = {0, 0, 0};
+    double ww = 0.0;
+    for (std::size_t i = 0; i<k.size(); i++)
+    {
+        const double y = (k[i] - m)/s;
+        const double basis[3] = {1.0, y, std::sqrt(y*y + 1)};
+        for (int r = 0; r<3; r++)
+        {
+            g[r] += weight[i]*w[i]*basis[r];
+            for (int c = r; c<3; c++){H[3*r + c] += weight[i]*basis[r]*basis[c];}
+        }
+        ww += weight[i]*w[i]*w[i];
+    }
+    for (int r = 0; r<3; r++){for (int c = 0; c<r; c++){H[3*r + c] = H[3*c + r];}}
+
+    const double margin = 1 - 1e-9;
+    const double wing = 2*margin;
+    const double y0 = -m/s;
+    const double z0 = std::sqrt(y0*y0 + 1);
+    double G[7][3] = {{-1, 0, 0}, {1, 0, 0}, {0, 1, -1}, {0, -1, -1}, {0, 1, 1}, {0, -1, 1}, 
+        {-margin*s, -margin*s*y0, 0}};
+    double h[7] = {0.0, w_max, 0.0, 0.0, wing*s, wing*s, 0.0};
+    double multipliers[7];
+    double error = constrained_fit(H, g, ww, G, h, 6, x, multipliers, &hint.active, 1);
+    if (x[2]*(x[2] + std::fabs(x[1]))<=margin*s*s*(x[0] + x[1]*y0 + x[2]*z0)){return error;}
+
+    // With the Lagrangian x'Hx - 2g'x + 2*lambda'(Gx - h), the derivative of the fit in B 
+    // is 2*(lambda_6*c - s*(lambda_4 + lambda_5)). The probes start from the recent active 
+    // sets, which the search revisits as B crosses the faces of the constraints.
+    double z[3];
+    double best = wing;
+    error = HUGE_VAL;
+    auto probe = [&](double B)
+    {
+        h[4] = h[5] = B*s;
+        G[6][2] = B - margin*s*z0;
+        const double value = constrained_fit(H, g, ww, G, h, 7, z, multipliers, 
+            hint.probe_active, SVI_CALIBRATION_ACTIVE_SETS);
+        if (value<error){error = value; best = B; std::copy_n(z, 3, x);}
+        return 2*(multipliers[6]*z[2] - s*(multipliers[4] + multipliers[5]));
+    };
+    // Without a previous B the search starts from the wing and bisects: the derivative at 
+    // B = 0, where c = d = 0, is not defined. From a previous B it steps out geometrically.
+    const bool warm = hint.B>0 and hint.B<wing;
+    double B = warm ? hint.B : wing;
+    double step = warm ? SVI_CALIBRATION_SEARCH_STEP*wing : 0.0;
+    double lower = 0.0;
+    double upper = wing;
+    double slope_lower = 0.0;
+    double slope_upper = 0.0;
+    int side = 0;
+    for (int iteration = 0; iteration<SVI_CALIBRATION_SEARCH_ITERATIONS; iteration++)
+    {
+        const double slope = probe(B);
+        if (not (slope<0 or slope>0)){break;}
+        // Illinois: the end kept twice in a row has its derivative halved.
+        if (slope<0)
+        {
+            if (side==1 and slope_upper>0){slope_upper *= .5;}
+            lower = B; slope_lower = slope; side = 1;
+            if (B==wing){break;}
+        }
+        else 
+        {
+            if (side==-1 and slope_lower<0){slope_lower *= .5;}
+            upper = B; slope_upper = slope; side = -1;
+        }
+        if (upper - lower<=SVI_CALIBRATION_SEARCH_TOLERANCE*wing 
+            or std::fabs(slope)*(upper - lower)<=SVI_CALIBRATION_TOLERANCE*ww){break;}
+        if (slope_lower<0 and slope_upper>0)
+        {B = (lower*slope_upper - upper*slope_lower)/(slope_upper - slope_lower);}
+        else if (step>0)
+        {
+            B = slope_lower<0 ? std::min(lower + step, wing) : upper - step;
+            step *= 4;
+        }
+        else {B = .5*(lower + upper);}
+        if (not (B>lower and B<=upper) or (B==upper and slope_upper>0)){B = .5*(lower + upper);}
+    }
+    hint.B = best;
+    return error;
+};
+
+/**
+ * @brief Minimises a function of 2 variables with the Nelder-Mead simplex.
+ * @param f The function.
+ * @param x The initial simplex, overwritten by the final simplex, best vertex first.
+ * @param fx The values at the vertices.
+ * @param tolerance The absolute spread of the values at convergence.
+ * @return The number of evaluations.
+ */
+template <typename Function>
+static int nelder_mead(Function f, double x[3][2], double fx[3], double tolerance)
+{
+    int evaluations = 0;
+    for (int v = 0; v<3; v++){fx[v] = f(x[v]); evaluations++;}
+    auto order = [&]()
+    {
+        for (int i = 1; i<3; i++)
+        {
+            for (int j = i; j>0 and fx[j]<fx[j-1]; j--)
+            {std::swap(fx[j], fx[j-1]); std::swap(x[j], x[j-1]);}
+        }
+    };
+    order();
+    while (evaluations<SVI_CALIBRATION_MAX_EVALUATIONS and fx[2] - fx[0]>tolerance)
+    {
+        const double centroid[2] = {.5*(x[0][0] + x[1][0]), .5*(x[0][1] + x[1][1])};
+        auto point = [&](double t, double* out)
+        {
+            out[0] = centroid[0] + t*(x[2][0] - centroid[0]);
+            out[1] = centroid[1] + t*(x[2][1] - centroid[1]);
+            evaluations++;
+            return f(out);
+        };
+        double reflected[2];
+        const double f_reflected = point(-1.0, reflected);
+        if (f_reflected<fx[0])
+        {
+            double expanded[2];
+            const double f_expanded = point(-2.0, expanded);
+            const bool expand = f_expanded<f_reflected;
+            std::copy_n(expand ? expanded : reflected, 2, x[2]);
+            fx[2] = expand ? f_expanded : f_reflected;
+        }
+        else if (f_reflected<fx[1])
+        {
+            std::copy_n(reflected, 2, x[2]);
+            fx[2] = f_reflected;
+        }
+        else 
+        {
+            double contracted[2];
+            const bool outside = f_reflected<fx[2];
+            const double f_contracted = point(outside ? -.5 : .5, contracted);
+            if (f_contracted<std::min(f_reflected, fx[2]))
+            {
+                std::copy_n(contracted, 2, x[2]);
+                fx[2] = f_contracted;
+            }
+            else 
+            {
+                for (int v = 1; v<3; v++)
+                {
+                    x[v][0] = .5*(x[0][0] + x[v][0]);
+                    x[v][1] = .5*(x[0][1] + x[v][1]);
+                    fx[v] = f(x[v]);
+                    evaluations++;
+                }
+            }
+        }
+        order();
+    }
+    return evaluations;
+};
+
+/**
+ * @brief Calibrates one slice, from its previous fit if it has one.
+ * @param index The index of the slice.
+ * @return The fit, which is also stored in fits.
+ */
+SVIFit SVICalibrator::calibrate_slice(std::size_t index)
+{
+    std::span<const double> k = k_[index];
+    std::span<const double> w = w_[index];
+    std::span<const double> weight = weight_[index];
+    double k_min = HUGE_VAL;
+    double k_max = -HUGE_VAL;
+    double w_max = 0.0;
+    double w_min = HUGE_VAL;
+    double k_w_min = 0.0;
+    double weights = 0.0;
+    double scale = 0.0;
+    for (std::size_t i = 0; i<k.size(); i++)
+    {
+        if (not (weight[i]>0)){continue;}
+        k_min = std::min(k_min, k[i]);
+        k_max = std::max(k_max, k[i]);
+        w_max = std::max(w_max, w[i]);
+        if (w[i]<w_min){w_min = w[i]; k_w_min = k[i];}
+        weights += weight[i];
+        scale += weight[i]*w[i]*w[i];
+    }
+    const double range = std::max(k_max - k_min, 1e-4);
+
+    // The outer variables are m and log(s), kept in a box around the quotes.
+    auto parameters = [&](const double* u, double& m, double& s)
+    {
+        m = std::min(std::max(u[0], k_min - range), k_max + range);
+        s = std::exp(std::min(std::max(u[1], std::log(1e-3*range)), std::log(2*range)));
+    };
+    // The points of the simplex are close: each inner fit starts from the state of the 
+    // previous one.
+    SVIInnerFitHint hint;
+    auto objective = [&](const double* u)
+    {
+        double m;
+        double s;
+        double x[3] = {0, 0, 0};
+        parameters(u, m, s);
+        // The distance to the box keeps the simplex from drifting on the clamped plateau.
+        return inner_fit(k, w, weight, m, s, w_max, x, hint) + std::fabs(u[0] - m) + std::fabs(u[1] - std::log(s));
+    };
+
+    SVIFit& fit = fits[index];
+    const bool warm = fit.evaluations>0;
+    const double m0 = warm ? fit.m : k_w_min;
+    const double u0 = std::log(warm ? fit.s : .1*range);
+    const double step_m = warm ? .02*range : .25*range;
+    const double step_u = warm ? .1 : 1.0;
+    double simplex[3][2] = {{m0, u0}, {m0 + step_m, u0}, {m0, u0 + step_u}};
+    double values[3];
+    const int evaluations = nelder_mead(objective, simplex, values, SVI_CALIBRATION_TOLERANCE*scale);
+
+    double m;
+    double s;
+    double x[3] = {0, 0, 0};
+    parameters(simplex[0], m, s);
+    const double error = inner_fit(k, w, weight, m, s, w_max, x, hint);
+    fit.a = x[0];
+    fit.b = x[2]/s;
+    // |d| <= c holds up to the rounding of the ratio.
+    fit.p = x[2]>0 ? std::min(std::max(x[1]/x[2], -1.0), 1.0) : 0.0;
+    fit.m = m;
+    fit.s = s;
+    fit.T_ = T_[index];
+    fit.rmse = std::sqrt(std::max(error, 0.0)/weights);
+    fit.evaluations = evaluations;
+    SVI svi = fit.get_svi();
+    fit.arbitrage_free = svi.status==SVI_VALID and svi.butterfly_arbitrage_check();
+    return fit;
+};
+
+/**
+ * @brief Calibrates every slice, the slices are shared between the workers.
+ */
+void SVICalibrator::calibrate()
+{
+    const std::size_t n = size();
+    std::atomic<std::size_t> next{0};
+    auto work = [&]()
+    {for (std::size_t i = next++; i<n; i = next++){calibrate_slice(i);}};
+    std::vector<std::thread> pool;
+    for (std::size_t w = 1; w<std::min(workers, n); w++){pool.emplace_back(work);}
+    work();
+    for (std::thread& thread: pool){thread.join();}
+};
+
+
+/** 
+ * @struct SSVICalibrator
+ * @brief The global calibrator of a power law SSVI surface, the parameters (rho, nu, gamma) 
+ * and the ATM total variances of the slices are fitted together to the quotes of every 
+ * slice. The quotes of every slice are views over arrays owned by the caller, which can be 
+ * updated between calibrations.
+ * @see SSVI
+ */
+/**
+ * @var std::vector<double> SSVICalibrator::atm_total_variance
+ * @brief The calibrated ATM total variance of every slice, non decreasing with the year fraction.
+ */
+/**
+ * @var double SSVICalibrator::rmse
+ * @brief The weighted root mean square error of the total variances over every quote.
+ */
+/**
+ * @var int SSVICalibrator::iterations
+ * @brief The number of Levenberg-Marquardt iterations of the last calibration, 0 if the 
+ * surface was never calibrated since its last slice was added. The next calibration starts 
+ * from the current parameters when positive.
+ */
+/**
+ * @var bool SSVICalibrator::arbitrage_free
+ * @brief Indicator if the SSVI parameters are valid and pass SSVI::butterfly_arbitrage_check 
+ * and SSVI::calendar_spread_arbitrage_check at the ATM total variance of every slice.
+ */
+/**
+ * @var std::size_t SSVICalibrator::workers
+ * @brief The maximum number of worker threads, the hardware concurrency by default. A worker 
+ * is only started for every SSVI_CALIBRATION_QUOTES_PER_WORKER quotes, since the threads are
+ * started on every error evaluation and a slice costs well under a nanosecond per quote, so
+ * that the surfaces of up to a few hundred thousand quotes are calibrated serially.
+ */
+
+/**
+ * @brief The default constructor, without slice.
+ */
+SSVICalibrator::SSVICalibrator(): 
+    rho(0.0), nu(0.0), gamma(.5), rmse(0.0), iterations(0), arbitrage_free(false), 
+    workers(std::max(1u, std::thread::hardware_concurrency())){};
+
+/**
+ * @brief Adds a slice after the existing ones, the arrays are not copied.
+ * @param t The year fraction of the slice, larger than the one of the previous slice.
+ * @param k The log moneyness of the quotes.
+ * @param w The total variances of the quotes.
+ * @param weight The non negative weights of the quotes.
+ * @return The index of the slice.
+ * @throw SVIBatchSizeMismatch
+ * @throw SVINotEnoughQuotes
+ * @throw SSVIUnsortedSlices
+ */
+std::size_t SSVICalibrator::add_slice(
+    double t, 
+    std::span<const double> k, 
+    std::span<const double> w, 
+    std::span<const double> weight)
+{
+    if (w.size()!=k.size() or weight.size()!=k.size()){throw SVIBatchSizeMismatch();}
+    if (std::none_of(weight.begin(), weight.end(), [](double x){return x>0;}))
+    {throw SVINotEnoughQuotes();}
+    if (not (t>(T_.empty() ? 0.0 : T_.back()))){throw SSVIUnsortedSlices();}
+    T_.push_back(t);
+    k_.push_back(k);
+    w_.push_back(w);
+    weight_.push_back(weight);
+    atm_total_variance.push_back(0.0);
+    iterations = 0;
+    return T_.size() - 1;
+};
+
+/**
+ * @return The number of slices.
+ */
+std::size_t SSVICalibrator::size()
+{
+    return T_.size();
+};
+
+/**
+ * @return The calibrated SSVI, built with the non throwing constructor.
+ */
+SSVI SSVICalibrator::get_ssvi()
+{
+    return SSVI(rho, nu, gamma, std::nothrow);
+};
+
+/**
+ * @brief Accumulates the weighted least squares sums of the quotes of one slice. 
+ * 
+ * With x = phi*k + rho and R = sqrt(x*x + 1 - rho*rho), the total variance is 
+ * w = theta/2*(1 + rho*phi*k + R) and its derivatives at fixed theta are 
+ * A = dw/drho = theta/2*phi*k*(1 + 1/R) and B = dw/dphi = theta/2*k*(rho + x/R).
+ * @param k The log moneyness of the quotes.
+ * @param w The total variances of the quotes.
+ * @param weight The weights of the quotes.
+ * @param rho The SSVI parameter rho.
+ * @param phi The power law parametrization at the ATM total variance of the slice.
+ * @param theta The ATM total variance of the slice.
+ * @param sums The 10 output sums, the weighted products AA, AB, Aw, BB, Bw, ww, then the 
+ * weighted products of the error e = w - quote with A, B and w, then the weighted ee.
+ */
+static void accumulate_slice(std::span<const double> k, std::span<const double> w, 
+    std::span<const double> weight, double rho, double phi, double theta, double* sums)
+{
+    using namespace simd;
+    const Pack rho_ = broadcast(rho);
+    const Pack phi_ = broadcast(phi);
+    const Pack half = broadcast(.5*theta);
+    const Pack cross = broadcast(1 - rho*rho);
+    Pack acc[10];
+    for (Pack& a: acc){a = broadcast(0.0);}
+    auto block = [&](const double* k_, const double* w_, const double* weight_)
+    {
+        const Pack x = load(k_);
+        const Pack phi_k = phi_*x;
+        const Pack y = phi_k + rho_;
+        const Pack R = sqrt(fmadd(y, y, cross));
+        const Pack inverse = 1.0/R;
+        const Pack model = half*(fmadd(rho_, phi_k, R) + 1.0);
+        const Pack A = half*phi_k*(inverse + 1.0);
+        const Pack B = half*x*fmadd(y, inverse, rho_);
+        const Pack omega = load(weight_);
+        const Pack error = model - load(w_);
+        const Pack omega_A = omega*A;
+        const Pack omega_B = omega*B;
+        const Pack omega_e = omega*error;
+        acc[0] = fmadd(omega_A, A, acc[0]);
+        acc[1] = fmadd(omega_A, B, acc[1]);
+        acc[2] = fmadd(omega_A, model, acc[2]);
+        acc[3] = fmadd(omega_B, B, acc[3]);
+        acc[4] = fmadd(omega_B, model, acc[4]);
+        acc[5] = fmadd(omega*model, model, acc[5]);
+        acc[6] = fmadd(omega_e, A, acc[6]);
+        acc[7] = fmadd(omega_e, B, acc[7]);
+        acc[8] = fmadd(omega_e, model, acc[8]);
+        acc[9] = fmadd(omega_e, error, acc[9]);
+    };
+    const std::size_t n = k.size();
+    const std::size_t full = n - n%simd::WIDTH;
+    for (std::size_t i = 0; i<full; i += simd::WIDTH){block(&k[i], &w[i], &weight[i]);}
+    if (full<n)
+    {
+        // The padding quotes have a zero weight.
+        double tail[3][simd::WIDTH] = {};
+        for (std::size_t i = full; i<n; i++)
+        {
+            tail[0][i - full] = k[i];
+            tail[1][i - full] = w[i];
+            tail[2][i - full] = weight[i];
+        }
+        block(tail[0], tail[1], tail[2]);
+    }
+    for (int j = 0; j<10; j++)
+    {
+        double lanes[simd::WIDTH];
+        store(lanes, acc[j]);
+        sums[j] = 0.0;
+        for (std::size_t l = 0; l<simd::WIDTH; l++){sums[j] += lanes[l];}
+    }
+};
+
+/**
+ * @brief Maps the optimisation variables of the SSVI calibration, 
+ * u = (rho, nu/nu_max, gamma, theta_1, theta_2 - theta_1, ..., theta_n - theta_n-1), 
+ * to the SSVI parameters. nu_max(rho, gamma, theta) is the largest nu such that 
+ * theta_j*phi_j*(1+|rho|) <= 4 and theta_j*phi_j*phi_j*(1+|rho|) <= 4 for every slice j.
+ * @param u The optimisation variables.
+ * @param theta The output ATM total variances.
+ * @param dnu The output derivatives of nu with respect to u.
+ * @return The parameter nu.
+ */
+static double surface_parameters(std::span<const double> u, std::span<double> theta, 
+    std::span<double> dnu)
+{
+    const double rho = u[0];
+    const double gamma = u[2];
+    const double log_rho = std::log(1 + std::fabs(rho));
+    double bound = HUGE_VAL;
+    double drho = 0.0;
+    double dlog_theta = 0.0;
+    std::size_t binding = 0;
+    for (std::size_t j = 0; j<theta.size(); j++)
+    {
+        theta[j] = (j==0 ? 0.0 : theta[j-1]) + u[3 + j];
+        const double log_theta = std::log(theta[j]);
+        // log(nu_max) is the smallest of the log bounds of both conditions at every slice.
+        const double bound1 = std::log(4.0) - log_rho - (1 - gamma)*log_theta;
+        const double bound2 = std::log(2.0) - .5*log_rho - .5*(1 - 2*gamma)*log_theta;
+        if (bound1<bound){bound = bound1; drho = -1.0; dlog_theta = -(1 - gamma); binding = j;}
+        if (bound2<bound){bound = bound2; drho = -.5; dlog_theta = -.5*(1 - 2*gamma); binding = j;}
+    }
+    const double nu_max = std::exp(bound);
+    const double nu = u[1]*nu_max;
+    std::fill(dnu.begin(), dnu.end(), 0.0);
+    dnu[0] = nu*drho*(rho>0 ? 1.0 : (rho<0 ? -1.0 : 0.0))/(1 + std::fabs(rho));
+    dnu[1] = nu_max;
+    dnu[2] = nu*std::log(theta[binding]);
+    for (std::size_t l = 0; l<=binding; l++){dnu[3 + l] = nu*dlog_theta/theta[binding];}
+    return nu;
+};
+
+/**
+ * @brief The weighted sum of the squared errors of the SSVI surface at the optimisation 
+ * variables u, with the gradient and the Gauss-Newton Hessian of its half with respect to u.
+ * 
+ * The quotes of every slice are reduced to the 10 sums of accumulate_slice, in parallel 
+ * over the slices. Their derivatives with respect to (rho, nu, gamma, theta_j) are 
+ * (A, B*theta_j^-gamma, -B*phi_j*log(theta_j), (w - gamma*phi_j*B)/theta_j), from which the 
+ * gradient and Hessian with respect to (rho, nu, gamma, theta) are assembled, then mapped 
+ * to u by the chain rule.
+ * @param calibrator The calibrator.
+ * @param u The optimisation variables.
+ * @param gradient The output gradient.
+ * @param hessian The output Hessian, row major.
+ * @return The weighted sum of the squared errors.
+ */
+static double surface_error(SSVICalibrator& calibrator, std::span<const double> u, 
+    std::span<double> gradient, std::span<double> hessian)
+{
+    const std::size_t n = calibrator.size();
+    const std::size_t dims = n + 3;
+    std::vector<double> theta(n);
+    std::vector<double> dnu(dims);
+    const double nu = surface_parameters(u, theta, dnu);
+    const double rho = u[0];
+    const double gamma = u[2];
+
+    std::vector<double> sums(10*n);
+    std::size_t quotes = 0;
+    for (std::size_t j = 0; j<n; j++){quotes += calibrator.k_[j].size();}
+    std::atomic<std::size_t> next{0};
+    auto work = [&]()
+    {
+        for (std::size_t j = next++; j<n; j = next++)
+        {
+            accumulate_slice(calibrator.k_[j], calibrator.w_[j], calibrator.weight_[j], 
+                rho, nu*std::pow(theta[j], -gamma), theta[j], &sums[10*j]);
+        }
+    };
+    const std::size_t workers = std::min({calibrator.workers, n, 
+        1 + quotes/SSVI_CALIBRATION_QUOTES_PER_WORKER});
+    std::vector<std::thread> pool;
+    for (std::size_t w = 1; w<workers; w++){pool.emplace_back(work);}
+    work();
+    for (std::thread& thread: pool){thread.join();}
+
+    // The gradient and Hessian with respect to (rho, nu, gamma, theta_1, ..., theta_n).
+    std::vector<double> G(dims, 0.0);
+    std::vector<double> H(dims*dims, 0.0);
+    double error = 0.0;
+    for (std::size_t j = 0; j<n; j++)
+    {
+        const double* sum = &sums[10*j];
+        const double power = std::pow(theta[j], -gamma);
+        const double phi = nu*power;
+        const double S[3][3] = {{sum[0], sum[1], sum[2]}, {sum[1], sum[3], sum[4]}, 
+            {sum[2], sum[4], sum[5]}};
+        const double M[4][3] = {{1, 0, 0}, {0, power, 0}, {0, -phi*std::log(theta[j]), 0}, 
+            {0, -gamma*phi/theta[j], 1/theta[j]}};
+        const std::size_t index[4] = {0, 1, 2, 3 + j};
+        for (int a = 0; a<4; a++)
+        {
+            double MS[3];
+            for (int c = 0; c<3; c++){MS[c] = M[a][0]*S[0][c] + M[a][1]*S[1][c] + M[a][2]*S[2][c];}
+            for (int b = 0; b<4; b++)
+            {H[index[a]*dims + index[b]] += MS[0]*M[b][0] + MS[1]*M[b][1] + MS[2]*M[b][2];}
+            G[index[a]] += M[a][0]*sum[6] + M[a][1]*sum[7] + M[a][2]*sum[8];
+        }
+        error += sum[9];
+    }
+
+    // The chain rule to u, the Jacobian D of the parameters is the identity for rho and 
+    // gamma, the cumulative sum for the ATM total variances and dnu for nu, so that the 
+    // product of a row by D reduces to suffix sums in O(n).
+    auto right_multiply = [&](double* row)
+    {
+        const double row_nu = row[1];
+        double suffix = 0.0;
+        for (std::size_t c = dims - 1; c>=3; c--){suffix += row[c]; row[c] = suffix;}
+        row[1] = 0.0;
+        for (std::size_t c = 0; c<dims; c++){row[c] += row_nu*dnu[c];}
+    };
+    for (std::size_t r = 0; r<dims; r++){right_multiply(&H[r*dims]);}
+    for (std::size_t r = 0; r<dims; r++)
+    {for (std::size_t c = 0; c<dims; c++){hessian[r*dims + c] = H[c*dims + r];}}
+    for (std::size_t r = 0; r<dims; r++){right_multiply(&hessian[r*dims]);}
+    right_multiply(G.data());
+    std::copy(G.begin(), G.end(), gradient.begin());
+    return error;
+};
+
+/**
+ * @brief Calibrates the surface by a bounded Levenberg-Marquardt, from the current 
+ * parameters if the surface was already calibrated. 
+ * 
+ * The variables at a bound with a gradient pointing outwards are frozen for the step and 
+ * the step is projected on the bounds. The first calibration starts from rho = 0, 
+ * gamma = 1/2, nu = nu_max/2 and the ATM total variances interpolated from the quotes.
+ */
+void SSVICalibrator::calibrate()
+{
+    const std::size_t n = size();
+    if (n==0){return;}
+    const std::size_t dims = n + 3;
+    const double margin = 1 - 1e-9;
+    std::vector<double> lower(dims, 0.0);
+    std::vector<double> upper(dims, HUGE_VAL);
+    lower[0] = -margin;
+    upper[0] = margin;
+    upper[1] = margin;
+    upper[2] = 1.0;
+    lower[3] = 1e-12;
+
+    double weights = 0.0;
+    double scale = 0.0;
+    std::vector<double> theta(n);
+    for (std::size_t j = 0; j<n; j++)
+    {
+        // The ATM total variance is interpolated between the quotes around k = 0.
+        double below = -HUGE_VAL;
+        double above = HUGE_VAL;
+        double w_below = 0.0;
+        double w_above = 0.0;
+        for (std::size_t i = 0; i<k_[j].size(); i++)
+        {
+            if (not (weight_[j][i]>0)){continue;}
+            weights += weight_[j][i];
+            scale += weight_[j][i]*w_[j][i]*w_[j][i];
+            const double k = k_[j][i];
+            if (k<=0 and k>below){below = k; w_below = w_[j][i];}
+            if (k>=0 and k<above){above = k; w_above = w_[j][i];}
+        }
+        if (below==-HUGE_VAL){theta[j] = w_above;}
+        else if (above==HUGE_VAL or above==below){theta[j] = w_below;}
+        else {theta[j] = w_below + (w_above - w_below)*(-below)/(above - below);}
+        theta[j] = std::max(theta[j], j==0 ? lower[3] : theta[j-1]);
+    }
+
+    std::vector<double> u(dims);
+    std::vector<double> dnu(dims);
+    const bool warm = iterations>0;
+    u[0] = warm ? rho : 0.0;
+    u[1] = 1.0;
+    u[2] = warm ? gamma : .5;
+    for (std::size_t j = 0; j<n; j++)
+    {
+        const double theta_ = warm ? atm_total_variance[j] : theta[j];
+        u[3 + j] = theta_ - (j==0 ? 0.0 : (warm ? atm_total_variance[j-1] : theta[j-1]));
+    }
+    u[1] = warm ? nu/surface_parameters(u, theta, dnu) : .5;
+    for (std::size_t i = 0; i<dims; i++){u[i] = std::min(std::max(u[i], lower[i]), upper[i]);}
+
+    std::vector<double> gradient(dims);
+    std::vector<double> hessian(dims*dims);
+    std::vector<double> trial(dims);
+    std::vector<double> trial_gradient(dims);
+    std::vector<double> trial_hessian(dims*dims);
+    std::vector<double> A(dims*dims);
+    std::vector<double> step(dims);
+    std::vector<std::size_t> free(dims);
+    double error = surface_error(*this, u, gradient, hessian);
+    double lambda = 1e-3;
+    int iteration = 0;
+    while (iteration<SSVI_CALIBRATION_MAX_ITERATIONS and lambda<1e12)
+    {
+        iteration++;
+        std::size_t m = 0;
+        for (std::size_t i = 0; i<dims; i++)
+        {
+            const bool at_lower = u[i]<=lower[i] and gradient[i]>0;
+            const bool at_upper = u[i]>=upper[i] and gradient[i]<0;
+            if (not (at_lower or at_upper)){free[m++] = i;}
+        }
+        if (m==0){break;}
+        for (std::size_t r = 0; r<m; r++)
+        {
+            for (std::size_t c = 0; c<m; c++){A[r*m + c] = hessian[free[r]*dims + free[c]];}
+            A[r*m + r] += lambda*hessian[free[r]*dims + free[r]];
+            step[r] = -gradient[free[r]];
+        }
+        if (not solve_linear_system(A.data(), step.data(), (int)m)){lambda *= 10; continue;}
+        trial = u;
+        for (std::size_t r = 0; r<m; r++)
+        {
+            const std::size_t i = free[r];
+            trial[i] = std::min(std::max(u[i] + step[r], lower[i]), upper[i]);
+        }
+        const double trial_error = surface_error(*this, trial, trial_gradient, trial_hessian);
+        if (trial_error<error)
+        {
+            const double decrease = error - trial_error;
+            std::swap(u, trial);
+            std::swap(gradient, trial_gradient);
+            std::swap(hessian, trial_hessian);
+            error = trial_error;
+            lambda = std::max(.1*lambda, 1e-12);
+            if (decrease<=SVI_CALIBRATION_TOLERANCE*scale){break;}
+        }
+        else {lambda *= 10;}
+    }
+
+    nu = surface_parameters(u, atm_total_variance, dnu);
+    rho = u[0];
+    gamma = u[2];
+    rmse = std::sqrt(std::max(error, 0.0)/weights);
+    iterations = iteration;
+    SSVI ssvi = get_ssvi();
+    arbitrage_free = ssvi.status==SSVI_VALID;
+    for (std::size_t j = 0; j<n; j++)
+    {
+        arbitrage_free = arbitrage_free 
+            and ssvi.butterfly_arbitrage_check(atm_total_variance[j]) 
+            and ssvi.calendar_spread_arbitrage_check(atm_total_variance[j]) 
+            and (j==0 or atm_total_variance[j]>=atm_total_variance[j-1]);
+    }
+};
@@ -0,0 +1,85 @@
+#pragma once 
+#include <iostream>
+#include <cmath>
+#include <span>
+#include <vector>
+#include "svi.h"
+
+class SVINotEnoughQuotes:  public std::exception 
+{public: const char * what() const throw();};
+
+class SSVIUnsortedSlices:  public std::exception 
+{public: const char * what() const throw();};
+
+constexpr int SVI_CALIBRATION_MAX_EVALUATIONS = 400;
+constexpr double SVI_CALIBRATION_TOLERANCE = 1e-12;
+constexpr int SVI_CALIBRATION_SEARCH_ITERATIONS = 40;
+constexpr double SVI_CALIBRATION_SEARCH_TOLERANCE = 1e-10;
+constexpr double SVI_CALIBRATION_SEARCH_STEP = 1e-3;
+constexpr int SVI_CALIBRATION_ACTIVE_SETS = 4;
+constexpr int SSVI_CALIBRATION_MAX_ITERATIONS = 100;
+constexpr std::size_t SSVI_CALIBRATION_QUOTES_PER_WORKER = 1 << 18;
+
+struct SVIFit
+{
+    double a; 
+    double b; 
+    double p; 
+    double m; 
+    double s; 
+    double T_; 
+    double rmse; 
+    int evaluations; 
+    bool arbitrage_free; 
+    SVI get_svi(); 
+    RawSVI get_raw_svi(); 
+    double total_variance(double k); 
+};
+
+struct SVICalibrator
+{
+    std::vector<double> T_; 
+    std::vector<std::span<const double>> k_; 
+    std::vector<std::span<const double>> w_; 
+    std::vector<std::span<const double>> weight_; 
+    std::vector<SVIFit> fits; 
+    std::size_t workers; 
+    SVICalibrator(); 
+    ~SVICalibrator(){}; 
+    std::size_t add_slice(
+        double t, 
+        std::span<const double> k, 
+        std::span<const double> w, 
+        std::span<const double> weight
+    ); 
+    std::size_t size(); 
+    SVIFit calibrate_slice(std::size_t index); 
+    void calibrate(); 
+};
+
+struct SSVICalibrator
+{
+    std::vector<double> T_; 
+    std::vector<std::span<const double>> k_; 
+    std::vector<std::span<const double>> w_; 
+    std::vector<std::span<const double>> weight_; 
+    double rho; 
+    double nu; 
+    double gamma; 
+    std::vector<double> atm_total_variance; 
+    double rmse; 
+    int iterations; 
+    bool arbitrage_free; 
+    std::size_t workers; 
+    SSVICalibrator(); 
+    ~SSVICalibrator(){}; 
+    std::size_t add_slice(
+        double t, 
+        std::span<const double> k, 
+        std::span<const double> w, 
+        std::span<const double> weight
+    ); 
+    std::size_t size(); 
+    SSVI get_ssvi(); 
+    void calibrate(); 
+};
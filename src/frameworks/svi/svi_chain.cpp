@@ -0,0 +1,220 @@
+#include "svi_chain.h"
+#include <algorithm>
+#include "../../math/simd/simd.h"
+
+/**
+* @file svi_chain.h
+* @brief This file defines the pricer of an option chain of one expiry straight from its SVI
+* slice.
+*
+* The log moneyness k = log(K/F), the total variance w(k) and its slope w'(k), the implied
+* volatility and the Black prices and sensitivities of simd::WIDTH strikes are computed in
+* registers and only the selected outputs are stored: the implied volatilities never make a
+* round trip through memory between the smile and the pricer, and nothing is allocated, the
+* outputs being written in the arrays of the caller.
+*
+* The sensitivities are taken on the forward F, the discount factor being held fixed. Beside
+* the Black sensitivities at a fixed implied volatility, the smile is moved with the forward:
+* the sticky moneyness delta keeps w fixed in k,
+* dV/dF = delta - dV/dw*w'(k)/F, and the sticky moneyness vega moves the ATM volatility
+* sigma_atm with w/theta fixed in k/sqrt(theta), theta = sigma_atm^2*T being the ATM total
+* variance, dV/dsigma_atm = dV/dw*(2w - k*w'(k))/sigma_atm, the Black vega at the money.
+*/
+
+/**
+ * @struct SVIChainResult
+ * @brief The output arrays of SVIChain::evaluate(), of the chain size or empty if they are
+ * not needed.
+ */
+/**
+ * @var std::span<double> SVIChainResult::sticky_moneyness_delta
+ * @brief The first order sensitivities to the forward, the total variance being fixed in
+ * log moneyness.
+ */
+/**
+ * @var std::span<double> SVIChainResult::sticky_moneyness_vega
+ * @brief The first order sensitivities to the ATM volatility, the smile being fixed in
+ * log moneyness over ATM standard deviation.
+ */
+
+/**
+ * @param index The output index, in the order of the declaration.
+ * @return The output array.
+ */
+std::span<double>& SVIChainResult::output(int index)
+{
+    switch (index)
+    {
+        case 0: return implied_volatility;
+        case 1: return price;
+        case 2: return delta;
+        case 3: return gamma;
+        case 4: return vega;
+        case 5: return vanna;
+        case 6: return volga;
+        case 7: return dual_delta;
+        case 8: return dual_gamma;
+        case 9: return sticky_moneyness_delta;
+        default: return sticky_moneyness_vega;
+    }
+};
+
+/**
+ * @struct SVIChain
+ * @brief The european vanilla options of one expiry, priced on the forward with the implied
+ * volatilities of a raw SVI slice.
+ */
+/**
+ * @var RawSVI SVIChain::slice_
+ * @brief The raw SVI slice of the expiry.
+ */
+/**
+ * @var double SVIChain::F_
+ * @brief The forward price of the expiry.
+ */
+/**
+ * @var double SVIChain::D_
+ * @brief The discount factor of the expiry.
+ */
+/**
+ * @var double SVIChain::T_
+ * @brief The year fraction of the expiry.
+ */
+
+/**
+ * @brief The main constructor.
+ * @param slice The raw SVI slice.
+ * @param F The forward price.
+ * @param D The discount factor.
+ * @param t The year fraction.
+ * @throw SVIWrongParameterValue
+ */
+SVIChain::SVIChain(RawSVI slice, double F, double D, double t):
+    slice_(slice), F_(F), D_(D), T_(t)
+{
+    if (not (F_>0 and D_>0 and T_>0)){throw SVIWrongParameterValue();}
+};
+
+/**
+ * @brief The SVI slice constructor, the expiry being the one of the slice.
+ * @param slice The SVI slice.
+ * @param F The forward price.
+ * @param D The discount factor.
+ * @throw SVIWrongParameterValue
+ */
+SVIChain::SVIChain(SVI& slice, double F, double D):
+    SVIChain(slice.get_raw_svi(), F, D, slice.T_){};
+
+/**
+ * @brief Prices simd::WIDTH strikes.
+ * @param chain The option chain.
+ * @param K_ The strike lanes.
+ * @param cp_ The call/put flag lanes (1 or -1).
+ * @param out The output lanes, in the order of SVIChainResult::output().
+ * @param selected The bit mask of the outputs to store.
+ * @param sigma_atm The ATM implied volatility of the slice.
+ */
+static void evaluate_block(SVIChain& chain, const double* K_, const double* cp_,
+    double* const* out, unsigned int selected, double sigma_atm)
+{
+    using namespace simd;
+    const RawSVI& raw = chain.slice_;
+    const Pack K = load(K_);
+    const Pack cp = load(cp_);
+    const double F_ = chain.F_;
+    const Pack F = broadcast(F_);
+    const Pack D = broadcast(chain.D_);
+
+    const Pack k = log(K/F_);
+    const Pack shift = k - raw.m;
+    const Pack root = sqrt(fmadd(shift, shift, broadcast(raw.s*raw.s)));
+    const Pack w = raw.a + raw.b*fmadd(broadcast(raw.p), shift, root);
+    const Pack sqrt_w = sqrt(w);
+    const Pack sigma = sqrt_w*(1/std::sqrt(chain.T_));
+    const Pack d1 = -k/sqrt_w + .5*sqrt_w;
+    const Pack d2 = d1 - sqrt_w;
+    Pack nd1, N1;
+    normal_pdf_cdf(d1, nd1, N1);
+    const Mask call = cp > broadcast(0.0);
+    const Pack Nd1 = select(call, N1, 1.0 - N1);
+    const Pack Nd2 = normal_cdf(cp*d2);
+    const Pack D_nd1 = D*nd1;
+    const Pack vega = F*D_nd1*std::sqrt(chain.T_);
+    const Pack dVdw = .5*F*D_nd1/sqrt_w;
+
+    if (selected & (1u << 0)){store(out[0], sigma);}
+    if (selected & (1u << 1)){store(out[1], D*cp*(F*Nd1 - K*Nd2));}
+    if (selected & (1u << 2)){store(out[2], D*cp*Nd1);}
+    if (selected & (1u << 3)){store(out[3], D_nd1/(F*sqrt_w));}
+    if (selected & (1u << 4)){store(out[4], vega);}
+    if (selected & (1u << 5)){store(out[5], -D_nd1*d2/sigma);}
+    if (selected & (1u << 6)){store(out[6], vega*d1*d2/sigma);}
+    if (selected & (1u << 7)){store(out[7], -D*cp*Nd2);}
+    if (selected & (1u << 8)){store(out[8], D_nd1*F/(K*K*sqrt_w));}
+    if (selected & (3u << 9))
+    {
+        const Pack dwdk = raw.b*(raw.p + shift/root);
+        if (selected & (1u << 9)){store(out[9], D*cp*Nd1 - dVdw*dwdk/F_);}
+        if (selected & (1u << 10))
+        {store(out[10], dVdw*(2.0*w - k*dwdk)/sigma_atm);}
+    }
+};
+
+/**
+ * @brief Evaluates the implied volatilities, prices and sensitivities of a chain of strikes
+ * in one pass.
+ *
+ * Full blocks of simd::WIDTH strikes are read and written in place, the remaining strikes are
+ * copied into a padded block so that the tail runs through the same kernel. The outputs of a
+ * strike of non positive total variance are NaN.
+ *
+ * @param K The strike prices.
+ * @param is_call indicators if the options are calls (True) or puts (False).
+ * @param result The output arrays, each non empty array must have the chain size.
+ * @throw SVIBatchSizeMismatch
+ */
+void SVIChain::evaluate(
+    std::span<const double> K,
+    std::span<const bool> is_call,
+    SVIChainResult& result)
+{
+    const std::size_t n = K.size();
+    if (is_call.size()!=n){throw SVIBatchSizeMismatch();}
+    unsigned int selected = 0;
+    double* out[SVI_CHAIN_OUTPUT_COUNT];
+    double tail_out[SVI_CHAIN_OUTPUT_COUNT][simd::WIDTH];
+    double* tail_ptrs[SVI_CHAIN_OUTPUT_COUNT];
+    for (int g = 0; g<SVI_CHAIN_OUTPUT_COUNT; g++)
+    {
+        std::span<double> output = result.output(g);
+        if (output.empty()){continue;}
+        if (output.size()!=n){throw SVIBatchSizeMismatch();}
+        selected |= 1u << g;
+        out[g] = output.data();
+        tail_ptrs[g] = tail_out[g];
+    }
+
+    const double sigma_atm = std::sqrt(slice_.atm_total_variance()/T_);
+    double cp[simd::WIDTH];
+    std::size_t i = 0;
+    for (; i + simd::WIDTH<=n; i += simd::WIDTH)
+    {
+        for (std::size_t j = 0; j<simd::WIDTH; j++){cp[j] = is_call[i + j] ? 1.0 : -1.0;}
+        evaluate_block(*this, &K[i], cp, out, selected, sigma_atm);
+        for (int g = 0; g<SVI_CHAIN_OUTPUT_COUNT; g++)
+        {if (selected & (1u << g)){out[g] += simd::WIDTH;}}
+    }
+    if (i<n)
+    {
+        // Padding lanes hold an at-the-money call so that they stay finite.
+        double tail_K[simd::WIDTH];
+        for (std::size_t j = 0; j<simd::WIDTH; j++)
+        {
+            tail_K[j] = i + j<n ? K[i + j] : F_;
+            cp[j] = (i + j>=n or is_call[i + j]) ? 1.0 : -1.0;
+        }
+        evaluate_block(*this, tail_K, cp, tail_ptrs, selected, sigma_atm);
+        for (int g = 0; g<SVI_CHAIN_OUTPUT_COUNT; g++)
+        {if (selected & (1u << g)){std::copy_n(tail_out[g], n - i, out[g]);}}
+    }
+};
@@ -0,0 +1,39 @@
+#pragma once 
+#include <iostream>
+#include <cmath>
+#include <span>
+#include "svi.h"
+
+constexpr int SVI_CHAIN_OUTPUT_COUNT = 11;
+
+struct SVIChainResult
+{
+    std::span<double> implied_volatility; 
+    std::span<double> price; 
+    std::span<double> delta; 
+    std::span<double> gamma; 
+    std::span<double> vega; 
+    std::span<double> vanna; 
+    std::span<double> volga; 
+    std::span<double> dual_delta; 
+    std::span<double> dual_gamma; 
+    std::span<double> sticky_moneyness_delta; 
+    std::span<double> sticky_moneyness_vega; 
+    std::span<double>& output(int index); 
+};
+
+struct SVIChain
+{
+    RawSVI slice_; 
+    double F_; 
+    double D_; 
+    double T_; 
+    SVIChain(RawSVI slice, double F, double D, double t); 
+    SVIChain(SVI& slice, double F, double D); 
+    ~SVIChain(){}; 
+    void evaluate( 
+        std::span<const double> K, 
+        std::span<const bool> is_call, 
+        SVIChainResult& result
+    ); 
+};
@@ -0,0 +1,368 @@
+#include "vol_surface.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+/** 
+* @file vol_surface.h
+* @brief This file defines a volatility surface baked from SVI slices, queried without 
+* evaluating the SVI formula.
+* 
+* The total variance of every slice is tabulated on a uniform grid of log moneyness, one 
+* contiguous row per expiry. A query interpolates linearly in k inside the rows of the 
+* expiries around T, then linearly in total variance between both expiries. Linear 
+* interpolation in k keeps ordered rows ordered, and the interpolation in T at fixed k is a 
+* convex combination, so the surface is free of calendar spread arbitrage whenever its 
+* slices are at the grid points. Before the first expiry and after the last one, the total 
+* variance is scaled with T at fixed k, which keeps the implied volatility constant.
+* 
+* The expiry interval of T is found in constant time from a uniform table of buckets 
+* narrower than the gaps between the expiries.
+*/
+
+/** 
+ * @class VolSurfaceInvalidGrid
+ * @brief Definition of the error when the log moneyness grid is empty or not increasing. 
+ */
+/** 
+ * @brief Definition of what() virtual std::exception function.
+ * @return The explication of the error.
+ */
+const char * VolSurfaceInvalidGrid::what() const throw(){
+    return "The log moneyness grid needs at least 2 points and k_min < k_max.";
+};
+
+/** 
+ * @class VolSurfaceUnsortedSlices
+ * @brief Definition of the error when the slices are not added by increasing year fractions. 
+ */
+/** 
+ * @brief Definition of what() virtual std::exception function.
+ * @return The explication of the error.
+ */
+const char * VolSurfaceUnsortedSlices::what() const throw(){
+    return "The slices of a volatility surface must be added by strictly increasing positive year fractions.";
+};
+
+/** 
+ * @class VolSurfaceEmpty
+ * @brief Definition of the error when a volatility surface without slice is queried. 
+ */
+/** 
+ * @brief Definition of what() virtual std::exception function.
+ * @return The explication of the error.
+ */
+const char * VolSurfaceEmpty::what() const throw(){
+    return "The volatility surface has no slice to interpolate.";
+};
+
+/** 
+ * @struct VolSurface
+ * @brief The total variances of raw SVI slices baked on a (log moneyness, expiry) grid, 
+ * interpolated in constant time. 
+ * 
+ * The slices are only written by set_slice(), add_slice() and update(), and only baked by 
+ * rebuild(), which must not run concurrently with the queries.
+ */
+/**
+ * @var std::vector<double> VolSurface::k_
+ * @brief The uniform log moneyness grid k_min + i*dk, i < nk.
+ */
+/**
+ * @var std::vector<bool> VolSurface::dirty
+ * @brief Indicators if the slices changed since their last baking.
+ */
+/**
+ * @var std::vector<double> VolSurface::w
+ * @brief The baked total variances, the row of the slice j starting at j*nk.
+ */
+/**
+ * @var std::vector<std::size_t> VolSurface::buckets
+ * @brief The index of the last expiry before the start of every bucket of bucket_width.
+ */
+/**
+ * @var std::size_t VolSurface::workers
+ * @brief The maximum number of worker threads of rebuild(), the hardware concurrency by 
+ * default. A worker is only started for every VOL_SURFACE_POINTS_PER_WORKER points.
+ */
+
+/**
+ * @brief The main constructor, without slice.
+ * @param k_min The lowest log moneyness of the grid.
+ * @param k_max The highest log moneyness of the grid.
+ * @param nk The number of points of the grid.
+ * @throw VolSurfaceInvalidGrid
+ */
+VolSurface::VolSurface(double k_min, double k_max, std::size_t nk): 
+    k_min(k_min), dk((k_max - k_min)/((double)nk - 1)), nk(nk), bucket_width(1.0), 
+    workers(std::max(1u, std::thread::hardware_concurrency()))
+{
+    if (nk<2 or not (k_max>k_min)){throw VolSurfaceInvalidGrid();}
+    k_.resize(nk);
+    for (std::size_t i = 0; i<nk; i++){k_[i] = k_min + (double)i*dk;}
+};
+
+/**
+ * @return The number of slices.
+ */
+std::size_t VolSurface::size()
+{
+    return T_.size();
+};
+
+/**
+ * @brief Rebuilds the buckets of the expiry intervals after a change of the year fractions.
+ * The buckets are narrower than the gaps between the expiries, so that an interval is at 
+ * most one step away from the one of its bucket.
+ * @param surface The volatility surface, with at least one slice.
+ */
+static void index_expiries(VolSurface& surface)
+{
+    const std::vector<double>& T = surface.T_;
+    double gap = T[0];
+    for (std::size_t j = 1; j<T.size(); j++){gap = std::min(gap, T[j] - T[j-1]);}
+    const std::size_t count = std::min(VOL_SURFACE_MAX_BUCKETS, 
+        (std::size_t)std::ceil(T.back()/gap) + 1);
+    surface.bucket_width = T.back()/(double)(count - 1);
+    surface.buckets.resize(count);
+    std::size_t j = 0;
+    for (std::size_t b = 0; b<count; b++)
+    {
+        while (j + 1<T.size() and T[j + 1]<=(double)b*surface.bucket_width){j++;}
+        surface.buckets[b] = j;
+    }
+};
+
+/**
+ * @brief Adds a slice after the existing ones, baked by the next rebuild().
+ * @param t The year fraction of the slice, larger than the one of the previous slice.
+ * @param slice The raw SVI slice.
+ * @return The index of the slice.
+ * @throw VolSurfaceUnsortedSlices
+ */
+std::size_t VolSurface::add_slice(double t, RawSVI slice)
+{
+    if (not (t>(T_.empty() ? 0.0 : T_.back()))){throw VolSurfaceUnsortedSlices();}
+    T_.push_back(t);
+    slices.push_back(slice);
+    dirty.push_back(true);
+    w.resize(T_.size()*nk);
+    index_expiries(*this);
+    return T_.size() - 1;
+};
+
+/**
+ * @brief Replaces a slice, which is baked by the next rebuild() only if its parameters changed.
+ * @param index The index of the slice.
+ * @param slice The raw SVI slice.
+ * @return True if the parameters changed.
+ */
+bool VolSurface::set_slice(std::size_t index, RawSVI slice)
+{
+    RawSVI& current = slices[index];
+    if (current.a==slice.a and current.b==slice.b and current.p==slice.p 
+        and current.m==slice.m and current.s==slice.s)
+    {return false;}
+    current = slice;
+    dirty[index] = true;
+    return true;
+};
+
+/**
+ * @brief Sets the year fractions and the slices of a surface from the ones of a calibrator, 
+ * adding the missing slices. The year fractions are checked before the surface changes.
+ * @param surface The volatility surface.
+ * @param T The year fractions of the calibrator.
+ * @param slice The raw SVI slice of an index of the calibrator.
+ * @throw VolSurfaceUnsortedSlices
+ */
+template <typename Slice>
+static void update_slices(VolSurface& surface, const std::vector<double>& T, Slice slice)
+{
+    for (std::size_t j = 0; j<T.size(); j++)
+    {if (not (T[j]>(j==0 ? 0.0 : T[j-1]))){throw VolSurfaceUnsortedSlices();}}
+    // The slices of the surface after the ones of the calibrator keep their year fractions.
+    if (not T.empty() and T.size()<surface.size() and not (surface.T_[T.size()]>T.back()))
+    {throw VolSurfaceUnsortedSlices();}
+    bool moved = false;
+    for (std::size_t j = 0; j<T.size(); j++)
+    {
+        if (j<surface.size())
+        {
+            // The rows are total variances, which do not depend on the year fraction.
+            moved = moved or surface.T_[j]!=T[j];
+            surface.T_[j] = T[j];
+            surface.set_slice(j, slice(j));
+        }
+        else {surface.add_slice(T[j], slice(j));}
+    }
+    if (moved){index_expiries(surface);}
+};
+
+/**
+ * @brief Sets the year fractions and the slices from the fits of a SVI calibrator, adding 
+ * the missing ones, then rebuilds the changed ones.
+ * @param calibrator The SVI calibrator, its slices sorted by increasing year fractions.
+ * @throw VolSurfaceUnsortedSlices
+ */
+void VolSurface::update(SVICalibrator& calibrator)
+{
+    update_slices(*this, calibrator.T_, [&](std::size_t j){return calibrator.fits[j].get_raw_svi();});
+    rebuild();
+};
+
+/**
+ * @brief Sets the year fractions and the slices from a SSVI calibrator at its ATM total 
+ * variances, adding the missing ones, then rebuilds the changed ones.
+ * @param calibrator The SSVI calibrator.
+ * @throw VolSurfaceUnsortedSlices
+ */
+void VolSurface::update(SSVICalibrator& calibrator)
+{
+    SSVI ssvi = calibrator.get_ssvi();
+    update_slices(*this, calibrator.T_, 
+        [&](std::size_t j){return ssvi.get_raw_svi(calibrator.atm_total_variance[j]);});
+    rebuild();
+};
+
+/**
+ * @brief Bakes the slices which changed since their last baking, in parallel over the slices.
+ */
+void VolSurface::rebuild()
+{
+    std::vector<std::size_t> pending;
+    for (std::size_t j = 0; j<size(); j++){if (dirty[j]){pending.push_back(j);}}
+    std::atomic<std::size_t> next{0};
+    auto work = [&]()
+    {
+        for (std::size_t i = next++; i<pending.size(); i = next++)
+        {
+            const std::size_t j = pending[i];
+            std::span<double> row(&w[j*nk], nk);
+            slices[j].evaluate(k_, T_[j], row, std::span<double>(), std::span<double>(), 
+                std::span<double>());
+        }
+    };
+    const std::size_t count = std::min({workers, pending.size(), 
+        1 + pending.size()*nk/VOL_SURFACE_POINTS_PER_WORKER});
+    std::vector<std::thread> pool;
+    for (std::size_t worker = 1; worker<count; worker++){pool.emplace_back(work);}
+    work();
+    for (std::thread& thread: pool){thread.join();}
+    for (std::size_t j: pending){dirty[j] = false;}
+};
+
+/**
+ * @brief The rows and weights of the total variance at a year fraction.
+ * @param surface The volatility surface.
+ * @param t The year fraction.
+ * @param row0 The output first row.
+ * @param row1 The output second row.
+ * @param c0 The output weight of the first row.
+ * @param c1 The output weight of the second row.
+ * @throw VolSurfaceEmpty
+ */
+static void expiry_weights(VolSurface& surface, double t, const double*& row0, 
+    const double*& row1, double& c0, double& c1)
+{
+    const std::vector<double>& T = surface.T_;
+    if (T.empty()){throw VolSurfaceEmpty();}
+    const std::size_t last = T.size() - 1;
+    std::size_t j;
+    if (t<=T[0] or t>=T[last])
+    {
+        j = t<=T[0] ? 0 : last;
+        c0 = t/T[j];
+        c1 = 0.0;
+        row0 = row1 = &surface.w[j*surface.nk];
+        return;
+    }
+    j = surface.buckets[(std::size_t)(t/surface.bucket_width)];
+    while (T[j + 1]<=t){j++;}
+    c1 = (t - T[j])/(T[j + 1] - T[j]);
+    c0 = 1 - c1;
+    row0 = &surface.w[j*surface.nk];
+    row1 = row0 + surface.nk;
+};
+
+/**
+ * @brief The linear interpolation of two rows at a log moneyness, extrapolated linearly 
+ * from the end cells outside of the grid.
+ * @param surface The volatility surface.
+ * @param row0 The first row.
+ * @param row1 The second row.
+ * @param c0 The weight of the first row.
+ * @param c1 The weight of the second row.
+ * @param k The log moneyness.
+ * @return The interpolated total variance.
+ */
+static double interpolate(VolSurface& surface, const double* row0, const double* row1, 
+    double c0, double c1, double k)
+{
+    const double x = (k - surface.k_min)/surface.dk;
+    const double cell = std::min(std::max(std::floor(x), 0.0), (double)(surface.nk - 2));
+    const std::size_t i = (std::size_t)cell;
+    const double f = x - cell;
+    const double w0 = row0[i] + f*(row0[i + 1] - row0[i]);
+    const double w1 = row1[i] + f*(row1[i + 1] - row1[i]);
+    return c0*w0 + c1*w1;
+};
+
+/**
+ * @param k The log moneyness.
+ * @param t The year fraction.
+ * @return The interpolated total variance.
+ * @throw VolSurfaceEmpty
+ */
+double VolSurface::total_variance(double k, double t)
+{
+    const double* row0;
+    const double* row1;
+    double c0;
+    double c1;
+    expiry_weights(*this, t, row0, row1, c0, c1);
+    return interpolate(*this, row0, row1, c0, c1, k);
+};
+
+/**
+ * @param k The log moneyness.
+ * @param t The year fraction.
+ * @return The interpolated implied volatility.
+ * @throw VolSurfaceEmpty
+ */
+double VolSurface::implied_volatility(double k, double t)
+{
+    return std::sqrt(total_variance(k, t)/t);
+};
+
+/**
+ * @brief Interpolates a strip of log moneyness at one year fraction, the expiry interval 
+ * being found once.
+ * @param k The log moneyness.
+ * @param t The year fraction.
+ * @param total_variance The output total variances, empty if not needed.
+ * @param implied_volatility The output implied volatilities, empty if not needed.
+ * @throw SVIBatchSizeMismatch
+ * @throw VolSurfaceEmpty
+ */
+void VolSurface::evaluate(
+    std::span<const double> k, 
+    double t, 
+    std::span<double> total_variance, 
+    std::span<double> implied_volatility)
+{
+    if ((not total_variance.empty() and total_variance.size()!=k.size()) 
+        or (not implied_volatility.empty() and implied_volatility.size()!=k.size()))
+    {throw SVIBatchSizeMismatch();}
+    const double* row0;
+    const double* row1;
+    double c0;
+    double c1;
+    expiry_weights(*this, t, row0, row1, c0, c1);
+    for (std::size_t i = 0; i<k.size(); i++)
+    {
+        const double w_ = interpolate(*this, row0, row1, c0, c1, k[i]);
+        if (not total_variance.empty()){total_variance[i] = w_;}
+        if (not implied_volatility.empty()){implied_volatility[i] = std::sqrt(w_/t);}
+    }
+};
@@ -0,0 +1,50 @@
+#pragma once 
+#include <iostream>
+#include <cmath>
+#include <span>
+#include <vector>
+#include "svi.h"
+#include "svi_calibration.h"
+
+class VolSurfaceInvalidGrid:  public std::exception 
+{public: const char * what() const throw();};
+
+class VolSurfaceUnsortedSlices:  public std::exception 
+{public: const char * what() const throw();};
+
+class VolSurfaceEmpty:  public std::exception 
+{public: const char * what() const throw();};
+
+constexpr std::size_t VOL_SURFACE_MAX_BUCKETS = 1 << 16;
+constexpr std::size_t VOL_SURFACE_POINTS_PER_WORKER = 1 << 16;
+
+struct VolSurface
+{
+    double k_min; 
+    double dk; 
+    std::size_t nk; 
+    std::vector<double> k_; 
+    std::vector<double> T_; 
+    std::vector<RawSVI> slices; 
+    std::vector<bool> dirty; 
+    std::vector<double> w; 
+    std::vector<std::size_t> buckets; 
+    double bucket_width; 
+    std::size_t workers; 
+    VolSurface(double k_min, double k_max, std::size_t nk); 
+    ~VolSurface(){}; 
+    std::size_t size(); 
+    std::size_t add_slice(double t, RawSVI slice); 
+    bool set_slice(std::size_t index, RawSVI slice); 
+    void update(SVICalibrator& calibrator); 
+    void update(SSVICalibrator& calibrator); 
+    void rebuild(); 
+    double total_variance(double k, double t); 
+    double implied_volatility(double k, double t); 
+    void evaluate(
+        std::span<const double> k, 
+        double t, 
+        std::span<double> total_variance, 
+        std::span<double> implied_volatility
+    ); 
+};
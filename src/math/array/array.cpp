@@ -1,4 +1,6 @@
 #include "array.h"
+#include <algorithm>
+#include <cmath>
 
 /** 
 * @file array.h
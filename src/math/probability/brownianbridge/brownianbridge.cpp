@@ -0,0 +1,154 @@
+#include "brownianbridge.h"
+#include <cmath>
+#include "../../math/simd/simd.h"
+
+/**
+* @file brownianbridge.h
+* @brief This file defines the Brownian bridge construction of the brownian paths.
+*
+* The terminal value is drawn first from the first normal, then every remaining point 
+* is drawn conditionally on its already drawn neighbours, bisecting the time grid. The 
+* first dimensions of a quasi random point, which are the most evenly distributed, 
+* therefore drive the largest scales of the path.
+*
+* References :
+* - "Monte Carlo Methods in Finance", Jäckel, 2002, chapter 10.
+*/
+
+/** 
+ * @class BrownianBridgeInvalidTimes
+ * @brief Definition of the invalid time grid error.
+ */
+/** 
+ * @brief Definition of what() virtual std::exception function.
+ * @return The explication of the error.
+ */
+const char * BrownianBridgeInvalidTimes::what() const throw(){
+    return "The times of the Brownian bridge must be positive and strictly increasing";
+};
+
+/** 
+ * @class BrownianBridgeSizeMismatch
+ * @brief Definition of the input/output size mismatch error.
+ */
+/** 
+ * @brief Definition of what() virtual std::exception function.
+ * @return The explication of the error.
+ */
+const char * BrownianBridgeSizeMismatch::what() const throw(){
+    return "The normal and path arrays must hold steps*paths values";
+};
+
+/**
+ * @struct BrownianBridge
+ * @brief The Brownian bridge construction on a time grid t_1 < ... < t_n, t_0 = 0.
+ */
+/**
+ * @var std::vector<std::size_t> BrownianBridge::bridge_index
+ * @brief The index of the point drawn at each stage.
+ */
+/**
+ * @var std::vector<std::size_t> BrownianBridge::left_index
+ * @brief The index following the left neighbour of the point drawn at each stage, 0 
+ * when the left neighbour is the origin.
+ */
+/**
+ * @var std::vector<std::size_t> BrownianBridge::right_index
+ * @brief The index of the right neighbour of the point drawn at each stage.
+ */
+/**
+ * @var std::vector<double> BrownianBridge::stddev
+ * @brief The conditional standard deviation of the point drawn at each stage.
+ */
+
+/**
+ * @brief Main constructor
+ * @param times The times t_1 < ... < t_n of the path.
+ * @throw BrownianBridgeInvalidTimes
+ */
+BrownianBridge::BrownianBridge(std::span<const double> times): 
+    steps(times.size()), bridge_index(steps), left_index(steps), right_index(steps), 
+    left_weight(steps), right_weight(steps), stddev(steps)
+{
+    if (steps==0 or not (times[0]>0)){throw BrownianBridgeInvalidTimes();}
+    for (std::size_t i = 1; i<steps; i++)
+    {if (not (times[i]>times[i-1])){throw BrownianBridgeInvalidTimes();}}
+
+    // map[l] is the stage at which the point l is drawn, 0 while it is not.
+    std::vector<std::size_t> map(steps, 0);
+    map[steps-1] = 1;
+    bridge_index[0] = steps-1;
+    stddev[0] = std::sqrt(times[steps-1]);
+    left_weight[0] = right_weight[0] = 0.0;
+    for (std::size_t j = 0, i = 1; i<steps; i++)
+    {
+        while (map[j]){j++;}
+        std::size_t k = j;
+        while (not map[k]){k++;}
+        const std::size_t l = j + ((k - 1 - j) >> 1);
+        map[l] = i;
+        bridge_index[i] = l;
+        left_index[i] = j;
+        right_index[i] = k;
+        const double t_j = j==0 ? 0.0 : times[j-1];
+        left_weight[i] = (times[k] - times[l])/(times[k] - t_j);
+        right_weight[i] = (times[l] - t_j)/(times[k] - t_j);
+        stddev[i] = std::sqrt((times[l] - t_j)*(times[k] - times[l])/(times[k] - t_j));
+        j = k + 1;
+        if (j>=steps){j = 0;}
+    }
+};
+
+/**
+ * @brief Regular time grid constructor.
+ * @param steps The number of time steps.
+ * @param T The year fraction of the last point.
+ * @throw BrownianBridgeInvalidTimes
+ */
+BrownianBridge::BrownianBridge(std::size_t steps, double T): 
+    BrownianBridge([&]()
+    {
+        std::vector<double> times(steps);
+        for (std::size_t i = 0; i<steps; i++){times[i] = T*(i + 1)/steps;}
+        return times;
+    }()){};
+
+/**
+ * @brief Builds the brownian paths W(t_1..t_n) of several paths from their normals, 
+ * both arrays by step: z[i*paths + p] is the normal of the stage i and w[k*paths + p] 
+ * the value at t_{k+1} of the path p.
+ * @param z The standard normals, stage by stage.
+ * @param w The output brownian paths.
+ * @param paths The number of paths.
+ * @throw BrownianBridgeSizeMismatch
+ */
+void BrownianBridge::build(std::span<const double> z, std::span<double> w, std::size_t paths)
+{
+    using namespace simd;
+    if (z.size()!=steps*paths or w.size()!=steps*paths){throw BrownianBridgeSizeMismatch();}
+    for (std::size_t i = 0; i<steps; i++)
+    {
+        const std::size_t l = bridge_index[i];
+        const bool has_left = i>0 and left_index[i]>0;
+        const bool has_right = i>0;
+        const double* left = has_left ? &w[(left_index[i] - 1)*paths] : nullptr;
+        const double* right = has_right ? &w[right_index[i]*paths] : nullptr;
+        const double* normal = &z[i*paths];
+        double* out = &w[l*paths];
+        std::size_t p = 0;
+        for (; p + WIDTH<=paths; p += WIDTH)
+        {
+            Pack x = stddev[i]*load(&normal[p]);
+            if (has_right){x = fmadd(broadcast(right_weight[i]), load(&right[p]), x);}
+            if (has_left){x = fmadd(broadcast(left_weight[i]), load(&left[p]), x);}
+            store(&out[p], x);
+        }
+        for (; p<paths; p++)
+        {
+            double x = stddev[i]*normal[p];
+            if (has_right){x += right_weight[i]*right[p];}
+            if (has_left){x += left_weight[i]*left[p];}
+            out[p] = x;
+        }
+    }
+};
@@ -0,0 +1,25 @@
+#pragma once
+#include <iostream>
+#include <span>
+#include <vector>
+
+class BrownianBridgeInvalidTimes: public std::exception 
+{public: const char * what() const throw();};
+
+class BrownianBridgeSizeMismatch: public std::exception 
+{public: const char * what() const throw();};
+
+struct BrownianBridge
+{
+    std::size_t steps; 
+    std::vector<std::size_t> bridge_index; 
+    std::vector<std::size_t> left_index; 
+    std::vector<std::size_t> right_index; 
+    std::vector<double> left_weight; 
+    std::vector<double> right_weight; 
+    std::vector<double> stddev; 
+    BrownianBridge(std::span<const double> times); 
+    BrownianBridge(std::size_t steps, double T); 
+    ~BrownianBridge(){};
+    void build(std::span<const double> z, std::span<double> w, std::size_t paths); 
+};
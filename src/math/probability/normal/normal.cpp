@@ -17,6 +17,18 @@ const char * NormalDistributionNonPositiveSigma::what() const throw(){
     return "The parameter sigma for the normal distribution has to be positive.";
 };
 
+/** 
+ * @class NormalDistributionSizeMismatch
+ * @brief Definition of the error when the input and output arrays do not have the same size.
+ */
+/** 
+ * @brief Definition of what() virtual std::exception function.
+ * @return The explication of the error.
+ */
+const char * NormalDistributionSizeMismatch::what() const throw(){
+    return "The input and output arrays of the normal distribution must have the same size.";
+};
+
 /** 
 * @struct NormalDistribution
 * @brief Defition of the normal distribution.
@@ -107,20 +119,183 @@ double NormalDistribution::cdf(double x)
         c = e/(RT2PI*f);
         }
     }
-    return x<=0.0 ? c : 1-c;
+    return x<=mu_ ? c : 1-c;
 };
 
 /**
- * @brief Compute a random sample number from the defined normal distribution.
- * @param generator 
+ * @brief Compute a random sample number from the defined normal distribution, drawn
+ * from the random stream of the calling thread.
  * @return A random number sampled from the normal distribution.
+ * @see thread_random_stream
  */
 double NormalDistribution::random()
 {
-    std::random_device rd;
-    std::mt19937 gen(rd()); 
-    std::normal_distribution<double> distribution(mu_,sigma_);
-    return distribution(gen);
+    return mu_ + sigma_*thread_random_stream().normal();
+};
+
+/**
+ * @brief Fills an array with random samples from the defined normal distribution, drawn
+ * from the random stream of the calling thread.
+ * @param x The output samples.
+ * @see RandomStream::fill_normal
+ */
+void NormalDistribution::random(std::span<double> x)
+{
+    thread_random_stream().fill_normal(x);
+    for (double& value: x){value = mu_ + sigma_*value;}
+};
+
+/**
+ * @brief Fills an array with the random samples of indices offset to offset+size-1 of a
+ * counter based stream, independently of how the indices are split between threads.
+ * @param x The output samples.
+ * @param stream The counter based random stream.
+ * @param offset The index of the first sample.
+ * @see PhiloxStream::fill_normal
+ */
+void NormalDistribution::random(std::span<double> x, PhiloxStream& stream, uint64_t offset)
+{
+    stream.fill_normal(offset, x);
+    for (double& value: x){value = mu_ + sigma_*value;}
+};
+
+/**
+ * @brief Evaluates simd::WIDTH lanes of the standardised density and cumulative probability.
+ * @param x The input lanes.
+ * @param mu The expected value.
+ * @param sigma The standard deviation value.
+ * @param pdf The output density lanes, nullptr if not needed.
+ * @param cdf The output cumulative probability lanes, nullptr if not needed.
+ */
+static void evaluate_block(const double* x, double mu, double sigma, double* pdf, double* cdf)
+{
+    using namespace simd;
+    const Pack z = (load(x) - mu)*(1/sigma);
+    if (cdf==nullptr){store(pdf, normal_pdf(z)*(1/sigma)); return;}
+    if (pdf==nullptr){store(cdf, normal_cdf(z)); return;}
+    Pack pdf_;
+    Pack cdf_;
+    normal_pdf_cdf(z, pdf_, cdf_);
+    store(pdf, pdf_*(1/sigma));
+    store(cdf, cdf_);
+};
+
+/**
+ * @brief Runs the block kernel over arrays, the tail is copied into a padded block.
+ * @param x The input values.
+ * @param mu The expected value.
+ * @param sigma The standard deviation value.
+ * @param pdf The output densities, nullptr if not needed.
+ * @param cdf The output cumulative probabilities, nullptr if not needed.
+ * @param n The number of values.
+ */
+static void evaluate_array(const double* x, double mu, double sigma, double* pdf, double* cdf, std::size_t n)
+{
+    const std::size_t W = simd::WIDTH;
+    std::size_t i = 0;
+    for (; i + W<=n; i += W)
+    {evaluate_block(x + i, mu, sigma, pdf ? pdf + i : nullptr, cdf ? cdf + i : nullptr);}
+    if (i<n)
+    {
+        double tail_x[simd::WIDTH];
+        double tail_pdf[simd::WIDTH];
+        double tail_cdf[simd::WIDTH];
+        for (std::size_t j = 0; j<W; j++){tail_x[j] = i+j<n ? x[i+j] : mu;}
+        evaluate_block(tail_x, mu, sigma, pdf ? tail_pdf : nullptr, cdf ? tail_cdf : nullptr);
+        for (std::size_t j = 0; i+j<n; j++)
+        {
+            if (pdf){pdf[i+j] = tail_pdf[j];}
+            if (cdf){cdf[i+j] = tail_cdf[j];}
+        }
+    }
+};
+
+/**
+ * @brief Calculates the probability densities of an array of values with SIMD lanes.
+ * @param x The values to estimate the pdf with.
+ * @param pdf The output probability densities.
+ * @throws NormalDistributionSizeMismatch
+ */
+void NormalDistribution::pdf(std::span<const double> x, std::span<double> pdf)
+{
+    if (pdf.size()!=x.size()){throw NormalDistributionSizeMismatch();}
+    evaluate_array(x.data(), mu_, sigma_, pdf.data(), nullptr, x.size());
 };
 
+/**
+ * @brief Calculates the cumulative probabilities of an array of values with SIMD lanes.
+ *
+ * The same approximation as the scalar cdf, with the rational and continued-fraction
+ * regimes both evaluated and blended instead of branched on.
+ *
+ * @param x The values to estimate the cdf with.
+ * @param cdf The output cumulative probabilities.
+ * @throws NormalDistributionSizeMismatch
+ */
+void NormalDistribution::cdf(std::span<const double> x, std::span<double> cdf)
+{
+    if (cdf.size()!=x.size()){throw NormalDistributionSizeMismatch();}
+    evaluate_array(x.data(), mu_, sigma_, nullptr, cdf.data(), x.size());
+};
+
+/**
+ * @brief Calculates the probability densities and the cumulative probabilities of an 
+ * array of values, sharing the exponential between both.
+ * @param x The values to estimate the pdf and cdf with.
+ * @param pdf The output probability densities.
+ * @param cdf The output cumulative probabilities.
+ * @throws NormalDistributionSizeMismatch
+ */
+void NormalDistribution::pdf_cdf(std::span<const double> x, std::span<double> pdf, std::span<double> cdf)
+{
+    if (pdf.size()!=x.size() or cdf.size()!=x.size()){throw NormalDistributionSizeMismatch();}
+    evaluate_array(x.data(), mu_, sigma_, pdf.data(), cdf.data(), x.size());
+};
 
+/**
+ * @brief Calculates the quantile, i.e. the inverse of the cumulative probability.
+ *
+ * Method developed in "Algorithm AS241: The percentage points of the normal distribution" 
+ * from Michael Wichura (1988), accurate to about 1e-16.
+ *
+ * @param p The cumulative probability.
+ * @return The value x such that cdf(x) = p, -inf at 0, inf at 1 and NaN outside [0,1].
+ */
+double NormalDistribution::inv_cdf(double p)
+{
+    return mu_ + sigma_*simd::normal_quantile(p);
+};
+
+/**
+ * @brief Calculates the quantiles of an array of cumulative probabilities with SIMD lanes,
+ * the regimes of the scalar inv_cdf being evaluated and blended.
+ * @param p The cumulative probabilities.
+ * @param x The output quantiles.
+ * @throws NormalDistributionSizeMismatch
+ */
+void NormalDistribution::inv_cdf(std::span<const double> p, std::span<double> x)
+{
+    if (x.size()!=p.size()){throw NormalDistributionSizeMismatch();}
+    const std::size_t n = p.size();
+    const std::size_t W = simd::WIDTH;
+    std::size_t i = 0;
+    for (; i + W<=n; i += W)
+    {simd::store(&x[i], mu_ + sigma_*simd::normal_quantile(simd::load(&p[i])));}
+    if (i<n)
+    {
+        double tail[simd::WIDTH];
+        for (std::size_t j = 0; j<W; j++){tail[j] = i+j<n ? p[i+j] : 0.5;}
+        simd::store(tail, mu_ + sigma_*simd::normal_quantile(simd::load(tail)));
+        for (std::size_t j = 0; i+j<n; j++){x[i+j] = tail[j];}
+    }
+};
+
+/**
+ * @param p The cumulative probability.
+ * @return The quantile of the distribution.
+ * @see NormalDistribution::inv_cdf
+ */
+double NormalDistribution::quantile(double p)
+{
+    return inv_cdf(p);
+};
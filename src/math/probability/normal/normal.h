@@ -3,12 +3,18 @@
 #include <numbers>
 #include <cmath>
 #include <random>
+#include <span>
 #include "../../math/probability/probability.h"
 #include "../../math/numbers.h"
+#include "../../math/simd/simd.h"
+#include "../../math/probability/random/random.h"
 
 class NormalDistributionNonPositiveSigma: public std::exception 
 {public: const char * what() const throw();};
 
+class NormalDistributionSizeMismatch: public std::exception 
+{public: const char * what() const throw();};
+
 struct NormalDistribution: ProbabilityDistribution
 {
     double mu_; 
@@ -18,5 +24,13 @@ struct NormalDistribution: ProbabilityDistribution
     ~NormalDistribution(){};
     double pdf(double x); 
     double cdf(double x); 
+    void pdf(std::span<const double> x, std::span<double> pdf); 
+    void cdf(std::span<const double> x, std::span<double> cdf); 
+    void pdf_cdf(std::span<const double> x, std::span<double> pdf, std::span<double> cdf); 
+    double inv_cdf(double p); 
+    void inv_cdf(std::span<const double> p, std::span<double> x); 
+    double quantile(double p); 
     double random();
+    void random(std::span<double> x);
+    void random(std::span<double> x, PhiloxStream& stream, uint64_t offset);
 };
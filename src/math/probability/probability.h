@@ -7,6 +7,7 @@ struct ProbabilityDistribution
     virtual ~ProbabilityDistribution(){};
     virtual double pdf(double x) = 0; 
     virtual double cdf(double x) = 0; 
+    virtual double quantile(double p) = 0; 
     virtual double random() = 0;
 };
 
@@ -0,0 +1,456 @@
+#include "random.h"
+#include <atomic>
+
+/**
+* @file random.h
+* @brief This file defines the random number generators used by the simulations.
+*
+* Every stream owns a small xoshiro256** engine, seeded deterministically from a seed
+* and a stream index, so that any run can be replayed. The Philox streams are counter
+* based instead: a draw is a function of (seed, stream, index) only, so that a simulation
+* split across workers reproduces the single threaded run bit for bit. Normal draws use
+* the Box-Muller transform evaluated on simd::WIDTH pairs at a time.
+*
+* References :
+* - "Scrambled linear pseudorandom number generators", Blackman, Vigna, 2021.
+* - "Parallel random numbers: as easy as 1, 2, 3", Salmon, Moraes, Dror, Shaw, 2011.
+* - "A note on the generation of random normal deviates", Box, Muller, 1958.
+*/
+
+/**
+ * @brief One step of the splitmix64 generator, used to expand the seeds.
+ * @param x The generator state, advanced in place.
+ * @return The next 64 random bits.
+ */
+static uint64_t splitmix64(uint64_t& x)
+{
+    x += 0x9e3779b97f4a7c15;
+    uint64_t z = x;
+    z = (z ^ (z >> 30))*0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27))*0x94d049bb133111eb;
+    return z ^ (z >> 31);
+};
+
+/**
+ * @param x The bits to rotate.
+ * @param k The rotation.
+ * @return The bits rotated left by k.
+ */
+static inline uint64_t rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+};
+
+/**
+ * @param bits 64 random bits.
+ * @return A uniform double in [0,1) with 53 random bits.
+ */
+static inline double to_uniform(uint64_t bits)
+{
+    return (bits >> 11)*0x1.0p-53;
+};
+
+/**
+* @struct RandomEngine
+* @brief The xoshiro256** pseudo random generator, period 2^256-1.
+*/
+/**
+ * @var uint64_t RandomEngine::state
+ * @brief The 256 bits state of the generator.
+ */
+
+/**
+* @brief RandomEngine constructor, the state is expanded from the seed and the stream
+* index with splitmix64 so that neighbouring seeds and streams are decorrelated.
+* @param seed The seed of the run.
+* @param stream The index of the stream within the run.
+*/
+RandomEngine::RandomEngine(uint64_t seed, uint64_t stream)
+{
+    uint64_t x = seed ^ (stream*0xd1b54a32d192ed03);
+    splitmix64(x);
+    for (int i = 0; i<4; i++){state[i] = splitmix64(x);}
+};
+
+/**
+ * @return The next 64 random bits.
+ */
+uint64_t RandomEngine::next()
+{
+    const uint64_t result = rotl(state[1]*5, 7)*9;
+    const uint64_t t = state[1] << 17;
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = rotl(state[3], 45);
+    return result;
+};
+
+/**
+* @struct RandomStream
+* @brief A reproducible stream of uniform and standard normal draws.
+*/
+/**
+ * @var double RandomStream::spare
+ * @brief The second normal of the last Box-Muller pair drawn by normal().
+ */
+
+/**
+* @brief RandomStream constructor
+* @param seed The seed of the run.
+* @param stream The index of the stream within the run.
+*/
+RandomStream::RandomStream(uint64_t seed, uint64_t stream):
+    engine(seed, stream), spare(0.0), has_spare(false){};
+
+/**
+ * @return A uniform draw in [0,1).
+ */
+double RandomStream::uniform()
+{
+    return to_uniform(engine.next());
+};
+
+/**
+ * @return A standard normal draw, pairs are generated and the second one is kept.
+ */
+double RandomStream::normal()
+{
+    if (has_spare){has_spare = false; return spare;}
+    const double u1 = to_uniform(engine.next()) + 0x1.0p-53;
+    const double u2 = to_uniform(engine.next());
+    const double r = sqrt(-2*log(u1));
+    spare = r*sin(2*numbers::PI*u2);
+    has_spare = true;
+    return r*cos(2*numbers::PI*u2);
+};
+
+/**
+ * @brief Fills an array with uniform draws in [0,1).
+ * @param u The output array.
+ */
+void RandomStream::fill_uniform(std::span<double> u)
+{
+    for (double& value: u){value = to_uniform(engine.next());}
+};
+
+/**
+ * @brief Draws 2*simd::WIDTH standard normals with the Box-Muller transform.
+ * @param engine The generator.
+ * @param z The output array of 2*simd::WIDTH values.
+ */
+static void box_muller_block(RandomEngine& engine, double* z)
+{
+    using namespace simd;
+    double u1[WIDTH];
+    double u2[WIDTH];
+    for (std::size_t j = 0; j<WIDTH; j++)
+    {
+        // u1 lies in (0,1] so that its log is finite.
+        u1[j] = to_uniform(engine.next()) + 0x1.0p-53;
+        u2[j] = to_uniform(engine.next());
+    }
+    const Pack r = sqrt(-2.0*log(load(u1)));
+    Pack s;
+    Pack c;
+    sincos_2pi(load(u2), s, c);
+    store(z, r*c);
+    store(z + WIDTH, r*s);
+};
+
+/**
+ * @brief Fills an array with standard normal draws, simd::WIDTH Box-Muller pairs at a time.
+ * The values only depend on the state of the stream, not on the ISA.
+ * @param z The output array.
+ */
+void RandomStream::fill_normal(std::span<double> z)
+{
+    const std::size_t n = z.size();
+    const std::size_t B = 2*simd::WIDTH;
+    std::size_t i = 0;
+    for (; i + B<=n; i += B){box_muller_block(engine, &z[i]);}
+    if (i<n)
+    {
+        double tail[2*simd::WIDTH];
+        box_muller_block(engine, tail);
+        for (std::size_t j = 0; i+j<n; j++){z[i+j] = tail[j];}
+    }
+};
+
+static std::atomic<uint64_t> global_seed{0x5eed5eed5eed5eed};
+static std::atomic<uint64_t> seed_epoch{0};
+static std::atomic<uint64_t> default_streams{0};
+
+/**
+* @struct ThreadRandomStream
+* @brief The random stream of a thread, with its stream index and the seed it was built from.
+*/
+struct ThreadRandomStream
+{
+    RandomStream stream;
+    uint64_t index;
+    uint64_t epoch;
+};
+
+/**
+ * @return The stream state of the calling thread. Until the thread picks its index with 
+ * set_thread_random_stream(), it draws from a stream of its own, numbered in the order the 
+ * threads first draw from THREAD_RANDOM_STREAM_DEFAULT, above the indices picked explicitly.
+ */
+static ThreadRandomStream& thread_stream_state()
+{
+    thread_local const uint64_t index = THREAD_RANDOM_STREAM_DEFAULT + default_streams++;
+    thread_local ThreadRandomStream state{RandomStream(global_seed.load(), index), index, 
+        seed_epoch.load()};
+    return state;
+};
+
+/**
+ * @brief Seeds the run: the stream of every thread restarts from the seed on its next
+ * draw, keeping its stream index.
+ * @param seed The seed of the run.
+ */
+void set_random_seed(uint64_t seed)
+{
+    global_seed = seed;
+    seed_epoch++;
+};
+
+/**
+ * @brief Restarts the stream of the calling thread on the given stream index of the seed.
+ * The workers of a parallel run call it with their worker or block index, so that the
+ * draws do not depend on which thread happened to draw first.
+ * @param index The index of the stream within the run.
+ */
+void set_thread_random_stream(uint64_t index)
+{
+    ThreadRandomStream& state = thread_stream_state();
+    state.index = index;
+    state.epoch = seed_epoch.load();
+    state.stream = RandomStream(global_seed.load(), index);
+};
+
+/**
+ * @return The random stream of the calling thread, on the stream index picked with
+ * set_thread_random_stream(), or on its own default stream.
+ */
+RandomStream& thread_random_stream()
+{
+    ThreadRandomStream& state = thread_stream_state();
+    const uint64_t epoch = seed_epoch.load();
+    if (state.epoch!=epoch)
+    {
+        state.epoch = epoch;
+        state.stream = RandomStream(global_seed.load(), state.index);
+    }
+    return state.stream;
+};
+
+static const uint32_t PHILOX_M0 = 0xd2511f53;
+static const uint32_t PHILOX_M1 = 0xcd9e8d57;
+static const uint32_t PHILOX_W0 = 0x9e3779b9;
+static const uint32_t PHILOX_W1 = 0xbb67ae85;
+static const std::size_t PHILOX_LANES = 16;
+
+/**
+ * @brief The ten Philox-4x32 rounds applied to PHILOX_LANES consecutive counters, lane
+ * by lane in structure of arrays layout so that the 32x32->64 bits products vectorise
+ * and the independent lanes hide the latency of the multiplications.
+ * @param key The key of the generator.
+ * @param stream The high 64 bits of the counters.
+ * @param counter The low 64 bits of the counter of the first lane.
+ * @param x0 The first 64 random bits of the lanes.
+ * @param x1 The second 64 random bits of the lanes.
+ */
+static void philox_block(const uint32_t key[2], uint64_t stream, uint64_t counter,
+    uint64_t* x0, uint64_t* x1)
+{
+    const std::size_t W = PHILOX_LANES;
+    uint32_t c0[W], c1[W], c2[W], c3[W];
+    for (std::size_t j = 0; j<W; j++)
+    {
+        c0[j] = uint32_t(counter + j);
+        c1[j] = uint32_t((counter + j) >> 32);
+        c2[j] = uint32_t(stream);
+        c3[j] = uint32_t(stream >> 32);
+    }
+    uint32_t k0 = key[0];
+    uint32_t k1 = key[1];
+    for (int round = 0; round<10; round++)
+    {
+        for (std::size_t j = 0; j<W; j++)
+        {
+            const uint64_t p0 = uint64_t(PHILOX_M0)*c0[j];
+            const uint64_t p1 = uint64_t(PHILOX_M1)*c2[j];
+            c0[j] = uint32_t(p1 >> 32) ^ c1[j] ^ k0;
+            c1[j] = uint32_t(p1);
+            c2[j] = uint32_t(p0 >> 32) ^ c3[j] ^ k1;
+            c3[j] = uint32_t(p0);
+        }
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    for (std::size_t j = 0; j<W; j++)
+    {
+        x0[j] = uint64_t(c0[j]) | (uint64_t(c1[j]) << 32);
+        x1[j] = uint64_t(c2[j]) | (uint64_t(c3[j]) << 32);
+    }
+};
+
+/**
+* @struct PhiloxEngine
+* @brief The Philox-4x32-10 counter based generator: the output is a bijection of a
+* 128 bits counter keyed by the seed, so that any draw can be generated directly
+* without running the generator through the previous ones.
+*/
+/**
+ * @var uint32_t PhiloxEngine::key
+ * @brief The 64 bits key derived from the seed.
+ */
+
+/**
+* @brief PhiloxEngine constructor
+* @param seed The seed of the run.
+*/
+PhiloxEngine::PhiloxEngine(uint64_t seed):
+    key{uint32_t(seed), uint32_t(seed >> 32)}{};
+
+/**
+ * @brief Computes the 128 random bits of one counter.
+ * @param stream The high 64 bits of the counter.
+ * @param counter The low 64 bits of the counter.
+ * @param out The four random 32 bits words.
+ */
+void PhiloxEngine::generate(uint64_t stream, uint64_t counter, uint32_t out[4])
+{
+    uint32_t c[4] = {uint32_t(counter), uint32_t(counter >> 32), uint32_t(stream), uint32_t(stream >> 32)};
+    uint32_t k0 = key[0];
+    uint32_t k1 = key[1];
+    for (int round = 0; round<10; round++)
+    {
+        const uint64_t p0 = uint64_t(PHILOX_M0)*c[0];
+        const uint64_t p1 = uint64_t(PHILOX_M1)*c[2];
+        c[0] = uint32_t(p1 >> 32) ^ c[1] ^ k0;
+        c[1] = uint32_t(p1);
+        c[2] = uint32_t(p0 >> 32) ^ c[3] ^ k1;
+        c[3] = uint32_t(p0);
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    for (int i = 0; i<4; i++){out[i] = c[i];}
+};
+
+/**
+* @struct PhiloxStream
+* @brief A stream of draws addressed by index, e.g. a Monte Carlo path whose draw
+* step*dimension + factor can be generated by any worker in any order.
+*
+* Draw i uses the counter (stream, i/2): uniform i is its (i%2)-th 64 bits word, normal i
+* is the cosine (i even) or sine (i odd) branch of the Box-Muller pair built on its two
+* words. The uniforms and the normals of a stream share the counters, a stream should
+* be used for one kind of draws only.
+*/
+/**
+ * @var uint64_t PhiloxStream::stream
+ * @brief The index of the stream, the high half of the counters.
+ */
+
+/**
+* @brief PhiloxStream constructor
+* @param seed The seed of the run.
+* @param stream The index of the stream within the run.
+*/
+PhiloxStream::PhiloxStream(uint64_t seed, uint64_t stream):
+    engine(seed), stream(stream){};
+
+/**
+ * @param index The index of the draw.
+ * @return The uniform draw in [0,1) at this index.
+ */
+double PhiloxStream::uniform(uint64_t index)
+{
+    uint32_t out[4];
+    engine.generate(stream, index/2, out);
+    const uint32_t* word = &out[2*(index%2)];
+    return to_uniform(uint64_t(word[0]) | (uint64_t(word[1]) << 32));
+};
+
+/**
+ * @param index The index of the draw.
+ * @return The standard normal draw at this index, identical to the one written by
+ * fill_normal at the same index.
+ */
+double PhiloxStream::normal(uint64_t index)
+{
+    double z;
+    fill_normal(index, std::span<double>(&z, 1));
+    return z;
+};
+
+/**
+ * @brief Fills an array with the uniform draws of indices offset to offset+size-1.
+ * @param offset The index of the first draw.
+ * @param u The output array.
+ */
+void PhiloxStream::fill_uniform(uint64_t offset, std::span<double> u)
+{
+    const std::size_t W = PHILOX_LANES;
+    uint64_t x0[W], x1[W];
+    std::size_t i = 0;
+    while (i<u.size())
+    {
+        const uint64_t pair = (offset + i)/2;
+        philox_block(engine.key, stream, pair, x0, x1);
+        for (std::size_t j = 0; j<W; j++)
+        {
+            const uint64_t index = 2*(pair + j);
+            if (index>=offset + i and index - offset<u.size()){u[index - offset] = to_uniform(x0[j]);}
+            if (index + 1>=offset + i and index + 1 - offset<u.size()){u[index + 1 - offset] = to_uniform(x1[j]);}
+        }
+        i = 2*(pair + W) - offset;
+    }
+};
+
+/**
+ * @brief Fills an array with the standard normal draws of indices offset to
+ * offset+size-1, PHILOX_LANES Box-Muller pairs at a time. The values only depend on the
+ * seed, the stream and the indices, not on the ISA or on how the range is split.
+ * @param offset The index of the first draw.
+ * @param z The output array.
+ */
+void PhiloxStream::fill_normal(uint64_t offset, std::span<double> z)
+{
+    using namespace simd;
+    const std::size_t W = PHILOX_LANES;
+    uint64_t x0[W], x1[W];
+    double u1[W], u2[W], c[W], s[W];
+    std::size_t i = 0;
+    while (i<z.size())
+    {
+        const uint64_t pair = (offset + i)/2;
+        philox_block(engine.key, stream, pair, x0, x1);
+        for (std::size_t j = 0; j<W; j++)
+        {
+            u1[j] = to_uniform(x0[j]) + 0x1.0p-53;
+            u2[j] = to_uniform(x1[j]);
+        }
+        for (std::size_t j = 0; j<W; j += WIDTH)
+        {
+            const Pack r = sqrt(-2.0*log(load(&u1[j])));
+            Pack sin_2pi_u;
+            Pack cos_2pi_u;
+            sincos_2pi(load(&u2[j]), sin_2pi_u, cos_2pi_u);
+            store(&c[j], r*cos_2pi_u);
+            store(&s[j], r*sin_2pi_u);
+        }
+        for (std::size_t j = 0; j<W; j++)
+        {
+            const uint64_t index = 2*(pair + j);
+            if (index>=offset + i and index - offset<z.size()){z[index - offset] = c[j];}
+            if (index + 1>=offset + i and index + 1 - offset<z.size()){z[index + 1 - offset] = s[j];}
+        }
+        i = 2*(pair + W) - offset;
+    }
+};
@@ -0,0 +1,54 @@
+#pragma once
+#include <iostream>
+#include <cstdint>
+#include <span>
+#include "../../math/simd/simd.h"
+
+constexpr uint64_t THREAD_RANDOM_STREAM_DEFAULT = uint64_t(1) << 63;
+
+struct RandomEngine
+{
+    uint64_t state[4];
+    RandomEngine(uint64_t seed, uint64_t stream);
+    ~RandomEngine(){};
+    uint64_t next();
+};
+
+struct RandomStream
+{
+    RandomEngine engine;
+    double spare;
+    bool has_spare;
+    RandomStream(uint64_t seed, uint64_t stream);
+    ~RandomStream(){};
+    double uniform();
+    double normal();
+    void fill_uniform(std::span<double> u);
+    void fill_normal(std::span<double> z);
+};
+
+struct PhiloxEngine
+{
+    uint32_t key[2];
+    PhiloxEngine(uint64_t seed);
+    ~PhiloxEngine(){};
+    void generate(uint64_t stream, uint64_t counter, uint32_t out[4]);
+};
+
+struct PhiloxStream
+{
+    PhiloxEngine engine;
+    uint64_t stream;
+    PhiloxStream(uint64_t seed, uint64_t stream);
+    ~PhiloxStream(){};
+    double uniform(uint64_t index);
+    double normal(uint64_t index);
+    void fill_uniform(uint64_t offset, std::span<double> u);
+    void fill_normal(uint64_t offset, std::span<double> z);
+};
+
+void set_random_seed(uint64_t seed);
+
+void set_thread_random_stream(uint64_t index);
+
+RandomStream& thread_random_stream();
@@ -0,0 +1,236 @@
+#include "sobol.h"
+#include <bit>
+#include "../../math/simd/simd.h"
+
+/**
+* @file sobol.h
+* @brief This file defines the Sobol low discrepancy sequence used by the quasi Monte 
+* Carlo simulations.
+*
+* The points are generated in Gray code order, one xor of a direction number per 
+* dimension and point, and can optionally be Owen scrambled: the scrambled sequence 
+* keeps the low discrepancy of the points while making them random, so that independent 
+* scramblings give an unbiased estimate of the integration error.
+*
+* References :
+* - "On the distribution of points in a cube and the approximate evaluation of 
+*   integrals", Sobol, 1967.
+* - "Implementation of Sobol's quasirandom sequence generator", Bratley, Fox, 1988.
+* - "Practical Hash-based Owen Scrambling", Burley, 2020.
+*/
+
+/** 
+ * @class SobolDimensionOutOfRange
+ * @brief Definition of the unsupported dimension error.
+ */
+/** 
+ * @brief Definition of what() virtual std::exception function.
+ * @return The explication of the error.
+ */
+const char * SobolDimensionOutOfRange::what() const throw(){
+    return "The dimension of the Sobol sequence must be between 1 and SOBOL_MAX_DIMENSION";
+};
+
+/** 
+ * @class SobolSizeMismatch
+ * @brief Definition of the output size mismatch error.
+ */
+/** 
+ * @brief Definition of what() virtual std::exception function.
+ * @return The explication of the error.
+ */
+const char * SobolSizeMismatch::what() const throw(){
+    return "The output array must hold count*dimension values";
+};
+
+/** 
+ * @class SobolSequenceExhausted
+ * @brief Definition of the error of points past the end of the sequence.
+ */
+/** 
+ * @brief Definition of what() virtual std::exception function.
+ * @return The explication of the error.
+ */
+const char * SobolSequenceExhausted::what() const throw(){
+    return "The Sobol sequence holds SOBOL_MAX_POINTS points";
+};
+
+/**
+ * @param x The bits to reverse.
+ * @return The bits in reverse order.
+ */
+static inline uint32_t reverse_bits(uint32_t x)
+{
+    x = ((x >> 1) & 0x55555555) | ((x & 0x55555555) << 1);
+    x = ((x >> 2) & 0x33333333) | ((x & 0x33333333) << 2);
+    x = ((x >> 4) & 0x0f0f0f0f) | ((x & 0x0f0f0f0f) << 4);
+    x = ((x >> 8) & 0x00ff00ff) | ((x & 0x00ff00ff) << 8);
+    return (x >> 16) | (x << 16);
+};
+
+/**
+ * @brief Nested uniform (Owen) scrambling of a 32 bits coordinate: every bit is flipped 
+ * depending on a hash of the higher order bits, the hash is the Laine-Karras permutation
+ * applied to the reversed bits.
+ * @param x The coordinate.
+ * @param seed The seed of the dimension.
+ * @return The scrambled coordinate.
+ */
+static inline uint32_t owen_scramble(uint32_t x, uint32_t seed)
+{
+    x = reverse_bits(x);
+    x += seed;
+    x ^= x*0x6c50b47c;
+    x ^= x*0xb82f1e52;
+    x ^= x*0xc7afe638;
+    x ^= x*0x8d22f6e6;
+    return reverse_bits(x);
+};
+
+/**
+ * @struct SobolSequence
+ * @brief The Sobol sequence of points in [0,1)^dimension with the Joe-Kuo direction 
+ * numbers.
+ */
+/**
+ * @var bool SobolSequence::scrambled
+ * @brief Indicator if the points are Owen scrambled.
+ */
+/**
+ * @var std::vector<uint32_t> SobolSequence::directions
+ * @brief The direction numbers, directions[bit*dimension + d] for the dimension d.
+ */
+/**
+ * @var std::vector<uint32_t> SobolSequence::seeds
+ * @brief The scrambling seeds of the dimensions.
+ */
+/**
+ * @var std::vector<uint32_t> SobolSequence::state
+ * @brief The unscrambled coordinates of the next point.
+ */
+/**
+ * @var uint64_t SobolSequence::index
+ * @brief The index of the next point in the sequence.
+ */
+
+/**
+ * @brief Unscrambled sequence constructor.
+ * @param dimension The dimension of the points.
+ * @throw SobolDimensionOutOfRange
+ */
+SobolSequence::SobolSequence(std::size_t dimension): 
+    dimension(dimension), scrambled(false), directions(SOBOL_BITS*dimension), 
+    seeds(dimension, 0), state(dimension, 0), index(0)
+{
+    if (dimension==0 or dimension>SOBOL_MAX_DIMENSION){throw SobolDimensionOutOfRange();}
+    std::vector<uint32_t> m(SOBOL_BITS);
+    for (std::size_t d = 0; d<dimension; d++)
+    {
+        // The first dimension is the van der Corput sequence, m_k = 1.
+        unsigned int degree = 0;
+        uint32_t polynomial = 0;
+        if (d==0){m.assign(SOBOL_BITS, 1);}
+        else
+        {
+            polynomial = SOBOL_POLYNOMIALS[d-1];
+            while ((polynomial >> (degree + 1))!=0){degree++;}
+            for (unsigned int k = 0; k<degree; k++){m[k] = SOBOL_INITIAL_DIRECTIONS[d-1][k];}
+            for (unsigned int j = degree; j<SOBOL_BITS; j++)
+            {
+                uint32_t value = m[j-degree];
+                for (unsigned int k = 0; k<degree; k++)
+                {
+                    const unsigned int shift = degree - k;
+                    if ((polynomial >> k) & 1){value ^= m[j-shift] << shift;}
+                }
+                m[j] = value;
+            }
+        }
+        for (std::size_t j = 0; j<SOBOL_BITS; j++)
+        {directions[j*dimension + d] = m[j] << (SOBOL_BITS - 1 - j);}
+    }
+};
+
+/**
+ * @brief Owen scrambled sequence constructor.
+ * @param dimension The dimension of the points.
+ * @param seed The seed of the scrambling.
+ * @throw SobolDimensionOutOfRange
+ */
+SobolSequence::SobolSequence(std::size_t dimension, uint64_t seed): 
+    SobolSequence(dimension)
+{
+    scrambled = true;
+    uint64_t x = seed;
+    for (std::size_t d = 0; d<dimension; d++)
+    {
+        x += 0x9e3779b97f4a7c15;
+        uint64_t z = x;
+        z = (z ^ (z >> 30))*0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27))*0x94d049bb133111eb;
+        seeds[d] = uint32_t((z ^ (z >> 31)) >> 32);
+    }
+};
+
+/**
+ * @brief Moves the sequence to the point n, from the Gray code of n.
+ * @param n The index of the next point.
+ * @throw SobolSequenceExhausted
+ */
+void SobolSequence::skip_to(uint64_t n)
+{
+    if (n>SOBOL_MAX_POINTS){throw SobolSequenceExhausted();}
+    const uint64_t gray = n ^ (n >> 1);
+    state.assign(dimension, 0);
+    for (std::size_t j = 0; j<SOBOL_BITS; j++)
+    {
+        if ((gray >> j) & 1)
+        {for (std::size_t d = 0; d<dimension; d++){state[d] ^= directions[j*dimension + d];}}
+    }
+    index = n;
+};
+
+/**
+ * @brief Writes the next count points, by dimension: u[d*count + i] is the coordinate d 
+ * of the point i. The coordinates are the centres of their 2^-32 intervals, so that 
+ * they lie in (0,1) and map to finite normal quantiles.
+ * @param count The number of points.
+ * @param u The output coordinates.
+ * @throw SobolSizeMismatch
+ * @throw SobolSequenceExhausted
+ */
+void SobolSequence::next(std::size_t count, std::span<double> u)
+{
+    if (u.size()!=count*dimension){throw SobolSizeMismatch();}
+    if (count>SOBOL_MAX_POINTS - index){throw SobolSequenceExhausted();}
+    for (std::size_t i = 0; i<count; i++)
+    {
+        for (std::size_t d = 0; d<dimension; d++)
+        {
+            const uint32_t x = scrambled ? owen_scramble(state[d], seeds[d]) : state[d];
+            u[d*count + i] = (x + 0.5)*0x1.0p-32;
+        }
+        // The next point in Gray code order flips the lowest zero bit of the index, the 
+        // last point has none.
+        if (index + 1==SOBOL_MAX_POINTS){index++; break;}
+        const uint32_t* v = &directions[std::countr_one(index)*dimension];
+        for (std::size_t d = 0; d<dimension; d++){state[d] ^= v[d];}
+        index++;
+    }
+};
+
+/**
+ * @brief Writes the standard normal quantiles of the next count points, by dimension.
+ * @param count The number of points.
+ * @param z The output normal coordinates.
+ * @throw SobolSizeMismatch
+ * @throw SobolSequenceExhausted
+ */
+void SobolSequence::next_normal(std::size_t count, std::span<double> z)
+{
+    next(count, z);
+    std::size_t i = 0;
+    for (; i + simd::WIDTH<=z.size(); i += simd::WIDTH)
+    {simd::store(&z[i], simd::normal_quantile(simd::load(&z[i])));}
+    for (; i<z.size(); i++){z[i] = simd::normal_quantile(z[i]);}
+};
@@ -0,0 +1,38 @@
+#pragma once
+#include <iostream>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+class SobolDimensionOutOfRange: public std::exception 
+{public: const char * what() const throw();};
+
+class SobolSizeMismatch: public std::exception 
+{public: const char * what() const throw();};
+
+class SobolSequenceExhausted: public std::exception 
+{public: const char * what() const throw();};
+
+constexpr std::size_t SOBOL_MAX_DIMENSION = 1024;
+constexpr std::size_t SOBOL_MAX_DEGREE = 13;
+constexpr std::size_t SOBOL_BITS = 32;
+constexpr uint64_t SOBOL_MAX_POINTS = uint64_t(1) << SOBOL_BITS;
+
+extern const uint16_t SOBOL_POLYNOMIALS[SOBOL_MAX_DIMENSION - 1];
+extern const uint16_t SOBOL_INITIAL_DIRECTIONS[SOBOL_MAX_DIMENSION - 1][SOBOL_MAX_DEGREE];
+
+struct SobolSequence
+{
+    std::size_t dimension; 
+    bool scrambled; 
+    std::vector<uint32_t> directions; 
+    std::vector<uint32_t> seeds; 
+    std::vector<uint32_t> state; 
+    uint64_t index; 
+    SobolSequence(std::size_t dimension); 
+    SobolSequence(std::size_t dimension, uint64_t seed); 
+    ~SobolSequence(){};
+    void skip_to(uint64_t n); 
+    void next(std::size_t count, std::span<double> u); 
+    void next_normal(std::size_t count, std::span<double> z); 
+};
@@ -0,0 +1,39 @@
+#include "simd.h"
+
+/**
+* @file simd.h
+* @brief This file defines the SIMD packs used by the vectorized kernels of Arbitrage.
+*
+* The instruction set is selected at compile time: AVX-512 when __AVX512F__ is defined,
+* AVX2 when __AVX2__ is defined, and a one-lane scalar pack otherwise. Kernels written
+* against simd::Pack therefore compile to the three variants without modification.
+*
+* References :
+* - "Methods and programs for mathematical functions", Moshier, 1989 (Cephes exp/log).
+* - "Better approximations to cumulative normal functions", West, 2004.
+*/
+
+/**
+ * @struct simd::Pack
+ * @brief A register of simd::WIDTH double values.
+ */
+
+/**
+ * @struct simd::Mask
+ * @brief The lane mask produced by Pack comparisons and consumed by simd::select.
+ */
+
+/**
+ * @brief The instruction set the kernels were compiled for.
+ * @return "avx512", "avx2" or "scalar".
+ */
+const char * simd::instruction_set()
+{
+#if defined(__AVX512F__)
+    return "avx512";
+#elif defined(__AVX2__)
+    return "avx2";
+#else
+    return "scalar";
+#endif
+};
@@ -0,0 +1,416 @@
+#pragma once
+#include <iostream>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include "../numbers.h"
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace simd
+{
+#if defined(__AVX512F__)
+
+    constexpr std::size_t WIDTH = 8;
+    struct Pack {__m512d v;};
+    struct Mask {__mmask8 m;};
+    // The zero masking forms of the intrinsics whose unmasked form reads an undefined source,
+    // which GCC 12 reports as uninitialized, on every lane.
+    constexpr __mmask8 LANES = 0xFF;
+
+    inline Pack broadcast(double x){return {_mm512_set1_pd(x)};}
+    inline Pack load(const double* p){return {_mm512_loadu_pd(p)};}
+    inline void store(double* p, Pack a){_mm512_storeu_pd(p, a.v);}
+    inline Pack operator+(Pack a, Pack b){return {_mm512_add_pd(a.v, b.v)};}
+    inline Pack operator-(Pack a, Pack b){return {_mm512_sub_pd(a.v, b.v)};}
+    inline Pack operator*(Pack a, Pack b){return {_mm512_mul_pd(a.v, b.v)};}
+    inline Pack operator/(Pack a, Pack b){return {_mm512_div_pd(a.v, b.v)};}
+    inline Pack operator-(Pack a){return {_mm512_sub_pd(_mm512_setzero_pd(), a.v)};}
+    inline Pack fmadd(Pack a, Pack b, Pack c){return {_mm512_fmadd_pd(a.v, b.v, c.v)};}
+    inline Pack sqrt(Pack a){return {_mm512_maskz_sqrt_pd(LANES, a.v)};}
+    inline Pack abs(Pack a){return {_mm512_abs_pd(a.v)};}
+    inline Pack min(Pack a, Pack b){return {_mm512_maskz_min_pd(LANES, a.v, b.v)};}
+    inline Pack max(Pack a, Pack b){return {_mm512_maskz_max_pd(LANES, a.v, b.v)};}
+    inline Pack round(Pack a)
+    {return {_mm512_maskz_roundscale_pd(LANES, a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)};}
+    inline Pack floor(Pack a)
+    {return {_mm512_maskz_roundscale_pd(LANES, a.v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC)};}
+    inline Mask operator<(Pack a, Pack b){return {_mm512_cmp_pd_mask(a.v, b.v, _CMP_LT_OQ)};}
+    inline Mask operator<=(Pack a, Pack b){return {_mm512_cmp_pd_mask(a.v, b.v, _CMP_LE_OQ)};}
+    inline Mask operator>(Pack a, Pack b){return {_mm512_cmp_pd_mask(a.v, b.v, _CMP_GT_OQ)};}
+    inline Mask operator>=(Pack a, Pack b){return {_mm512_cmp_pd_mask(a.v, b.v, _CMP_GE_OQ)};}
+    inline Mask operator==(Pack a, Pack b){return {_mm512_cmp_pd_mask(a.v, b.v, _CMP_EQ_OQ)};}
+    inline Mask operator&(Mask a, Mask b){return {(__mmask8)(a.m & b.m)};}
+    inline Mask operator|(Mask a, Mask b){return {(__mmask8)(a.m | b.m)};}
+    inline Mask operator!(Mask a){return {(__mmask8)(~a.m)};}
+    inline bool any(Mask a){return a.m != 0;}
+    inline bool all(Mask a){return a.m == LANES;}
+    inline Pack select(Mask c, Pack a, Pack b){return {_mm512_mask_blend_pd(c.m, b.v, a.v)};}
+    inline Pack pow2n(Pack n){return {_mm512_maskz_scalef_pd(LANES, _mm512_set1_pd(1.0), n.v)};}
+    inline Pack frexp(Pack x, Pack& e)
+    {
+        e = {_mm512_add_pd(_mm512_maskz_getexp_pd(LANES, x.v), _mm512_set1_pd(1.0))};
+        return {_mm512_maskz_getmant_pd(LANES, x.v, _MM_MANT_NORM_p5_1, _MM_MANT_SIGN_src)};
+    }
+
+#elif defined(__AVX2__)
+
+    constexpr std::size_t WIDTH = 4;
+    struct Pack {__m256d v;};
+    struct Mask {__m256d m;};
+
+    inline Pack broadcast(double x){return {_mm256_set1_pd(x)};}
+    inline Pack load(const double* p){return {_mm256_loadu_pd(p)};}
+    inline void store(double* p, Pack a){_mm256_storeu_pd(p, a.v);}
+    inline Pack operator+(Pack a, Pack b){return {_mm256_add_pd(a.v, b.v)};}
+    inline Pack operator-(Pack a, Pack b){return {_mm256_sub_pd(a.v, b.v)};}
+    inline Pack operator*(Pack a, Pack b){return {_mm256_mul_pd(a.v, b.v)};}
+    inline Pack operator/(Pack a, Pack b){return {_mm256_div_pd(a.v, b.v)};}
+    inline Pack operator-(Pack a){return {_mm256_sub_pd(_mm256_setzero_pd(), a.v)};}
+#if defined(__FMA__)
+    inline Pack fmadd(Pack a, Pack b, Pack c){return {_mm256_fmadd_pd(a.v, b.v, c.v)};}
+#else
+    inline Pack fmadd(Pack a, Pack b, Pack c){return a*b + c;}
+#endif
+    inline Pack sqrt(Pack a){return {_mm256_sqrt_pd(a.v)};}
+    inline Pack abs(Pack a){return {_mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v)};}
+    inline Pack min(Pack a, Pack b){return {_mm256_min_pd(a.v, b.v)};}
+    inline Pack max(Pack a, Pack b){return {_mm256_max_pd(a.v, b.v)};}
+    inline Pack round(Pack a)
+    {return {_mm256_round_pd(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)};}
+    inline Pack floor(Pack a)
+    {return {_mm256_round_pd(a.v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC)};}
+    inline Mask operator<(Pack a, Pack b){return {_mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ)};}
+    inline Mask operator<=(Pack a, Pack b){return {_mm256_cmp_pd(a.v, b.v, _CMP_LE_OQ)};}
+    inline Mask operator>(Pack a, Pack b){return {_mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ)};}
+    inline Mask operator>=(Pack a, Pack b){return {_mm256_cmp_pd(a.v, b.v, _CMP_GE_OQ)};}
+    inline Mask operator==(Pack a, Pack b){return {_mm256_cmp_pd(a.v, b.v, _CMP_EQ_OQ)};}
+    inline Mask operator&(Mask a, Mask b){return {_mm256_and_pd(a.m, b.m)};}
+    inline Mask operator|(Mask a, Mask b){return {_mm256_or_pd(a.m, b.m)};}
+    inline Mask operator!(Mask a)
+    {return {_mm256_xor_pd(a.m, _mm256_castsi256_pd(_mm256_set1_epi64x(-1)))};}
+    inline bool any(Mask a){return _mm256_movemask_pd(a.m) != 0;}
+    inline bool all(Mask a){return _mm256_movemask_pd(a.m) == 0xF;}
+    inline Pack select(Mask c, Pack a, Pack b){return {_mm256_blendv_pd(b.v, a.v, c.m)};}
+    inline Pack pow2n(Pack n)
+    {
+        // 2^52 + 1023 moves the biased exponent into the low mantissa bits.
+        __m256d biased = _mm256_add_pd(n.v, _mm256_set1_pd(4503599627370496.0 + 1023.0));
+        return {_mm256_castsi256_pd(_mm256_slli_epi64(_mm256_castpd_si256(biased), 52))};
+    }
+    inline Pack frexp(Pack x, Pack& e)
+    {
+        const __m256i bits = _mm256_castpd_si256(x.v);
+        const __m256i magic = _mm256_set1_epi64x(0x4330000000000000);
+        __m256i exponent = _mm256_or_si256(_mm256_srli_epi64(bits, 52), magic);
+        e = {_mm256_sub_pd(
+            _mm256_castsi256_pd(exponent),
+            _mm256_set1_pd(4503599627370496.0 + 1022.0))};
+        __m256i mantissa = _mm256_or_si256(
+            _mm256_and_si256(bits, _mm256_set1_epi64x(0x000FFFFFFFFFFFFF)),
+            _mm256_set1_epi64x(0x3FE0000000000000));
+        return {_mm256_castsi256_pd(mantissa)};
+    }
+
+#else
+
+    constexpr std::size_t WIDTH = 1;
+    struct Pack {double v;};
+    struct Mask {bool m;};
+
+    inline Pack broadcast(double x){return {x};}
+    inline Pack load(const double* p){return {*p};}
+    inline void store(double* p, Pack a){*p = a.v;}
+    inline Pack operator+(Pack a, Pack b){return {a.v + b.v};}
+    inline Pack operator-(Pack a, Pack b){return {a.v - b.v};}
+    inline Pack operator*(Pack a, Pack b){return {a.v * b.v};}
+    inline Pack operator/(Pack a, Pack b){return {a.v / b.v};}
+    inline Pack operator-(Pack a){return {-a.v};}
+    inline Pack fmadd(Pack a, Pack b, Pack c){return {a.v*b.v + c.v};}
+    inline Pack sqrt(Pack a){return {std::sqrt(a.v)};}
+    inline Pack abs(Pack a){return {std::fabs(a.v)};}
+    inline Pack min(Pack a, Pack b){return {a.v < b.v ? a.v : b.v};}
+    inline Pack max(Pack a, Pack b){return {a.v > b.v ? a.v : b.v};}
+    inline Pack round(Pack a){return {std::nearbyint(a.v)};}
+    inline Pack floor(Pack a){return {std::floor(a.v)};}
+    inline Mask operator<(Pack a, Pack b){return {a.v < b.v};}
+    inline Mask operator<=(Pack a, Pack b){return {a.v <= b.v};}
+    inline Mask operator>(Pack a, Pack b){return {a.v > b.v};}
+    inline Mask operator>=(Pack a, Pack b){return {a.v >= b.v};}
+    inline Mask operator==(Pack a, Pack b){return {a.v == b.v};}
+    inline Mask operator&(Mask a, Mask b){return {a.m && b.m};}
+    inline Mask operator|(Mask a, Mask b){return {a.m || b.m};}
+    inline Mask operator!(Mask a){return {!a.m};}
+    inline bool any(Mask a){return a.m;}
+    inline bool all(Mask a){return a.m;}
+    inline Pack select(Mask c, Pack a, Pack b){return {c.m ? a.v : b.v};}
+    inline Pack pow2n(Pack n){return {std::ldexp(1.0, (int)n.v)};}
+    inline Pack frexp(Pack x, Pack& e)
+    {
+        int exponent;
+        double mantissa = std::frexp(x.v, &exponent);
+        e = {(double)exponent};
+        return {mantissa};
+    }
+
+#endif
+
+    inline Pack operator+(Pack a, double b){return a + broadcast(b);}
+    inline Pack operator+(double a, Pack b){return broadcast(a) + b;}
+    inline Pack operator-(Pack a, double b){return a - broadcast(b);}
+    inline Pack operator-(double a, Pack b){return broadcast(a) - b;}
+    inline Pack operator*(Pack a, double b){return a * broadcast(b);}
+    inline Pack operator*(double a, Pack b){return broadcast(a) * b;}
+    inline Pack operator/(Pack a, double b){return a / broadcast(b);}
+    inline Pack operator/(double a, Pack b){return broadcast(a) / b;}
+
+    const char * instruction_set();
+
+    // Scalar lanes, so that kernels templated on the lane type also run on double.
+    inline double select(bool c, double a, double b){return c ? a : b;}
+    inline bool any(bool a){return a;}
+    inline bool all(bool a){return a;}
+    inline double sqrt(double a){return std::sqrt(a);}
+    inline double abs(double a){return std::fabs(a);}
+    inline double min(double a, double b){return a < b ? a : b;}
+    inline double max(double a, double b){return a > b ? a : b;}
+    inline double exp(double a){return std::exp(a);}
+    inline double log(double a){return std::log(a);}
+
+    template <typename V> inline V constant(double x);
+    template <> inline double constant<double>(double x){return x;}
+    template <> inline Pack constant<Pack>(double x){return broadcast(x);}
+
+    /**
+     * @brief Exponential, Cephes rational approximation after reduction by ln(2).
+     * Accurate to a couple of ulps over the full double range.
+     */
+    inline Pack exp(Pack x)
+    {
+        const Pack xc = min(max(x, broadcast(-708.39641853226410622)), broadcast(709.78271289338399678));
+        const Pack n = round(xc*1.4426950408889634073599);
+        const Pack r = (xc - n*6.93145751953125e-1) - n*1.42860682030941723212e-6;
+        const Pack rr = r*r;
+        const Pack px = r*fmadd(fmadd(broadcast(1.26177193074810590878e-4), rr,
+            broadcast(3.02994407707441961300e-2)), rr, broadcast(9.99999999999999999910e-1));
+        const Pack qx = fmadd(fmadd(fmadd(broadcast(3.00198505138664455042e-6), rr,
+            broadcast(2.52448340349684104192e-3)), rr, broadcast(2.27265548208155028766e-1)),
+            rr, broadcast(2.00000000000000000009e0));
+        const Pack e = (1.0 + 2.0*px/(qx - px))*pow2n(n);
+        const Pack inf = broadcast(HUGE_VAL);
+        return select(x < broadcast(-708.39641853226410622), broadcast(0.0),
+            select(x > broadcast(709.78271289338399678), inf, e));
+    }
+
+    /**
+     * @brief Natural logarithm, Cephes rational approximation of log(1+x) on
+     * [sqrt(1/2)-1, sqrt(2)-1]. Non positive arguments return NaN.
+     */
+    inline Pack log(Pack x)
+    {
+        Pack e;
+        Pack m = frexp(x, e);
+        const Mask small = m < broadcast(0.70710678118654752440);
+        e = select(small, e - 1.0, e);
+        m = select(small, m + m - 1.0, m - 1.0);
+        const Pack z = m*m;
+        const Pack num = fmadd(fmadd(fmadd(fmadd(fmadd(broadcast(1.01875663804580931796e-4), m,
+            broadcast(4.97494994976747001425e-1)), m, broadcast(4.70579119878881725854e0)), m,
+            broadcast(1.44989225341610930846e1)), m, broadcast(1.79368678507819816313e1)), m,
+            broadcast(7.70838733755885391666e0));
+        const Pack den = fmadd(fmadd(fmadd(fmadd(m + 1.12873587189167450590e1, m,
+            broadcast(4.52279145837532221105e1)), m, broadcast(8.29875266912776603211e1)), m,
+            broadcast(7.11544750618563894466e1)), m, broadcast(2.31251620126765340583e1));
+        Pack y = m*(z*num/den);
+        y = y - e*2.121944400546905827679e-4;
+        y = y - 0.5*z;
+        const Pack result = (m + y) + e*0.693359375;
+        return select(x > broadcast(0.0), result, broadcast(NAN));
+    }
+
+    /**
+     * @brief Sine and cosine of 2*pi*u for u in [0,1), Cephes polynomials on [-pi/4,pi/4]
+     * after an exact reduction of 4u to the nearest quadrant.
+     */
+    inline void sincos_2pi(Pack u, Pack& s, Pack& c)
+    {
+        const Pack k = round(4.0*u);
+        const Pack x = (4.0*u - k)*(numbers::PI/2);
+        const Pack z = x*x;
+        const Pack ps = fmadd(fmadd(fmadd(fmadd(fmadd(broadcast(1.58962301576546568060e-10), z,
+            broadcast(-2.50507477628578072866e-8)), z, broadcast(2.75573136213857245213e-6)), z,
+            broadcast(-1.98412698295895385996e-4)), z, broadcast(8.33333333332211858878e-3)), z,
+            broadcast(-1.66666666666666307295e-1));
+        const Pack pc = fmadd(fmadd(fmadd(fmadd(fmadd(broadcast(-1.13585365213876817300e-11), z,
+            broadcast(2.08757008419747316778e-9)), z, broadcast(-2.75573141792967388112e-7)), z,
+            broadcast(2.48015872888517045348e-5)), z, broadcast(-1.38888888888730564116e-3)), z,
+            broadcast(4.16666666666665929218e-2));
+        const Pack sin_x = fmadd(x*z, ps, x);
+        const Pack cos_x = fmadd(z*z, pc, 1.0 - 0.5*z);
+        const Pack quadrant = k - 4.0*floor(0.25*k);
+        const Mask swap = (quadrant == broadcast(1.0)) | (quadrant == broadcast(3.0));
+        const Mask negate_s = quadrant > broadcast(1.5);
+        const Mask negate_c = (quadrant == broadcast(1.0)) | (quadrant == broadcast(2.0));
+        s = select(swap, cos_x, sin_x);
+        c = select(swap, sin_x, cos_x);
+        s = select(negate_s, -s, s);
+        c = select(negate_c, -c, c);
+    }
+
+    /**
+     * @brief Standard normal probability density.
+     */
+    inline Pack normal_pdf(Pack x)
+    {
+        return exp(-0.5*x*x)*(1/std::sqrt(2*numbers::PI));
+    }
+
+    inline double normal_pdf(double x)
+    {
+        return std::exp(-0.5*x*x)*(1/std::sqrt(2*numbers::PI));
+    }
+
+    /**
+     * @brief The lower tail N(-|x|) of Graeme West (2004) given e = exp(-x*x/2), with the
+     * rational and continued-fraction regimes both evaluated and blended.
+     */
+    inline Pack normal_tail(Pack z, Pack e)
+    {
+        const Pack n = fmadd(fmadd(fmadd(fmadd(fmadd(fmadd(broadcast(3.52624965998911e-02), z,
+            broadcast(0.700383064443688)), z, broadcast(6.37396220353165)), z,
+            broadcast(33.912866078383)), z, broadcast(112.079291497871)), z,
+            broadcast(221.213596169931)), z, broadcast(220.206867912376));
+        const Pack d = fmadd(fmadd(fmadd(fmadd(fmadd(fmadd(fmadd(broadcast(8.83883476483184e-02), z,
+            broadcast(1.75566716318264)), z, broadcast(16.064177579207)), z,
+            broadcast(86.7807322029461)), z, broadcast(296.564248779674)), z,
+            broadcast(637.333633378831)), z, broadcast(793.826512519948)), z,
+            broadcast(440.413735824752));
+        const Pack f = z + 1.0/(z + 2.0/(z + 3.0/(z + 4.0/(z + 13.0/20.0))));
+        const Pack c = select(z < broadcast(7.07106781186547), e*n/d, e/(std::sqrt(2*numbers::PI)*f));
+        return select(z <= broadcast(37.0), c, broadcast(0.0));
+    }
+
+    /**
+     * @brief Standard normal cumulative probability, the same Graeme West (2004)
+     * approximation as NormalDistribution::cdf with both regimes evaluated and blended.
+     */
+    inline Pack normal_cdf(Pack x)
+    {
+        const Pack z = abs(x);
+        const Pack c = normal_tail(z, exp(-0.5*z*z));
+        return select(x <= broadcast(0.0), c, 1.0 - c);
+    }
+
+    /**
+     * @brief Standard normal density and cumulative probability sharing one exp.
+     */
+    inline void normal_pdf_cdf(Pack x, Pack& pdf, Pack& cdf)
+    {
+        const Pack z = abs(x);
+        const Pack e = exp(-0.5*z*z);
+        const Pack c = normal_tail(z, e);
+        pdf = e*(1/std::sqrt(2*numbers::PI));
+        cdf = select(x <= broadcast(0.0), c, 1.0 - c);
+    }
+
+    inline double normal_cdf(double x)
+    {
+        const double z = std::fabs(x);
+        double c = 0.0;
+        if (z<=37.0)
+        {
+            const double e = std::exp(-0.5*z*z);
+            if (z<7.07106781186547)
+            {
+                const double n = ((((((3.52624965998911e-02*z + 0.700383064443688)*z 
+                    + 6.37396220353165)*z + 33.912866078383)*z + 112.079291497871)*z 
+                    + 221.213596169931)*z + 220.206867912376);
+                const double d = (((((((8.83883476483184e-02*z + 1.75566716318264)*z 
+                    + 16.064177579207)*z + 86.7807322029461)*z + 296.564248779674)*z 
+                    + 637.333633378831)*z + 793.826512519948)*z + 440.413735824752);
+                c = e*n/d;
+            }
+            else
+            {
+                const double f = z + 1.0/(z + 2.0/(z + 3.0/(z + 4.0/(z + 13.0/20.0))));
+                c = e/(std::sqrt(2*numbers::PI)*f);
+            }
+        }
+        return x<=0.0 ? c : 1-c;
+    }
+    /**
+     * @brief Wichura's AS241 (PPND16) rational approximations of the standard normal
+     * quantile, accurate to about 1e-16. The coefficients are shared by the scalar
+     * and the pack versions.
+     */
+    namespace as241
+    {
+        constexpr double A[8] = {3.3871328727963666080e0, 1.3314166789178437745e+2,
+            1.9715909503065514427e+3, 1.3731693765509461125e+4, 4.5921953931549871457e+4,
+            6.7265770927008700853e+4, 3.3430575583588128105e+4, 2.5090809287301226727e+3};
+        constexpr double B[8] = {1.0, 4.2313330701600911252e+1, 6.8718700749205790830e+2,
+            5.3941960214247511077e+3, 2.1213794301586595867e+4, 3.9307895800092710610e+4,
+            2.8729085735721942674e+4, 5.2264952788528545610e+3};
+        constexpr double C[8] = {1.42343711074968357734e0, 4.63033784615654529590e0,
+            5.76949722146069140550e0, 3.64784832476320460504e0, 1.27045825245236838258e0,
+            2.41780725177450611770e-1, 2.27238449892691845833e-2, 7.74545014278341407640e-4};
+        constexpr double D[8] = {1.0, 2.05319162663775882187e0, 1.67638483018380384940e0,
+            6.89767334985100004550e-1, 1.48103976427480074590e-1, 1.51986665636164571966e-2,
+            5.47593808499534494600e-4, 1.05075007164441684324e-9};
+        constexpr double E[8] = {6.65790464350110377720e0, 5.46378491116411436990e0,
+            1.78482653991729133580e0, 2.96560571828504891230e-1, 2.65321895265761230930e-2,
+            1.24266094738807843860e-3, 2.71155556874348757815e-5, 2.01033439929228813265e-7};
+        constexpr double F[8] = {1.0, 5.99832206555887937690e-1, 1.36929880922735805310e-1,
+            1.48753612908506148525e-2, 7.86869131145613259100e-4, 1.84631831751005468180e-5,
+            1.42151175831644588870e-7, 2.04426310338993978564e-15};
+
+        template <typename V>
+        inline V rational(const double* n, const double* d, const V& x)
+        {
+            V num = x*n[7] + n[6];
+            V den = x*d[7] + d[6];
+            for (int i = 5; i>=0; i--)
+            {
+                num = num*x + n[i];
+                den = den*x + d[i];
+            }
+            return num/den;
+        }
+    }
+
+    inline double normal_quantile(double p)
+    {
+        if (!(p>=0.0 and p<=1.0)){return NAN;}
+        if (p==0.0){return -HUGE_VAL;}
+        if (p==1.0){return HUGE_VAL;}
+        const double q = p - 0.5;
+        if (std::fabs(q)<=0.425){return q*as241::rational(as241::A, as241::B, 0.180625 - q*q);}
+        const double r = std::sqrt(-std::log(q<0.0 ? p : 1.0 - p));
+        const double x = r<=5.0 ? as241::rational(as241::C, as241::D, r - 1.6)
+            : as241::rational(as241::E, as241::F, r - 5.0);
+        return q<0.0 ? -x : x;
+    }
+
+    /**
+     * @brief Standard normal quantile, the three regimes of AS241 evaluated and blended.
+     * Returns -inf at 0, inf at 1 and NaN outside [0,1].
+     */
+    inline Pack normal_quantile(Pack p)
+    {
+#if !defined(__AVX512F__) && !defined(__AVX2__)
+        // A single lane gains nothing from evaluating every regime.
+        return {normal_quantile(p.v)};
+#else
+        const Pack q = p - 0.5;
+        const Pack central = q*as241::rational(as241::A, as241::B, 0.180625 - q*q);
+        const Pack r = sqrt(-log(min(p, 1.0 - p)));
+        const Pack tail = select(r <= broadcast(5.0),
+            as241::rational(as241::C, as241::D, r - 1.6), as241::rational(as241::E, as241::F, r - 5.0));
+        Pack x = select(abs(q) <= broadcast(0.425), central, select(q < broadcast(0.0), -tail, tail));
+        x = select(p == broadcast(0.0), broadcast(-HUGE_VAL), x);
+        x = select(p == broadcast(1.0), broadcast(HUGE_VAL), x);
+        return select((p >= broadcast(0.0)) & (p <= broadcast(1.0)), x, broadcast(NAN));
+#endif
+    }
+};
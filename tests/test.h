@@ -0,0 +1,52 @@
+#pragma once
+#include <iostream>
+#include <cmath>
+#include <chrono>
+
+/**
+* @file test.h
+* @brief The checks shared by the test executables, a test returns a non zero exit code when
+* one of its checks failed.
+*/
+
+inline int test_failures = 0;
+
+inline void check(bool condition, const char* name)
+{
+    if (not condition)
+    {
+        std::cerr << "FAILED: " << name << std::endl;
+        test_failures++;
+    }
+};
+
+inline void check_close(double value, double expected, double tolerance, const char* name)
+{
+    if (not (std::fabs(value - expected)<=tolerance*std::max(1.0, std::fabs(expected))))
+    {
+        std::cerr << "FAILED: " << name << " " << value << " != " << expected << std::endl;
+        test_failures++;
+    }
+};
+
+template <typename F>
+inline void check_throws(F f, const char* name)
+{
+    bool thrown = false;
+    try {f();} catch (const std::exception&) {thrown = true;}
+    check(thrown, name);
+};
+
+template <typename F>
+inline double milliseconds(F f)
+{
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+};
+
+inline int test_result()
+{
+    if (test_failures==0){std::cout << "passed" << std::endl;}
+    return test_failures==0 ? 0 : 1;
+};
@@ -0,0 +1,137 @@
+#include "test.h"
+#include <vector>
+#include <memory>
+#include "american/american_chain.h"
+
+/**
+* @file test_american.cpp
+* @brief Checks the american chain against the scalar Barone-Adesi-Whaley pricer, its cache
+* of exercise boundaries and the rejection of its invalid inputs, the Barone-Adesi-Whaley 
+* pricer against the published table of Haug, and the Leisen-Reimer reference against the 
+* american puts of Longstaff and Schwartz, its own convergence and the european calls.
+*/
+
+constexpr double AMERICAN_CHAIN_TOLERANCE = 1e-12;
+constexpr double AMERICAN_TABLE_TOLERANCE = 3e-4;
+constexpr double AMERICAN_TREE_TOLERANCE = 3e-3;
+constexpr double AMERICAN_TREE_CONVERGENCE = 1e-3;
+constexpr double AMERICAN_TREE_EUROPEAN_TOLERANCE = 1e-5;
+
+/**
+ * @brief A published american price.
+ */
+struct AmericanQuote
+{
+    bool is_call; 
+    double S; 
+    double sigma; 
+    double T; 
+    double price; 
+};
+
+int main()
+{
+    // Three expiries of 7 strikes, calls and puts, on a spot and on a future.
+    std::vector<double> K, r, q, sigma, T;
+    std::vector<bool> calls, futures;
+    for (double t: {0.1, 0.5, 2.0})
+    for (double k: {70.0, 85.0, 95.0, 100.0, 105.0, 115.0, 130.0})
+    for (int kind = 0; kind<4; kind++)
+    {
+        K.push_back(k); r.push_back(0.05); q.push_back(0.08); sigma.push_back(0.3); T.push_back(t);
+        calls.push_back(kind % 2==0); futures.push_back(kind>=2);
+    }
+    const std::size_t n = K.size();
+    std::unique_ptr<bool[]> is_call(new bool[n]), is_future(new bool[n]);
+    for (std::size_t i = 0; i<n; i++){is_call[i] = calls[i]; is_future[i] = futures[i];}
+    AmericanChain chain(K, r, q, sigma, T,
+        std::span<const bool>(is_call.get(), n), std::span<const bool>(is_future.get(), n));
+    check(chain.solves==12, "one boundary per expiry, type and underlying");
+
+    for (double S: {60.0, 100.0, 140.0})
+    {
+        chain.update_spot(S);
+        for (std::size_t i = 0; i<n; i++)
+        {
+            BaroneAdesiWhaley option(K[i], r[i], q[i], sigma[i], T[i], is_call[i], is_future[i]);
+            check_close(chain.price[i], option.price(S), AMERICAN_CHAIN_TOLERANCE, "chain matches scalar");
+        }
+    }
+
+    // Only the boundaries of the moved volatilities are solved again.
+    for (std::size_t i = 0; i<n; i++){if (T[i]==2.0){sigma[i] = 0.35;}}
+    chain.update_volatility(sigma);
+    check(chain.solves==16, "unchanged volatilities reuse their boundaries");
+
+    // Invalid volatilities leave the chain untouched.
+    chain.update_spot(100.0);
+    const std::vector<double> before(chain.price.begin(), chain.price.end());
+    std::vector<double> invalid = sigma;
+    invalid[n - 1] = 0.0;
+    check_throws([&]{chain.update_volatility(invalid);}, "non positive volatility");
+    chain.update_spot(100.0);
+    check(chain.price==before, "rejected update leaves the chain");
+    std::vector<double> expired = T;
+    expired[0] = 0.0;
+    check_throws([&]{AmericanChain(K, r, q, sigma, expired,
+        std::span<const bool>(is_call.get(), n), std::span<const bool>(is_future.get(), n));},
+        "non positive year fraction");
+
+    // The Barone-Adesi-Whaley values of Haug, "The Complete Guide to Option Pricing Formulas",
+    // K = 100, r = .1 and no carry, on a spot with q = r and on a future. The table stops the 
+    // Newton iterations of the critical price earlier, which moves the deep in the money short
+    // calls by up to 3e-3.
+    const AmericanQuote haug[] = {
+        {true, 90, .15, .1, .0206}, {true, 100, .15, .1, 1.8771}, {true, 110, .15, .1, 10.0089},
+        {true, 90, .25, .1, .3159}, {true, 100, .25, .1, 3.1280}, {true, 110, .25, .1, 10.3919},
+        {true, 90, .35, .1, .9495}, {true, 100, .35, .1, 4.3777}, {true, 110, .35, .1, 11.1679},
+        {true, 90, .15, .5, .8208}, {true, 100, .15, .5, 4.0842}, {true, 110, .15, .5, 10.8087},
+        {true, 90, .25, .5, 2.7437}, {true, 100, .25, .5, 6.8015}, {true, 110, .25, .5, 13.0170},
+        {true, 90, .35, .5, 5.0063}, {true, 100, .35, .5, 9.5106}, {true, 110, .35, .5, 15.5689},
+        {false, 90, .15, .1, 10.0000}, {false, 100, .15, .1, 1.8770}, {false, 110, .15, .1, .0410},
+        {false, 90, .25, .1, 10.2533}, {false, 100, .25, .1, 3.1277}, {false, 110, .25, .1, .4562},
+        {false, 90, .35, .1, 10.8787}, {false, 100, .35, .1, 4.3777}, {false, 110, .35, .1, 1.2402},
+        {false, 90, .15, .5, 10.5595}, {false, 100, .15, .5, 4.0842}, {false, 110, .15, .5, 1.0822},
+        {false, 90, .25, .5, 12.4419}, {false, 100, .25, .5, 6.8014}, {false, 110, .25, .5, 3.3226},
+        {false, 90, .35, .5, 14.6945}, {false, 100, .35, .5, 9.5104}, {false, 110, .35, .5, 5.8823}};
+    for (const AmericanQuote& quote: haug)
+    {
+        BaroneAdesiWhaley spot(100.0, .1, .1, quote.sigma, quote.T, quote.is_call, false);
+        BaroneAdesiWhaley future(100.0, .1, 0.0, quote.sigma, quote.T, quote.is_call, true);
+        check_close(spot.price(quote.S), quote.price, AMERICAN_TABLE_TOLERANCE, "Haug BAW table, spot");
+        check_close(future.price(quote.S), quote.price, AMERICAN_TABLE_TOLERANCE, "Haug BAW table, future");
+    }
+
+    // The finite difference american puts of Longstaff, Schwartz, "Valuing American Options by
+    // Simulation", K = 40 and r = .06, against the Leisen-Reimer reference, which converges 
+    // to a few 1e-3 above the table (4.4866 for the first put).
+    const AmericanQuote longstaff_schwartz[] = {
+        {false, 36, .2, 1, 4.478}, {false, 36, .2, 2, 4.840}, {false, 36, .4, 1, 7.101}, {false, 36, .4, 2, 8.508},
+        {false, 38, .2, 1, 3.250}, {false, 38, .2, 2, 3.745}, {false, 38, .4, 1, 6.148}, {false, 38, .4, 2, 7.670},
+        {false, 40, .2, 1, 2.314}, {false, 40, .2, 2, 2.885}, {false, 40, .4, 1, 5.312}, {false, 40, .4, 2, 6.920},
+        {false, 42, .2, 1, 1.617}, {false, 42, .2, 2, 2.212}, {false, 42, .4, 1, 4.582}, {false, 42, .4, 2, 6.248},
+        {false, 44, .2, 1, 1.110}, {false, 44, .2, 2, 1.690}, {false, 44, .4, 1, 3.948}, {false, 44, .4, 2, 5.647}};
+    for (const AmericanQuote& quote: longstaff_schwartz)
+    {
+        const double reference = american_reference_price(quote.S, 40.0, .06, 0.0, quote.sigma, quote.T, 
+            false, false, AMERICAN_REFERENCE_STEPS);
+        check_close(reference, quote.price, AMERICAN_TREE_TOLERANCE, "Leisen-Reimer tree, Longstaff-Schwartz table");
+        const double converged = american_reference_price(quote.S, 40.0, .06, 0.0, quote.sigma, quote.T, 
+            false, false, 4*AMERICAN_REFERENCE_STEPS);
+        check_close(reference, converged, AMERICAN_TREE_CONVERGENCE, "Leisen-Reimer tree convergence");
+    }
+
+    // Without dividends the american call is the european one, which the tree prices to 1/steps^2.
+    for (double S: {80.0, 100.0, 120.0})
+    {
+        const double european = BlackScholesClosedForm(S, 100.0, .05, 0.0, .3, 1.5, true, false).price();
+        check_close(american_reference_price(S, 100.0, .05, 0.0, .3, 1.5, true, false, AMERICAN_REFERENCE_STEPS),
+            european, AMERICAN_TREE_EUROPEAN_TOLERANCE,
+            "Leisen-Reimer tree, call without dividends");
+    }
+    check_throws([&]{american_reference_price(100.0, 100.0, .05, 0.0, 0.0, 1.0, false, false, 101);},
+        "tree of non positive volatility");
+    check_throws([&]{american_reference_price(100.0, 100.0, .05, 0.0, .3, 0.0, false, false, 101);},
+        "tree of non positive year fraction");
+    return test_result();
+};
@@ -0,0 +1,156 @@
+#include "test.h"
+#include <vector>
+#include <memory>
+#include "barrier/barrier.h"
+#include "montecarlo/montecarlo.h"
+#include "finitedifference/finitedifference.h"
+
+/**
+* @file test_barrier.cpp
+* @brief Checks the analytic vega and theta of the barrier batch against central differences
+* of its prices, its prices against the Monte Carlo engine, and its narrow corridor double
+* knock outs against the knock out grids of the finite difference pricer.
+*/
+
+constexpr double BARRIER_GREEK_TOLERANCE = 1e-6;
+constexpr double BARRIER_BUMP = 1e-5;
+constexpr double BARRIER_GRID_TOLERANCE = 1e-4;
+constexpr double BARRIER_GRID_BUMP = 1e-4;
+
+/**
+ * @brief The finite difference price of a double knock out.
+ * @param sigma The volatility.
+ * @param T The year fraction.
+ * @param K The strike.
+ * @param is_call indicator if the option is a call (True) or a put (False).
+ * @param lower The lower barrier.
+ * @param upper The upper barrier.
+ * @return The price.
+ */
+double double_knock_out_grid(double sigma, double T, double K, bool is_call, double lower, double upper)
+{
+    FiniteDifferenceSolver solver(FiniteDifferenceGrid(100.0, 0.05, 0.02, sigma, T, false, 400, 1000, 
+        lower, upper));
+    solver.solve(std::span<const double>(&K, 1), is_call, false);
+    return solver.price[0];
+};
+
+/**
+ * @brief The prices of a batch of barrier options.
+ * @param sigma The volatility.
+ * @param T The year fraction.
+ * @return The prices.
+ */
+std::vector<double> barrier_prices(double sigma, double T, const std::vector<double>& K,
+    const std::vector<bool>& calls, const std::vector<BarrierType>& barrier,
+    const std::vector<double>& lower, const std::vector<double>& upper)
+{
+    const std::size_t n = K.size();
+    std::unique_ptr<bool[]> is_call(new bool[n]);
+    for (std::size_t i = 0; i<n; i++){is_call[i] = calls[i];}
+    BarrierOptionBatch batch(100.0, 0.05, 0.02, sigma, T, false, K,
+        std::span<const bool>(is_call.get(), n), barrier, lower, upper);
+    std::vector<double> price(n);
+    BlackScholesBatchResult result;
+    result.price = price;
+    batch.evaluate(result, PRICE);
+    return price;
+};
+
+int main()
+{
+    const BarrierType types[6] = {DOWN_AND_IN, DOWN_AND_OUT, UP_AND_IN, UP_AND_OUT,
+        DOUBLE_KNOCK_IN, DOUBLE_KNOCK_OUT};
+    std::vector<double> K, lower, upper;
+    std::vector<bool> calls;
+    std::vector<BarrierType> barrier;
+    for (BarrierType type: types)
+    for (double k: {80.0, 95.0, 100.0, 110.0, 125.0})
+    for (bool call: {true, false})
+    {
+        K.push_back(k); calls.push_back(call); barrier.push_back(type);
+        lower.push_back(85.0); upper.push_back(120.0);
+    }
+    // A breached knock out and a breached knock in.
+    K.push_back(100.0); calls.push_back(true); barrier.push_back(DOWN_AND_OUT);
+    lower.push_back(101.0); upper.push_back(0.0);
+    K.push_back(100.0); calls.push_back(false); barrier.push_back(UP_AND_IN);
+    lower.push_back(0.0); upper.push_back(99.0);
+    const std::size_t n = K.size();
+
+    const double sigma = 0.25;
+    const double T = 0.75;
+    std::unique_ptr<bool[]> is_call(new bool[n]);
+    for (std::size_t i = 0; i<n; i++){is_call[i] = calls[i];}
+    BarrierOptionBatch batch(100.0, 0.05, 0.02, sigma, T, false, K,
+        std::span<const bool>(is_call.get(), n), barrier, lower, upper);
+    std::vector<double> price(n), vega(n), theta(n);
+    BlackScholesBatchResult result;
+    result.price = price;
+    result.vega = vega;
+    result.theta = theta;
+    batch.evaluate(result, PRICE | VEGA | THETA);
+
+    const double h_sigma = BARRIER_BUMP*sigma;
+    const double h_T = BARRIER_BUMP*T;
+    const std::vector<double> sigma_up = barrier_prices(sigma + h_sigma, T, K, calls, barrier, lower, upper);
+    const std::vector<double> sigma_down = barrier_prices(sigma - h_sigma, T, K, calls, barrier, lower, upper);
+    const std::vector<double> T_up = barrier_prices(sigma, T + h_T, K, calls, barrier, lower, upper);
+    const std::vector<double> T_down = barrier_prices(sigma, T - h_T, K, calls, barrier, lower, upper);
+    for (std::size_t i = 0; i<n; i++)
+    {
+        check_close(vega[i], (sigma_up[i] - sigma_down[i])/(2*h_sigma), BARRIER_GREEK_TOLERANCE, "analytic vega");
+        check_close(theta[i], -(T_up[i] - T_down[i])/(2*h_T), BARRIER_GREEK_TOLERANCE, "analytic theta");
+    }
+
+    // The Monte Carlo engine monitors the barriers at its steps, the continuous barriers of
+    // the batch are shifted away from the underlying by exp(0.5826*sigma*sqrt(dt)), as in
+    // Broadie, Glasserman, Kou, 1997.
+    const std::size_t steps = 250;
+    const double shift = std::exp(0.5826*sigma*std::sqrt(T/steps));
+    MonteCarloEngine engine(100.0, 0.05, 0.02, sigma, T, false, steps, 1 << 16, 11);
+    std::vector<MonteCarloPayoff> payoffs = {
+        MonteCarloPayoff(CALL, 100.0, DOWN_AND_OUT, 85.0),
+        MonteCarloPayoff(PUT, 100.0, UP_AND_IN, 120.0),
+        MonteCarloPayoff(CALL, 95.0, DOUBLE_KNOCK_OUT, 85.0, 120.0)};
+    const std::vector<MonteCarloEstimate> estimates = engine.price(payoffs);
+    const std::vector<double> continuous = barrier_prices(sigma, T, {100.0, 100.0, 95.0},
+        {true, false, true}, {DOWN_AND_OUT, UP_AND_IN, DOUBLE_KNOCK_OUT},
+        {85.0/shift, 0.0, 85.0/shift}, {0.0, 120.0*shift, 120.0*shift});
+    for (std::size_t p = 0; p<payoffs.size(); p++)
+    {
+        std::cout << "monte carlo " << estimates[p].price << " +- " << estimates[p].standard_error
+            << ", closed form " << continuous[p] << std::endl;
+        check(std::fabs(estimates[p].price - continuous[p])<4*estimates[p].standard_error + 1e-2,
+            "monte carlo matches closed form");
+    }
+
+    // Narrow corridors need many reflections, the prices of the three first ones vanish.
+    struct Corridor {double sigma; double T; double lower; double upper;};
+    const Corridor corridors[] = {{.3, 1.0, 98.0, 102.0}, {.3, 3.0, 95.0, 105.0}, {.3, .75, 95.0, 105.0},
+        {.15, .1, 97.0, 103.0}, {.2, .25, 92.0, 108.0}, {.2, 1.0, 90.0, 110.0}};
+    for (const Corridor& corridor: corridors)
+    for (bool call: {true, false})
+    {
+        const std::vector<double> strike = {call ? 99.0 : 101.0};
+        const bool flags[1] = {call};
+        const std::vector<BarrierType> type = {DOUBLE_KNOCK_OUT};
+        const std::vector<double> lower = {corridor.lower}, upper = {corridor.upper};
+        BarrierOptionBatch narrow(100.0, 0.05, 0.02, corridor.sigma, corridor.T, false, strike,
+            std::span<const bool>(flags, 1), type, lower, upper);
+        std::vector<double> narrow_price(1), narrow_vega(1);
+        BlackScholesBatchResult narrow_result;
+        narrow_result.price = narrow_price;
+        narrow_result.vega = narrow_vega;
+        narrow.evaluate(narrow_result, PRICE | VEGA);
+        const double grid = double_knock_out_grid(corridor.sigma, corridor.T, strike[0], call, 
+            corridor.lower, corridor.upper);
+        const double h = BARRIER_GRID_BUMP;
+        const double grid_vega = (double_knock_out_grid(corridor.sigma + h, corridor.T, strike[0], call, 
+            corridor.lower, corridor.upper) - double_knock_out_grid(corridor.sigma - h, corridor.T, 
+            strike[0], call, corridor.lower, corridor.upper))/(2*h);
+        check_close(narrow_price[0], grid, BARRIER_GRID_TOLERANCE, "narrow corridor price");
+        check_close(narrow_vega[0], grid_vega, BARRIER_GRID_TOLERANCE, "narrow corridor vega");
+    }
+    return test_result();
+};
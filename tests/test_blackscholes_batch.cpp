@@ -0,0 +1,199 @@
+#include "test.h"
+#include <vector>
+#include <memory>
+#include <limits>
+#include <algorithm>
+#include "blackscholes_batch.h"
+
+/**
+* @file test_blackscholes_batch.cpp
+* @brief Checks the batch evaluation of the Black Scholes closed form and the fused
+* GreeksBundle evaluation against the member functions of BlackScholesClosedForm, and the
+* shared kernel against textbook values and finite differences of the lower order outputs.
+*/
+
+constexpr double BLACK_SCHOLES_BATCH_TOLERANCE = 1e-9;
+constexpr double BLACK_SCHOLES_FINITE_DIFFERENCE_TOLERANCE = 1e-6;
+constexpr double BLACK_SCHOLES_RELATIVE_BUMP = 1e-4;
+
+typedef double (BlackScholesClosedForm::*Greek)();
+
+const Greek GREEKS[BLACK_SCHOLES_GREEK_COUNT] = {
+    &BlackScholesClosedForm::price, &BlackScholesClosedForm::delta,
+    &BlackScholesClosedForm::gamma, &BlackScholesClosedForm::theta,
+    &BlackScholesClosedForm::vega, &BlackScholesClosedForm::rho,
+    &BlackScholesClosedForm::epsilon, &BlackScholesClosedForm::vanna,
+    &BlackScholesClosedForm::volga, &BlackScholesClosedForm::charm,
+    &BlackScholesClosedForm::veta, &BlackScholesClosedForm::zomma,
+    &BlackScholesClosedForm::speed, &BlackScholesClosedForm::color,
+    &BlackScholesClosedForm::ultima, &BlackScholesClosedForm::dual_delta,
+    &BlackScholesClosedForm::dual_gamma};
+
+double bundle_output(const GreeksBundle& bundle, int g)
+{
+    const double values[BLACK_SCHOLES_GREEK_COUNT] = {
+        bundle.price, bundle.delta, bundle.gamma, bundle.theta, bundle.vega, bundle.rho,
+        bundle.epsilon, bundle.vanna, bundle.volga, bundle.charm, bundle.veta, bundle.zomma,
+        bundle.speed, bundle.color, bundle.ultima, bundle.dual_delta, bundle.dual_gamma};
+    return values[g];
+};
+
+/**
+ * @brief Central difference of a member function of BlackScholesClosedForm with respect to one 
+ * input, in the order (S, K, r, q, sigma, T).
+ */
+double finite_difference(Greek greek, const double* inputs, int input, bool call, bool future)
+{
+    double up[6], down[6];
+    std::copy(inputs, inputs + 6, up);
+    std::copy(inputs, inputs + 6, down);
+    const double h = BLACK_SCHOLES_RELATIVE_BUMP*std::max(1.0, std::fabs(inputs[input]));
+    up[input] += h;
+    down[input] -= h;
+    BlackScholesClosedForm upper(up[0], up[1], up[2], up[3], up[4], up[5], call, future);
+    BlackScholesClosedForm lower(down[0], down[1], down[2], down[3], down[4], down[5], call, future);
+    return ((upper.*greek)() - (lower.*greek)())/(2*h);
+};
+
+int main()
+{
+    // Hull, Options Futures and Other Derivatives, examples 15.6 and 19.1 to 19.6, Haug, The 
+    // Complete Guide to Option Pricing Formulas, the generalized and Black-76 examples.
+    check_close(BlackScholesClosedForm(42.0, 40.0, .1, 0.0, .2, .5, true, false).price(), 4.76, 5e-3, "Hull call");
+    check_close(BlackScholesClosedForm(42.0, 40.0, .1, 0.0, .2, .5, false, false).price(), .81, 5e-3, "Hull put");
+    check_close(BlackScholesClosedForm(75.0, 70.0, .1, .05, .35, .5, false, false).price(), 4.0870, 1e-4, "Haug put");
+    check_close(BlackScholesClosedForm(19.0, 19.0, .1, 0.0, .28, .75, true, true).price(), 1.7011, 1e-4, "Haug Black-76 call");
+    BlackScholesClosedForm hull(49.0, 50.0, .05, 0.0, .2, 20.0/52, true, false);
+    check_close(hull.delta(), .522, 5e-4, "Hull delta");
+    check_close(hull.gamma(), .066, 5e-4, "Hull gamma");
+    check_close(hull.vega(), 12.1, 5e-3, "Hull vega");
+    check_close(hull.theta(), -4.31, 5e-3, "Hull theta");
+    check_close(hull.rho(), 8.91, 5e-3, "Hull rho");
+
+    // The throwing constructor rejects what the status flags report.
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    check_throws([&]{BlackScholesClosedForm(0.0, 100.0, .01, 0.0, .2, 1.0, true, false);}, "zero spot");
+    check_throws([&]{BlackScholesClosedForm(nan, 100.0, .01, 0.0, .2, 1.0, true, false);}, "NaN spot");
+    check_throws([&]{BlackScholesClosedForm(100.0, -1.0, .01, 0.0, .2, 1.0, true, false);}, "negative strike");
+    check_throws([&]{BlackScholesClosedForm(100.0, 100.0, .01, 0.0, nan, 1.0, true, false);}, "NaN volatility");
+
+    // Every output against a central difference of the price or of the output one order below, 
+    // theta, charm and color being the derivatives in the valuation time, minus the ones in T.
+    enum {S_, K_, R_, Q_, SIGMA_, T_};
+    const struct {Greek greek; Greek base; int input; double sign;} differences[] = {
+        {&BlackScholesClosedForm::delta, &BlackScholesClosedForm::price, S_, 1.0},
+        {&BlackScholesClosedForm::gamma, &BlackScholesClosedForm::delta, S_, 1.0},
+        {&BlackScholesClosedForm::theta, &BlackScholesClosedForm::price, T_, -1.0},
+        {&BlackScholesClosedForm::vega, &BlackScholesClosedForm::price, SIGMA_, 1.0},
+        {&BlackScholesClosedForm::rho, &BlackScholesClosedForm::price, R_, 1.0},
+        {&BlackScholesClosedForm::epsilon, &BlackScholesClosedForm::price, Q_, 1.0},
+        {&BlackScholesClosedForm::vanna, &BlackScholesClosedForm::delta, SIGMA_, 1.0},
+        {&BlackScholesClosedForm::volga, &BlackScholesClosedForm::vega, SIGMA_, 1.0},
+        {&BlackScholesClosedForm::charm, &BlackScholesClosedForm::delta, T_, -1.0},
+        {&BlackScholesClosedForm::veta, &BlackScholesClosedForm::vega, T_, 1.0},
+        {&BlackScholesClosedForm::zomma, &BlackScholesClosedForm::gamma, SIGMA_, 1.0},
+        {&BlackScholesClosedForm::speed, &BlackScholesClosedForm::gamma, S_, 1.0},
+        {&BlackScholesClosedForm::color, &BlackScholesClosedForm::gamma, T_, -1.0},
+        {&BlackScholesClosedForm::ultima, &BlackScholesClosedForm::volga, SIGMA_, 1.0},
+        {&BlackScholesClosedForm::dual_delta, &BlackScholesClosedForm::price, K_, 1.0},
+        {&BlackScholesClosedForm::dual_gamma, &BlackScholesClosedForm::dual_delta, K_, 1.0}};
+    const double inputs[6] = {100.0, 95.0, .03, .01, .25, .7};
+    for (bool call: {true, false})
+    for (bool future: {false, true})
+    {
+        BlackScholesClosedForm option(inputs[0], inputs[1], inputs[2], inputs[3], inputs[4], 
+            inputs[5], call, future);
+        for (const auto& d: differences)
+        {
+            check_close((option.*d.greek)(), 
+                d.sign*finite_difference(d.base, inputs, d.input, call, future), 
+                BLACK_SCHOLES_FINITE_DIFFERENCE_TOLERANCE, "greek against finite difference");
+        }
+    }
+
+    // A chain whose size is not a multiple of the simd width, so that the tail is exercised.
+    const std::size_t n = 1003;
+    std::vector<double> S(n), K(n), r(n), q(n), sigma(n), T(n);
+    std::unique_ptr<bool[]> is_call(new bool[n]), is_future(new bool[n]);
+    for (std::size_t i = 0; i<n; i++)
+    {
+        S[i] = 100.0;
+        K[i] = 40.0 + 0.13*(i % 997);
+        r[i] = -0.01 + 0.001*(i % 70);
+        q[i] = 0.0005*(i % 40);
+        sigma[i] = 0.05 + 0.01*(i % 120);
+        T[i] = 0.01 + 0.02*(i % 150);
+        is_call[i] = i % 2==0;
+        is_future[i] = i % 3==0;
+    }
+    // Invalid lanes, one in a full block and one in the tail.
+    sigma[5] = 0.0;
+    T[n - 1] = -1.0;
+
+    std::vector<std::vector<double>> out(BLACK_SCHOLES_GREEK_COUNT, std::vector<double>(n));
+    BlackScholesBatchResult result;
+    for (int g = 0; g<BLACK_SCHOLES_GREEK_COUNT; g++){result.output(g) = out[g];}
+    std::vector<int> status(n);
+    BlackScholesBatch batch(S, K, r, q, sigma, T,
+        std::span<const bool>(is_call.get(), n), std::span<const bool>(is_future.get(), n));
+    batch.evaluate(result, ALL_GREEKS, status);
+
+    for (std::size_t i = 0; i<n; i++)
+    {
+        if (i==5 or i==n - 1)
+        {
+            check(status[i]!=BLACK_SCHOLES_VALID, "invalid lane status");
+            for (int g = 0; g<BLACK_SCHOLES_GREEK_COUNT; g++)
+            {check(std::isnan(out[g][i]), "invalid lane is NaN");}
+            continue;
+        }
+        check(status[i]==BLACK_SCHOLES_VALID, "valid lane status");
+        BlackScholesClosedForm option(S[i], K[i], r[i], q[i], sigma[i], T[i], is_call[i], is_future[i]);
+        const GreeksBundle bundle = option.evaluate(ALL_GREEKS);
+        for (int g = 0; g<BLACK_SCHOLES_GREEK_COUNT; g++)
+        {
+            const double expected = (option.*GREEKS[g])();
+            check_close(out[g][i], expected, BLACK_SCHOLES_BATCH_TOLERANCE, "batch greek");
+            check_close(bundle_output(bundle, g), expected, BLACK_SCHOLES_BATCH_TOLERANCE,
+                "bundle greek");
+        }
+    }
+
+    // Only the selected outputs are written.
+    std::vector<double> price(n), gamma(n, -1.0);
+    BlackScholesBatchResult partial;
+    partial.price = price;
+    batch.evaluate(partial, PRICE);
+    check_close(price[0], out[0][0], 0.0, "price only");
+    check(gamma[0]==-1.0, "unselected output untouched");
+
+    std::vector<double> short_output(n - 1);
+    BlackScholesBatchResult mismatch;
+    mismatch.price = short_output;
+    check_throws([&]{batch.evaluate(mismatch, PRICE);}, "output size mismatch");
+
+    // Cost per option of the batch, the fused bundle and the member functions.
+    const int rounds = 20;
+    const double batch_ms = milliseconds([&]{
+        for (int k = 0; k<rounds; k++){batch.evaluate(result, ALL_GREEKS);}});
+    double sink = 0.0;
+    const double bundle_ms = milliseconds([&]{
+        for (int k = 0; k<rounds; k++)
+        for (std::size_t i = 0; i<n - 1; i++)
+        {
+            BlackScholesClosedForm option(S[i], K[i], r[i], q[i], sigma[i] + 1e-3, T[i], true, false);
+            sink += option.evaluate(ALL_GREEKS).dual_gamma;
+        }});
+    const double members_ms = milliseconds([&]{
+        for (int k = 0; k<rounds; k++)
+        for (std::size_t i = 0; i<n - 1; i++)
+        {
+            BlackScholesClosedForm option(S[i], K[i], r[i], q[i], sigma[i] + 1e-3, T[i], true, false);
+            for (int g = 0; g<BLACK_SCHOLES_GREEK_COUNT; g++){sink += (option.*GREEKS[g])();}
+        }});
+    const double per_option = 1e6/(rounds*n);
+    std::cout << "all greeks, ns per option: batch " << batch_ms*per_option
+        << ", bundle " << bundle_ms*per_option << ", members " << members_ms*per_option
+        << " (" << (sink!=0.0) << ")" << std::endl;
+    return test_result();
+};
@@ -0,0 +1,76 @@
+#include "test.h"
+#include <vector>
+#include "blackscholes_chain.h"
+
+/**
+* @file test_blackscholes_chain.cpp
+* @brief Checks the chain pricer and the compile time specialised closed form against
+* BlackScholesClosedForm, whose flags are read at runtime, and that a rejected chain leaves its
+* outputs untouched.
+*/
+
+constexpr double BLACK_SCHOLES_CHAIN_TOLERANCE = 1e-9;
+
+int main()
+{
+    const std::size_t n = 203;
+    std::vector<double> S(n), K(n), r(n), q(n), sigma(n), T(n);
+    for (std::size_t i = 0; i<n; i++)
+    {
+        S[i] = 100.0;
+        K[i] = 50.0 + 0.5*i;
+        r[i] = 0.03;
+        q[i] = 0.01;
+        sigma[i] = 0.1 + 0.002*i;
+        T[i] = 0.05 + 0.01*i;
+    }
+
+    for (OptionType type: {CALL, PUT})
+    for (UnderlyingType underlying: {SPOT_UNDERLYING, FUTURE_UNDERLYING})
+    {
+        const bool call = type==CALL;
+        const bool future = underlying==FUTURE_UNDERLYING;
+        std::vector<std::vector<double>> chain_out(BLACK_SCHOLES_GREEK_COUNT, std::vector<double>(n));
+        BlackScholesBatchResult chain_result;
+        for (int g = 0; g<BLACK_SCHOLES_GREEK_COUNT; g++){chain_result.output(g) = chain_out[g];}
+        BlackScholesChain chain(S, K, r, q, sigma, T, type, underlying);
+        chain.evaluate(chain_result, ALL_GREEKS);
+
+        for (std::size_t i = 0; i<n; i++)
+        {
+            GreeksBundle specialised;
+            if (call and !future)
+            {specialised = BlackScholes<CALL, SPOT_UNDERLYING>(S[i], K[i], r[i], q[i], sigma[i], T[i]).evaluate(ALL_GREEKS);}
+            else if (call)
+            {specialised = BlackScholes<CALL, FUTURE_UNDERLYING>(S[i], K[i], r[i], q[i], sigma[i], T[i]).evaluate(ALL_GREEKS);}
+            else if (!future)
+            {specialised = BlackScholes<PUT, SPOT_UNDERLYING>(S[i], K[i], r[i], q[i], sigma[i], T[i]).evaluate(ALL_GREEKS);}
+            else
+            {specialised = BlackScholes<PUT, FUTURE_UNDERLYING>(S[i], K[i], r[i], q[i], sigma[i], T[i]).evaluate(ALL_GREEKS);}
+            BlackScholesClosedForm option(S[i], K[i], r[i], q[i], sigma[i], T[i], call, future);
+            GreeksBundle expected = option.evaluate(ALL_GREEKS);
+            for (int g = 0; g<BLACK_SCHOLES_GREEK_COUNT; g++)
+            {
+                check_close(chain_out[g][i], expected.output(g), BLACK_SCHOLES_CHAIN_TOLERANCE,
+                    "chain matches closed form");
+                check_close(specialised.output(g), expected.output(g), BLACK_SCHOLES_CHAIN_TOLERANCE,
+                    "specialised matches closed form");
+            }
+        }
+    }
+
+    // An invalid option at the end of the chain is rejected before anything is written.
+    sigma[n - 1] = 0.0;
+    std::vector<double> price(n, -1.0);
+    BlackScholesBatchResult result;
+    result.price = price;
+    BlackScholesChain chain(S, K, r, q, sigma, T, CALL, SPOT_UNDERLYING);
+    check_throws([&]{chain.evaluate(result, PRICE);}, "non positive volatility");
+    sigma[n - 1] = 0.2;
+    T[n - 1] = 0.0;
+    check_throws([&]{chain.evaluate(result, PRICE);}, "non positive year fraction");
+    bool untouched = true;
+    for (double value: price){untouched = untouched and value==-1.0;}
+    check(untouched, "rejected chain writes nothing");
+    return test_result();
+};
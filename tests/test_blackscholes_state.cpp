@@ -0,0 +1,85 @@
+#include "test.h"
+#include <vector>
+#include <limits>
+#include <memory>
+#include "blackscholes_state.h"
+
+/**
+* @file test_blackscholes_state.cpp
+* @brief Checks the incremental repricing of BlackScholesPricingState against
+* BlackScholesClosedForm, and the rejection of non positive volatilities and year fractions.
+*/
+
+constexpr double BLACK_SCHOLES_STATE_TOLERANCE = 1e-9;
+
+void check_state(BlackScholesPricingState& state, double S, const std::vector<double>& K,
+    const std::vector<double>& r, const std::vector<double>& q, const std::vector<double>& sigma,
+    const std::vector<double>& T, const bool* is_call, const bool* is_future)
+{
+    for (std::size_t i = 0; i<state.size(); i++)
+    {
+        BlackScholesClosedForm option(S, K[i], r[i], q[i], sigma[i], T[i], is_call[i], is_future[i]);
+        check_close(state.price[i], option.price(), BLACK_SCHOLES_STATE_TOLERANCE, "price");
+        check_close(state.delta[i], option.delta(), BLACK_SCHOLES_STATE_TOLERANCE, "delta");
+        check_close(state.gamma[i], option.gamma(), BLACK_SCHOLES_STATE_TOLERANCE, "gamma");
+        check_close(state.theta[i], option.theta(), BLACK_SCHOLES_STATE_TOLERANCE, "theta");
+        check_close(state.vega[i], option.vega(), BLACK_SCHOLES_STATE_TOLERANCE, "vega");
+        check_close(state.vanna[i], option.vanna(), BLACK_SCHOLES_STATE_TOLERANCE, "vanna");
+        check_close(state.volga[i], option.volga(), BLACK_SCHOLES_STATE_TOLERANCE, "volga");
+    }
+};
+
+int main()
+{
+    const std::size_t n = 37;
+    std::vector<double> K(n), r(n), q(n), sigma(n), T(n);
+    std::unique_ptr<bool[]> is_call(new bool[n]), is_future(new bool[n]);
+    for (std::size_t i = 0; i<n; i++)
+    {
+        K[i] = 80.0 + i;
+        r[i] = 0.02;
+        q[i] = 0.005*(i % 3);
+        sigma[i] = 0.15 + 0.01*i;
+        T[i] = 0.1 + 0.05*i;
+        is_call[i] = i % 2==0;
+        is_future[i] = i % 5==0;
+    }
+    const std::span<const bool> calls(is_call.get(), n), futures(is_future.get(), n);
+    BlackScholesPricingState state(100.0, K, r, q, sigma, T, calls, futures);
+    check_state(state, 100.0, K, r, q, sigma, T, is_call.get(), is_future.get());
+
+    state.update_spot(103.5);
+    check_state(state, 103.5, K, r, q, sigma, T, is_call.get(), is_future.get());
+    sigma[9] = 0.4;
+    state.update_volatility(9, 0.4);
+    check_state(state, 103.5, K, r, q, sigma, T, is_call.get(), is_future.get());
+
+    check_throws([&]{state.update_volatility(3, 0.0);}, "non positive volatility update");
+    std::vector<double> bad(sigma);
+    bad[n - 1] = -0.1;
+    check_throws([&]{state.update_volatility(bad);}, "non positive volatility updates");
+    check_close(state.price[n - 1], BlackScholesClosedForm(103.5, K[n - 1], r[n - 1], q[n - 1],
+        sigma[n - 1], T[n - 1], is_call[n - 1], is_future[n - 1]).price(),
+        BLACK_SCHOLES_STATE_TOLERANCE, "rejected update leaves the state");
+    check_throws([&]{BlackScholesPricingState(100.0, K, r, q, bad, T, calls, futures);},
+        "non positive volatility");
+    std::vector<double> expired(T);
+    expired[0] = 0.0;
+    check_throws([&]{BlackScholesPricingState(100.0, K, r, q, sigma, expired, calls, futures);},
+        "non positive year fraction");
+
+    // NaN inputs and out of range indices are rejected and leave the state unchanged.
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    check_throws([&]{state.update_spot(0.0);}, "non positive spot update");
+    check_throws([&]{state.update_spot(nan);}, "NaN spot update");
+    check_throws([&]{state.update_volatility(3, nan);}, "NaN volatility update");
+    check_throws([&]{state.update_volatility(n, 0.2);}, "out of range volatility update");
+    bad[n - 1] = nan;
+    check_throws([&]{state.update_volatility(bad);}, "NaN volatility updates");
+    check_state(state, 103.5, K, r, q, sigma, T, is_call.get(), is_future.get());
+    check_throws([&]{BlackScholesPricingState(-1.0, K, r, q, sigma, T, calls, futures);},
+        "non positive spot");
+    check_throws([&]{BlackScholesPricingState(nan, K, r, q, sigma, T, calls, futures);},
+        "NaN spot");
+    return test_result();
+};
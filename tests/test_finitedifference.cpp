@@ -0,0 +1,131 @@
+#include "test.h"
+#include <vector>
+#include <memory>
+#include "finitedifference/finitedifference.h"
+#include "american/american.h"
+#include "barrier/barrier.h"
+
+/**
+* @file test_finitedifference.cpp
+* @brief Checks the finite difference pricer against the Black Scholes closed form on a strip
+* of strikes, its american puts against the Leisen-Reimer reference, its knock out grids against
+* the Reiner-Rubinstein closed forms, its gamma and theta against bumped prices, the report of
+* the penalty iterations which did not converge and the rejection of the options of another
+* expiry.
+*/
+
+constexpr double FINITE_DIFFERENCE_PRICE_TOLERANCE = 2e-3;
+constexpr double FINITE_DIFFERENCE_GREEK_TOLERANCE = 5e-3;
+constexpr double FINITE_DIFFERENCE_BUMP = 1e-2;
+
+/**
+ * @brief The finite difference american put price.
+ * @param S The spot price.
+ * @param T The year fraction.
+ * @return The price.
+ */
+double american_put(double S, double T)
+{
+    FiniteDifferenceSolver solver(FiniteDifferenceGrid(S, 0.05, 0.02, 0.25, T, false, 800, 400));
+    const double K = 105.0;
+    solver.solve(std::span<const double>(&K, 1), false, true);
+    return solver.price[0];
+};
+
+int main()
+{
+    const long long valuation = 1700000000;
+    const long long year = 365*24*60*60;
+    FiniteDifferenceGrid grid(100.0, 0.05, 0.02, 0.25, 1.0, false, 400, 100);
+    FiniteDifferenceSolver solver(grid);
+
+    for (OptionType type: {CALL, PUT})
+    {
+        EuropeanVanillaOption option(std::make_unique<EpochTimestamp>(valuation + year, SECONDS), type, 105.0f);
+        const GreeksBundle bundle = solver.evaluate(option, EpochTimestamp(valuation, SECONDS), ACT365);
+        BlackScholesClosedForm exact(100.0, 105.0, 0.05, 0.02, 0.25, 1.0, type==CALL, false);
+        check_close(bundle.price, exact.price(), FINITE_DIFFERENCE_PRICE_TOLERANCE, "european price");
+        check_close(bundle.delta, exact.delta(), FINITE_DIFFERENCE_PRICE_TOLERANCE, "european delta");
+        check_close(bundle.gamma, exact.gamma(), FINITE_DIFFERENCE_PRICE_TOLERANCE, "european gamma");
+        check_close(bundle.theta, exact.theta(), FINITE_DIFFERENCE_PRICE_TOLERANCE, "european theta");
+    }
+
+    // A strip of strikes which is not a multiple of the simd width, in one sweep.
+    const std::vector<double> strikes = {70.0, 80.0, 90.0, 95.0, 100.0, 105.0, 110.0, 120.0, 135.0};
+    for (bool is_call: {true, false})
+    {
+        solver.solve(strikes, is_call, false);
+        for (std::size_t k = 0; k<strikes.size(); k++)
+        {
+            BlackScholesClosedForm exact(100.0, strikes[k], 0.05, 0.02, 0.25, 1.0, is_call, false);
+            check_close(solver.price[k], exact.price(), FINITE_DIFFERENCE_PRICE_TOLERANCE, "strip price");
+            check(solver.status[k]==FINITE_DIFFERENCE_CONVERGED, "strip status");
+        }
+    }
+
+    // American puts against the Leisen-Reimer tree.
+    for (double S: {80.0, 100.0, 120.0})
+    for (double T: {.25, 1.0, 3.0})
+    {
+        FiniteDifferenceSolver american(FiniteDifferenceGrid(S, 0.05, 0.02, 0.25, T, false, 800, 400));
+        const double K = 105.0;
+        american.solve(std::span<const double>(&K, 1), false, true);
+        const double reference = american_reference_price(S, K, 0.05, 0.02, 0.25, T, false, false, 
+            4*AMERICAN_REFERENCE_STEPS);
+        check_close(american.price[0], reference, FINITE_DIFFERENCE_PRICE_TOLERANCE, "american put");
+        check(american.status[0]==FINITE_DIFFERENCE_CONVERGED, "american put status");
+
+        // The grid sensitivities against bumped prices, the grid moves with the spot.
+        const double h_S = FINITE_DIFFERENCE_BUMP*S;
+        const double h_T = FINITE_DIFFERENCE_BUMP*T;
+        const double up = american_put(S + h_S, T);
+        const double down = american_put(S - h_S, T);
+        const double gamma = (up - 2*american.price[0] + down)/(h_S*h_S);
+        const double theta = -(american_put(S, T + h_T) - american_put(S, T - h_T))/(2*h_T);
+        check_close(american.gamma[0], gamma, FINITE_DIFFERENCE_GREEK_TOLERANCE, "american gamma");
+        check_close(american.theta[0], theta, FINITE_DIFFERENCE_GREEK_TOLERANCE, "american theta");
+    }
+
+    // Knock out grids against the Reiner-Rubinstein closed forms of the barrier batch.
+    const std::vector<double> barrier_strikes = {90.0, 100.0, 110.0};
+    const bool calls[3] = {true, true, true};
+    const bool puts[3] = {false, false, false};
+    const std::vector<BarrierType> down_and_out(3, DOWN_AND_OUT), up_and_out(3, UP_AND_OUT);
+    const std::vector<double> lower(3, 85.0), upper(3, 120.0);
+    std::vector<double> closed_form(3);
+    BlackScholesBatchResult result;
+    result.price = closed_form;
+    for (bool is_call: {true, false})
+    {
+        const bool is_down = is_call;
+        FiniteDifferenceSolver knock_out(FiniteDifferenceGrid(100.0, 0.05, 0.02, 0.25, 1.0, false, 800, 400, 
+            is_down ? 85.0 : 0.0, is_down ? std::numeric_limits<double>::infinity() : 120.0));
+        knock_out.solve(barrier_strikes, is_call, false);
+        BarrierOptionBatch(100.0, 0.05, 0.02, 0.25, 1.0, false, barrier_strikes, 
+            std::span<const bool>(is_call ? calls : puts, 3), is_down ? down_and_out : up_and_out, 
+            lower, upper).evaluate(result, PRICE);
+        for (std::size_t k = 0; k<3; k++)
+        {
+            check_close(knock_out.price[k], closed_form[k], FINITE_DIFFERENCE_PRICE_TOLERANCE, 
+                "knock out grid");
+        }
+    }
+
+    // Far more space steps than time steps: the exercise region moves by more nodes per step
+    // than the penalty iterations can follow.
+    FiniteDifferenceGrid coarse(100.0, 0.1, 0.0, 0.2, 3.0, false, 2000, 2);
+    FiniteDifferenceSolver unconverged(coarse);
+    const double K = 110.0;
+    unconverged.solve(std::span<const double>(&K, 1), false, true);
+    check(unconverged.status[0] & FINITE_DIFFERENCE_NOT_CONVERGED, "penalty iterations not converged");
+    AmericanVanillaOption put(std::make_unique<EpochTimestamp>(valuation + 3*year, SECONDS), PUT, 110.0f);
+    check_throws([&]{unconverged.evaluate(put, EpochTimestamp(valuation, SECONDS), ACT365);}, 
+        "evaluate rejects unconverged penalty iterations");
+
+    // An option of another expiry, or without expiry, is not priced on the grid.
+    EuropeanVanillaOption later(std::make_unique<EpochTimestamp>(valuation + year + 86400, SECONDS), CALL, 105.0f);
+    check_throws([&]{solver.evaluate(later, EpochTimestamp(valuation, SECONDS), ACT365);}, "expiry mismatch");
+    EuropeanVanillaOption undated(nullptr, CALL, 105.0f);
+    check_throws([&]{solver.evaluate(undated, EpochTimestamp(valuation, SECONDS), ACT365);}, "missing expiry");
+    return test_result();
+};
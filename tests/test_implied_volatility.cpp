@@ -0,0 +1,78 @@
+#include "test.h"
+#include <vector>
+#include <memory>
+#include "implied_volatility.h"
+
+/**
+* @file test_implied_volatility.cpp
+* @brief Checks the round trip of the implied volatility solvers through the Black Scholes
+* prices of in and out of the money options on spot and futures, and that every lane whose
+* status is not IV_CONVERGED is NaN.
+*/
+
+constexpr double IMPLIED_VOLATILITY_TOLERANCE = 1e-10;
+
+int main()
+{
+    std::vector<double> price, S, K, r, q, T, sigma;
+    std::vector<bool> calls, futures;
+    for (bool future: {false, true})
+    for (bool call: {true, false})
+    for (double k: {0.5, 0.8, 0.95, 1.0, 1.05, 1.3, 2.0})
+    for (double t: {0.01, 0.25, 1.0, 5.0})
+    for (double v: {0.05, 0.2, 0.8, 2.0})
+    {
+        // In and out of the money options on spot and futures with non zero rates, skipping 
+        // the ones whose volatility is lost in the rounding of the price.
+        BlackScholesClosedForm option(100.0, 100.0*k, 0.02, 0.01, v, t, call, future);
+        if (option.price()<1e-6 or option.vega()<1e-5*option.price()){continue;}
+        price.push_back(option.price());
+        S.push_back(100.0); K.push_back(100.0*k); r.push_back(0.02); q.push_back(0.01);
+        T.push_back(t); sigma.push_back(v); calls.push_back(call); futures.push_back(future);
+    }
+    // Below intrinsic, invalid input and a deep out-of-the-money price of a few ulps above the
+    // smallest normal number, which only has to be NaN unless converged.
+    const double not_converged_K = 971.64570157532285;
+    const double not_converged_T = 0.0041426511213648971;
+    const double not_converged_price = BlackScholesClosedForm(1.0, not_converged_K, 0.0, 0.0,
+        2.8844141356762094, not_converged_T, true, false).price();
+    const double extra[3][5] = {
+        {0.0, 100.0, 50.0, 0.0, 1.0},
+        {1.0, 100.0, 100.0, 0.0, -1.0},
+        {not_converged_price, 1.0, not_converged_K, 0.0, not_converged_T}};
+    for (const double* e: extra)
+    {
+        price.push_back(e[0]); S.push_back(e[1]); K.push_back(e[2]); r.push_back(e[3]);
+        q.push_back(0.0); T.push_back(e[4]); sigma.push_back(0.0); calls.push_back(true);
+        futures.push_back(false);
+    }
+
+    const std::size_t n = price.size();
+    const std::size_t solvable = n - 3;
+    std::unique_ptr<bool[]> is_call(new bool[n]), is_future(new bool[n]);
+    for (std::size_t i = 0; i<n; i++){is_call[i] = calls[i]; is_future[i] = futures[i];}
+    std::vector<double> batch_sigma(n);
+    std::vector<int> batch_status(n);
+    BlackScholesImpliedVolatilityBatch batch(price, S, K, r, q, T,
+        std::span<const bool>(is_call.get(), n), std::span<const bool>(is_future.get(), n));
+    batch.evaluate(batch_sigma, batch_status);
+
+    for (std::size_t i = 0; i<n; i++)
+    {
+        BlackScholesImpliedVolatility iv(price[i], S[i], K[i], r[i], q[i], T[i], is_call[i], 
+            is_future[i]);
+        check(iv.status==batch_status[i], "batch status matches scalar status");
+        check((iv.status==IV_CONVERGED)==std::isfinite(iv.sigma), "scalar NaN unless converged");
+        check((batch_status[i]==IV_CONVERGED)==std::isfinite(batch_sigma[i]),
+            "batch NaN unless converged");
+        if (i<solvable)
+        {
+            check(iv.status==IV_CONVERGED, "round trip converged");
+            check_close(iv.sigma, sigma[i], IMPLIED_VOLATILITY_TOLERANCE, "scalar round trip");
+            check_close(batch_sigma[i], sigma[i], IMPLIED_VOLATILITY_TOLERANCE, "batch round trip");
+        }
+    }
+    check(batch_status[solvable]==IV_BELOW_INTRINSIC, "below intrinsic");
+    check(batch_status[solvable + 1]==IV_INVALID_INPUT, "invalid input");
+    return test_result();
+};
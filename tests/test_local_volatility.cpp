@@ -0,0 +1,70 @@
+#include "test.h"
+#include <vector>
+#include "svi/local_volatility.h"
+#include "svi/vol_surface.h"
+
+/**
+* @file test_local_volatility.cpp
+* @brief Checks the Dupire local variance grid of the slices of a power law SSVI surface
+* against its closed form, the floors of an undefined density, and the errors of a grid
+* queried before it is built.
+*/
+
+// The derivative in T of the quadratic in log(T) through 3 expiries 10% apart.
+constexpr double LOCAL_VOLATILITY_TEST_TOLERANCE = 4.7e-4;
+
+int main()
+{
+    // theta(T) = sigma*sigma*T, the local variance is dw/dtheta*sigma*sigma/g(k).
+    SSVI ssvi(-.4, .8, .4);
+    const double sigma2 = .04;
+    std::vector<double> T;
+    for (double t = .25; t<2.01; t *= 1.1){T.push_back(t);}
+    std::vector<double> theta;
+    std::vector<RawSVI> slices;
+    for (double t: T)
+    {
+        theta.push_back(sigma2*t);
+        slices.push_back(ssvi.get_raw_svi(sigma2*t));
+    }
+    LocalVolatilityGrid grid(-1.0, 1.0, 101);
+    check_throws([&]{grid.local_variance(0.0, 1.0);}, "local variance before build");
+    check_throws([&]{grid.local_volatility(0.0, 1.0);}, "local volatility before build");
+    std::vector<double> strip(grid.nk);
+    check_throws([&]{grid.evaluate(grid.k_, 1.0, strip);}, "strip before build");
+    grid.build(slices, T);
+
+    const std::size_t nk = grid.nk;
+    std::vector<double> dwdtheta(nk*T.size()), g(nk*T.size());
+    ssvi.evaluate(grid.k_, theta, T, {}, {}, {}, dwdtheta, g);
+    for (std::size_t j = 0; j<T.size(); j++)
+    {
+        for (std::size_t i = 0; i<nk; i++)
+        {
+            const double expected = dwdtheta[j*nk + i]*sigma2/g[j*nk + i];
+            check_close(grid.local_variance(grid.k_[i], T[j]), expected, LOCAL_VOLATILITY_TEST_TOLERANCE,
+                "local variance against the closed form");
+        }
+        grid.evaluate(grid.k_, T[j], strip);
+        for (std::size_t i = 0; i<nk; i++)
+        {
+            check_close(strip[i], grid.local_volatility(grid.k_[i], T[j]), 0.0,
+                "strip local volatility");
+        }
+    }
+
+    // A slice of zero total variance, after one above it, has an undefined density and 
+    // decreasing total variances, both floored.
+    LocalVolatilityGrid floored(-1.0, 1.0, 101);
+    const std::vector<RawSVI> degenerate = {RawSVI(.04, .1, -.3, 0.0, .2), RawSVI(0.0, 0.0, 0.0, 0.0, .1)};
+    const std::vector<double> degenerate_t = {.5, 1.0};
+    floored.build(degenerate, degenerate_t);
+    check(std::isnan(floored.density[floored.nk]), "undefined density");
+    for (double v: floored.variance)
+    {check(std::isfinite(v) and v>=floored.variance_floor, "floored local variance");}
+    for (double k = -1.2; k<=1.2; k += .1)
+    {check(std::isfinite(floored.local_volatility(k, .75)), "floored local volatility");}
+    const std::vector<double> unsorted = {1.0, .5};
+    check_throws([&]{floored.build(degenerate, unsorted);}, "unsorted expiries");
+    return test_result();
+};
@@ -0,0 +1,80 @@
+#include "test.h"
+#include <vector>
+#include "montecarlo/longstaff_schwartz.h"
+
+/**
+* @file test_longstaff_schwartz.cpp
+* @brief Checks the least squares Monte Carlo prices of bermudan puts against the table of
+* Longstaff and Schwartz, that they do not depend on the number of workers, and the
+* rejection of the invalid dates and payoffs.
+*/
+
+constexpr double LONGSTAFF_SCHWARTZ_STANDARD_ERRORS = 4.0;
+constexpr double LONGSTAFF_SCHWARTZ_TABLE_ERROR = .01;
+
+/**
+ * @brief A bermudan put of the table of Longstaff and Schwartz.
+ */
+struct LongstaffSchwartzQuote
+{
+    double S; 
+    double sigma; 
+    double T; 
+    double price; 
+};
+
+/**
+ * @param T The year fraction of the expiry.
+ * @return The 50 exercise dates per year of the table.
+ */
+std::vector<double> exercise_dates(double T)
+{
+    const std::size_t n = std::size_t(50*T);
+    std::vector<double> dates(n);
+    for (std::size_t k = 0; k<n; k++){dates[k] = T*(k + 1)/n;}
+    return dates;
+};
+
+int main()
+{
+    // "Valuing American Options by Simulation", table 1: K = 40, r = .06, 50 exercise dates 
+    // per year, the simulated prices of the table have standard errors of about .01.
+    const LongstaffSchwartzQuote table[] = {
+        {36, .2, 1, 4.472}, {36, .2, 2, 4.821}, {36, .4, 1, 7.091}, {36, .4, 2, 8.488},
+        {38, .2, 1, 3.244}, {38, .2, 2, 3.735}, {38, .4, 1, 6.139}, {38, .4, 2, 7.669},
+        {40, .2, 1, 2.313}, {40, .2, 2, 2.879}, {40, .4, 1, 5.308}, {40, .4, 2, 6.921},
+        {42, .2, 1, 1.617}, {42, .2, 2, 2.206}, {42, .4, 1, 4.588}, {42, .4, 2, 6.243},
+        {44, .2, 1, 1.118}, {44, .2, 2, 1.675}, {44, .4, 1, 3.957}, {44, .4, 2, 5.622}};
+    MonteCarloPayoff put(PUT, 40.0);
+    for (const LongstaffSchwartzQuote& quote: table)
+    {
+        const std::vector<double> dates = exercise_dates(quote.T);
+        LongstaffSchwartzEngine engine(quote.S, .06, 0.0, quote.sigma, false, dates, 1 << 15, 1 << 15, 17);
+        const MonteCarloEstimate estimate = engine.price(put);
+        const double error = std::hypot(estimate.standard_error, LONGSTAFF_SCHWARTZ_TABLE_ERROR);
+        check(std::fabs(estimate.price - quote.price)<=LONGSTAFF_SCHWARTZ_STANDARD_ERRORS*error, 
+            "Longstaff-Schwartz table");
+    }
+
+    // The blocks keep their streams and are reduced in order whichever worker runs them.
+    const std::vector<double> dates = exercise_dates(1.0);
+    LongstaffSchwartzEngine serial(36.0, .06, 0.0, .2, false, dates, 1 << 16, 1 << 16, 5);
+    serial.workers = 1;
+    LongstaffSchwartzEngine parallel = serial;
+    parallel.workers = 4;
+    check(parallel.active_workers(parallel.paths*dates.size())==4, "large runs use the workers");
+    check(parallel.active_workers(1024)==1, "small runs stay serial");
+    const MonteCarloEstimate serial_estimate = serial.price(put);
+    const MonteCarloEstimate parallel_estimate = parallel.price(put);
+    check(serial_estimate.price==parallel_estimate.price 
+        and serial_estimate.standard_error==parallel_estimate.standard_error, 
+        "Longstaff-Schwartz does not depend on workers");
+
+    const std::vector<double> unordered = {.5, .25, 1.0};
+    check_throws([&]{LongstaffSchwartzEngine(36.0, .06, 0.0, .2, false, unordered, 1024, 1024, 5);},
+        "unordered exercise dates");
+    check_throws([&]{LongstaffSchwartzEngine(36.0, .06, 0.0, .2, false, std::vector<double>(), 1024, 1024, 5);},
+        "no exercise date");
+    check_throws([&]{serial.price(MonteCarloPayoff(PUT, 40.0, DOWN_AND_OUT, 30.0));}, "barrier payoff");
+    return test_result();
+};
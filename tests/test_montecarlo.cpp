@@ -0,0 +1,166 @@
+#include "test.h"
+#include <vector>
+#include <memory>
+#include "montecarlo/montecarlo.h"
+
+/**
+* @file test_montecarlo.cpp
+* @brief Checks the pseudo random Monte Carlo prices of vanilla, barrier and structured payoffs
+* against their closed forms and parities, the control variate and the standard errors, that
+* the quasi random runs converge faster than the pseudo random ones on a vanilla call, that
+* they do not depend on the number of workers, and that the invalid inputs are reported to
+* the caller. Checks the Sobol points against the Joe-Kuo sequence and its last point, and the 
+* covariance of the Brownian bridge.
+*/
+
+constexpr double MONTE_CARLO_STANDARD_ERRORS = 4.0;
+
+/**
+ * @brief Measures the root mean square error of the Monte Carlo price of a vanilla call
+ * over several seeds.
+ * @param quasi_random Indicator if the paths are built from the Sobol sequence.
+ * @param exact The closed form price.
+ * @return The root mean square error.
+ */
+double call_rmse(bool quasi_random, double exact)
+{
+    const int seeds = 16;
+    double squares = 0.0;
+    for (int s = 0; s<seeds; s++)
+    {
+        MonteCarloEngine engine(100.0, 0.03, 0.01, 0.25, 1.0, false, 4, 4096, 1000 + s);
+        engine.control_variate = false;
+        engine.quasi_random = quasi_random;
+        MonteCarloPayoff call(CALL, 100.0);
+        const double error = engine.price(call).price - exact;
+        squares += error*error;
+    }
+    return std::sqrt(squares/seeds);
+};
+
+int main()
+{
+    // Vanilla prices within a few standard errors of the closed form, on spot and futures.
+    for (bool future: {false, true})
+    for (OptionType type: {CALL, PUT})
+    {
+        MonteCarloEngine engine(100.0, 0.03, 0.01, 0.25, 1.0, future, 1, 65536, 5);
+        engine.control_variate = false;
+        MonteCarloPayoff vanilla(type, 105.0);
+        const MonteCarloEstimate estimate = engine.price(vanilla);
+        const double closed_form = BlackScholesClosedForm(100.0, 105.0, 0.03, 0.01, 0.25, 1.0, 
+            type==CALL, future).price();
+        check(std::fabs(estimate.price - closed_form)<MONTE_CARLO_STANDARD_ERRORS*estimate.standard_error, 
+            "vanilla within the standard errors");
+    }
+
+    // On the same paths the knock in and the knock out add up to the vanilla, and the vanilla 
+    // control variate lowers the standard error of a barrier option.
+    MonteCarloEngine barrier_engine(100.0, 0.03, 0.01, 0.25, 1.0, false, 50, 16384, 11);
+    barrier_engine.control_variate = false;
+    std::vector<MonteCarloPayoff> barriers = {MonteCarloPayoff(CALL, 100.0, DOWN_AND_OUT, 80.0), 
+        MonteCarloPayoff(CALL, 100.0, DOWN_AND_IN, 80.0), MonteCarloPayoff(CALL, 100.0)};
+    const std::vector<MonteCarloEstimate> plain = barrier_engine.price(barriers);
+    check_close(plain[0].price + plain[1].price, plain[2].price, 1e-12, "knock in plus knock out");
+    barrier_engine.control_variate = true;
+    const std::vector<MonteCarloEstimate> controlled = barrier_engine.price(barriers);
+    check(controlled[0].standard_error<.5*plain[0].standard_error, "control variate lowers the error");
+    check(std::fabs(controlled[0].price - plain[0].price)
+        <MONTE_CARLO_STANDARD_ERRORS*plain[0].standard_error, "control variate keeps the price");
+
+    // A call spread is the weighted sum of its legs, which the control variate prices exactly.
+    std::vector<std::unique_ptr<Option>> legs;
+    legs.push_back(std::make_unique<EuropeanVanillaOption>(nullptr, CALL, 95.0f));
+    legs.push_back(std::make_unique<EuropeanVanillaOption>(nullptr, CALL, 110.0f));
+    StructuredOption spread(std::move(legs), {1.0, -1.0});
+    MonteCarloEngine spread_engine(100.0, 0.03, 0.01, 0.25, 1.0, false, 1, 8192, 13);
+    spread_engine.control_variate = false;
+    std::vector<MonteCarloPayoff> spread_payoffs = {MonteCarloPayoff(spread), 
+        MonteCarloPayoff(CALL, 95.0), MonteCarloPayoff(CALL, 110.0)};
+    const std::vector<MonteCarloEstimate> spread_plain = spread_engine.price(spread_payoffs);
+    check_close(spread_plain[0].price, spread_plain[1].price - spread_plain[2].price, 1e-12, 
+        "structured payoff is the sum of its legs");
+    spread_engine.control_variate = true;
+    const double spread_closed_form = 
+        BlackScholesClosedForm(100.0, 95.0, 0.03, 0.01, 0.25, 1.0, true, false).price() 
+        - BlackScholesClosedForm(100.0, 110.0, 0.03, 0.01, 0.25, 1.0, true, false).price();
+    check_close(spread_engine.price(spread_payoffs)[0].price, spread_closed_form, 1e-10, 
+        "structured payoff with its control variate");
+
+    // A payoff whose standard error is 1e-12 of its price, where E[Y^2] - E[Y]^2 cancels.
+    MonteCarloEngine forward(1e6, 0.0, 0.0, 1e-9, 1.0, false, 1, 65536, 17);
+    forward.antithetic = false;
+    forward.control_variate = false;
+    MonteCarloPayoff deep(CALL, 1.0);
+    check_close(forward.price(deep).standard_error, 1e6*1e-9/std::sqrt(65536.0), .05, 
+        "standard error of a large price");
+    check_throws([]{MonteCarloEngine(0.0, 0.03, 0.01, 0.25, 1.0, false, 1, 1, 1);}, "non positive spot");
+    check_throws([]{MonteCarloEngine(100.0, 0.03, 0.01, std::nan(""), 1.0, false, 1, 1, 1);}, 
+        "NaN volatility");
+    check_throws([]{MonteCarloEngine(100.0, 0.03, 0.01, 0.25, 0.0, false, 1, 1, 1);}, 
+        "non positive year fraction");
+
+    const double exact = BlackScholesClosedForm(100.0, 100.0, 0.03, 0.01, 0.25, 1.0, true, false).price();
+    const double pseudo_rmse = call_rmse(false, exact);
+    const double quasi_rmse = call_rmse(true, exact);
+    std::cout << "call rmse on 4096 paths: pseudo random " << pseudo_rmse
+        << ", quasi random " << quasi_rmse << std::endl;
+    check(quasi_rmse<.25*pseudo_rmse, "quasi random converges faster");
+
+    // The blocks keep their points of the sequence whichever worker simulates them.
+    MonteCarloEngine serial(100.0, 0.03, 0.01, 0.25, 1.0, false, 64, 8192, 7);
+    serial.quasi_random = true;
+    serial.workers = 1;
+    MonteCarloEngine parallel = serial;
+    parallel.workers = 4;
+    MonteCarloPayoff call(CALL, 110.0);
+    check(serial.price(call).price==parallel.price(call).price, "quasi random does not depend on workers");
+
+    // The first 8 points of the Joe-Kuo sequence in the dimensions 1 to 10, in eighths, from the
+    // published initial direction numbers; the points are the centres of their 2^-32 intervals.
+    const int joe_kuo[10][8] = {
+        {0, 4, 6, 2, 3, 7, 5, 1}, {0, 4, 2, 6, 3, 7, 1, 5}, {0, 4, 2, 6, 5, 1, 7, 3}, 
+        {0, 4, 2, 6, 7, 3, 5, 1}, {0, 4, 6, 2, 3, 7, 5, 1}, {0, 4, 6, 2, 1, 5, 7, 3}, 
+        {0, 4, 2, 6, 3, 7, 1, 5}, {0, 4, 6, 2, 7, 3, 1, 5}, {0, 4, 6, 2, 7, 3, 1, 5}, 
+        {0, 4, 6, 2, 5, 1, 3, 7}};
+    SobolSequence sobol(10);
+    std::vector<double> u(8*10);
+    sobol.next(8, u);
+    for (int d = 0; d<10; d++)
+    for (int i = 0; i<8; i++)
+    {check_close(u[d*8 + i], joe_kuo[d][i]/8.0 + 0x1.0p-33, 1e-15, "Joe-Kuo Sobol points");}
+
+    // The last points of the sequence, of Gray codes 2^31 + 1 and 2^31, then nothing.
+    SobolSequence last(1);
+    last.skip_to(SOBOL_MAX_POINTS - 2);
+    std::vector<double> u_last(2);
+    last.next(2, u_last);
+    check_close(u_last[0], .5 + 3*0x1.0p-33, 1e-15, "second to last Sobol point");
+    check_close(u_last[1], 3*0x1.0p-33, 1e-15, "last Sobol point");
+    std::vector<double> u_past(1);
+    check_throws([&]{last.next(1, u_past);}, "Sobol sequence exhausted");
+    check_throws([&]{last.skip_to(SOBOL_MAX_POINTS + 1);}, "Sobol skip past the end");
+
+    // The bridge is linear in the normals: on unit normals, path p holds the column p of the
+    // map, whose rows give the covariances min(t_i, t_j) of the brownian motion.
+    const std::vector<double> times = {.1, .15, .4, .5, .9, 1.3, 2.0};
+    const std::size_t steps = times.size();
+    BrownianBridge bridge(times);
+    std::vector<double> unit(steps*steps, 0.0), columns(steps*steps);
+    for (std::size_t i = 0; i<steps; i++){unit[i*steps + i] = 1.0;}
+    bridge.build(unit, columns, steps);
+    for (std::size_t i = 0; i<steps; i++)
+    for (std::size_t j = 0; j<steps; j++)
+    {
+        double covariance = 0.0;
+        for (std::size_t p = 0; p<steps; p++){covariance += columns[i*steps + p]*columns[j*steps + p];}
+        check_close(covariance, std::min(times[i], times[j]), 1e-14, "Brownian bridge covariance");
+    }
+
+    // More steps than Sobol dimensions, on a run large enough to start workers.
+    MonteCarloEngine too_many_steps(100.0, 0.03, 0.01, 0.25, 1.0, false, SOBOL_MAX_DIMENSION + 1, 4096, 7);
+    too_many_steps.quasi_random = true;
+    too_many_steps.workers = 4;
+    check_throws([&]{too_many_steps.price(call);}, "sobol dimension out of range");
+    return test_result();
+};
@@ -0,0 +1,86 @@
+#include "test.h"
+#include <vector>
+#include "math/probability/normal/normal.h"
+
+/**
+* @file test_normal.cpp
+* @brief Checks the array pdf/cdf kernels of NormalDistribution against the scalar functions
+* and the exact cdf, the inverse cdf through the round trip in the tails, and reports their
+* cost per element.
+*/
+
+constexpr double NORMAL_PDF_TOLERANCE = 1e-15;
+constexpr double NORMAL_CDF_TOLERANCE = 2e-16;
+constexpr double NORMAL_INV_CDF_TOLERANCE = 1e-12;
+constexpr double NORMAL_INV_CDF_BATCH_TOLERANCE = 1e-15;
+
+int main()
+{
+    NormalDistribution normal;
+    std::vector<double> x;
+    for (double v = -30.0; v<=30.0; v += 0.0137){x.push_back(v);}
+    // An odd size, so that the tail of the arrays runs through the padded block.
+    x.push_back(0.0);
+    const std::size_t n = x.size();
+    std::vector<double> pdf(n), cdf(n), fused_pdf(n), fused_cdf(n);
+    normal.pdf(x, pdf);
+    normal.cdf(x, cdf);
+    normal.pdf_cdf(x, fused_pdf, fused_cdf);
+
+    for (std::size_t i = 0; i<n; i++)
+    {
+        const double scalar_pdf = normal.pdf(x[i]);
+        check(std::fabs(pdf[i] - scalar_pdf)<=NORMAL_PDF_TOLERANCE*scalar_pdf, "pdf matches scalar");
+        check(fused_pdf[i]==pdf[i], "fused pdf matches pdf");
+        check(fused_cdf[i]==cdf[i], "fused cdf matches cdf");
+        check_close(cdf[i], normal.cdf(x[i]), NORMAL_CDF_TOLERANCE, "cdf matches scalar");
+        check_close(cdf[i], .5*std::erfc(-x[i]/std::sqrt(2.0)), NORMAL_CDF_TOLERANCE, "cdf matches erfc");
+    }
+
+    std::vector<double> short_output(n - 1);
+    check_throws([&]{normal.cdf(x, short_output);}, "cdf size mismatch");
+    check_throws([&]{normal.pdf_cdf(x, pdf, short_output);}, "pdf_cdf size mismatch");
+
+    // Probabilities from 1e-300 to 1 - 1e-16, through the central and both tail regimes.
+    std::vector<double> p;
+    for (double e = -300.0; e<-1.0; e += 0.37){p.push_back(std::pow(10.0, e));}
+    for (double v = 0.05; v<1.0; v += 0.0031){p.push_back(v);}
+    for (double e = -1.0; e>-16.0; e -= 0.23){p.push_back(1.0 - std::pow(10.0, e));}
+    const std::size_t m = p.size();
+    std::vector<double> quantiles(m);
+    normal.inv_cdf(p, quantiles);
+    for (std::size_t i = 0; i<m; i++)
+    {
+        const double scalar_quantile = normal.inv_cdf(p[i]);
+        check(std::fabs(quantiles[i] - scalar_quantile)
+            <=NORMAL_INV_CDF_BATCH_TOLERANCE*std::fabs(scalar_quantile), "batch inv_cdf matches scalar");
+        check(normal.quantile(p[i])==scalar_quantile, "quantile matches inv_cdf");
+        // The round trip goes through erfc in the smaller of the two tails, whose relative
+        // accuracy holds down to 1e-300.
+        const double tail = p[i]<.5 ? p[i] : 1.0 - p[i];
+        const double round_trip = .5*std::erfc(std::fabs(scalar_quantile)/std::sqrt(2.0));
+        check(std::fabs(round_trip - tail)<=NORMAL_INV_CDF_TOLERANCE*tail, "inv_cdf round trip");
+    }
+    check(normal.inv_cdf(.5)==0.0, "median");
+    check(normal.inv_cdf(1e-300)<-37.0, "deep lower tail");
+    check_throws([&]{normal.inv_cdf(p, std::span<double>(quantiles).first(m - 1));},
+        "inv_cdf size mismatch");
+
+    const int rounds = 200;
+    double sink = 0.0;
+    const double array_ms = milliseconds([&]{
+        for (int k = 0; k<rounds; k++){normal.pdf_cdf(x, pdf, cdf); sink += cdf[k % n];}});
+    const double scalar_ms = milliseconds([&]{
+        for (int k = 0; k<rounds; k++)
+        for (std::size_t i = 0; i<n; i++){sink += normal.pdf(x[i]) + normal.cdf(x[i]);}});
+    const double inv_array_ms = milliseconds([&]{
+        for (int k = 0; k<rounds; k++){normal.inv_cdf(p, quantiles); sink += quantiles[k % m];}});
+    const double inv_scalar_ms = milliseconds([&]{
+        for (int k = 0; k<rounds; k++)
+        for (std::size_t i = 0; i<m; i++){sink += normal.inv_cdf(p[i]);}});
+    std::cout << "pdf+cdf, ns per element: array " << array_ms*1e6/(rounds*n)
+        << ", scalar " << scalar_ms*1e6/(rounds*n) << std::endl;
+    std::cout << "inv_cdf, ns per element: array " << inv_array_ms*1e6/(rounds*m)
+        << ", scalar " << inv_scalar_ms*1e6/(rounds*m) << " (" << (sink!=0.0) << ")" << std::endl;
+    return test_result();
+};
@@ -0,0 +1,122 @@
+#include "test.h"
+#include <vector>
+#include <thread>
+#include "math/probability/random/random.h"
+
+/**
+* @file test_random.cpp
+* @brief Checks the xoshiro256** and Philox-4x32-10 engines against their reference outputs,
+* that the thread streams only depend on the seed and on the stream index their thread
+* picked, that the threads which pick none draw from distinct streams, and that the Philox
+* draws do not depend on how their indices are split.
+*/
+
+/**
+ * @brief Draws from the stream of a new thread on the given stream index.
+ * @param index The stream index of the thread.
+ * @param draws The output draws.
+ */
+void draw_on_thread(uint64_t index, std::vector<double>& draws)
+{
+    std::thread worker([&]{
+        set_thread_random_stream(index);
+        thread_random_stream().fill_normal(draws);});
+    worker.join();
+};
+
+int main()
+{
+    // The reference implementation of Blackman and Vigna from the state {1, 2, 3, 4}.
+    RandomEngine engine(0, 0);
+    const uint64_t state[4] = {1, 2, 3, 4};
+    for (int i = 0; i<4; i++){engine.state[i] = state[i];}
+    const uint64_t expected[4] = {11520, 0, 1509978240, 1215971899390074240};
+    for (uint64_t e: expected){check(engine.next()==e, "xoshiro256** reference output");}
+
+    const uint64_t seed = 20240601;
+    const std::size_t n = 1001;
+    std::vector<double> reference_1(n), reference_2(n);
+    RandomStream(seed, 1).fill_normal(reference_1);
+    RandomStream(seed, 2).fill_normal(reference_2);
+
+    // The streams follow the index of the threads, whichever thread draws first.
+    set_random_seed(seed);
+    std::vector<double> first(n), second(n);
+    draw_on_thread(2, second);
+    draw_on_thread(1, first);
+    check(first==reference_1, "thread stream 1 follows its index");
+    check(second==reference_2, "thread stream 2 follows its index");
+    draw_on_thread(1, second);
+    draw_on_thread(2, first);
+    check(second==reference_1 and first==reference_2, "thread streams replay in any order");
+
+    // Threads which do not pick an index draw from distinct default streams.
+    std::vector<double> default_1(n), default_2(n);
+    std::thread thread_1([&]{thread_random_stream().fill_normal(default_1);});
+    std::thread thread_2([&]{thread_random_stream().fill_normal(default_2);});
+    thread_1.join();
+    thread_2.join();
+    check(default_1!=default_2, "default thread streams differ");
+    check(default_1!=reference_1 and default_1!=reference_2, "default streams avoid the picked indices");
+
+    // Reseeding restarts the stream of the calling thread on its own index.
+    set_thread_random_stream(1);
+    std::vector<double> replay(n);
+    thread_random_stream().fill_normal(replay);
+    set_random_seed(seed + 1);
+    set_random_seed(seed);
+    std::vector<double> reseeded(n);
+    thread_random_stream().fill_normal(reseeded);
+    check(replay==reference_1 and reseeded==reference_1, "reseeded stream replays");
+
+    // Single draws use the same engine, and their sample moments are those of N(0,1).
+    RandomStream stream(seed, 3);
+    double mean = 0.0;
+    double variance = 0.0;
+    const int draws = 200000;
+    for (int i = 0; i<draws; i++){const double z = stream.normal(); mean += z; variance += z*z;}
+    mean /= draws;
+    variance = variance/draws - mean*mean;
+    check(std::fabs(mean)<5.0/std::sqrt(draws), "normal mean");
+    check(std::fabs(variance - 1.0)<5.0*std::sqrt(2.0/draws), "normal variance");
+    // The known answers of the Random123 distribution, key and counter words low first.
+    const uint64_t philox[3][3] = {
+        {0, 0, 0},
+        {0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff},
+        {0x299f31d0a4093822, 0x0370734413198a2e, 0x85a308d3243f6a88}};
+    const uint32_t philox_expected[3][4] = {
+        {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8},
+        {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd},
+        {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}};
+    for (int k = 0; k<3; k++)
+    {
+        uint32_t out[4];
+        PhiloxEngine(philox[k][0]).generate(philox[k][1], philox[k][2], out);
+        for (int i = 0; i<4; i++){check(out[i]==philox_expected[k][i], "philox known answer");}
+    }
+
+    // Any split of the indices, at odd offsets and across blocks, gives the same draws.
+    PhiloxStream counter_stream(seed, 7);
+    std::vector<double> whole_uniform(n), whole_normal(n), part(n);
+    counter_stream.fill_uniform(0, whole_uniform);
+    counter_stream.fill_normal(0, whole_normal);
+    for (std::size_t i = 0; i<n; i += 97)
+    {
+        check(counter_stream.uniform(i)==whole_uniform[i], "philox uniform by index");
+        check(counter_stream.normal(i)==whole_normal[i], "philox normal by index");
+    }
+    const std::size_t cuts[4] = {0, 3, 38, n};
+    for (int c = 0; c<3; c++)
+    {
+        const std::span<double> piece = std::span<double>(part).subspan(cuts[c], cuts[c + 1] - cuts[c]);
+        counter_stream.fill_uniform(cuts[c], piece);
+    }
+    check(part==whole_uniform, "philox uniform split");
+    for (int c = 0; c<3; c++)
+    {
+        const std::span<double> piece = std::span<double>(part).subspan(cuts[c], cuts[c + 1] - cuts[c]);
+        counter_stream.fill_normal(cuts[c], piece);
+    }
+    check(part==whole_normal, "philox normal split");
+    return test_result();
+};
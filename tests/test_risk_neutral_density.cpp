@@ -0,0 +1,112 @@
+#include "test.h"
+#include <memory>
+#include <vector>
+#include "svi/risk_neutral_density.h"
+#include "blackscholes.h"
+
+/**
+* @file test_risk_neutral_density.cpp
+* @brief Checks the quadrature prices of the risk neutral densities of arbitrage free SVI
+* slices against the Black-Scholes prices at the implied volatilities of the slices: the
+* vanillas, the digitals as the strike derivatives of the vanillas, the unit mass and the
+* forward, and the structured options of the expiry of the density only.
+*/
+
+constexpr double RISK_NEUTRAL_DENSITY_PRICE_TOLERANCE = 3e-7;
+// The central differences of the closed form, of step 1e-4*F, are exact to h*h*C'''/6.
+constexpr double RISK_NEUTRAL_DENSITY_DIGITAL_TOLERANCE = 1e-6;
+constexpr double RISK_NEUTRAL_DENSITY_MASS_TOLERANCE = 1e-10;
+
+int main()
+{
+    const long long valuation = 1700000000;
+    const long long year = 365*24*60*60;
+    const std::vector<RawSVI> slices = {RawSVI(.01, .08, -.4, .02, .2), RawSVI(.02, .1, -.3, .05, .25)};
+    const std::vector<double> T = {.5, 1.0};
+    const std::vector<double> F = {100.0, 102.0};
+    const std::vector<double> D = {std::exp(-.025), std::exp(-.05)};
+    RiskNeutralDensityGrid grid(401);
+    grid.workers = 2;
+    grid.build(slices, T, F, D);
+    check(grid.size()==T.size(), "expiries");
+
+    // The Black-Scholes price of the future at the implied volatility of the slice.
+    auto black = [&](std::size_t j, bool is_call, double K)
+    {
+        const double sigma = RawSVI(slices[j]).implied_volatility(std::log(K/F[j]), T[j]);
+        return BlackScholesClosedForm(F[j], K, -std::log(D[j])/T[j], 0.0, sigma, T[j], is_call, true).price();
+    };
+    for (std::size_t j = 0; j<T.size(); j++)
+    {
+        const std::size_t last = j*grid.nk + grid.nk - 1;
+        double total = 0.0;
+        for (std::size_t i = 0; i<grid.nk; i++){total += grid.weights[j*grid.nk + i];}
+        check_close(total, 1.0, RISK_NEUTRAL_DENSITY_MASS_TOLERANCE, "unit quadrature weights");
+        check_close(grid.lower[last], 1.0, RISK_NEUTRAL_DENSITY_MASS_TOLERANCE, "unit cumulative probability");
+        check_close(grid.lower_share[last], 1.0, RISK_NEUTRAL_DENSITY_MASS_TOLERANCE, "forward repriced");
+        check_close(grid.mass[j], 1.0, RISK_NEUTRAL_DENSITY_MASS_TOLERANCE, "mass of an arbitrage free slice");
+        std::vector<double> S(grid.nk);
+        grid.underlying_prices(j, S);
+        check_close(grid.price(j, S), D[j]*F[j], RISK_NEUTRAL_DENSITY_MASS_TOLERANCE, "discounted forward");
+
+        std::vector<double> strikes;
+        std::vector<bool> calls;
+        for (double K = .6*F[j]; K<=1.6*F[j]; K += .0137*F[j])
+        {
+            for (bool is_call: {true, false})
+            {
+                const double h = 1e-4*F[j];
+                const double price = grid.price(j, is_call ? CALL : PUT, K);
+                check_close(price, black(j, is_call, K), RISK_NEUTRAL_DENSITY_PRICE_TOLERANCE, "vanilla price");
+                const double slope = (black(j, is_call, K + h) - black(j, is_call, K - h))/(2*h);
+                check_close(grid.digital(j, is_call ? CALL : PUT, K), is_call ? -slope : slope,
+                    RISK_NEUTRAL_DENSITY_DIGITAL_TOLERANCE, "digital price");
+                strikes.push_back(K);
+                calls.push_back(is_call);
+            }
+        }
+
+        // The strips are the prices one by one.
+        std::unique_ptr<bool[]> is_call(new bool[calls.size()]);
+        std::copy(calls.begin(), calls.end(), is_call.get());
+        std::vector<double> prices(strikes.size()), digitals(strikes.size());
+        grid.price(j, strikes, std::span<const bool>(is_call.get(), calls.size()), prices);
+        grid.digital(j, strikes, std::span<const bool>(is_call.get(), calls.size()), digitals);
+        for (std::size_t i = 0; i<strikes.size(); i++)
+        {
+            check_close(prices[i], grid.price(j, calls[i] ? CALL : PUT, strikes[i]), 0.0, "strip price");
+            check_close(digitals[i], grid.digital(j, calls[i] ? CALL : PUT, strikes[i]), 0.0, "strip digital");
+        }
+    }
+
+    // A call spread of the second expiry, whose legs must all expire at it.
+    auto call_spread = [&](long long first, long long second)
+    {
+        std::vector<std::unique_ptr<Option>> legs;
+        legs.push_back(std::make_unique<EuropeanVanillaOption>(
+            first ? std::make_unique<EpochTimestamp>(first, SECONDS) : nullptr, CALL, 95.0f));
+        legs.push_back(std::make_unique<EuropeanVanillaOption>(
+            second ? std::make_unique<EpochTimestamp>(second, SECONDS) : nullptr, CALL, 105.0f));
+        return StructuredOption(std::move(legs), {1.0, -1.0});
+    };
+    const EpochTimestamp today(valuation, SECONDS);
+    StructuredOption spread = call_spread(valuation + year, valuation + year);
+    check_close(grid.price(1, spread, today, ACT365), grid.price(1, CALL, 95.0) - grid.price(1, CALL, 105.0),
+        0.0, "call spread");
+    StructuredOption later = call_spread(valuation + year, valuation + year + 86400);
+    check_throws([&]{grid.price(1, later, today, ACT365);}, "leg of another expiry");
+    StructuredOption undated = call_spread(valuation + year, 0);
+    check_throws([&]{grid.price(1, undated, today, ACT365);}, "leg without expiry");
+    check_throws([&]{grid.price(0, spread, today, ACT365);}, "structured option of another expiry");
+    check_throws([&]{grid.price(2, CALL, 100.0);}, "unknown expiry");
+
+    // The invalid forwards, discount factors and year fractions leave the grid unchanged.
+    const std::vector<double> negative = {100.0, -1.0};
+    const std::vector<double> zero = {0.0, 1.0};
+    check_throws([&]{grid.build(slices, T, negative, D);}, "negative forward");
+    check_throws([&]{grid.build(slices, T, F, zero);}, "zero discount factor");
+    check_throws([&]{grid.build(slices, zero, F, D);}, "zero year fraction");
+    check_throws([&]{grid.build(slices, T, F, std::vector<double>{1.0});}, "size mismatch");
+    check(grid.F_==F and grid.D_==D and grid.T_==T, "grid unchanged");
+    return test_result();
+};
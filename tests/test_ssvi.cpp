@@ -0,0 +1,52 @@
+#include "test.h"
+#include <vector>
+#include "svi/svi_calibration.h"
+
+/**
+* @file test_ssvi.cpp
+* @brief Checks the SSVI butterfly arbitrage condition on a correlation which breaks it, and
+* the calibration of a small SSVI surface, which runs serially.
+*/
+
+constexpr double SSVI_CALIBRATION_TEST_TOLERANCE = 1e-6;
+
+int main()
+{
+    // theta*phi(theta) = 3 and theta*phi(theta)^2 = 2.25 pass the condition at rho = 0, while
+    // theta*phi(theta)*(1+|rho|) = 4.5 breaks it at |rho| = .5.
+    const double theta = 4.0;
+    check(SSVI(0.0, 1.5, .5).butterfly_arbitrage_check(theta), "no butterfly arbitrage at rho = 0");
+    check(not SSVI(.5, 1.5, .5).butterfly_arbitrage_check(theta), "butterfly arbitrage at rho = .5");
+    check(not SSVI(-.5, 1.5, .5).butterfly_arbitrage_check(theta), "butterfly arbitrage at rho = -.5");
+
+    // A surface of 4 slices of 41 quotes, far below SSVI_CALIBRATION_QUOTES_PER_WORKER.
+    SSVI ssvi(-.4, .8, .4);
+    const int slices = 4;
+    std::vector<std::vector<double>> k(slices), w(slices), weight(slices);
+    for (int j = 0; j<slices; j++)
+    {
+        const double t = .25*(j + 1);
+        for (int i = 0; i<=40; i++)
+        {
+            const double x = -.4 + .02*i;
+            k[j].push_back(x);
+            w[j].push_back(ssvi.total_variance(x, .04*t));
+            weight[j].push_back(1.0);
+        }
+    }
+    SSVICalibrator calibrator;
+    for (int j = 0; j<slices; j++){calibrator.add_slice(.25*(j + 1), k[j], w[j], weight[j]);}
+    const double ms = milliseconds([&]{calibrator.calibrate();});
+    check(calibrator.arbitrage_free, "calibrated surface is arbitrage free");
+    check_close(calibrator.rho, -.4, SSVI_CALIBRATION_TEST_TOLERANCE, "calibrated rho");
+    check_close(calibrator.nu, .8, SSVI_CALIBRATION_TEST_TOLERANCE, "calibrated nu");
+    check_close(calibrator.gamma, .4, SSVI_CALIBRATION_TEST_TOLERANCE, "calibrated gamma");
+    for (int j = 0; j<slices; j++)
+    {
+        check_close(calibrator.atm_total_variance[j], .04*.25*(j + 1),
+            SSVI_CALIBRATION_TEST_TOLERANCE, "calibrated ATM total variance");
+    }
+    std::cout << "surface of " << slices << " slices of 41 quotes: " << ms << " ms, "
+        << calibrator.iterations << " iterations" << std::endl;
+    return test_result();
+};
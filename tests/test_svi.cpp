@@ -0,0 +1,170 @@
+#include "test.h"
+#include <vector>
+#include <limits>
+#include "svi/svi.h"
+
+/**
+* @file test_svi.cpp
+* @brief Checks the grid evaluation of SVI and SSVI against their member functions and
+* finite differences, the status of the non throwing constructors and of the batches, and
+* reports the cost of the grid evaluation against the member functions.
+*/
+
+constexpr double SVI_GRID_TOLERANCE = 1e-12;
+constexpr double SVI_FINITE_DIFFERENCE_TOLERANCE = 1e-6;
+constexpr double SVI_BUMP = 1e-5;
+
+int main()
+{
+    // A smile whose size is not a multiple of the simd width, so that the tail is exercised.
+    const std::size_t n = 503;
+    std::vector<double> k(n);
+    for (std::size_t i = 0; i<n; i++){k[i] = -1.0 + 2.0*i/(n - 1);}
+
+    SVI svi(.04, -.05, .3, .5, .03, 1.0);
+    std::vector<double> w(n), vol(n), dwdk(n), density(n), local(n);
+    svi.evaluate(k, w, vol, dwdk, density, local);
+    for (std::size_t i = 0; i<n; i++)
+    {
+        check_close(w[i], svi.total_variance(k[i]), SVI_GRID_TOLERANCE, "SVI total variance");
+        check_close(vol[i], svi.implied_volatility(k[i]), SVI_GRID_TOLERANCE, "SVI implied volatility");
+        check_close(dwdk[i], svi.dwdk(k[i]), SVI_GRID_TOLERANCE, "SVI dw/dk");
+        check_close(density[i], svi.risk_neutral_density(k[i]), SVI_GRID_TOLERANCE, "SVI density");
+        const double expected = svi.local_volatility(k[i]);
+        if (std::isnan(expected)){check(std::isnan(local[i]), "SVI local volatility is NaN");}
+        else {check_close(local[i], expected, SVI_GRID_TOLERANCE, "SVI local volatility");}
+        const double up = svi.dwdk(k[i] + SVI_BUMP);
+        const double down = svi.dwdk(k[i] - SVI_BUMP);
+        check_close(svi.dw2dk2(k[i]), (up - down)/(2*SVI_BUMP), SVI_FINITE_DIFFERENCE_TOLERANCE,
+            "SVI d2w/dk2");
+    }
+
+    // The implied volatilities alone skip the slope terms.
+    std::vector<double> only_vol(n);
+    svi.evaluate(k, {}, only_vol, {}, {}, {});
+    for (std::size_t i = 0; i<n; i++)
+    {check_close(only_vol[i], vol[i], 0.0, "SVI implied volatility only");}
+    std::vector<double> short_output(n - 1);
+    check_throws([&]{svi.evaluate(k, short_output, {}, {}, {}, {});}, "SVI output size mismatch");
+
+    SSVI ssvi(-.4, .8, .4);
+    const std::vector<double> theta = {.01, .02, .04, .08};
+    const std::vector<double> t = {.25, .5, 1.0, 2.0};
+    const std::size_t size = n*theta.size();
+    std::vector<double> ssvi_w(size), ssvi_vol(size), ssvi_dwdk(size), ssvi_dwdtheta(size),
+        ssvi_density(size);
+    ssvi.evaluate(k, theta, t, ssvi_w, ssvi_vol, ssvi_dwdk, ssvi_dwdtheta, ssvi_density);
+    for (std::size_t j = 0; j<theta.size(); j++)
+    {
+        RawSVI raw = ssvi.get_raw_svi(theta[j]);
+        for (std::size_t i = 0; i<n; i++)
+        {
+            const std::size_t index = j*n + i;
+            check_close(ssvi_w[index], ssvi.total_variance(k[i], theta[j]), SVI_GRID_TOLERANCE,
+                "SSVI total variance");
+            check_close(ssvi_vol[index], ssvi.implied_volatility(k[i], theta[j], t[j]),
+                SVI_GRID_TOLERANCE, "SSVI implied volatility");
+            const double dk = (ssvi.total_variance(k[i] + SVI_BUMP, theta[j])
+                - ssvi.total_variance(k[i] - SVI_BUMP, theta[j]))/(2*SVI_BUMP);
+            check_close(ssvi_dwdk[index], dk, SVI_FINITE_DIFFERENCE_TOLERANCE, "SSVI dw/dk");
+            const double h = SVI_BUMP*theta[j];
+            const double dtheta = (ssvi.total_variance(k[i], theta[j] + h)
+                - ssvi.total_variance(k[i], theta[j] - h))/(2*h);
+            check_close(ssvi_dwdtheta[index], dtheta, SVI_FINITE_DIFFERENCE_TOLERANCE,
+                "SSVI dw/dtheta");
+            check_close(ssvi_density[index], raw.risk_neutral_density(k[i]),
+                SVI_FINITE_DIFFERENCE_TOLERANCE, "SSVI density");
+        }
+    }
+    check_throws([&]{ssvi.evaluate(k, theta, {}, ssvi_w, {}, {}, {}, {});},
+        "SSVI slice size mismatch");
+
+    // The non throwing constructors report the invalid parameters the throwing ones reject.
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    check(SVI(.04, -.05, .3, .5, .03, 1.0, std::nothrow).status==SVI_VALID, "valid SVI status");
+    check(SVI(-.04, -.05, .3, .5, .03, 1.0, std::nothrow).status & SVI_NON_POSITIVE_VARIANCE, 
+        "non positive variance status");
+    check(SVI(.04, -.05, .3, .5, .03, nan, std::nothrow).status & SVI_NON_POSITIVE_YEAR_FRACTION, 
+        "NaN year fraction status");
+    check(SVI(.04, -.05, -.5, .3, .03, 1.0, std::nothrow).status & SVI_NEGATIVE_B, 
+        "negative b status");
+    check_throws([&]{SVI(-.04, -.05, .3, .5, .03, 1.0);}, "invalid SVI");
+    check(SSVI(-.4, .8, .4, std::nothrow).status==SSVI_VALID, "valid SSVI status");
+    check(SSVI(1.5, .8, .4, std::nothrow).status & SSVI_CORRELATION_OUT_OF_RANGE, 
+        "correlation status");
+    check(SSVI(-.4, .8, nan, std::nothrow).status & SSVI_GAMMA_OUT_OF_RANGE, "NaN gamma status");
+    check(SSVI(-.4, -.8, .4, std::nothrow).status & SSVI_NEGATIVE_NU, "negative nu status");
+    check_throws([&]{SSVI(-.4, -.8, .4);}, "invalid SSVI");
+
+    // Batches of quotes on several slices, one of them invalid, each quote against its slice.
+    std::vector<double> vt, ut, ct, pt, vmt, T, batch_k, batch_theta;
+    for (int j = 0; j<3; j++)
+    for (std::size_t i = 0; i<n; i += 7)
+    {
+        vt.push_back(j==1 ? -.04 : .04 + .01*j); ut.push_back(-.05); ct.push_back(.3); 
+        pt.push_back(.5); vmt.push_back(.03); T.push_back(.5*(j + 1)); batch_k.push_back(k[i]); 
+        batch_theta.push_back(j==1 ? 0.0 : theta[j]);
+    }
+    const std::size_t m = batch_k.size();
+    std::vector<double> batch_vol(m);
+    std::vector<int> batch_status(m);
+    SVIBatch(vt, ut, ct, pt, vmt, T, batch_k).evaluate(batch_vol, batch_status);
+    for (std::size_t i = 0; i<m; i++)
+    {
+        SVI slice(vt[i], ut[i], ct[i], pt[i], vmt[i], T[i], std::nothrow);
+        check(batch_status[i]==slice.status, "SVI batch status");
+        if (slice.status!=SVI_VALID){check(std::isnan(batch_vol[i]), "SVI batch invalid slice is NaN");}
+        else 
+        {
+            check_close(batch_vol[i], slice.implied_volatility(batch_k[i]), SVI_GRID_TOLERANCE, 
+                "SVI batch implied volatility");
+        }
+    }
+    SSVIBatch(-.4, .8, .4, batch_k, batch_theta, T).evaluate(batch_vol, batch_status);
+    for (std::size_t i = 0; i<m; i++)
+    {
+        if (batch_theta[i]==0.0)
+        {
+            check(batch_status[i]==SSVI_NON_POSITIVE_VARIANCE, "SSVI batch invalid quote status");
+            check(std::isnan(batch_vol[i]), "SSVI batch invalid quote is NaN");
+            continue;
+        }
+        check(batch_status[i]==SSVI_VALID, "SSVI batch status");
+        check_close(batch_vol[i], ssvi.implied_volatility(batch_k[i], batch_theta[i], T[i]), 
+            SVI_GRID_TOLERANCE, "SSVI batch implied volatility");
+    }
+    SSVIBatch(1.5, .8, .4, batch_k, batch_theta, T).evaluate(batch_vol, batch_status);
+    check(batch_status[0]==SSVI_CORRELATION_OUT_OF_RANGE and std::isnan(batch_vol[0]), 
+        "SSVI batch invalid parameters");
+    std::vector<int> short_status(m - 1);
+    check_throws([&]{SVIBatch(vt, ut, ct, pt, vmt, T, batch_k).evaluate(batch_vol, short_status);}, 
+        "SVI batch output size mismatch");
+
+    // Cost per point of the grid evaluation and of the member functions.
+    const int rounds = 200;
+    double sink = 0.0;
+    const double svi_batch_ms = milliseconds([&]{
+        for (int r = 0; r<rounds; r++){svi.evaluate(k, w, vol, dwdk, density, local);}});
+    const double svi_scalar_ms = milliseconds([&]{
+        for (int r = 0; r<rounds; r++)
+        for (std::size_t i = 0; i<n; i++)
+        {
+            sink += svi.total_variance(k[i]) + svi.implied_volatility(k[i]) + svi.dwdk(k[i])
+                + svi.risk_neutral_density(k[i]) + svi.local_volatility(k[i]);
+        }});
+    const double ssvi_batch_ms = milliseconds([&]{
+        for (int r = 0; r<rounds; r++){ssvi.evaluate(k, theta, t, ssvi_w, ssvi_vol, {}, {}, {});}});
+    const double ssvi_scalar_ms = milliseconds([&]{
+        for (int r = 0; r<rounds; r++)
+        for (std::size_t j = 0; j<theta.size(); j++)
+        for (std::size_t i = 0; i<n; i++)
+        {
+            sink += ssvi.total_variance(k[i], theta[j])
+                + ssvi.implied_volatility(k[i], theta[j], t[j]);
+        }});
+    std::cout << "ns per point: SVI all outputs batch " << 1e6*svi_batch_ms/(rounds*n)
+        << ", members " << 1e6*svi_scalar_ms/(rounds*n) << "; SSVI total variance and "
+        << "implied volatility batch " << 1e6*ssvi_batch_ms/(rounds*size) << ", members "
+        << 1e6*ssvi_scalar_ms/(rounds*size) << " (" << (sink!=0.0) << ")" << std::endl;
+    return test_result();
+};
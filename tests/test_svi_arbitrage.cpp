@@ -0,0 +1,122 @@
+#include "test.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "svi/svi_arbitrage.h"
+
+/**
+* @file test_svi_arbitrage.cpp
+* @brief Checks the static arbitrage scan of SVI surfaces against the conditions evaluated
+* point by point: a slice with a negative density, two slices whose total variances cross,
+* and a SSVI surface within eta*(1+|rho|) <= 2 which is free of both.
+*/
+
+constexpr double ARBITRAGE_TEST_TOLERANCE = 1e-12;
+
+/**
+ * @brief The regions of consecutive grid points with a negative value.
+ */
+static std::vector<std::pair<std::size_t, std::size_t>> negative_regions(const std::vector<double>& values)
+{
+    std::vector<std::pair<std::size_t, std::size_t>> regions;
+    for (std::size_t i = 0; i<values.size(); i++)
+    {
+        if (values[i]>=0){continue;}
+        const std::size_t first = i;
+        while (i + 1<values.size() and values[i + 1]<0){i++;}
+        regions.push_back({first, i});
+    }
+    return regions;
+};
+
+/**
+ * @brief Checks the regions of one type of the scan against the expected grid points.
+ */
+static void check_regions(ArbitrageScanner& scanner, std::size_t surface, std::size_t slice,
+    ArbitrageType type, const std::vector<double>& values, const std::string& name)
+{
+    std::vector<ArbitrageRegion> found;
+    for (const ArbitrageRegion& region: scanner.regions)
+    {
+        if (region.surface==surface and region.slice==slice and region.type==type)
+        {found.push_back(region);}
+    }
+    const std::vector<std::pair<std::size_t, std::size_t>> expected = negative_regions(values);
+    check(found.size()==expected.size(), (name + " region count").c_str());
+    for (std::size_t r = 0; r<std::min(found.size(), expected.size()); r++)
+    {
+        const auto [first, last] = expected[r];
+        check(found[r].k_lower==scanner.k_[first], (name + " region lower bound").c_str());
+        check(found[r].k_upper==scanner.k_[last], (name + " region upper bound").c_str());
+        const double worst = *std::min_element(values.begin() + first, values.begin() + last + 1);
+        check_close(found[r].worst, worst, ARBITRAGE_TEST_TOLERANCE, (name + " region worst value").c_str());
+    }
+};
+
+int main()
+{
+    ArbitrageScanner scanner(-1.5, 1.5, 300);
+    const std::size_t nk = scanner.k_.size();
+    scanner.workers = 3;
+
+    // The slice of Axel Vogt, whose density is negative on the right wing (Gatheral,
+    // Jacquier, 2013), followed by a slice above it.
+    const std::vector<RawSVI> vogt = {RawSVI(-.041, .1331, .306, .3586, .4153),
+        RawSVI(.01, .1331, .306, .3586, .4153)};
+    const std::vector<double> vogt_t = {1.0, 2.0};
+    // Two arbitrage free slices which cross at k = -.1, the later one below for k < -.1.
+    const std::vector<RawSVI> crossing = {RawSVI(.04, .1, -.5, 0.0, .2), RawSVI(.05, .1, .5, 0.0, .2)};
+    const std::vector<double> crossing_t = {.5, 1.0};
+    // A power law SSVI with eta*(1+|rho|) = 1.12 and gamma = .4.
+    SSVI ssvi(-.4, .8, .4);
+    std::vector<RawSVI> clean;
+    const std::vector<double> clean_t = {.25, .5, 1.0, 2.0};
+    for (double t: clean_t)
+    {
+        check(ssvi.butterfly_arbitrage_check(.04*t), "SSVI slice within the butterfly conditions");
+        clean.push_back(ssvi.get_raw_svi(.04*t));
+    }
+    scanner.add_surface(vogt, vogt_t);
+    scanner.add_surface(crossing, crossing_t);
+    scanner.add_surface(clean, clean_t);
+    check(not scanner.scan(), "arbitrage found");
+
+    std::vector<double> g(nk), difference(nk);
+    for (std::size_t i = 0; i<nk; i++){g[i] = RawSVI(vogt[0]).risk_neutral_density(scanner.k_[i]);}
+    check(not negative_regions(g).empty(), "negative density of the Vogt slice");
+    check_regions(scanner, 0, 0, BUTTERFLY_ARBITRAGE, g, "Vogt butterfly");
+    for (std::size_t i = 0; i<nk; i++){g[i] = RawSVI(vogt[1]).risk_neutral_density(scanner.k_[i]);}
+    check_regions(scanner, 0, 1, BUTTERFLY_ARBITRAGE, g, "shifted Vogt butterfly");
+    check_regions(scanner, 0, 0, CALENDAR_SPREAD_ARBITRAGE, std::vector<double>(nk, 0.0), "Vogt calendar spread");
+
+    for (std::size_t i = 0; i<nk; i++)
+    {
+        const double k = scanner.k_[i];
+        difference[i] = RawSVI(crossing[1]).total_variance(k) - RawSVI(crossing[0]).total_variance(k);
+    }
+    check_regions(scanner, 1, 0, CALENDAR_SPREAD_ARBITRAGE, difference, "crossing calendar spread");
+    check(std::count_if(scanner.regions.begin(), scanner.regions.end(), 
+        [](const ArbitrageRegion& region){return region.surface==1 and region.type==BUTTERFLY_ARBITRAGE;})==0, 
+        "crossing slices are butterfly free");
+    const std::vector<std::pair<std::size_t, std::size_t>> crossed = negative_regions(difference);
+    check(crossed.size()==1 and crossed[0].first==0 and scanner.k_[crossed[0].second]<-.1
+        and scanner.k_[crossed[0].second + 1]>-.1, "crossing calendar spread below k = -.1");
+
+    for (const ArbitrageRegion& region: scanner.regions){check(region.surface!=2, "clean SSVI surface");}
+
+    // The regions are ordered by surface, slice and log moneyness.
+    for (std::size_t r = 1; r<scanner.regions.size(); r++)
+    {
+        const ArbitrageRegion& x = scanner.regions[r - 1];
+        const ArbitrageRegion& y = scanner.regions[r];
+        check(x.surface<y.surface or (x.surface==y.surface and x.slice<=y.slice), "region order");
+    }
+
+    ArbitrageScanner clean_scanner(-1.5, 1.5, 300);
+    clean_scanner.add_surface(clean, clean_t);
+    check(clean_scanner.scan() and clean_scanner.regions.empty(), "clean SSVI surface alone");
+    check_throws([&]{clean_scanner.add_surface(clean, vogt_t);}, "surface size mismatch");
+    const std::vector<double> unsorted = {.5, .25, 1.0, 2.0};
+    check_throws([&]{clean_scanner.add_surface(clean, unsorted);}, "unsorted surface");
+    return test_result();
+};
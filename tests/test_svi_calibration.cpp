@@ -0,0 +1,129 @@
+#include "test.h"
+#include <vector>
+#include "svi/svi_calibration.h"
+
+/**
+* @file test_svi_calibration.cpp
+* @brief Checks the SVI slice calibration on a slice whose wing constraint binds, on
+* arbitrage free slices which it recovers, and the parallel calibration of a surface, cold
+* and from the previous fits.
+*/
+
+constexpr double SVI_CALIBRATION_TEST_TOLERANCE = 1e-6;
+// The simplex stops on the spread of the errors, the parameters are known to its square root.
+constexpr double SVI_CALIBRATION_PARAMETER_TOLERANCE = 1e-4;
+// The error of the best fit of the binding slice under the wing constraint.
+constexpr double SVI_CALIBRATION_BINDING_RMSE = .0247623;
+
+/**
+ * @brief Fills the quotes of a raw SVI slice on 41 log moneyness in [-.4, .4].
+ */
+static void raw_svi_quotes(double a, double b, double p, double m, double s,
+    std::vector<double>& k, std::vector<double>& w, std::vector<double>& weight)
+{
+    k.clear(); w.clear(); weight.clear();
+    for (int i = 0; i<=40; i++)
+    {
+        const double x = -.4 + .02*i;
+        k.push_back(x);
+        w.push_back(a + b*(p*(x - m) + std::sqrt((x - m)*(x - m) + s*s)));
+        weight.push_back(1.0);
+    }
+};
+
+/**
+ * @brief The weighted root mean square error of a fit, from its total variance.
+ */
+static double fit_rmse(SVIFit& fit, const std::vector<double>& k, const std::vector<double>& w)
+{
+    double error = 0.0;
+    for (std::size_t i = 0; i<k.size(); i++){error += std::pow(fit.total_variance(k[i]) - w[i], 2);}
+    return std::sqrt(error/k.size());
+};
+
+int main()
+{
+    // A raw SVI slice breaking b*b*(1+|p|) <= w(0), the fit is on the wing constraint.
+    std::vector<double> k, w, weight;
+    raw_svi_quotes(.001, .4, -.7, .1, .05, k, w, weight);
+    SVICalibrator calibrator;
+    calibrator.workers = 1;
+    calibrator.add_slice(.1, k, w, weight);
+    SVIFit fit = calibrator.calibrate_slice(0);
+    check(fit.arbitrage_free, "cold fit is arbitrage free");
+    check(fit.b*fit.b*(1 + std::fabs(fit.p))<=fit.total_variance(0.0)*(1 + 1e-6), "cold fit on the wing constraint");
+    check(fit.rmse<=SVI_CALIBRATION_BINDING_RMSE, "cold fit error");
+    check_close(fit.rmse, fit_rmse(fit, k, w), SVI_CALIBRATION_TEST_TOLERANCE, "cold fit reported error");
+    const double cold_rmse = fit.rmse;
+    const int cold_evaluations = fit.evaluations;
+    fit = calibrator.calibrate_slice(0);
+    check(fit.arbitrage_free, "warm fit is arbitrage free");
+    check(fit.rmse<=cold_rmse*(1 + 1e-6), "warm fit keeps the cold error");
+    check(fit.evaluations<cold_evaluations, "warm fit starts from the cold one");
+
+    // Arbitrage free slices, inside the wing constraint, are recovered.
+    const double slices[3][5] = {{.04, .1, -.3, .05, .2}, {.02, .15, .4, -.1, .1}, {.01, .2, -.6, .15, .3}};
+    for (const auto& [a, b, p, m, s]: slices)
+    {
+        raw_svi_quotes(a, b, p, m, s, k, w, weight);
+        SVICalibrator inside;
+        inside.workers = 1;
+        inside.add_slice(.5, k, w, weight);
+        fit = inside.calibrate_slice(0);
+        check(b*b*(1 + std::fabs(p))<fit.total_variance(0.0), "slice inside the wing constraint");
+        check(fit.arbitrage_free, "recovered fit is arbitrage free");
+        check(fit.rmse<SVI_CALIBRATION_TEST_TOLERANCE, "recovered fit error");
+        check_close(fit.a, a, SVI_CALIBRATION_PARAMETER_TOLERANCE, "recovered a");
+        check_close(fit.b, b, SVI_CALIBRATION_PARAMETER_TOLERANCE, "recovered b");
+        check_close(fit.p, p, SVI_CALIBRATION_PARAMETER_TOLERANCE, "recovered p");
+        check_close(fit.m, m, SVI_CALIBRATION_PARAMETER_TOLERANCE, "recovered m");
+        check_close(fit.s, s, SVI_CALIBRATION_PARAMETER_TOLERANCE, "recovered s");
+    }
+
+    // A surface of binding and arbitrage free slices, whose quotes move between two
+    // calibrations: the workers give the serial fits, cold and from the previous fits.
+    const int size = 8;
+    std::vector<std::vector<double>> surface_k(size), surface_w(size), surface_weight(size);
+    for (int j = 0; j<size; j++)
+    {
+        raw_svi_quotes(.01 + .005*j, j%2 ? .4 : .15, -.7 + .1*j, .1 - .02*j, j%2 ? .05 : .2,
+            surface_k[j], surface_w[j], surface_weight[j]);
+    }
+    SVICalibrator serial;
+    SVICalibrator parallel;
+    serial.workers = 1;
+    parallel.workers = 4;
+    for (int j = 0; j<size; j++)
+    {
+        serial.add_slice(.25*(j + 1), surface_k[j], surface_w[j], surface_weight[j]);
+        parallel.add_slice(.25*(j + 1), surface_k[j], surface_w[j], surface_weight[j]);
+    }
+    for (int round = 0; round<2; round++)
+    {
+        if (round==1)
+        {
+            // The views see the moved quotes.
+            for (std::vector<double>& slice: surface_w){for (double& x: slice){x *= 1.02;}}
+        }
+        serial.calibrate();
+        parallel.calibrate();
+        for (int j = 0; j<size; j++)
+        {
+            SVIFit& expected = serial.fits[j];
+            SVIFit& actual = parallel.fits[j];
+            check(actual.a==expected.a and actual.b==expected.b and actual.p==expected.p
+                and actual.m==expected.m and actual.s==expected.s and actual.rmse==expected.rmse,
+                "parallel fit is the serial fit");
+            check(actual.arbitrage_free, "parallel fit is arbitrage free");
+            check_close(actual.rmse, fit_rmse(actual, surface_k[j], surface_w[j]),
+                SVI_CALIBRATION_TEST_TOLERANCE, "parallel fit reported error");
+            if (round==0){continue;}
+            SVICalibrator cold;
+            cold.workers = 1;
+            cold.add_slice(.25*(j + 1), surface_k[j], surface_w[j], surface_weight[j]);
+            check(actual.rmse<=cold.calibrate_slice(0).rmse*(1 + 1e-4) + SVI_CALIBRATION_TEST_TOLERANCE,
+                "warm parallel fit keeps the cold error");
+        }
+    }
+    return test_result();
+};
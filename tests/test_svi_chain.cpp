@@ -0,0 +1,113 @@
+#include "test.h"
+#include <memory>
+#include <vector>
+#include "svi/svi_chain.h"
+#include "blackscholes.h"
+
+/**
+* @file test_svi_chain.cpp
+* @brief Checks the option chain priced from a SVI slice against the implied volatilities of
+* the slice and the Black-Scholes closed form, the sticky moneyness sensitivities against
+* the prices of the bumped forward and ATM volatility, the smile moving with them, and the
+* strikes of a chain which is not a multiple of simd::WIDTH.
+*/
+
+constexpr double SVI_CHAIN_TEST_TOLERANCE = 1e-10;
+// The central differences of relative step 1e-4 are exact to h*h*V'''/6.
+constexpr double SVI_CHAIN_BUMP_TOLERANCE = 1e-6;
+
+int main()
+{
+    const RawSVI raw(.02, .1, -.4, .05, .2);
+    const double T = .75;
+    const double F = 100.0;
+    const double D = std::exp(-.03*T);
+    const double r = -std::log(D)/T;
+    SVIChain chain(raw, F, D, T);
+    const double theta = RawSVI(raw).atm_total_variance();
+    const double sigma_atm = std::sqrt(theta/T);
+
+    // 4 full blocks and 3 strikes in the tail of the widest packs.
+    const std::size_t n = 4*simd::WIDTH + 3;
+    std::vector<double> K(n);
+    std::unique_ptr<bool[]> is_call(new bool[n]);
+    for (std::size_t i = 0; i<n; i++)
+    {
+        K[i] = 60.0 + 100.0*(double)i/(double)(n - 1);
+        is_call[i] = i%3!=0;
+    }
+    const std::span<const bool> calls(is_call.get(), n);
+    std::vector<std::vector<double>> outputs(SVI_CHAIN_OUTPUT_COUNT, std::vector<double>(n));
+    SVIChainResult result;
+    for (int g = 0; g<SVI_CHAIN_OUTPUT_COUNT; g++){result.output(g) = outputs[g];}
+    chain.evaluate(K, calls, result);
+
+    // The price at the implied volatility of a smile moved with the forward and the ATM
+    // volatility: w(k) = theta'/theta*w_0(k*sqrt(theta/theta')).
+    auto smile_price = [&](std::size_t i, double forward, double atm)
+    {
+        const double ratio = atm*atm*T/theta;
+        const double w = ratio*RawSVI(raw).total_variance(std::log(K[i]/forward)/std::sqrt(ratio));
+        return BlackScholesClosedForm(forward, K[i], r, 0.0, std::sqrt(w/T), T, is_call[i], true).price();
+    };
+    SVI svi = RawSVI(raw).get_svi(T);
+    for (std::size_t i = 0; i<n; i++)
+    {
+        const double sigma = svi.implied_volatility(std::log(K[i]/F));
+        check_close(result.implied_volatility[i], sigma, SVI_CHAIN_TEST_TOLERANCE, "implied volatility");
+        BlackScholesClosedForm exact(F, K[i], r, 0.0, sigma, T, is_call[i], true);
+        check_close(result.price[i], exact.price(), SVI_CHAIN_TEST_TOLERANCE, "price");
+        check_close(result.delta[i], exact.delta(), SVI_CHAIN_TEST_TOLERANCE, "delta");
+        check_close(result.gamma[i], exact.gamma(), SVI_CHAIN_TEST_TOLERANCE, "gamma");
+        check_close(result.vega[i], exact.vega(), SVI_CHAIN_TEST_TOLERANCE, "vega");
+        check_close(result.vanna[i], exact.vanna(), SVI_CHAIN_TEST_TOLERANCE, "vanna");
+        check_close(result.volga[i], exact.volga(), SVI_CHAIN_TEST_TOLERANCE, "volga");
+        check_close(result.dual_delta[i], exact.dual_delta(), SVI_CHAIN_TEST_TOLERANCE, "dual delta");
+        check_close(result.dual_gamma[i], exact.dual_gamma(), SVI_CHAIN_TEST_TOLERANCE, "dual gamma");
+
+        const double h = 1e-4*F;
+        check_close(result.sticky_moneyness_delta[i],
+            (smile_price(i, F + h, sigma_atm) - smile_price(i, F - h, sigma_atm))/(2*h),
+            SVI_CHAIN_BUMP_TOLERANCE, "sticky moneyness delta");
+        const double dsigma = 1e-4*sigma_atm;
+        check_close(result.sticky_moneyness_vega[i],
+            (smile_price(i, F, sigma_atm + dsigma) - smile_price(i, F, sigma_atm - dsigma))/(2*dsigma),
+            SVI_CHAIN_BUMP_TOLERANCE, "sticky moneyness vega");
+    }
+    const std::vector<double> atm_K = {F};
+    const bool atm_call = true;
+    std::vector<double> atm_vega(1), atm_sticky_vega(1);
+    SVIChainResult atm;
+    atm.vega = atm_vega;
+    atm.sticky_moneyness_vega = atm_sticky_vega;
+    chain.evaluate(atm_K, std::span<const bool>(&atm_call, 1), atm);
+    check_close(atm_sticky_vega[0], atm_vega[0], SVI_CHAIN_TEST_TOLERANCE, "sticky moneyness vega at the money");
+
+    // The chains of every length up to two blocks, with a subset of the outputs, are the
+    // strikes of the full chain: the tail goes through the padded block.
+    for (std::size_t m = 1; m<=2*simd::WIDTH + 1; m++)
+    {
+        std::vector<double> price(m), delta(m);
+        SVIChainResult partial;
+        partial.price = price;
+        partial.sticky_moneyness_delta = delta;
+        chain.evaluate(std::span<const double>(K.data(), m), std::span<const bool>(is_call.get(), m), partial);
+        for (std::size_t i = 0; i<m; i++)
+        {
+            check_close(price[i], result.price[i], 0.0, "tail price");
+            check_close(delta[i], result.sticky_moneyness_delta[i], 0.0, "tail sticky moneyness delta");
+        }
+    }
+    SVIChainResult none;
+    chain.evaluate(std::span<const double>(), std::span<const bool>(), none);
+
+    std::vector<double> short_output(n - 1);
+    SVIChainResult mismatch;
+    mismatch.price = short_output;
+    check_throws([&]{chain.evaluate(K, calls, mismatch);}, "output size mismatch");
+    check_throws([&]{chain.evaluate(K, std::span<const bool>(is_call.get(), n - 1), result);}, "flag size mismatch");
+    check_throws([&]{SVIChain(raw, -F, D, T);}, "negative forward");
+    check_throws([&]{SVIChain(raw, F, 0.0, T);}, "zero discount factor");
+    check_throws([&]{SVIChain(raw, F, D, 0.0);}, "zero year fraction");
+    return test_result();
+};
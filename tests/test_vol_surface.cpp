@@ -0,0 +1,128 @@
+#include "test.h"
+#include <vector>
+#include "svi/vol_surface.h"
+
+/**
+* @file test_vol_surface.cpp
+* @brief Checks the lookups of the baked volatility surface against the SVI implied
+* volatilities at the grid points, between the expiries and between the grid points, the
+* strip evaluation, the errors of an empty surface and the update from a SVI calibrator
+* whose year fractions change.
+*/
+
+constexpr double VOL_SURFACE_TEST_TOLERANCE = 1e-12;
+// The linear interpolation between the grid points, of width .01, is exact to dk*dk*w''/8.
+constexpr double VOL_SURFACE_INTERPOLATION_TOLERANCE = 1e-4;
+
+int main()
+{
+    const std::vector<double> T = {.25, .5, 1.0, 2.0};
+    std::vector<RawSVI> slices;
+    for (std::size_t j = 0; j<T.size(); j++)
+    {slices.push_back(RawSVI(.01 + .02*T[j], .1 + .02*j, -.5 + .05*j, .05, .2 + .05*j));}
+    VolSurface surface(-1.0, 1.0, 201);
+    for (std::size_t j = 0; j<T.size(); j++){surface.add_slice(T[j], slices[j]);}
+    surface.rebuild();
+
+    auto svi_total_variance = [&](std::size_t j, double k)
+    {return T[j]*std::pow(slices[j].get_svi(T[j]).implied_volatility(k), 2);};
+    for (std::size_t j = 0; j<T.size(); j++)
+    {
+        SVI svi = slices[j].get_svi(T[j]);
+        for (std::size_t i = 0; i<surface.nk; i += 5)
+        {
+            const double k = surface.k_[i];
+            check_close(surface.implied_volatility(k, T[j]), svi.implied_volatility(k),
+                VOL_SURFACE_TEST_TOLERANCE, "implied volatility at the grid points");
+            // Between the expiries the total variance is linear in the year fraction.
+            if (j + 1==T.size()){continue;}
+            const double t = .7*T[j] + .3*T[j + 1];
+            const double expected = .7*svi_total_variance(j, k) + .3*svi_total_variance(j + 1, k);
+            check_close(surface.total_variance(k, t), expected, VOL_SURFACE_TEST_TOLERANCE,
+                "total variance between the expiries");
+            check_close(surface.implied_volatility(k, t), std::sqrt(expected/t),
+                VOL_SURFACE_TEST_TOLERANCE, "implied volatility between the expiries");
+        }
+        // Between the grid points.
+        for (double k = -.995; k<1.0; k += .05)
+        {
+            check_close(surface.implied_volatility(k, T[j]), svi.implied_volatility(k),
+                VOL_SURFACE_INTERPOLATION_TOLERANCE, "implied volatility between the grid points");
+        }
+    }
+    // Outside of the expiries the implied volatility is constant.
+    for (double k = -1.0; k<=1.0; k += .1)
+    {
+        check_close(surface.implied_volatility(k, .1), surface.implied_volatility(k, T[0]),
+            VOL_SURFACE_TEST_TOLERANCE, "implied volatility before the first expiry");
+        check_close(surface.implied_volatility(k, 3.0), surface.implied_volatility(k, T.back()),
+            VOL_SURFACE_TEST_TOLERANCE, "implied volatility after the last expiry");
+    }
+
+    // The strip finds the expiry interval once.
+    std::vector<double> strip_k;
+    for (double k = -1.2; k<=1.2; k += .0123){strip_k.push_back(k);}
+    std::vector<double> strip_w(strip_k.size()), strip_vol(strip_k.size());
+    surface.evaluate(strip_k, .8, strip_w, strip_vol);
+    for (std::size_t i = 0; i<strip_k.size(); i++)
+    {
+        check_close(strip_w[i], surface.total_variance(strip_k[i], .8), 0.0, "strip total variance");
+        check_close(strip_vol[i], surface.implied_volatility(strip_k[i], .8), 0.0, "strip implied volatility");
+    }
+    std::vector<double> short_output(strip_k.size() - 1);
+    check_throws([&]{surface.evaluate(strip_k, .8, short_output, {});}, "strip output size mismatch");
+
+    VolSurface empty(-1.0, 1.0, 201);
+    check_throws([&]{empty.total_variance(0.0, 1.0);}, "empty surface total variance");
+    check_throws([&]{empty.implied_volatility(0.0, 1.0);}, "empty surface implied volatility");
+    check_throws([&]{empty.evaluate(strip_k, 1.0, strip_w, {});}, "empty surface strip");
+    check_throws([&]{VolSurface(1.0, -1.0, 201);}, "invalid grid");
+    check_throws([&]{surface.add_slice(1.5, slices[0]);}, "unsorted slice");
+
+    // A calibrated surface, whose year fractions move and the fits with them.
+    std::vector<std::vector<double>> k(T.size()), w(T.size()), weight(T.size());
+    SVICalibrator calibrator;
+    calibrator.workers = 1;
+    for (std::size_t j = 0; j<T.size(); j++)
+    {
+        for (int i = 0; i<=40; i++)
+        {
+            k[j].push_back(-.4 + .02*i);
+            w[j].push_back(slices[j].total_variance(k[j].back()));
+            weight[j].push_back(1.0);
+        }
+        calibrator.add_slice(T[j], k[j], w[j], weight[j]);
+    }
+    VolSurface calibrated(-1.0, 1.0, 201);
+    for (int round = 0; round<2; round++)
+    {
+        if (round==1)
+        {
+            for (std::size_t j = 0; j<T.size(); j++)
+            {
+                calibrator.T_[j] = .5*T[j] + .1;
+                for (double& x: w[j]){x *= 1.05;}
+            }
+        }
+        calibrator.calibrate();
+        calibrated.update(calibrator);
+        check(calibrated.size()==T.size(), "updated slices");
+        for (std::size_t j = 0; j<T.size(); j++)
+        {
+            check(calibrated.T_[j]==calibrator.T_[j], "updated year fraction");
+            SVI svi = calibrator.fits[j].get_svi();
+            for (std::size_t i = 0; i<calibrated.nk; i += 10)
+            {
+                const double x = calibrated.k_[i];
+                check_close(calibrated.implied_volatility(x, calibrator.T_[j]), svi.implied_volatility(x),
+                    VOL_SURFACE_TEST_TOLERANCE, "updated implied volatility at the grid points");
+            }
+        }
+    }
+    // Unsorted year fractions leave the surface unchanged.
+    const std::vector<double> before = calibrated.T_;
+    calibrator.T_[1] = 2*calibrator.T_[2];
+    check_throws([&]{calibrated.update(calibrator);}, "unsorted calibrator");
+    check(calibrated.T_==before, "surface unchanged by the unsorted calibrator");
+    return test_result();
+};